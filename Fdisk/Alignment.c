@@ -0,0 +1,328 @@
+/**
+ *===================================================================================
+ * @file           : Alignment.c
+ * @author         : Ali Mamdouh
+ * @brief          : check partitions against physical sector and RAID stripe geometry
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Alignment.h"      // Includes the geometry structure and analysis API
+#include <sys/stat.h>       // Provides stat and S_ISBLK
+#include <sys/sysmacros.h>  // Provides major and minor
+#include <limits.h>         // Provides PATH_MAX
+#include "GPT_Parsing.h"    // Provides the attribute formatter used in the suggested layout
+#include "UTF16.h"          // Provides the conversion of partition names to UTF-8
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Reads an unsigned number from a sysfs attribute file.
+ *
+ * @return 0 on success, or -1 if the file does not exist or holds no number.
+ */
+static int read_sysfs_number(const char *path, uint32_t *value)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    unsigned long number;
+    int status = (fscanf(file, "%lu", &number) == 1) ? 0 : -1;
+    fclose(file);
+
+    if (status == 0)
+    {
+        *value = (uint32_t)number;
+    }
+    return status;
+}
+
+
+
+/**
+ * Reads a queue attribute of a block device, from its own directory or, for a
+ * partition, from the directory of the whole disk.
+ */
+static int read_queue_attribute(unsigned int major_number, unsigned int minor_number, const char *name, uint32_t *value)
+{
+    char path[PATH_MAX];
+
+    snprintf(path, sizeof(path), ALIGN_SYSFS_DEV_BLOCK_DIR "/%u:%u/queue/%s", major_number, minor_number, name);
+    if (read_sysfs_number(path, value) == 0)
+    {
+        return 0;
+    }
+
+    snprintf(path, sizeof(path), ALIGN_SYSFS_DEV_BLOCK_DIR "/%u:%u/../queue/%s", major_number, minor_number, name);
+    return read_sysfs_number(path, value);
+}
+
+
+
+/**
+ * Greatest common divisor and least common multiple, used to combine alignment units.
+ */
+static uint64_t gcd(uint64_t a, uint64_t b)
+{
+    while (b != 0)
+    {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static uint64_t lcm(uint64_t a, uint64_t b)
+{
+    if (a == 0) return b;
+    if (b == 0) return a;
+    return a / gcd(a, b) * b;
+}
+
+
+
+/**
+ * Returns how many bytes `offset` is past the last aligned boundary (0 if aligned).
+ *
+ * Boundaries are at `alignment_offset + n * unit`.
+ */
+static uint64_t misalignment(uint64_t offset, uint64_t unit, uint32_t alignment_offset)
+{
+    if (unit == 0)
+    {
+        return 0;
+    }
+    return (offset + unit - (alignment_offset % unit)) % unit;
+}
+
+
+
+
+
+
+/**
+ * Determines the I/O geometry of a device.
+ *
+ * The logical and physical sector sizes come from the block I/O layer. For block devices,
+ * `minimum_io_size`, `optimal_io_size` and `alignment_offset` are read from sysfs
+ * (RAID arrays and some SSDs report their chunk and stripe sizes there). Image files have
+ * no sysfs entry: the minimum I/O size defaults to the physical sector size and no
+ * optimal I/O size is assumed; the caller can override every field.
+ *
+ * @param device: Path of the device or image.
+ * @param dev: The opened device.
+ * @param geometry: Receives the geometry.
+ */
+void ALIGN_get_geometry(const char *device, const BLK_Device *dev, ALIGN_Geometry *geometry)
+{
+    geometry->logical_sector_size = dev->logical_sector_size;
+    geometry->physical_sector_size = dev->physical_sector_size;
+    geometry->minimum_io_size = dev->physical_sector_size;
+    geometry->optimal_io_size = 0;
+    geometry->alignment_offset = 0;
+
+    struct stat st;
+    if (!dev->is_block_device || stat(device, &st) != 0 || !S_ISBLK(st.st_mode))
+    {
+        return;
+    }
+
+    unsigned int major_number = major(st.st_rdev);
+    unsigned int minor_number = minor(st.st_rdev);
+    char path[PATH_MAX];
+
+    read_queue_attribute(major_number, minor_number, "physical_block_size", &geometry->physical_sector_size);
+    read_queue_attribute(major_number, minor_number, "minimum_io_size", &geometry->minimum_io_size);
+    read_queue_attribute(major_number, minor_number, "optimal_io_size", &geometry->optimal_io_size);
+
+    snprintf(path, sizeof(path), ALIGN_SYSFS_DEV_BLOCK_DIR "/%u:%u/alignment_offset", major_number, minor_number);
+    read_sysfs_number(path, &geometry->alignment_offset);
+}
+
+
+
+
+
+
+/**
+ * Describes the cost of the worst misalignment of a partition.
+ *
+ * A write issued by the filesystem on a unit boundary of the partition lands across two
+ * units of the device when the partition start is misaligned:
+ * - physical sector: the drive reads both physical sectors, merges and writes them back,
+ *   so every small write costs two physical reads and two physical writes (~2x, plus the
+ *   read latency);
+ * - minimum I/O (RAID chunk): every chunk-sized write touches two chunks (2x member I/O);
+ * - optimal I/O (RAID stripe): every full-stripe write becomes two partial-stripe writes,
+ *   each needing a parity read-modify-write.
+ */
+static const char *penalty(uint64_t physical, uint64_t minimum_io, uint64_t optimal_io)
+{
+    if (physical != 0)   return "RMW on every write (~2x writes + reads)";
+    if (minimum_io != 0) return "chunk writes hit 2 chunks (~2x)";
+    if (optimal_io != 0) return "stripe writes split (parity RMW)";
+    return "none";
+}
+
+
+
+/**
+ * Prints an alignment column: "ok", "-" (no such unit) or the misalignment in bytes.
+ */
+static void print_column(FILE *out, uint64_t unit, uint64_t misaligned)
+{
+    char text[24];
+    if (unit == 0)            snprintf(text, sizeof(text), "-");
+    else if (misaligned == 0) snprintf(text, sizeof(text), "ok");
+    else                      snprintf(text, sizeof(text), "+%" PRIu64, misaligned);
+    fprintf(out, "%-9s ", text);
+}
+
+
+
+
+
+
+/**
+ * Checks the start and size of every partition against the device geometry.
+ *
+ * This function performs the following tasks:
+ * 1. Prints the geometry used for the analysis.
+ * 2. For every primary, logical and GPT partition, prints whether its start is aligned to
+ *    the physical sector, the minimum I/O size and the optimal I/O size (or by how many
+ *    bytes it is off), whether its size is a whole number of physical sectors/minimum
+ *    I/O units, and the read-modify-write penalty a misaligned start causes.
+ * 3. For misaligned partitions, suggests the largest aligned extent inside the current
+ *    one, printed in the `start=, size=` syntax of layout scripts (`-s`): the start is
+ *    rounded up to the alignment grain and the size down to a whole number of stripes.
+ *    GPT partitions also keep their `name=` and `attrs=` fields.
+ *
+ * The stripe is the least common multiple of the physical sector, minimum and optimal I/O
+ * sizes, and the grain the least common multiple of the stripe and 1 MiB, both shifted by
+ * the alignment offset. Extended partitions are containers and are not checked, nor are
+ * reversed GPT entries.
+ *
+ * @param out: Stream the report is printed to.
+ * @param device: Name of the device, printed in every row.
+ * @param geometry: The geometry to check against.
+ * @param table: The partition descriptors of the device.
+ *
+ * @return The number of misaligned partitions.
+ */
+int ALIGN_print_report(FILE *out, const char *device, const ALIGN_Geometry *geometry, const PARSE_Table *table)
+{
+    uint64_t sector_size = geometry->logical_sector_size;
+    uint64_t physical = geometry->physical_sector_size;
+    uint64_t minimum_io = (geometry->minimum_io_size > physical) ? geometry->minimum_io_size : 0;
+    uint64_t optimal_io = geometry->optimal_io_size;
+    uint64_t size_unit = minimum_io ? minimum_io : physical;
+    uint64_t stripe = lcm(physical, lcm(minimum_io, optimal_io));
+    uint64_t grain = lcm(ALIGN_DEFAULT_GRAIN, stripe);
+    int misaligned_count = 0;
+
+    fprintf(out, "\nAlignment: logical %u B, physical %u B, minimum I/O %u B, optimal I/O %u B, offset %u B\n",
+            geometry->logical_sector_size, geometry->physical_sector_size, geometry->minimum_io_size,
+            geometry->optimal_io_size, geometry->alignment_offset);
+    fprintf(out, "%-16s%-6s %-12s %-12s %-9s %-9s %-9s %-9s %s\n",
+            "Device", "Index", "Start", "Sectors", "Physical", "MinIO", "OptIO", "Size", "Penalty");
+
+    for (size_t i = 0; i < table->count; i++)
+    {
+        const PARSE_Partition *partition = &table->partitions[i];
+        if (partition->origin == PARSE_ORIGIN_EXTENDED || (partition->flags & PARSE_FLAG_REVERSED))
+        {
+            continue;
+        }
+
+        uint64_t start = partition->start * sector_size;
+        uint64_t length = partition->count * sector_size;
+        uint64_t off_physical = misalignment(start, physical, geometry->alignment_offset);
+        uint64_t off_minimum = misalignment(start, minimum_io, geometry->alignment_offset);
+        uint64_t off_optimal = misalignment(start, optimal_io, geometry->alignment_offset);
+
+        fprintf(out, "%-16s%-6d %-12" PRIu64 " %-12" PRIu64 " ", device, partition->index, partition->start, partition->count);
+        print_column(out, physical, off_physical);
+        print_column(out, minimum_io, off_minimum);
+        print_column(out, optimal_io, off_optimal);
+        fprintf(out, "%-9s %s\n", (length % size_unit == 0) ? "ok" : "partial",
+                penalty(off_physical, off_minimum, off_optimal));
+
+        if (off_physical != 0 || off_minimum != 0 || off_optimal != 0)
+        {
+            misaligned_count++;
+        }
+    }
+
+    if (misaligned_count == 0)
+    {
+        fprintf(out, "All partitions are aligned\n");
+        return 0;
+    }
+
+    // Suggest the largest aligned extent inside every misaligned partition
+    fprintf(out, "\n%d partition%s misaligned; suggested aligned layout (grain %" PRIu64 " KiB):\n",
+            misaligned_count, misaligned_count == 1 ? " is" : "s are", grain / 1024);
+
+    for (size_t i = 0; i < table->count; i++)
+    {
+        const PARSE_Partition *partition = &table->partitions[i];
+        uint64_t start = partition->start * sector_size;
+        if (partition->origin == PARSE_ORIGIN_EXTENDED || (partition->flags & PARSE_FLAG_REVERSED) ||
+            (misalignment(start, physical, geometry->alignment_offset) == 0 &&
+             misalignment(start, minimum_io, geometry->alignment_offset) == 0 &&
+             misalignment(start, optimal_io, geometry->alignment_offset) == 0))
+        {
+            continue;
+        }
+
+        uint64_t end = start + partition->count * sector_size;
+        uint64_t off = misalignment(start, grain, geometry->alignment_offset);
+        uint64_t new_start = (off == 0) ? start : start + (grain - off);
+        uint64_t new_length = (end > new_start) ? ((end - new_start) / stripe) * stripe : 0;
+
+        if (new_length == 0)
+        {
+            fprintf(out, "%s%d: too small to hold an aligned extent\n", device, partition->index);
+            continue;
+        }
+
+        // GPT partitions keep their name and attributes (a name containing '"' cannot be quoted)
+        char name[UTF16_UTF8_SIZE(PARSE_NAME_LENGTH)] = "";
+        char attributes[GPT_ATTR_TEXT_SIZE] = "";
+        if (partition->origin == PARSE_ORIGIN_GPT)
+        {
+            UTF16_to_utf8(partition->name, PARSE_NAME_LENGTH, name, sizeof(name));
+            if (strchr(name, '"') != NULL)
+            {
+                name[0] = '\0';
+            }
+            GPT_format_attributes(partition->attributes, partition->type_guid, true, attributes, sizeof(attributes));
+        }
+
+        fprintf(out, "%s%d: start=%" PRIu64 ", size=%" PRIu64 "%s%s%s%s%s%s   # was start=%" PRIu64 ", size=%" PRIu64 "\n",
+                device, partition->index, new_start / sector_size, new_length / sector_size,
+                (name[0] != '\0') ? ", name=\"" : "", name, (name[0] != '\0') ? "\"" : "",
+                (attributes[0] != '\0') ? ", attrs=\"" : "", attributes, (attributes[0] != '\0') ? "\"" : "",
+                partition->start, partition->count);
+    }
+
+    return misaligned_count;
+}
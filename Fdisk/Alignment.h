@@ -0,0 +1,84 @@
+/**
+ *===================================================================================
+ * @file           : Alignment.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Alignment (partition alignment analysis)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _ALIGNMENT_H_
+#define _ALIGNMENT_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Block_IO.h"        // Provides BLK_Device (sector sizes)
+#include "Partition_Parse.h" // Provides the partition descriptors to analyse
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Directory of the sysfs attributes of a block device, by major:minor number.
+ *
+ * `queue/physical_block_size`, `queue/minimum_io_size` and `queue/optimal_io_size` live in
+ * the whole-disk directory; for a partition they are found in the parent directory.
+ */
+#define ALIGN_SYSFS_DEV_BLOCK_DIR   "/sys/dev/block"  // sysfs block devices by major:minor
+
+/**
+ * Default alignment grain in bytes for suggested layouts.
+ *
+ * 1 MiB is a multiple of every common physical sector, RAID chunk and SSD erase block
+ * size, and is what fdisk, parted and Windows use by default.
+ */
+#define ALIGN_DEFAULT_GRAIN         (1024 * 1024)  // 1 MiB
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Represents the I/O geometry partitions should be aligned to.
+ *
+ * Fields:
+ *
+ * @param logical_sector_size: Size of an LBA in bytes.
+ * @param physical_sector_size: Smallest unit the device writes without read-modify-write.
+ * @param minimum_io_size: Preferred minimum I/O size (e.g., RAID chunk size), or 0.
+ * @param optimal_io_size: Optimal I/O size (e.g., RAID stripe width), or 0 if not reported.
+ * @param alignment_offset: Bytes by which LBA 0 is offset from the physical alignment.
+ */
+typedef struct {
+    uint32_t logical_sector_size;    /**< Logical sector size. */
+    uint32_t physical_sector_size;   /**< Physical sector size. */
+    uint32_t minimum_io_size;        /**< Minimum I/O size (RAID chunk). */
+    uint32_t optimal_io_size;        /**< Optimal I/O size (RAID stripe). */
+    uint32_t alignment_offset;       /**< Alignment offset of LBA 0. */
+} ALIGN_Geometry;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+void ALIGN_get_geometry(const char *device, const BLK_Device *dev, ALIGN_Geometry *geometry);
+int ALIGN_print_report(FILE *out, const char *device, const ALIGN_Geometry *geometry, const PARSE_Table *table);
+
+#endif
@@ -0,0 +1,865 @@
+/**
+ *===================================================================================
+ * @file           : Block_IO.c
+ * @author         : Ali Mamdouh
+ * @brief          : sector-size-aware aligned reads from block devices and disk images
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#define _GNU_SOURCE       // Required for O_DIRECT
+#include "Block_IO.h"     // Includes the block I/O API and configuration macros
+#include "Image_Format.h" // Provides the qcow2 and VHD backends
+#include "MBR_Parsing.h"  // Provides the extended partition types
+#include <fcntl.h>        // Provides open and the O_* flags
+#include <unistd.h>       // Provides pread and close
+#include <sys/stat.h>     // Provides fstat and S_ISBLK
+#include <sys/ioctl.h>    // Provides ioctl
+#include <sys/mman.h>     // Provides mmap, madvise and munmap
+#include <linux/fs.h>     // Provides BLKSSZGET, BLKPBSZGET, BLKGETSIZE64 and BLKRRPART
+#include <stdlib.h>       // Provides posix_memalign and free
+#include <string.h>       // Provides memcpy and memcmp
+#include <errno.h>        // Provides errno
+
+
+
+
+
+
+/*============================================================================
+ **********************  Global Variables Decleration  ***********************
+ ============================================================================*/
+/**
+ * System call counters of every device closed so far (see `BLK_get_stats`).
+ */
+static BLK_Stats total_stats;
+
+/**
+ * Logical sector size forced for image files (see `BLK_set_image_sector_size`), 0 to probe.
+ */
+static uint32_t image_sector_size_override;
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Rounds a value down to a multiple of a power-of-two alignment.
+ */
+static uint64_t align_down(uint64_t value, size_t alignment)
+{
+    return value & ~((uint64_t)alignment - 1);
+}
+
+
+
+/**
+ * Rounds a value up to a multiple of a power-of-two alignment.
+ */
+static uint64_t align_up(uint64_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~((uint64_t)alignment - 1);
+}
+
+
+
+/**
+ * Adds the counters of a device to the process totals (devices close on many threads).
+ */
+static void add_stats(const BLK_Stats *stats)
+{
+    __atomic_fetch_add(&total_stats.syscalls, stats->syscalls, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&total_stats.reads, stats->reads, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&total_stats.read_bytes, stats->read_bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&total_stats.writes, stats->writes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&total_stats.write_bytes, stats->write_bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&total_stats.maps, stats->maps, __ATOMIC_RELAXED);
+}
+
+
+
+/**
+ * Checks that a sector size is a power of two between 512 and `BLK_MAX_SECTOR_SIZE`.
+ */
+static int is_valid_sector_size(uint64_t size)
+{
+    return size >= BLK_DEFAULT_SECTOR_SIZE && size <= BLK_MAX_SECTOR_SIZE && (size & (size - 1)) == 0;
+}
+
+
+
+
+
+
+/**
+ * Reads up to `length` bytes at `offset`, retrying on short reads and EINTR.
+ *
+ * @return The number of bytes read (less than `length` only at end of file), or -1 on error.
+ */
+static ssize_t pread_full(BLK_Device *dev, void *buf, size_t length, uint64_t offset)
+{
+    size_t done = 0;
+
+    while (done < length)
+    {
+        ssize_t count = pread(dev->fd, (char *)buf + done, length - done, (off_t)(offset + done));
+        dev->stats.syscalls++;
+        dev->stats.reads++;
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if (count == 0)
+        {
+            break; // End of device or image
+        }
+        done += (size_t)count;
+        dev->stats.read_bytes += (uint64_t)count;
+    }
+
+    return (ssize_t)done;
+}
+
+
+
+
+
+
+/**
+ * Allocates a buffer suitable for reads from a device.
+ *
+ * The buffer is aligned to the device alignment (required by O_DIRECT) and its size
+ * is rounded up to a multiple of it. Free it with `free`.
+ *
+ * @param dev: The device the buffer will be used with.
+ * @param length: Minimum size of the buffer in bytes.
+ *
+ * @return Pointer to the buffer, or NULL on allocation failure.
+ */
+void *BLK_alloc_buffer(const BLK_Device *dev, size_t length)
+{
+    void *buf = NULL;
+    size_t alignment = dev->alignment < sizeof(void *) ? sizeof(void *) : dev->alignment;
+
+    if (posix_memalign(&buf, alignment, align_up(length ? length : 1, alignment)) != 0)
+    {
+        return NULL;
+    }
+
+    return buf;
+}
+
+
+
+
+
+
+/**
+ * Reads a byte range from a device with aligned I/O.
+ *
+ * qcow2 and VHD images are read through their backend (see `IMAGE_read`). For mapped
+ * image files the bytes are copied out of the mapping. Otherwise, if the 
+ * offset, length and buffer already satisfy the device alignment, the data is
+ * read straight into the caller's buffer. Otherwise the surrounding aligned range is
+ * read into an aligned bounce buffer and the requested bytes are copied out, so callers
+ * can read structures (e.g., a 512-byte EBR record on a 4Kn disk) at any offset.
+ *
+ * @param dev: The device to read from.
+ * @param offset: Byte offset of the first byte to read.
+ * @param buf: Destination buffer of at least `length` bytes.
+ * @param length: Number of bytes to read.
+ *
+ * @return 0 on success, or -1 on error or if the range lies beyond the end of the device
+ *         (errno is set).
+ */
+int BLK_read(BLK_Device *dev, uint64_t offset, void *buf, size_t length)
+{
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    // Image format backend: translate guest offsets through the lookup tables
+    if (dev->image != NULL)
+    {
+        return IMAGE_read(dev->image, offset, buf, length);
+    }
+
+    // mmap backend: copy straight out of the mapping, no system call
+    if (dev->map != NULL)
+    {
+        if (offset > dev->map_length || length > dev->map_length - offset)
+        {
+            errno = EIO; // The range extends past the end of the image
+            return -1;
+        }
+        memcpy(buf, dev->map + offset, length);
+        return 0;
+    }
+
+    uint64_t start = align_down(offset, dev->alignment);
+    uint64_t end = align_up(offset + length, dev->alignment);
+
+    // Fast path: the request is already aligned, read directly into the caller's buffer
+    if (start == offset && end == offset + length && ((uintptr_t)buf % dev->alignment) == 0)
+    {
+        ssize_t count = pread_full(dev, buf, length, offset);
+        if (count == (ssize_t)length)
+        {
+            return 0;
+        }
+        if (count >= 0)
+        {
+            errno = EIO; // Short read: the range extends past the end of the device
+        }
+        return -1;
+    }
+
+    // Slow path: read the enclosing aligned range into a bounce buffer
+    size_t span = (size_t)(end - start);
+    char *bounce = BLK_alloc_buffer(dev, span);
+    if (bounce == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    ssize_t count = pread_full(dev, bounce, span, start);
+    int status = 0;
+    if (count < 0)
+    {
+        status = -1;
+    }
+    else if ((uint64_t)count < offset + length - start)
+    {
+        errno = EIO; // The end of an image file need not be aligned, but the requested bytes must exist
+        status = -1;
+    }
+    else
+    {
+        memcpy(buf, bounce + (offset - start), length);
+    }
+
+    free(bounce);
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Reads whole logical sectors from a device.
+ *
+ * @param dev: The device to read from.
+ * @param lba: Logical Block Address of the first sector.
+ * @param count: Number of logical sectors to read.
+ * @param buf: Destination buffer of at least `count * logical_sector_size` bytes.
+ *
+ * @return 0 on success, or -1 on error.
+ */
+int BLK_read_sectors(BLK_Device *dev, uint64_t lba, uint64_t count, void *buf)
+{
+    return BLK_read(dev, lba * dev->logical_sector_size, buf, (size_t)(count * dev->logical_sector_size));
+}
+
+
+
+
+
+
+/**
+ * Returns a pointer to a byte range of a device, without copying when possible.
+ *
+ * For mapped image files this returns a pointer straight into the mapping (zero-copy), 
+ * after checking that the whole range lies inside the image. For other devices, the 
+ * range is read into `scratch` and `scratch` is returned. Either way, the structures 
+ * in the range can be parsed in place through the returned pointer, which must be 
+ * treated as read-only.
+ *
+ * @param dev: The device to read from.
+ * @param offset: Byte offset of the first byte.
+ * @param length: Number of bytes needed.
+ * @param scratch: Buffer of at least `length` bytes, used when the range is not mapped 
+ *                 (aligned for O_DIRECT if it comes from `BLK_alloc_buffer`).
+ *
+ * @return Pointer to the requested bytes, or NULL on error (errno is set).
+ */
+const void *BLK_get(BLK_Device *dev, uint64_t offset, size_t length, void *scratch)
+{
+    if (dev->map != NULL)
+    {
+        if (offset > dev->map_length || length > dev->map_length - offset)
+        {
+            errno = EIO; // Bounds check: the range extends past the end of the image
+            return NULL;
+        }
+        return dev->map + offset;
+    }
+
+    return (BLK_read(dev, offset, scratch, length) == 0) ? scratch : NULL;
+}
+
+
+
+
+
+
+/**
+ * Writes an aligned byte range to a device with a single write.
+ *
+ * The offset, length and buffer must satisfy the device alignment (use a buffer from 
+ * `BLK_alloc_buffer` covering whole logical sectors). The device must have been opened 
+ * with `BLK_FLAG_WRITE`. Mapped images see the new data through the shared mapping.
+ * qcow2 and VHD images are read-only.
+ *
+ * @param dev: The device to write to.
+ * @param offset: Byte offset of the first byte to write.
+ * @param buf: Data to write.
+ * @param length: Number of bytes to write.
+ *
+ * @return 0 on success, or -1 on error (errno is set).
+ */
+int BLK_write(BLK_Device *dev, uint64_t offset, const void *buf, size_t length)
+{
+    if (dev->image != NULL)
+    {
+        errno = EROFS;
+        return -1;
+    }
+    if ((offset % dev->alignment) != 0 || (length % dev->alignment) != 0 || ((uintptr_t)buf % dev->alignment) != 0)
+    {
+        errno = EINVAL; // Writes are never read-modify-written behind the caller's back
+        return -1;
+    }
+
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t count = pwrite(dev->fd, (const char *)buf + done, length - done, (off_t)(offset + done));
+        dev->stats.syscalls++;
+        dev->stats.writes++;
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        done += (size_t)count;
+        dev->stats.write_bytes += (uint64_t)count;
+    }
+
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Writes a byte range of any offset and length with a single aligned write.
+ *
+ * If the range does not cover whole alignment units (e.g., a 512-byte GPT header on an 
+ * image opened with O_DIRECT), the surrounding aligned range is read first and the data 
+ * is overlaid on it, so the device still sees exactly one aligned write.
+ *
+ * @param dev: The device to write to (opened with `BLK_FLAG_WRITE`).
+ * @param offset: Byte offset of the first byte to write.
+ * @param data: Data to write (no alignment requirement).
+ * @param length: Number of bytes to write.
+ *
+ * @return 0 on success, or -1 on error (errno is set).
+ */
+int BLK_write_span(BLK_Device *dev, uint64_t offset, const void *data, size_t length)
+{
+    uint64_t start = align_down(offset, dev->alignment);
+    size_t span = (size_t)(align_up(offset + length, dev->alignment) - start);
+
+    char *buf = BLK_alloc_buffer(dev, span);
+    if (buf == NULL)
+    {
+        return -1;
+    }
+
+    // Merge with the bytes around the range when it is not aligned
+    if ((start != offset || span != length) && BLK_read(dev, start, buf, span) != 0)
+    {
+        free(buf);
+        return -1;
+    }
+
+    memcpy(buf + (offset - start), data, length);
+
+    int status = BLK_write(dev, start, buf, span);
+    free(buf);
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Flushes written data of a device to stable storage.
+ *
+ * @param dev: The device to flush.
+ *
+ * @return 0 on success, or -1 on error (errno is set).
+ */
+int BLK_sync(BLK_Device *dev)
+{
+    dev->stats.syscalls++;
+    return fsync(dev->fd);
+}
+
+
+
+
+
+
+/**
+ * Asks the kernel to re-read the partition table of a block device (`BLKRRPART`).
+ *
+ * Image files have no kernel partition table, so nothing is done for them.
+ *
+ * @param dev: The device whose partition table was rewritten.
+ *
+ * @return 0 on success, or -1 on error (errno is set, EBUSY if a partition is in use).
+ */
+int BLK_reread_partitions(BLK_Device *dev)
+{
+    if (!dev->is_block_device)
+    {
+        return 0;
+    }
+    dev->stats.syscalls++;
+    return ioctl(dev->fd, BLKRRPART);
+}
+
+
+
+
+
+
+/**
+ * Maps an image file read-only for zero-copy parsing.
+ *
+ * The partition tables of an image are tiny compared to the image, so the whole file is 
+ * mapped (address space only) and `MADV_RANDOM` disables read-ahead: only the pages 
+ * actually parsed are faulted in. If mapping fails, the device keeps using `pread`.
+ *
+ * @param dev: The image file device.
+ */
+static void map_image(BLK_Device *dev)
+{
+    if (dev->size_bytes == 0 || dev->size_bytes > SIZE_MAX)
+    {
+        return;
+    }
+
+    void *map = mmap(NULL, (size_t)dev->size_bytes, PROT_READ, MAP_SHARED, dev->fd, 0);
+    dev->stats.syscalls++;
+    if (map == MAP_FAILED)
+    {
+        return;
+    }
+
+    madvise(map, (size_t)dev->size_bytes, MADV_RANDOM);
+    dev->stats.syscalls++;
+    dev->stats.maps++;
+
+    dev->map = map;
+    dev->map_length = (size_t)dev->size_bytes;
+}
+
+
+
+
+
+
+/**
+ * Queries the sector sizes and size of a block device with ioctls.
+ *
+ * @param dev: The device whose fields are filled in.
+ */
+static void query_block_device(BLK_Device *dev)
+{
+    int logical = 0;
+    unsigned int physical = 0;
+    uint64_t size = 0;
+
+    if (ioctl(dev->fd, BLKSSZGET, &logical) == 0 && is_valid_sector_size((uint64_t)logical))
+    {
+        dev->logical_sector_size = (uint32_t)logical;
+    }
+
+    if (ioctl(dev->fd, BLKPBSZGET, &physical) == 0 && physical >= dev->logical_sector_size)
+    {
+        dev->physical_sector_size = physical;
+    }
+    else
+    {
+        dev->physical_sector_size = dev->logical_sector_size;
+    }
+
+    if (ioctl(dev->fd, BLKGETSIZE64, &size) == 0)
+    {
+        dev->size_bytes = size;
+    }
+    dev->stats.syscalls += 3;
+}
+
+
+
+
+
+
+/**
+ * Checks for the 0x55AA signature of an EBR at an LBA, for a given sector size.
+ *
+ * @param dev: The device.
+ * @param lba: LBA of the EBR.
+ * @param sector_size: Sector size the LBA is counted in.
+ *
+ * @return: Non-zero if the sector lies inside the device and ends with 0x55AA.
+ */
+static int has_ebr_signature(BLK_Device *dev, uint64_t lba, uint32_t sector_size)
+{
+    uint64_t offset = lba * sector_size;
+    if (offset + BLK_DEFAULT_SECTOR_SIZE > dev->size_bytes)
+    {
+        return 0;
+    }
+
+    // The 512-byte record lies in one aligned block: read that block
+    uint64_t block = align_down(offset, dev->alignment);
+    if (block + dev->alignment > dev->size_bytes)
+    {
+        return 0;
+    }
+    uint8_t *buf = BLK_alloc_buffer(dev, dev->alignment);
+    int valid = buf != NULL && BLK_read(dev, block, buf, dev->alignment) == 0 &&
+                buf[offset - block + 510] == 0x55 && buf[offset - block + 511] == 0xAA;
+    free(buf);
+    return valid;
+}
+
+
+
+
+
+
+/**
+ * Checks whether an MBR describes a 4Kn disk.
+ *
+ * A plain MBR does not reveal its sector size, but an extended partition does: its first
+ * EBR starts at the extended partition's LBA. The image is taken as 4Kn when that EBR
+ * has a valid signature read at 4096 bytes per sector, the extended partition fits the
+ * image at that size, and no EBR is found at 512 bytes per sector. MBRs without an
+ * extended partition cannot be told apart (see `BLK_set_image_sector_size`).
+ *
+ * @param dev: The device.
+ * @param mbr: The first 512 bytes of the device.
+ *
+ * @return: Non-zero if the MBR describes a 4Kn disk.
+ */
+static int is_4kn_mbr(BLK_Device *dev, const uint8_t *mbr)
+{
+    if (mbr[510] != 0x55 || mbr[511] != 0xAA)
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        const uint8_t *entry = mbr + 446 + 16 * i;
+        uint8_t type = entry[4];
+        if (type != CHS_EXTENDED_PARTITION && type != LBA_EXTENDED_PARTITION && type != LINUX_EXTENDED_PARTITION)
+        {
+            continue;
+        }
+
+        uint64_t start = (uint64_t)entry[8] | (uint64_t)entry[9] << 8 | (uint64_t)entry[10] << 16 | (uint64_t)entry[11] << 24;
+        uint64_t count = (uint64_t)entry[12] | (uint64_t)entry[13] << 8 | (uint64_t)entry[14] << 16 | (uint64_t)entry[15] << 24;
+        return start != 0 && (start + count) * BLK_MAX_SECTOR_SIZE <= dev->size_bytes &&
+               has_ebr_signature(dev, start, BLK_MAX_SECTOR_SIZE) &&
+               !has_ebr_signature(dev, start, BLK_DEFAULT_SECTOR_SIZE);
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Guesses the logical sector size of a disk image.
+ *
+ * An image file does not carry its sector size, but a GPT header always sits at LBA 1.
+ * The first 8 KiB are read once and the "EFI PART" signature is looked for at byte 512
+ * and at byte 4096. If the primary header is damaged, the last 4 KiB are read and the
+ * backup header is looked for in the last 512-byte and in the last 4096-byte sector.
+ * Without any GPT header, an MBR whose extended partition only makes sense with 4096-byte
+ * sectors makes the image 4Kn (see `is_4kn_mbr`); other images default to 512-byte sectors.
+ *
+ * @param dev: The device whose logical sector size is set.
+ */
+static void probe_image_sector_size(BLK_Device *dev)
+{
+    static const char signature[8] = { 'E', 'F', 'I', ' ', 'P', 'A', 'R', 'T' };
+    size_t probe_size = 2 * BLK_MAX_SECTOR_SIZE;
+
+    dev->logical_sector_size = BLK_DEFAULT_SECTOR_SIZE;
+
+    if (dev->size_bytes < probe_size)
+    {
+        probe_size = (size_t)align_down(dev->size_bytes, dev->alignment);
+    }
+
+    char *buf = BLK_alloc_buffer(dev, probe_size);
+    if (buf == NULL || BLK_read(dev, 0, buf, probe_size) != 0)
+    {
+        free(buf);
+        return;
+    }
+
+    if (probe_size >= 520 && memcmp(buf + 512, signature, sizeof(signature)) == 0)
+    {
+        dev->logical_sector_size = 512;
+    }
+    else if (probe_size >= 4104 && memcmp(buf + 4096, signature, sizeof(signature)) == 0)
+    {
+        dev->logical_sector_size = 4096;
+    }
+    else if (probe_size >= 512 && is_4kn_mbr(dev, (const uint8_t *)buf))
+    {
+        dev->logical_sector_size = 4096;
+    }
+    else if (dev->size_bytes >= 2 * BLK_MAX_SECTOR_SIZE && dev->size_bytes % BLK_MAX_SECTOR_SIZE == 0 &&
+             BLK_read(dev, dev->size_bytes - BLK_MAX_SECTOR_SIZE, buf, BLK_MAX_SECTOR_SIZE) == 0)
+    {
+        // No primary header: look for the backup header on the last LBA
+        if (memcmp(buf + BLK_MAX_SECTOR_SIZE - 512, signature, sizeof(signature)) != 0 &&
+            memcmp(buf, signature, sizeof(signature)) == 0)
+        {
+            dev->logical_sector_size = 4096;
+        }
+    }
+
+    free(buf);
+}
+
+
+
+
+
+
+/**
+ * Opens a block device or disk image for reading.
+ *
+ * This function performs the following tasks:
+ * 1. Opens the path read-only (read-write with `BLK_FLAG_WRITE`), with O_DIRECT if `BLK_FLAG_DIRECT` is requested
+ *    (falling back to buffered I/O if the file system rejects O_DIRECT).
+ * 2. For block devices, queries the logical/physical sector size and size with
+ *    `BLKSSZGET`, `BLKPBSZGET` and `BLKGETSIZE64`.
+ * 3. For image files, maps the image (unless O_DIRECT or `BLK_FLAG_NO_MMAP` is used),
+ *    attaches the qcow2 or VHD backend if the file is such an image (read-only, so
+ *    `BLK_FLAG_WRITE` fails with EROFS), and probes for a GPT header at 512 and 4096
+ *    bytes, or a 4Kn EBR chain, to find the logical sector size, unless a size was
+ *    forced with `BLK_set_image_sector_size`.
+ * 4. Sets the read alignment: the logical sector size, or the O_DIRECT alignment.
+ *
+ * @param dev: The structure that receives the opened device.
+ * @param path: Path of the device or image file.
+ * @param flags: Combination of `BLK_FLAG_*` values.
+ *
+ * @return 0 on success, or -1 if the path cannot be opened or is an unreadable image
+ *         (errno is set).
+ */
+int BLK_open(BLK_Device *dev, const char *path, int flags)
+{
+    struct stat st;
+    int access_mode = (flags & BLK_FLAG_WRITE) ? O_RDWR : O_RDONLY;
+
+    memset(dev, 0, sizeof(*dev));
+    dev->fd = -1;
+
+    // Open the device, trying O_DIRECT first if requested
+    if (flags & BLK_FLAG_DIRECT)
+    {
+        dev->fd = open(path, access_mode | O_DIRECT);
+        dev->direct = (dev->fd >= 0);
+        dev->stats.syscalls++;
+    }
+    if (dev->fd < 0)
+    {
+        dev->fd = open(path, access_mode);
+        dev->stats.syscalls++;
+    }
+    if (dev->fd < 0)
+    {
+        add_stats(&dev->stats);
+        return -1;
+    }
+
+    dev->stats.syscalls++;
+    if (fstat(dev->fd, &st) != 0)
+    {
+        int saved_errno = errno;
+        close(dev->fd);
+        dev->stats.syscalls++;
+        add_stats(&dev->stats);
+        errno = saved_errno;
+        return -1;
+    }
+
+    dev->is_block_device = S_ISBLK(st.st_mode);
+    dev->logical_sector_size = BLK_DEFAULT_SECTOR_SIZE;
+    dev->physical_sector_size = BLK_DEFAULT_SECTOR_SIZE;
+    dev->size_bytes = (uint64_t)st.st_size;
+    dev->alignment = dev->direct ? BLK_FILE_DIRECT_ALIGNMENT : BLK_DEFAULT_SECTOR_SIZE;
+
+    if (dev->is_block_device)
+    {
+        query_block_device(dev);
+        dev->alignment = dev->logical_sector_size;
+    }
+    else
+    {
+        if (!dev->direct && !(flags & BLK_FLAG_NO_MMAP))
+        {
+            map_image(dev);
+        }
+        if (IMAGE_open(dev) != 0 || (dev->image != NULL && (flags & BLK_FLAG_WRITE)))
+        {
+            int saved_errno = (dev->image != NULL) ? EROFS : errno;
+            BLK_close(dev);
+            errno = saved_errno;
+            return -1;
+        }
+        if (image_sector_size_override != 0)
+        {
+            dev->logical_sector_size = image_sector_size_override;
+        }
+        else
+        {
+            probe_image_sector_size(dev);
+        }
+        dev->physical_sector_size = dev->logical_sector_size;
+        if (!dev->direct)
+        {
+            dev->alignment = dev->logical_sector_size;
+        }
+    }
+
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Forces the logical sector size of the image files opened from now on.
+ *
+ * The probe of `BLK_open` only recognises 4Kn images by their GPT header or their EBR
+ * chain; a 4Kn MBR image without an extended partition reads as 512-byte sectors unless
+ * its size is given. Block devices keep the size reported by the kernel.
+ *
+ * @param size: 512 or 4096, or 0 to probe again.
+ *
+ * @return 0 on success, or -1 if the size is not a supported sector size.
+ */
+int BLK_set_image_sector_size(uint32_t size)
+{
+    if (size != 0 && !is_valid_sector_size(size))
+    {
+        return -1;
+    }
+    image_sector_size_override = size;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Closes a device opened with `BLK_open`.
+ *
+ * The system call counters of the device are added to the process totals.
+ *
+ * @param dev: The device to close.
+ */
+void BLK_close(BLK_Device *dev)
+{
+    if (dev->image != NULL)
+    {
+        IMAGE_close(dev->image); // Closes the image file and counts its system calls
+        dev->image = NULL;
+    }
+
+    if (dev->map != NULL)
+    {
+        munmap((void *)dev->map, dev->map_length);
+        dev->map = NULL;
+        dev->stats.syscalls++;
+    }
+
+    if (dev->fd >= 0)
+    {
+        close(dev->fd);
+        dev->fd = -1;
+        dev->stats.syscalls++;
+    }
+
+    add_stats(&dev->stats);
+    memset(&dev->stats, 0, sizeof(dev->stats));
+}
+
+
+
+
+
+
+/**
+ * Returns the system call counters of every device closed so far.
+ *
+ * Devices are probed on several threads, so the totals are updated atomically when a
+ * device is closed; devices still open are not included.
+ *
+ * @param stats: Receives the totals.
+ */
+void BLK_get_stats(BLK_Stats *stats)
+{
+    stats->syscalls = __atomic_load_n(&total_stats.syscalls, __ATOMIC_RELAXED);
+    stats->reads = __atomic_load_n(&total_stats.reads, __ATOMIC_RELAXED);
+    stats->read_bytes = __atomic_load_n(&total_stats.read_bytes, __ATOMIC_RELAXED);
+    stats->writes = __atomic_load_n(&total_stats.writes, __ATOMIC_RELAXED);
+    stats->write_bytes = __atomic_load_n(&total_stats.write_bytes, __ATOMIC_RELAXED);
+    stats->maps = __atomic_load_n(&total_stats.maps, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,159 @@
+/**
+ *===================================================================================
+ * @file           : Block_IO.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Block_IO (sector-size-aware aligned device/image reads)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _BLOCK_IO_H_
+#define _BLOCK_IO_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stdio.h>      // Provides functions for input and output operations (e.g., perror)
+#include <stddef.h>     // Defines size_t
+#include <inttypes.h>   // Provides integer types with specified widths (e.g., uint32_t, uint64_t)
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Default logical sector size in bytes.
+ *
+ * Used for image files that do not reveal their sector size, and as the size of the
+ * legacy MBR/EBR record, which always occupies the first 512 bytes of its sector.
+ */
+#define BLK_DEFAULT_SECTOR_SIZE     512  // Default logical sector size
+
+/**
+ * Largest logical sector size supported (4Kn drives).
+ */
+#define BLK_MAX_SECTOR_SIZE         4096  // Maximum logical sector size
+
+/**
+ * Alignment used for O_DIRECT on regular files.
+ *
+ * Block devices report their own logical sector size; for image files the required
+ * alignment depends on the underlying filesystem, so the largest common block size is used.
+ */
+#define BLK_FILE_DIRECT_ALIGNMENT   4096  // O_DIRECT alignment for image files
+
+/**
+ * Flag for `BLK_open`: bypass the page cache with O_DIRECT.
+ *
+ * Probing many cold devices with buffered reads pollutes the page cache with sectors
+ * that will never be read again. If the file system does not support O_DIRECT, the
+ * device silently falls back to buffered I/O.
+ */
+#define BLK_FLAG_DIRECT             0x1  // Open with O_DIRECT
+
+/**
+ * Flag for `BLK_open`: never map image files, always read them with `pread`.
+ */
+#define BLK_FLAG_NO_MMAP            0x2  // Disable the mmap image backend
+
+/**
+ * Flag for `BLK_open`: open the device read-write (needed by `BLK_write`).
+ */
+#define BLK_FLAG_WRITE              0x4  // Open read-write
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * System call counters of the block I/O layer.
+ *
+ * Every system call made on a device (open, fstat, ioctl, mmap, madvise, pread, pwrite,
+ * fsync, munmap, close) is counted, so the cost of parsing can be measured without
+ * strace. Reads served from a mapping are not system calls; the page faults they cause
+ * are not counted.
+ *
+ * Fields:
+ *
+ * @param syscalls: Total number of system calls.
+ * @param reads: Number of `pread` calls.
+ * @param read_bytes: Bytes returned by `pread`.
+ * @param writes: Number of `pwrite` calls.
+ * @param write_bytes: Bytes written by `pwrite`.
+ * @param maps: Number of image files mapped.
+ */
+typedef struct {
+    uint64_t syscalls;               /**< All system calls. */
+    uint64_t reads;                  /**< pread calls. */
+    uint64_t read_bytes;             /**< Bytes read. */
+    uint64_t writes;                 /**< pwrite calls. */
+    uint64_t write_bytes;            /**< Bytes written. */
+    uint64_t maps;                   /**< Mapped image files. */
+} BLK_Stats;
+
+/**
+ * Represents an opened block device or disk image.
+ *
+ * Fields:
+ *
+ * @param fd: File descriptor of the opened device or image.
+ * @param logical_sector_size: Size of an LBA in bytes (512 or 4096).
+ * @param physical_sector_size: Size of a physical sector in bytes (>= logical size).
+ * @param size_bytes: Size of the device or image in bytes.
+ * @param alignment: Alignment required for offsets, lengths and buffers of reads.
+ * @param is_block_device: Non-zero if the path is a block device (not an image file).
+ * @param direct: Non-zero if the device was opened with O_DIRECT.
+ * @param map: Read-only mapping of the whole image file, or NULL if not mapped.
+ * @param map_length: Length of the mapping in bytes.
+ * @param image: qcow2 or VHD image the device reads guest sectors from, or NULL for raw
+ *               devices and images (see `IMAGE_open`).
+ * @param stats: System calls made on this device; added to the process totals
+ *               (`BLK_get_stats`) when the device is closed.
+ */
+typedef struct {
+    int fd;                          /**< File descriptor. */
+    uint32_t logical_sector_size;    /**< Logical sector (LBA) size in bytes. */
+    uint32_t physical_sector_size;   /**< Physical sector size in bytes. */
+    uint64_t size_bytes;             /**< Size of the device or image in bytes. */
+    size_t alignment;                /**< Required read alignment in bytes. */
+    int is_block_device;             /**< Block device (1) or image file (0). */
+    int direct;                      /**< Opened with O_DIRECT. */
+    const uint8_t *map;              /**< mmap backend: mapping of the image file. */
+    size_t map_length;               /**< Length of the mapping. */
+    struct IMAGE_Image *image;       /**< Image format backend, NULL if raw. */
+    BLK_Stats stats;                 /**< System call counters. */
+} BLK_Device;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+int BLK_open(BLK_Device *dev, const char *path, int flags);
+void BLK_close(BLK_Device *dev);
+int BLK_set_image_sector_size(uint32_t size);
+void *BLK_alloc_buffer(const BLK_Device *dev, size_t length);
+int BLK_read(BLK_Device *dev, uint64_t offset, void *buf, size_t length);
+int BLK_read_sectors(BLK_Device *dev, uint64_t lba, uint64_t count, void *buf);
+const void *BLK_get(BLK_Device *dev, uint64_t offset, size_t length, void *scratch);
+int BLK_write(BLK_Device *dev, uint64_t offset, const void *buf, size_t length);
+int BLK_write_span(BLK_Device *dev, uint64_t offset, const void *data, size_t length);
+int BLK_sync(BLK_Device *dev);
+int BLK_reread_partitions(BLK_Device *dev);
+void BLK_get_stats(BLK_Stats *stats);
+
+#endif
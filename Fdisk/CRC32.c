@@ -0,0 +1,147 @@
+/**
+ *===================================================================================
+ * @file           : CRC32.c
+ * @author         : Ali Mamdouh
+ * @brief          : slice-by-8 CRC32 used to validate GPT structures
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "CRC32.h"    // Includes the CRC32 API and configuration macros
+#include <string.h>   // Provides memcpy for unaligned 64-bit loads
+
+
+
+
+
+/*============================================================================
+ **********************  Global Variables Declerations  **********************
+ ============================================================================*/
+/**
+ * Slice-by-8 lookup tables.
+ *
+ * Table 0 is the classic byte-wise CRC table; table k holds the CRC of a byte followed
+ * by k zero bytes, so eight table lookups advance the CRC over eight input bytes at once.
+ */
+static uint32_t crc32_tables[CRC32_SLICES][256];
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Builds the slice-by-8 lookup tables.
+ *
+ * This function runs once before main (GCC constructor attribute), so the tables are
+ * ready and read-only by the time any parsing code (possibly multi-threaded) runs.
+ */
+__attribute__((constructor))
+static void crc32_build_tables(void)
+{
+    // Build the classic byte-wise table
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32_POLYNOMIAL : 0);
+        }
+        crc32_tables[0][i] = crc;
+    }
+
+    // Each next table extends the previous one by one zero byte
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        for (int slice = 1; slice < CRC32_SLICES; slice++)
+        {
+            uint32_t prev = crc32_tables[slice - 1][i];
+            crc32_tables[slice][i] = (prev >> 8) ^ crc32_tables[0][prev & 0xFF];
+        }
+    }
+}
+
+
+
+
+
+
+/**
+ * Continues a CRC32 computation over an additional block of data.
+ *
+ * The CRC value passed in and returned is the final (post-inverted) form, so a
+ * computation can be split across several calls, starting from 0:
+ *   crc = CRC32_update(0, part1, len1);
+ *   crc = CRC32_update(crc, part2, len2);
+ *
+ * The main loop consumes 8 bytes per iteration using the slice-by-8 tables; the tail
+ * (fewer than 8 bytes) is processed byte by byte.
+ *
+ * @param crc: CRC of the data processed so far (0 for a new computation).
+ * @param data: Pointer to the data block.
+ * @param length: Number of bytes in the data block.
+ *
+ * @return The updated CRC32 value.
+ */
+uint32_t CRC32_update(uint32_t crc, const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    crc = ~crc;
+
+    // Process 8 bytes per iteration (GPT structures are little-endian, as is x86)
+    while (length >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word)); // Unaligned-safe load
+        word ^= crc;
+
+        crc = crc32_tables[7][ word        & 0xFF] ^
+              crc32_tables[6][(word >>  8) & 0xFF] ^
+              crc32_tables[5][(word >> 16) & 0xFF] ^
+              crc32_tables[4][(word >> 24) & 0xFF] ^
+              crc32_tables[3][(word >> 32) & 0xFF] ^
+              crc32_tables[2][(word >> 40) & 0xFF] ^
+              crc32_tables[1][(word >> 48) & 0xFF] ^
+              crc32_tables[0][(word >> 56) & 0xFF];
+
+        bytes  += 8;
+        length -= 8;
+    }
+
+    // Process the remaining tail byte by byte
+    while (length--)
+    {
+        crc = (crc >> 8) ^ crc32_tables[0][(crc ^ *bytes++) & 0xFF];
+    }
+
+    return ~crc;
+}
+
+
+
+
+
+
+/**
+ * Computes the CRC32 of a block of data.
+ *
+ * @param data: Pointer to the data block.
+ * @param length: Number of bytes in the data block.
+ *
+ * @return The CRC32 value of the data.
+ */
+uint32_t CRC32_compute(const void *data, size_t length)
+{
+    return CRC32_update(0, data, length);
+}
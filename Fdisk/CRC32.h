@@ -0,0 +1,58 @@
+/**
+ *===================================================================================
+ * @file           : CRC32.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of CRC32 (used to validate GPT header and entry array)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _CRC32_H_
+#define _CRC32_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stddef.h>    // Defines size_t
+#include <inttypes.h>  // Provides integer types with specified widths (e.g., uint32_t, uint64_t)
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Reflected form of the CRC-32 polynomial (IEEE 802.3).
+ *
+ * The UEFI specification uses this polynomial for both the GPT header CRC and the
+ * partition entry array CRC, with an initial value and final XOR of 0xFFFFFFFF.
+ */
+#define CRC32_POLYNOMIAL            0xEDB88320U  // Reflected CRC-32 polynomial
+
+/**
+ * Number of lookup tables used by the slice-by-8 algorithm.
+ *
+ * Slice-by-8 consumes 8 input bytes per iteration, using one 256-entry table per byte,
+ * which removes the byte-by-byte dependency chain of the classic table-driven CRC.
+ */
+#define CRC32_SLICES                8  // Number of slice tables
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+uint32_t CRC32_compute(const void *data, size_t length);
+uint32_t CRC32_update(uint32_t crc, const void *data, size_t length);
+
+#endif
@@ -0,0 +1,909 @@
+/**
+ *===================================================================================
+ * @file           : Content_Scan.c
+ * @author         : Ali Mamdouh
+ * @brief          : source file to stream partitions once through content analysers
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Content_Scan.h" // Includes the scan configuration macros, analyser type and API
+#include <stdlib.h>       // Provides calloc and free
+#include <string.h>       // Provides memcpy, memset and strerror
+#include <errno.h>        // Provides errno for error reporting
+#include <math.h>         // Provides log2 for the entropy
+#include <time.h>         // Provides clock_gettime
+#include <unistd.h>       // Provides sysconf
+#include <pthread.h>      // Provides the reader and analysis threads
+#ifdef __SSE2__
+#include <emmintrin.h>    // Provides the SSE2 intrinsics of the zero detection
+#endif
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+#define XXH_PRIME64_1               0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2               0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3               0x165667B19E3779F9ULL
+#define XXH_PRIME64_4               0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5               0x27D4EB2F165667C5ULL
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Zero detection: all-zero blocks of `CONTENT_ZERO_BLOCK` bytes (chunk state and total).
+ */
+typedef struct {
+    uint64_t blocks;           /**< Blocks seen. */
+    uint64_t zero_blocks;      /**< Blocks holding only zeros. */
+} zero_state;
+
+/**
+ * Entropy of one chunk: its byte histogram and whether it looks encrypted or compressed.
+ */
+typedef struct {
+    uint64_t histogram[256];   /**< Occurrences of every byte value. */
+    int high_entropy;          /**< Chunk entropy above `CONTENT_HIGH_ENTROPY`. */
+} entropy_chunk;
+
+/**
+ * Entropy of a partition.
+ */
+typedef struct {
+    uint64_t histogram[256];   /**< Occurrences of every byte value. */
+    uint64_t chunks;           /**< Chunks seen. */
+    uint64_t high_chunks;      /**< Chunks above `CONTENT_HIGH_ENTROPY`. */
+} entropy_total;
+
+/**
+ * Streaming XXH64 state (seed 0).
+ */
+typedef struct {
+    uint64_t length;           /**< Bytes hashed so far. */
+    uint64_t v[4];             /**< Accumulators of the 32-byte stripes. */
+    uint8_t buffer[32];        /**< Bytes of an incomplete stripe. */
+    size_t buffered;           /**< Bytes in `buffer`. */
+} xxh64_state;
+
+/**
+ * One read buffer of the ring shared by the reader and the analysis threads.
+ */
+typedef struct {
+    uint8_t *data;             /**< Aligned buffer of `CONTENT_READ_SIZE` bytes. */
+    size_t length;             /**< Bytes of the chunk it holds. */
+    int analysed;              /**< Every analyser has processed the chunk. */
+    void **states;             /**< Chunk state of every analyser. */
+} content_slot;
+
+/**
+ * State of the scan of one partition.
+ */
+typedef struct {
+    BLK_Device *dev;           /**< The device (only the reader thread reads it). */
+    uint64_t base;             /**< Byte offset of the partition. */
+    uint64_t length;           /**< Bytes to scan. */
+    content_slot *slots;       /**< Ring of read buffers. */
+    size_t slot_count;         /**< Number of buffers (twice the analysis threads). */
+    void **totals;             /**< Partition total of every analyser. */
+    pthread_mutex_t lock;      /**< Protects the counters and the `analysed` flags. */
+    pthread_cond_t filled_cond;   /**< Signaled when a chunk was read or the scan ends. */
+    pthread_cond_t analysed_cond; /**< Signaled when a chunk was analysed. */
+    uint64_t filled;           /**< Chunks read so far. */
+    uint64_t taken;            /**< Chunks handed to analysis threads. */
+    int finished;              /**< No more chunks will be read. */
+} content_scan;
+
+
+
+
+
+/*============================================================================
+ **************************  Functions Prototypes  ***************************
+ ============================================================================*/
+static void zero_analyse(void *chunk, const uint8_t *data, size_t length);
+static void zero_merge(void *total, const void *chunk, const uint8_t *data, size_t length);
+static void zero_print(FILE *out, const void *total);
+static void entropy_analyse(void *chunk, const uint8_t *data, size_t length);
+static void entropy_merge(void *total, const void *chunk, const uint8_t *data, size_t length);
+static void entropy_print(FILE *out, const void *total);
+static void digest_begin(void *total);
+static void digest_merge(void *total, const void *chunk, const uint8_t *data, size_t length);
+static void digest_print(FILE *out, const void *total);
+
+
+
+
+
+/*============================================================================
+ **********************  Global Variables Decleration  ***********************
+ ============================================================================*/
+/**
+ * Analysers every chunk is fed to, in column order.
+ */
+static const CONTENT_Analyser analysers[] =
+{
+    { " Zero(%)  Used(MB)  ", sizeof(zero_state), sizeof(zero_state), NULL, zero_analyse, zero_merge, zero_print },
+    { " Entropy  Random(%) ", sizeof(entropy_chunk), sizeof(entropy_total), NULL, entropy_analyse, entropy_merge, entropy_print },
+    { " XXH64",               0, sizeof(xxh64_state), digest_begin, NULL, digest_merge, digest_print },
+};
+
+#define ANALYSER_COUNT              (sizeof(analysers) / sizeof(analysers[0]))
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Returns the monotonic time in nanoseconds.
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+
+/**
+ * Reads a little-endian 64-bit value from an unaligned address.
+ */
+static uint64_t read_le64(const uint8_t *p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value; // x86 and arm64 Linux are little-endian
+}
+
+
+
+/**
+ * Reads a little-endian 32-bit value from an unaligned address.
+ */
+static uint32_t read_le32(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+
+
+/**
+ * Rotates a 64-bit value left.
+ */
+static uint64_t rotl64(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+
+
+
+
+
+/**
+ * Checks whether a block holds only zeros.
+ *
+ * With SSE2 the block is OR-ed together 64 bytes per iteration in four 16-byte lanes,
+ * and the accumulator is tested every 256 bytes, so data blocks are rejected early.
+ */
+static int is_zero_block(const uint8_t *data, size_t length)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    while (i + 256 <= length)
+    {
+        __m128i acc = zero;
+        for (size_t end = i + 256; i < end; i += 64)
+        {
+            acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i *)(data + i)));
+            acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i *)(data + i + 16)));
+            acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i *)(data + i + 32)));
+            acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i *)(data + i + 48)));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, zero)) != 0xFFFF)
+        {
+            return 0;
+        }
+    }
+#endif
+
+    uint64_t acc = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        acc |= read_le64(data + i);
+    }
+    for (; i < length; i++)
+    {
+        acc |= data[i];
+    }
+    return acc == 0;
+}
+
+
+
+
+
+
+/**
+ * Zero detection: counts the all-zero blocks of a chunk.
+ */
+static void zero_analyse(void *chunk, const uint8_t *data, size_t length)
+{
+    zero_state *state = chunk;
+
+    state->blocks = 0;
+    state->zero_blocks = 0;
+    for (size_t offset = 0; offset < length; offset += CONTENT_ZERO_BLOCK)
+    {
+        size_t block = (length - offset < CONTENT_ZERO_BLOCK) ? length - offset : CONTENT_ZERO_BLOCK;
+        state->blocks++;
+        state->zero_blocks += (uint64_t)is_zero_block(data + offset, block);
+    }
+}
+
+
+
+static void zero_merge(void *total, const void *chunk, const uint8_t *data, size_t length)
+{
+    zero_state *sum = total;
+    const zero_state *state = chunk;
+
+    (void)data;
+    (void)length;
+    sum->blocks += state->blocks;
+    sum->zero_blocks += state->zero_blocks;
+}
+
+
+
+/**
+ * Prints the share of zero blocks and the space a thin-provisioned copy would allocate.
+ */
+static void zero_print(FILE *out, const void *total)
+{
+    const zero_state *sum = total;
+    double percent = sum->blocks ? 100.0 * (double)sum->zero_blocks / (double)sum->blocks : 0.0;
+
+    fprintf(out, " %-8.1f %-9.0f", percent, (double)(sum->blocks - sum->zero_blocks) * CONTENT_ZERO_BLOCK / 1e6);
+}
+
+
+
+
+
+
+/**
+ * Returns the Shannon entropy of a byte histogram in bits per byte (0 to 8).
+ */
+static double histogram_entropy(const uint64_t *histogram)
+{
+    uint64_t count = 0;
+    double entropy = 0.0;
+
+    for (int i = 0; i < 256; i++)
+    {
+        count += histogram[i];
+    }
+    for (int i = 0; i < 256 && count != 0; i++)
+    {
+        if (histogram[i] != 0)
+        {
+            double p = (double)histogram[i] / (double)count;
+            entropy -= p * log2(p);
+        }
+    }
+    return entropy;
+}
+
+
+
+/**
+ * Entropy: builds the byte histogram of a chunk.
+ *
+ * Four histograms are updated in turn, so consecutive equal bytes (zero runs, padding)
+ * do not serialize on the same counter.
+ */
+static void entropy_analyse(void *chunk, const uint8_t *data, size_t length)
+{
+    entropy_chunk *state = chunk;
+    uint32_t counts[4][256];
+    size_t i = 0;
+
+    memset(counts, 0, sizeof(counts));
+    for (; i + 4 <= length; i += 4)
+    {
+        counts[0][data[i]]++;
+        counts[1][data[i + 1]]++;
+        counts[2][data[i + 2]]++;
+        counts[3][data[i + 3]]++;
+    }
+    for (; i < length; i++)
+    {
+        counts[0][data[i]]++;
+    }
+
+    for (int b = 0; b < 256; b++)
+    {
+        state->histogram[b] = (uint64_t)counts[0][b] + counts[1][b] + counts[2][b] + counts[3][b];
+    }
+    state->high_entropy = histogram_entropy(state->histogram) > CONTENT_HIGH_ENTROPY;
+}
+
+
+
+static void entropy_merge(void *total, const void *chunk, const uint8_t *data, size_t length)
+{
+    entropy_total *sum = total;
+    const entropy_chunk *state = chunk;
+
+    (void)data;
+    (void)length;
+    for (int b = 0; b < 256; b++)
+    {
+        sum->histogram[b] += state->histogram[b];
+    }
+    sum->chunks++;
+    sum->high_chunks += (uint64_t)state->high_entropy;
+}
+
+
+
+/**
+ * Prints the entropy of the whole partition and the share of chunks that look encrypted
+ * or compressed.
+ */
+static void entropy_print(FILE *out, const void *total)
+{
+    const entropy_total *sum = total;
+    double percent = sum->chunks ? 100.0 * (double)sum->high_chunks / (double)sum->chunks : 0.0;
+
+    fprintf(out, " %-8.3f %-10.1f", histogram_entropy(sum->histogram), percent);
+}
+
+
+
+
+
+
+/**
+ * XXH64 round: mixes one 8-byte lane into an accumulator.
+ */
+static uint64_t xxh64_round(uint64_t acc, uint64_t lane)
+{
+    acc += lane * XXH_PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+
+
+/**
+ * XXH64 merge round: folds an accumulator into the hash.
+ */
+static uint64_t xxh64_merge_round(uint64_t hash, uint64_t acc)
+{
+    hash ^= xxh64_round(0, acc);
+    return hash * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+
+
+/**
+ * Digest: initializes a seed 0 XXH64 state.
+ */
+static void digest_begin(void *total)
+{
+    xxh64_state *state = total;
+
+    state->v[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+    state->v[1] = XXH_PRIME64_2;
+    state->v[2] = 0;
+    state->v[3] = 0 - XXH_PRIME64_1;
+}
+
+
+
+/**
+ * Digest: hashes a chunk. XXH64 is sequential, so it runs on the reader thread in
+ * partition order, overlapped with the reads and the other analysers; the result is
+ * the plain XXH64 of the partition (`xxhsum -H1`).
+ */
+static void digest_merge(void *total, const void *chunk, const uint8_t *data, size_t length)
+{
+    xxh64_state *state = total;
+    size_t i = 0;
+
+    (void)chunk;
+    state->length += length;
+
+    // Complete a stripe left over from the previous chunk
+    if (state->buffered != 0)
+    {
+        size_t needed = sizeof(state->buffer) - state->buffered;
+        size_t copy = (length < needed) ? length : needed;
+        memcpy(state->buffer + state->buffered, data, copy);
+        state->buffered += copy;
+        i = copy;
+        if (state->buffered < sizeof(state->buffer))
+        {
+            return;
+        }
+        for (int lane = 0; lane < 4; lane++)
+        {
+            state->v[lane] = xxh64_round(state->v[lane], read_le64(state->buffer + lane * 8));
+        }
+        state->buffered = 0;
+    }
+
+    uint64_t v0 = state->v[0], v1 = state->v[1], v2 = state->v[2], v3 = state->v[3];
+    for (; i + 32 <= length; i += 32)
+    {
+        v0 = xxh64_round(v0, read_le64(data + i));
+        v1 = xxh64_round(v1, read_le64(data + i + 8));
+        v2 = xxh64_round(v2, read_le64(data + i + 16));
+        v3 = xxh64_round(v3, read_le64(data + i + 24));
+    }
+    state->v[0] = v0;
+    state->v[1] = v1;
+    state->v[2] = v2;
+    state->v[3] = v3;
+
+    memcpy(state->buffer, data + i, length - i);
+    state->buffered = length - i;
+}
+
+
+
+/**
+ * Digest: finalizes and prints the XXH64 of the partition.
+ */
+static void digest_print(FILE *out, const void *total)
+{
+    const xxh64_state *state = total;
+    uint64_t hash;
+    size_t i = 0;
+
+    if (state->length >= 32)
+    {
+        hash = rotl64(state->v[0], 1) + rotl64(state->v[1], 7) + rotl64(state->v[2], 12) + rotl64(state->v[3], 18);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            hash = xxh64_merge_round(hash, state->v[lane]);
+        }
+    }
+    else
+    {
+        hash = XXH_PRIME64_5;
+    }
+    hash += state->length;
+
+    for (; i + 8 <= state->buffered; i += 8)
+    {
+        hash ^= xxh64_round(0, read_le64(state->buffer + i));
+        hash = rotl64(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (i + 4 <= state->buffered)
+    {
+        hash ^= (uint64_t)read_le32(state->buffer + i) * XXH_PRIME64_1;
+        hash = rotl64(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        i += 4;
+    }
+    for (; i < state->buffered; i++)
+    {
+        hash ^= state->buffer[i] * XXH_PRIME64_5;
+        hash = rotl64(hash, 11) * XXH_PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+
+    fprintf(out, " %016" PRIx64, hash);
+}
+
+
+
+
+
+
+/**
+ * Thread body of an analysis thread.
+ *
+ * Takes the chunks in the order they were read, runs every analyser on them and marks
+ * them analysed, until the reader has finished and every chunk read has been taken.
+ */
+static void *analysis_worker(void *arg)
+{
+    content_scan *scan = arg;
+
+    pthread_mutex_lock(&scan->lock);
+    for (;;)
+    {
+        while (scan->taken == scan->filled && !scan->finished)
+        {
+            pthread_cond_wait(&scan->filled_cond, &scan->lock);
+        }
+        if (scan->taken == scan->filled)
+        {
+            break; // Finished and nothing left
+        }
+        content_slot *slot = &scan->slots[scan->taken % scan->slot_count];
+        scan->taken++;
+        pthread_mutex_unlock(&scan->lock);
+
+        for (size_t a = 0; a < ANALYSER_COUNT; a++)
+        {
+            if (analysers[a].analyse != NULL)
+            {
+                analysers[a].analyse(slot->states[a], slot->data, slot->length);
+            }
+        }
+
+        pthread_mutex_lock(&scan->lock);
+        slot->analysed = 1;
+        pthread_cond_signal(&scan->analysed_cond);
+    }
+    pthread_mutex_unlock(&scan->lock);
+    return NULL;
+}
+
+
+
+
+
+
+/**
+ * Waits until a chunk has been analysed, then merges it into the partition totals.
+ *
+ * Called by the reader thread before it reuses the buffer, so chunks are merged in
+ * partition order even though they are analysed in parallel.
+ */
+static void merge_slot(content_scan *scan, content_slot *slot)
+{
+    pthread_mutex_lock(&scan->lock);
+    while (!slot->analysed)
+    {
+        pthread_cond_wait(&scan->analysed_cond, &scan->lock);
+    }
+    slot->analysed = 0;
+    pthread_mutex_unlock(&scan->lock);
+
+    for (size_t a = 0; a < ANALYSER_COUNT; a++)
+    {
+        if (analysers[a].merge != NULL)
+        {
+            analysers[a].merge(scan->totals[a], slot->states[a], slot->data, slot->length);
+        }
+    }
+}
+
+
+
+
+
+
+/**
+ * Streams one partition through the analysers.
+ *
+ * The calling thread is the reader: it fills the ring of buffers with consecutive
+ * chunks, and before refilling a buffer it waits for its previous chunk to be analysed
+ * and merges it. The analysis threads work on the other buffers in the meantime, so the
+ * device always has a read in flight while the CPUs analyse the chunks already read.
+ *
+ * @return 0 on success, or -1 on read error (errno is set).
+ */
+static int scan_range(content_scan *scan, unsigned int workers)
+{
+    pthread_t threads[CONTENT_MAX_WORKERS];
+    unsigned int started = 0;
+    uint64_t chunks = (scan->length + CONTENT_READ_SIZE - 1) / CONTENT_READ_SIZE;
+    uint64_t merged = 0;
+    int error = 0;
+
+    scan->filled = 0;
+    scan->taken = 0;
+    scan->finished = 0;
+    for (unsigned int i = 0; i < workers; i++)
+    {
+        if (pthread_create(&threads[started], NULL, analysis_worker, scan) == 0)
+        {
+            started++;
+        }
+    }
+    if (started == 0)
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    for (uint64_t chunk = 0; chunk < chunks; chunk++)
+    {
+        content_slot *slot = &scan->slots[chunk % scan->slot_count];
+        if (chunk >= scan->slot_count)
+        {
+            merge_slot(scan, slot);
+            merged++;
+        }
+
+        uint64_t offset = chunk * CONTENT_READ_SIZE;
+        slot->length = (scan->length - offset < CONTENT_READ_SIZE) ? (size_t)(scan->length - offset) : CONTENT_READ_SIZE;
+        if (BLK_read(scan->dev, scan->base + offset, slot->data, slot->length) != 0)
+        {
+            error = errno;
+            break;
+        }
+
+        pthread_mutex_lock(&scan->lock);
+        scan->filled++;
+        pthread_cond_signal(&scan->filled_cond);
+        pthread_mutex_unlock(&scan->lock);
+    }
+
+    pthread_mutex_lock(&scan->lock);
+    scan->finished = 1;
+    pthread_cond_broadcast(&scan->filled_cond);
+    pthread_mutex_unlock(&scan->lock);
+
+    // Merge the chunks still in the ring, oldest first
+    for (; merged < scan->filled; merged++)
+    {
+        merge_slot(scan, &scan->slots[merged % scan->slot_count]);
+    }
+
+    for (unsigned int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (error != 0)
+    {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Allocates the ring of buffers, the chunk states and the partition totals of a scan.
+ *
+ * @return 0 on success, or -1 on allocation failure.
+ */
+static int alloc_scan(content_scan *scan, BLK_Device *dev, size_t slot_count)
+{
+    memset(scan, 0, sizeof(*scan));
+    scan->dev = dev;
+    scan->slot_count = slot_count;
+    scan->slots = calloc(slot_count, sizeof(content_slot));
+    scan->totals = calloc(ANALYSER_COUNT, sizeof(void *));
+    if (scan->slots == NULL || scan->totals == NULL)
+    {
+        return -1;
+    }
+
+    for (size_t a = 0; a < ANALYSER_COUNT; a++)
+    {
+        scan->totals[a] = calloc(1, analysers[a].total_state_size ? analysers[a].total_state_size : 1);
+        if (scan->totals[a] == NULL)
+        {
+            return -1;
+        }
+    }
+
+    for (size_t s = 0; s < slot_count; s++)
+    {
+        content_slot *slot = &scan->slots[s];
+        slot->data = BLK_alloc_buffer(dev, CONTENT_READ_SIZE);
+        slot->states = calloc(ANALYSER_COUNT, sizeof(void *));
+        if (slot->data == NULL || slot->states == NULL)
+        {
+            return -1;
+        }
+        for (size_t a = 0; a < ANALYSER_COUNT; a++)
+        {
+            slot->states[a] = calloc(1, analysers[a].chunk_state_size ? analysers[a].chunk_state_size : 1);
+            if (slot->states[a] == NULL)
+            {
+                return -1;
+            }
+        }
+    }
+
+    pthread_mutex_init(&scan->lock, NULL);
+    pthread_cond_init(&scan->filled_cond, NULL);
+    pthread_cond_init(&scan->analysed_cond, NULL);
+    return 0;
+}
+
+
+
+/**
+ * Frees what `alloc_scan` allocated (also after a partial allocation).
+ */
+static void free_scan(content_scan *scan, int initialized)
+{
+    for (size_t s = 0; scan->slots != NULL && s < scan->slot_count; s++)
+    {
+        for (size_t a = 0; scan->slots[s].states != NULL && a < ANALYSER_COUNT; a++)
+        {
+            free(scan->slots[s].states[a]);
+        }
+        free(scan->slots[s].states);
+        free(scan->slots[s].data);
+    }
+    for (size_t a = 0; scan->totals != NULL && a < ANALYSER_COUNT; a++)
+    {
+        free(scan->totals[a]);
+    }
+    free(scan->slots);
+    free(scan->totals);
+
+    if (initialized)
+    {
+        pthread_mutex_destroy(&scan->lock);
+        pthread_cond_destroy(&scan->filled_cond);
+        pthread_cond_destroy(&scan->analysed_cond);
+    }
+}
+
+
+
+
+
+
+/**
+ * Scans and prints one partition.
+ *
+ * @return 0 on success, or -1 on read error (a message is printed).
+ */
+static int scan_partition(FILE *out, content_scan *scan, unsigned int workers, const char *device, const PARSE_Partition *partition)
+{
+    BLK_Device *dev = scan->dev;
+    uint64_t base = partition->start * dev->logical_sector_size;
+    uint64_t length = partition->count * dev->logical_sector_size;
+
+    // Only scan what exists: the table may describe more than the device holds
+    if (base >= dev->size_bytes)
+    {
+        fprintf(out, "%-16s%-6d beyond the end of the device, skipped\n", device, partition->index);
+        return 0;
+    }
+    if (length > dev->size_bytes - base)
+    {
+        length = dev->size_bytes - base;
+    }
+
+    for (size_t a = 0; a < ANALYSER_COUNT; a++)
+    {
+        memset(scan->totals[a], 0, analysers[a].total_state_size);
+        if (analysers[a].begin != NULL)
+        {
+            analysers[a].begin(scan->totals[a]);
+        }
+    }
+    scan->base = base;
+    scan->length = length;
+
+    uint64_t start = now_ns();
+    if (scan_range(scan, workers) != 0)
+    {
+        fprintf(out, "%-16s%-6d read error: %s\n", device, partition->index, strerror(errno));
+        return -1;
+    }
+    double seconds = (double)(now_ns() - start) / 1e9;
+
+    fprintf(out, "%-16s%-6d %-10.0f %-8.0f", device, partition->index, (double)length / 1e6,
+            seconds > 0 ? (double)length / 1e6 / seconds : 0.0);
+    for (size_t a = 0; a < ANALYSER_COUNT; a++)
+    {
+        analysers[a].print(out, scan->totals[a]);
+    }
+    fprintf(out, "\n");
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Reads every partition of a device once and prints its content analysis (`--scan`).
+ *
+ * This function performs the following tasks:
+ * 1. Opens the device read-only with O_DIRECT, so streaming whole partitions does not
+ *    evict the page cache; nothing is ever written.
+ * 2. Starts one analysis thread per online CPU but one (the reader), up to
+ *    `CONTENT_MAX_WORKERS`, and allocates two `CONTENT_READ_SIZE` buffers per thread.
+ * 3. For every partition (extended containers excluded), streams the partition through
+ *    the buffers and feeds every chunk to all analysers: all-zero block detection
+ *    (thin-provisioning estimate), byte entropy (encrypted or compressed regions) and
+ *    the XXH64 digest.
+ *
+ * @param out: Stream the results are printed to.
+ * @param device: Path of the device or image file.
+ * @param table: The partition descriptors.
+ *
+ * @return 0 on success, or -1 if the device cannot be opened or a read fails.
+ */
+int CONTENT_print_report(FILE *out, const char *device, const PARSE_Table *table)
+{
+    BLK_Device dev;
+    content_scan scan;
+
+    if (BLK_open(&dev, device, BLK_FLAG_DIRECT | BLK_FLAG_NO_MMAP) != 0)
+    {
+        fprintf(out, "\nFailed to open %s for the content scan: %s\n", device, strerror(errno));
+        return -1;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int workers = (cpus > 1) ? (unsigned int)(cpus - 1) : 1;
+    if (workers > CONTENT_MAX_WORKERS)
+    {
+        workers = CONTENT_MAX_WORKERS;
+    }
+
+    if (alloc_scan(&scan, &dev, 2 * (size_t)workers) != 0)
+    {
+        fprintf(out, "\nFailed to allocate the content scan buffers of %s\n", device);
+        free_scan(&scan, 0);
+        BLK_close(&dev);
+        return -1;
+    }
+
+    fprintf(out, "\nContent scan %s (%s): %d KiB reads, %u analysis threads, zero blocks of %d bytes\n",
+            device, dev.direct ? "O_DIRECT" : "buffered", CONTENT_READ_SIZE / 1024, workers, CONTENT_ZERO_BLOCK);
+    fprintf(out, "%-16s%-6s %-10s %-8s", "Device", "Index", "Size(MB)", "MB/s");
+    for (size_t a = 0; a < ANALYSER_COUNT; a++)
+    {
+        fprintf(out, "%s", analysers[a].header);
+    }
+    fprintf(out, "\n");
+
+    int status = 0;
+    for (size_t i = 0; i < table->count && status == 0; i++)
+    {
+        const PARSE_Partition *partition = &table->partitions[i];
+        if (partition->origin == PARSE_ORIGIN_EXTENDED || partition->count == 0)
+        {
+            continue;
+        }
+        status = scan_partition(out, &scan, workers, device, partition);
+    }
+
+    free_scan(&scan, 1);
+    BLK_close(&dev);
+    return status;
+}
@@ -0,0 +1,102 @@
+/**
+ *===================================================================================
+ * @file           : Content_Scan.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Content_Scan (one-pass partition content analysis)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _CONTENT_SCAN_H_
+#define _CONTENT_SCAN_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stdio.h>            // Provides FILE
+#include "Block_IO.h"         // Provides aligned O_DIRECT reads
+#include "Partition_Parse.h"  // Provides the partition descriptors to scan
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Size of each read in bytes (one chunk of a partition).
+ *
+ * Large sequential reads keep the device streaming; every chunk is analysed as a unit.
+ */
+#define CONTENT_READ_SIZE           (4 * 1024 * 1024)  // 4 MiB
+
+/**
+ * Largest number of analysis threads per scan.
+ *
+ * Two read buffers are allocated per thread (double buffering), so the reader thread
+ * always has a free buffer to fill while every thread analyses another one.
+ */
+#define CONTENT_MAX_WORKERS         8
+
+/**
+ * Granularity of the all-zero detection in bytes (file system block, thin-provisioning unit).
+ */
+#define CONTENT_ZERO_BLOCK          4096
+
+/**
+ * Entropy in bits per byte above which a chunk is counted as encrypted or compressed.
+ */
+#define CONTENT_HIGH_ENTROPY        7.9
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Describes an analyser fed with every chunk of a partition.
+ *
+ * `analyse` runs on the worker threads, on chunks in any order, and stores its result
+ * in a per-chunk state. `merge` runs on the reader thread, once per chunk in partition
+ * order, and folds the chunk state (and, for order-dependent analysers such as digests,
+ * the chunk data) into the partition total. Either may be NULL.
+ *
+ * Fields:
+ *
+ * @param header: Column titles printed above the results.
+ * @param chunk_state_size: Size of the per-chunk state in bytes.
+ * @param total_state_size: Size of the partition total in bytes (zeroed before the scan).
+ * @param begin: Initializes the partition total (after zeroing), or NULL.
+ * @param analyse: Analyses one chunk into a chunk state (cleared by the function).
+ * @param merge: Folds a chunk into the partition total, in partition order.
+ * @param print: Prints the columns of a partition total.
+ */
+typedef struct {
+    const char *header;                                                           /**< Column titles. */
+    size_t chunk_state_size;                                                      /**< Per-chunk state size. */
+    size_t total_state_size;                                                      /**< Partition total size. */
+    void (*begin)(void *total);                                                   /**< Initialize the total. */
+    void (*analyse)(void *chunk, const uint8_t *data, size_t length);             /**< Any thread, any order. */
+    void (*merge)(void *total, const void *chunk, const uint8_t *data, size_t length); /**< Partition order. */
+    void (*print)(FILE *out, const void *total);                                  /**< Print the result. */
+} CONTENT_Analyser;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+int CONTENT_print_report(FILE *out, const char *device, const PARSE_Table *table);
+
+#endif
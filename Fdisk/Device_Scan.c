@@ -0,0 +1,424 @@
+/**
+ *===================================================================================
+ * @file           : Device_Scan.c
+ * @author         : Ali Mamdouh
+ * @brief          : enumerate block devices and probe many devices on a thread pool
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#define _GNU_SOURCE       // Required for versionsort (natural ordering of sda2 < sda10)
+#include "Device_Scan.h"  // Includes the device scan API and configuration macros
+#include <stdlib.h>       // Provides malloc, realloc, free
+#include <string.h>       // Provides strdup, strcmp
+#include <dirent.h>       // Provides scandir and versionsort
+#include <unistd.h>       // Provides access
+#include <pthread.h>      // Provides threads, mutexes and condition variables
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Holds the buffered output of one probed device until it is its turn to be printed.
+ */
+typedef struct {
+    char *text;      /**< Output produced by the probe (heap allocated by open_memstream). */
+    size_t length;   /**< Length of the output in bytes. */
+    int status;      /**< Return value of the probe function. */
+    int done;        /**< Set once the probe has finished. */
+} scan_result;
+
+/**
+ * State shared between the printing thread and the worker threads.
+ */
+typedef struct {
+    const SCAN_DeviceList *list;   /**< Devices to probe. */
+    SCAN_ProbeFunction probe;      /**< Probe callback. */
+    scan_result *results;          /**< One result slot per device, in list order. */
+    size_t next;                   /**< Index of the next device to hand out. */
+    pthread_mutex_t lock;          /**< Protects `next` and the `done` flags. */
+    pthread_cond_t finished;       /**< Signalled whenever a device finishes. */
+} scan_context;
+
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Appends a device path to a device list, growing the list as needed.
+ *
+ * @param list: The list to append to (zero-initialized for a new list).
+ * @param path: The device path; it is copied.
+ *
+ * @return 0 on success, or -1 on allocation failure.
+ */
+int SCAN_add_device(SCAN_DeviceList *list, const char *path)
+{
+    if (list->count == list->capacity)
+    {
+        size_t new_capacity = list->capacity ? list->capacity * 2 : 16;
+        char **paths = realloc(list->paths, new_capacity * sizeof(char *));
+        if (paths == NULL)
+        {
+            perror("Failed to grow device list");
+            return -1;
+        }
+        list->paths = paths;
+        list->capacity = new_capacity;
+    }
+
+    list->paths[list->count] = strdup(path);
+    if (list->paths[list->count] == NULL)
+    {
+        perror("Failed to store device path");
+        return -1;
+    }
+
+    list->count++;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Frees every path stored in a device list and resets it.
+ *
+ * @param list: The list to free.
+ */
+void SCAN_free_device_list(SCAN_DeviceList *list)
+{
+    for (size_t i = 0; i < list->count; i++)
+    {
+        free(list->paths[i]);
+    }
+    free(list->paths);
+
+    list->paths = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+
+
+
+
+
+/**
+ * scandir filter that skips the "." and ".." entries.
+ */
+static int skip_dot_entries(const struct dirent *entry)
+{
+    return entry->d_name[0] != '.';
+}
+
+
+
+
+
+
+/**
+ * Checks whether a sysfs block device reports a non-zero size.
+ *
+ * Unused loop and ram devices show up in /sys/block with a size of 0 sectors; like
+ * `fdisk -l`, they are not worth probing.
+ *
+ * @param disk: Name of the disk under /sys/block (e.g., "sda").
+ *
+ * @return 1 if the device has a non-zero size, 0 otherwise.
+ */
+static int has_nonzero_size(const char *disk)
+{
+    char path[SCAN_PATH_LENGTH];
+    unsigned long long sectors = 0;
+
+    snprintf(path, sizeof(path), SCAN_SYSFS_BLOCK_DIR "/%s/size", disk);
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    if (fscanf(file, "%llu", &sectors) != 1)
+    {
+        sectors = 0;
+    }
+    fclose(file);
+
+    return sectors != 0;
+}
+
+
+
+
+
+
+/**
+ * Appends the partitions of a disk (e.g., /dev/sda1, /dev/sda2) to a device list.
+ *
+ * Partitions are the subdirectories of /sys/block/<disk> that contain a `partition`
+ * attribute. They are added in natural order so the output order is stable.
+ *
+ * @param list: The list to append to.
+ * @param disk: Name of the disk under /sys/block.
+ *
+ * @return 0 on success, or -1 on allocation failure.
+ */
+static int add_disk_partitions(SCAN_DeviceList *list, const char *disk)
+{
+    char path[SCAN_PATH_LENGTH];
+    struct dirent **entries;
+    int status = 0;
+
+    snprintf(path, sizeof(path), SCAN_SYSFS_BLOCK_DIR "/%s", disk);
+
+    int count = scandir(path, &entries, skip_dot_entries, versionsort);
+    if (count < 0)
+    {
+        return 0; // Disk vanished or is not readable; nothing to add
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        char attribute[SCAN_PATH_LENGTH];
+        snprintf(attribute, sizeof(attribute), SCAN_SYSFS_BLOCK_DIR "/%s/%s/partition", disk, entries[i]->d_name);
+
+        if (status == 0 && access(attribute, F_OK) == 0)
+        {
+            snprintf(path, sizeof(path), "/dev/%s", entries[i]->d_name);
+            status = SCAN_add_device(list, path);
+        }
+        free(entries[i]);
+    }
+    free(entries);
+
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Enumerates all block devices and their partitions from sysfs.
+ *
+ * Every disk listed in /sys/block with a non-zero size is added as /dev/<disk>,
+ * followed by its partitions. Disks are visited in natural order, so repeated
+ * runs produce the same device order.
+ *
+ * @param list: The list that receives the device paths.
+ *
+ * @return 0 on success, or -1 if /sys/block cannot be read or allocation fails.
+ */
+int SCAN_enumerate_block_devices(SCAN_DeviceList *list)
+{
+    struct dirent **disks;
+    int status = 0;
+
+    int count = scandir(SCAN_SYSFS_BLOCK_DIR, &disks, skip_dot_entries, versionsort);
+    if (count < 0)
+    {
+        perror("Failed to read " SCAN_SYSFS_BLOCK_DIR);
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (status == 0 && has_nonzero_size(disks[i]->d_name))
+        {
+            char path[SCAN_PATH_LENGTH];
+            snprintf(path, sizeof(path), "/dev/%s", disks[i]->d_name);
+
+            status = SCAN_add_device(list, path);
+            if (status == 0)
+            {
+                status = add_disk_partitions(list, disks[i]->d_name);
+            }
+        }
+        free(disks[i]);
+    }
+    free(disks);
+
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Worker thread: probes devices until the list is exhausted.
+ *
+ * Each worker repeatedly takes the next unprobed device, runs the probe with its
+ * output redirected into a private memory stream, and publishes the result.
+ *
+ * @param arg: Pointer to the shared `scan_context`.
+ *
+ * @return NULL.
+ */
+static void *scan_worker(void *arg)
+{
+    scan_context *context = arg;
+
+    for (;;)
+    {
+        // Take the next device
+        pthread_mutex_lock(&context->lock);
+        size_t index = context->next++;
+        pthread_mutex_unlock(&context->lock);
+
+        if (index >= context->list->count)
+        {
+            break;
+        }
+
+        scan_result result = { NULL, 0, -1, 1 };
+
+        // Probe the device into a private buffer so outputs never interleave
+        FILE *out = open_memstream(&result.text, &result.length);
+        if (out == NULL)
+        {
+            perror("Failed to create output buffer");
+        }
+        else
+        {
+            result.status = context->probe(context->list->paths[index], out);
+            fclose(out);
+        }
+
+        // Publish the result
+        pthread_mutex_lock(&context->lock);
+        context->results[index] = result;
+        pthread_cond_broadcast(&context->finished);
+        pthread_mutex_unlock(&context->lock);
+    }
+
+    return NULL;
+}
+
+
+
+
+
+
+/**
+ * Probes every device of a list concurrently and prints the results in list order.
+ *
+ * The function performs the following tasks:
+ * 1. Starts up to `max_threads` workers (never more than there are devices).
+ * 2. Workers probe devices in parallel, each into its own memory buffer.
+ * 3. The calling thread prints each buffer as soon as it and every device before it
+ *    are done, so output streams out in a stable order while probing continues.
+ *
+ * @param list: The devices to probe.
+ * @param probe: The callback that probes one device.
+ * @param max_threads: Upper bound on the number of worker threads (0 selects the default).
+ *
+ * @return The number of devices whose probe failed, or -1 if the scan could not start.
+ */
+int SCAN_run(const SCAN_DeviceList *list, SCAN_ProbeFunction probe, unsigned int max_threads)
+{
+    if (list->count == 0)
+    {
+        return 0;
+    }
+
+    if (max_threads == 0)
+    {
+        max_threads = SCAN_DEFAULT_THREADS;
+    }
+    if (max_threads > list->count)
+    {
+        max_threads = (unsigned int)list->count;
+    }
+
+    scan_context context = { .list = list, .probe = probe, .next = 0 };
+    context.results = calloc(list->count, sizeof(scan_result));
+    pthread_t *threads = malloc(max_threads * sizeof(pthread_t));
+    if (context.results == NULL || threads == NULL)
+    {
+        perror("Failed to allocate scan state");
+        free(context.results);
+        free(threads);
+        return -1;
+    }
+
+    pthread_mutex_init(&context.lock, NULL);
+    pthread_cond_init(&context.finished, NULL);
+
+    // Start the worker pool
+    unsigned int started = 0;
+    for (; started < max_threads; started++)
+    {
+        if (pthread_create(&threads[started], NULL, scan_worker, &context) != 0)
+        {
+            break;
+        }
+    }
+
+    // If no worker could be started, probe on the calling thread
+    if (started == 0)
+    {
+        scan_worker(&context);
+    }
+
+    // Print results in list order as they become available
+    int failures = 0;
+    for (size_t i = 0; i < list->count; i++)
+    {
+        pthread_mutex_lock(&context.lock);
+        while (!context.results[i].done)
+        {
+            pthread_cond_wait(&context.finished, &context.lock);
+        }
+        pthread_mutex_unlock(&context.lock);
+
+        if (i > 0)
+        {
+            fputc('\n', stdout); // Separate devices with a blank line
+        }
+        if (context.results[i].text != NULL)
+        {
+            fwrite(context.results[i].text, 1, context.results[i].length, stdout);
+            free(context.results[i].text);
+        }
+        if (context.results[i].status != 0)
+        {
+            failures++;
+        }
+    }
+
+    for (unsigned int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&context.finished);
+    pthread_mutex_destroy(&context.lock);
+    free(context.results);
+    free(threads);
+
+    return failures;
+}
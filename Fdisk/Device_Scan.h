@@ -0,0 +1,98 @@
+/**
+ *===================================================================================
+ * @file           : Device_Scan.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Device_Scan (parallel probing of many devices/images)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _DEVICE_SCAN_H_
+#define _DEVICE_SCAN_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stdio.h>      // Provides FILE streams used to collect per-device output
+#include <stddef.h>     // Defines size_t
+#include <limits.h>     // Provides PATH_MAX
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Directory listing all block devices known to the kernel.
+ *
+ * Each entry is a whole disk; its partitions appear as subdirectories that contain
+ * a `partition` attribute file.
+ */
+#define SCAN_SYSFS_BLOCK_DIR        "/sys/block"  // sysfs block device directory
+
+/**
+ * Default number of worker threads used to probe devices concurrently.
+ *
+ * Probing is I/O bound (a few small reads per device), so the pool is sized for
+ * outstanding I/O rather than for CPU cores.
+ */
+#define SCAN_DEFAULT_THREADS        16  // Default size of the probing thread pool
+
+/**
+ * Maximum length of a device path built from a sysfs entry name.
+ */
+#define SCAN_PATH_LENGTH            PATH_MAX  // Maximum device path length
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Callback that probes one device and prints its partition table.
+ *
+ * @param device: Path of the device or image file to probe.
+ * @param out: Stream the device output must be written to.
+ *
+ * @return 0 on success, non-zero if the device could not be probed.
+ */
+typedef int (*SCAN_ProbeFunction)(const char *device, FILE *out);
+
+/**
+ * Represents a list of device paths to probe.
+ *
+ * Fields:
+ *
+ * @param paths: Array of heap-allocated device paths.
+ * @param count: Number of paths in the array.
+ * @param capacity: Allocated size of the array.
+ */
+typedef struct {
+    char **paths;     /**< Device paths. */
+    size_t count;     /**< Number of paths. */
+    size_t capacity;  /**< Allocated number of slots. */
+} SCAN_DeviceList;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+int SCAN_add_device(SCAN_DeviceList *list, const char *path);
+int SCAN_enumerate_block_devices(SCAN_DeviceList *list);
+void SCAN_free_device_list(SCAN_DeviceList *list);
+int SCAN_run(const SCAN_DeviceList *list, SCAN_ProbeFunction probe, unsigned int max_threads);
+
+#endif
@@ -0,0 +1,485 @@
+/**
+ *===================================================================================
+ * @file           : FS_Probe.c
+ * @author         : Ali Mamdouh
+ * @brief          : detect filesystems and volume signatures inside a partition
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "FS_Probe.h"   // Includes the probe result structure and API
+#include <stdlib.h>     // Provides free
+#include <string.h>     // Provides memcmp, memcpy and memset
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+#define FS_EXT_SUPERBLOCK_OFFSET    1024        // ext2/3/4 superblock offset
+#define FS_EXT_MAGIC                0xEF53      // ext2/3/4 magic
+#define FS_BTRFS_SUPERBLOCK_OFFSET  (64 * 1024) // Btrfs primary superblock offset
+#define FS_MD_MAGIC                 0xA92B4EFC  // Linux software RAID superblock magic
+#define FS_MD_0_90_RESERVED         (64 * 1024) // mdraid 0.90 reserved area at the end
+#define FS_SECTOR                   512         // Unit of the LVM2 label scan
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * The bytes of a partition fetched for probing: a head and a tail range.
+ *
+ * Fields:
+ *
+ * @param head: Bytes [0, head_length) of the partition.
+ * @param head_length: Length of the head range.
+ * @param tail: Bytes [tail_offset, length) of the partition, or NULL if the head covers them.
+ * @param tail_offset: Offset of the tail range in the partition.
+ * @param length: Length of the partition in bytes.
+ */
+typedef struct {
+    const uint8_t *head;     /**< Start of the partition. */
+    size_t head_length;      /**< Length of the head range. */
+    const uint8_t *tail;     /**< End of the partition, or NULL. */
+    uint64_t tail_offset;    /**< Offset of the tail range. */
+    uint64_t length;         /**< Partition length. */
+} FS_Window;
+
+/**
+ * A signature probe: returns 1 and fills `info` if its signature is present.
+ */
+typedef int (*FS_ProbeFunction)(const FS_Window *window, FS_Info *info);
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Returns a pointer to `length` bytes at `offset` in the partition, or NULL if they were not fetched.
+ */
+static const uint8_t *window_at(const FS_Window *window, uint64_t offset, size_t length)
+{
+    if (offset + length <= window->head_length)
+    {
+        return window->head + offset;
+    }
+    if (window->tail != NULL && offset >= window->tail_offset && offset + length <= window->length)
+    {
+        return window->tail + (offset - window->tail_offset);
+    }
+    return NULL;
+}
+
+
+
+static uint16_t le16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t le32(const uint8_t *p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint64_t le64(const uint8_t *p) { return (uint64_t)le32(p) | ((uint64_t)le32(p + 4) << 32); }
+static uint16_t be16(const uint8_t *p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+
+
+/**
+ * Formats 16 raw bytes as a lower-case UUID string (8-4-4-4-12).
+ */
+static void format_uuid(const uint8_t *uuid, char *out)
+{
+    snprintf(out, FS_UUID_LENGTH,
+             "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+             uuid[0], uuid[1], uuid[2], uuid[3], uuid[4], uuid[5], uuid[6], uuid[7],
+             uuid[8], uuid[9], uuid[10], uuid[11], uuid[12], uuid[13], uuid[14], uuid[15]);
+}
+
+
+
+/**
+ * Copies an on-disk label (NUL- or space-padded) into a C string.
+ */
+static void copy_label(char *out, const uint8_t *label, size_t length)
+{
+    size_t n = 0;
+    while (n < length && n < FS_LABEL_LENGTH - 1 && label[n] != '\0')
+    {
+        out[n] = (char)label[n];
+        n++;
+    }
+    while (n > 0 && out[n - 1] == ' ')
+    {
+        n--;
+    }
+    out[n] = '\0';
+}
+
+
+
+/**
+ * Fills the type of a probe result.
+ */
+static int found(FS_Info *info, const char *type)
+{
+    snprintf(info->type, sizeof(info->type), "%s", type);
+    return 1;
+}
+
+
+
+
+
+
+/**
+ * Linux software RAID member: superblock 1.1 at 0, 1.2 at 4 KiB, 1.0 near the end,
+ * or 0.90 in the last 64 KiB.
+ */
+static int probe_mdraid(const FS_Window *window, FS_Info *info)
+{
+    uint64_t offsets[3] = { 0, 4096, 0 };
+    int count = 2;
+    if (window->length >= 8192)
+    {
+        offsets[count++] = (window->length - 8192) & ~(uint64_t)4095;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const uint8_t *sb = window_at(window, offsets[i], 64);
+        if (sb != NULL && le32(sb) == FS_MD_MAGIC && le32(sb + 4) == 1)
+        {
+            format_uuid(sb + 16, info->uuid);
+            copy_label(info->label, sb + 32, 32);
+            return found(info, "linux_raid_member");
+        }
+    }
+
+    if (window->length >= 2 * FS_MD_0_90_RESERVED)
+    {
+        uint64_t offset = (window->length & ~(uint64_t)(FS_MD_0_90_RESERVED - 1)) - FS_MD_0_90_RESERVED;
+        const uint8_t *sb = window_at(window, offset, 64);
+        if (sb != NULL && le32(sb) == FS_MD_MAGIC && le32(sb + 4) == 0)
+        {
+            // set_uuid0 and set_uuid1..3 are native 32-bit words, printed as numbers
+            static const int words[4] = { 5, 13, 14, 15 };
+            uint8_t uuid[16];
+            for (int w = 0; w < 4; w++)
+            {
+                uint32_t word = le32(sb + words[w] * 4);
+                uuid[w * 4]     = (uint8_t)(word >> 24);
+                uuid[w * 4 + 1] = (uint8_t)(word >> 16);
+                uuid[w * 4 + 2] = (uint8_t)(word >> 8);
+                uuid[w * 4 + 3] = (uint8_t)word;
+            }
+            format_uuid(uuid, info->uuid);
+            return found(info, "linux_raid_member");
+        }
+    }
+    return 0;
+}
+
+
+
+/**
+ * LUKS1/LUKS2 encrypted volume ("LUKS\xba\xbe" at 0; UUID at 168, LUKS2 label at 24).
+ */
+static int probe_luks(const FS_Window *window, FS_Info *info)
+{
+    const uint8_t *hdr = window_at(window, 0, 512);
+    if (hdr == NULL || memcmp(hdr, "LUKS\xba\xbe", 6) != 0)
+    {
+        return 0;
+    }
+    copy_label(info->uuid, hdr + 168, 40);
+    if (be16(hdr + 6) == 2)
+    {
+        copy_label(info->label, hdr + 24, 48);
+    }
+    return found(info, "crypto_LUKS");
+}
+
+
+
+/**
+ * LVM2 physical volume ("LABELONE" in one of the first four sectors, type "LVM2 001").
+ */
+static int probe_lvm2(const FS_Window *window, FS_Info *info)
+{
+    for (uint64_t sector = 0; sector < 4; sector++)
+    {
+        const uint8_t *label = window_at(window, sector * FS_SECTOR, FS_SECTOR);
+        if (label == NULL || memcmp(label, "LABELONE", 8) != 0 || memcmp(label + 24, "LVM2 001", 8) != 0)
+        {
+            continue;
+        }
+
+        uint32_t pv_offset = le32(label + 20);
+        if (pv_offset > FS_SECTOR - 32)
+        {
+            continue;
+        }
+
+        // The PV UUID is 32 characters, printed in 6-4-4-4-4-4-6 groups
+        static const int groups[] = { 6, 4, 4, 4, 4, 4, 6 };
+        const uint8_t *uuid = label + pv_offset;
+        char *out = info->uuid;
+        for (int g = 0; g < 7; g++)
+        {
+            memcpy(out, uuid, (size_t)groups[g]);
+            out += groups[g];
+            uuid += groups[g];
+            *out++ = (g < 6) ? '-' : '\0';
+        }
+        return found(info, "LVM2_member");
+    }
+    return 0;
+}
+
+
+
+/**
+ * Btrfs ("_BHRfS_M" in the superblock at 64 KiB; fsid at 32, label at 0x12B).
+ */
+static int probe_btrfs(const FS_Window *window, FS_Info *info)
+{
+    const uint8_t *sb = window_at(window, FS_BTRFS_SUPERBLOCK_OFFSET, 4096);
+    if (sb == NULL || memcmp(sb + 64, "_BHRfS_M", 8) != 0)
+    {
+        return 0;
+    }
+    format_uuid(sb + 32, info->uuid);
+    copy_label(info->label, sb + 0x12B, 256);
+    return found(info, "btrfs");
+}
+
+
+
+/**
+ * XFS ("XFSB" at 0; UUID at 32, label at 108).
+ */
+static int probe_xfs(const FS_Window *window, FS_Info *info)
+{
+    const uint8_t *sb = window_at(window, 0, 512);
+    if (sb == NULL || memcmp(sb, "XFSB", 4) != 0)
+    {
+        return 0;
+    }
+    format_uuid(sb + 32, info->uuid);
+    copy_label(info->label, sb + 108, 12);
+    return found(info, "xfs");
+}
+
+
+
+/**
+ * ext2/3/4 (magic 0xEF53 in the superblock at 1 KiB; UUID at 104, label at 120).
+ *
+ * ext4 is reported if extents, 64bit or flex_bg are enabled, ext3 if the filesystem has
+ * a journal, ext2 otherwise.
+ */
+static int probe_ext(const FS_Window *window, FS_Info *info)
+{
+    const uint8_t *sb = window_at(window, FS_EXT_SUPERBLOCK_OFFSET, 1024);
+    if (sb == NULL || le16(sb + 56) != FS_EXT_MAGIC)
+    {
+        return 0;
+    }
+
+    uint32_t compat = le32(sb + 92);
+    uint32_t incompat = le32(sb + 96);
+    format_uuid(sb + 104, info->uuid);
+    copy_label(info->label, sb + 120, 16);
+
+    if (incompat & 0x0008)                            return found(info, "jbd");   // External journal device
+    if (incompat & (0x0040 | 0x0080 | 0x0200))        return found(info, "ext4");  // extents, 64bit, flex_bg
+    if (compat & 0x0004)                              return found(info, "ext3");  // has_journal
+    return found(info, "ext2");
+}
+
+
+
+/**
+ * NTFS ("NTFS    " at 3; volume serial number at 0x48).
+ *
+ * The NTFS label lives in the $Volume MFT record, far from the boot sector, and is not read.
+ */
+static int probe_ntfs(const FS_Window *window, FS_Info *info)
+{
+    const uint8_t *boot = window_at(window, 0, 512);
+    if (boot == NULL || memcmp(boot + 3, "NTFS    ", 8) != 0)
+    {
+        return 0;
+    }
+    snprintf(info->uuid, FS_UUID_LENGTH, "%016" PRIX64, le64(boot + 0x48));
+    return found(info, "ntfs");
+}
+
+
+
+/**
+ * FAT12/16/32 (file system type string in the boot sector; label and volume id).
+ */
+static int probe_vfat(const FS_Window *window, FS_Info *info)
+{
+    const uint8_t *boot = window_at(window, 0, 512);
+    if (boot == NULL || le16(boot + 510) != 0xAA55)
+    {
+        return 0;
+    }
+
+    const uint8_t *id;
+    const uint8_t *label;
+    if (memcmp(boot + 82, "FAT32   ", 8) == 0)
+    {
+        id = boot + 67;
+        label = boot + 71;
+    }
+    else if (memcmp(boot + 54, "FAT1", 4) == 0 || memcmp(boot + 54, "FAT     ", 8) == 0)
+    {
+        id = boot + 39;
+        label = boot + 43;
+    }
+    else
+    {
+        return 0;
+    }
+
+    uint32_t serial = le32(id);
+    snprintf(info->uuid, FS_UUID_LENGTH, "%04X-%04X", serial >> 16, serial & 0xFFFF);
+    copy_label(info->label, label, 11);
+    if (strcmp(info->label, "NO NAME") == 0)
+    {
+        info->label[0] = '\0';
+    }
+    return found(info, "vfat");
+}
+
+
+
+/**
+ * Linux swap ("SWAPSPACE2" at the end of the first page; UUID at 1036, label at 1052).
+ */
+static int probe_swap(const FS_Window *window, FS_Info *info)
+{
+    static const uint32_t page_sizes[] = { 4096, 8192, 16384, 65536 };
+
+    for (size_t i = 0; i < sizeof(page_sizes) / sizeof(page_sizes[0]); i++)
+    {
+        const uint8_t *magic = window_at(window, page_sizes[i] - 10, 10);
+        if (magic == NULL)
+        {
+            continue;
+        }
+        if (memcmp(magic, "SWAPSPACE2", 10) == 0)
+        {
+            const uint8_t *header = window_at(window, 1024, 44);
+            format_uuid(header + 12, info->uuid);
+            copy_label(info->label, header + 28, 16);
+            return found(info, "swap");
+        }
+        if (memcmp(magic, "SWAP-SPACE", 10) == 0)
+        {
+            return found(info, "swap");
+        }
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Probes a partition for a filesystem or volume signature.
+ *
+ * All probes share the same bytes, fetched with at most two reads per partition instead
+ * of one read per probe: the first `FS_HEAD_PROBE_SIZE` bytes and the last
+ * `FS_TAIL_PROBE_SIZE` bytes (a single read if the partition is small). For mapped
+ * images nothing is read or copied. RAID, LUKS and LVM2 signatures are checked before
+ * filesystems, so a RAID member whose data starts with a filesystem is reported as a
+ * member; FAT and swap, whose signatures are the weakest, are checked last.
+ *
+ * @param dev: The opened device.
+ * @param offset: Byte offset of the partition.
+ * @param length: Length of the partition in bytes.
+ * @param info: Receives the type, label and UUID.
+ *
+ * @return 1 if a signature was found, 0 if none was found, or -1 on a read error.
+ */
+int FS_probe(BLK_Device *dev, uint64_t offset, uint64_t length, FS_Info *info)
+{
+    static const FS_ProbeFunction probes[] =
+    {
+        probe_mdraid, probe_luks, probe_lvm2, probe_btrfs, probe_xfs, probe_ext,
+        probe_ntfs, probe_vfat, probe_swap
+    };
+
+    memset(info, 0, sizeof(*info));
+
+    // Never read past the end of the device, even if the partition table says so
+    if (offset >= dev->size_bytes)
+    {
+        return 0;
+    }
+    if (length > dev->size_bytes - offset)
+    {
+        length = dev->size_bytes - offset;
+    }
+
+    FS_Window window = { 0 };
+    window.length = length;
+    window.head_length = (length <= FS_HEAD_PROBE_SIZE + FS_TAIL_PROBE_SIZE) ? (size_t)length : FS_HEAD_PROBE_SIZE;
+    size_t tail_length = 0;
+    if (window.head_length < length)
+    {
+        window.tail_offset = (length - FS_TAIL_PROBE_SIZE) & ~(uint64_t)(FS_MD_0_90_RESERVED - 1);
+        tail_length = (size_t)(length - window.tail_offset);
+    }
+
+    // One scratch buffer for both ranges (not needed for mapped images)
+    char *scratch = NULL;
+    if (dev->map == NULL)
+    {
+        scratch = BLK_alloc_buffer(dev, window.head_length + tail_length);
+        if (scratch == NULL)
+        {
+            return -1;
+        }
+    }
+
+    window.head = BLK_get(dev, offset, window.head_length, scratch);
+    if (window.head != NULL && tail_length != 0)
+    {
+        window.tail = BLK_get(dev, offset + window.tail_offset, tail_length,
+                              scratch ? scratch + window.head_length : NULL);
+    }
+    if (window.head == NULL || (tail_length != 0 && window.tail == NULL))
+    {
+        free(scratch);
+        return -1;
+    }
+
+    int status = 0;
+    for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]) && status == 0; i++)
+    {
+        status = probes[i](&window, info);
+    }
+
+    free(scratch);
+    return status;
+}
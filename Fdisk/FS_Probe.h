@@ -0,0 +1,86 @@
+/**
+ *===================================================================================
+ * @file           : FS_Probe.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of FS_Probe (filesystem and volume signature probing)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _FS_PROBE_H_
+#define _FS_PROBE_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Block_IO.h"   // Provides BLK_Device reads
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Number of bytes read from the start of a partition.
+ *
+ * Covers every signature near the start of a volume in a single read: XFS, FAT, NTFS and
+ * LUKS at 0, LVM2 in the first four sectors, ext at 1 KiB, mdraid 1.2 at 4 KiB, swap at
+ * the end of the first page (up to 64 KiB pages) and the Btrfs superblock at 64 KiB.
+ */
+#define FS_HEAD_PROBE_SIZE          (68 * 1024)  // 64 KiB + one 4 KiB superblock
+
+/**
+ * Number of bytes read from the end of a partition.
+ *
+ * Covers the mdraid 0.90 superblock (64 KiB aligned, 64 KiB before the end) and the
+ * mdraid 1.0 superblock (4 KiB aligned, at least 8 KiB before the end).
+ */
+#define FS_TAIL_PROBE_SIZE          (128 * 1024)  // Last 64-128 KiB of the partition
+
+/**
+ * Sizes of the strings reported for a volume.
+ */
+#define FS_TYPE_LENGTH              24   // e.g., "linux_raid_member"
+#define FS_LABEL_LENGTH             257  // Btrfs labels are up to 256 bytes
+#define FS_UUID_LENGTH              64   // LVM2 PV UUIDs are 38 characters
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Represents the filesystem or volume found inside a partition.
+ *
+ * Fields:
+ *
+ * @param type: Type name as reported by blkid (e.g., "ext4", "vfat", "crypto_LUKS").
+ * @param label: Volume label, or empty.
+ * @param uuid: Volume UUID (or serial number for FAT/NTFS), or empty.
+ */
+typedef struct {
+    char type[FS_TYPE_LENGTH];     /**< Filesystem type. */
+    char label[FS_LABEL_LENGTH];   /**< Volume label. */
+    char uuid[FS_UUID_LENGTH];     /**< Volume UUID. */
+} FS_Info;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+int FS_probe(BLK_Device *dev, uint64_t offset, uint64_t length, FS_Info *info);
+
+#endif
@@ -0,0 +1,361 @@
+/**
+ *===================================================================================
+ * @file           : Free_Space.c
+ * @author         : Ali Mamdouh
+ * @brief          : free-space map of a partition table: gaps, overlaps, usable range
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Free_Space.h"   // Includes the free-space map structure and API
+#include <stdlib.h>       // Provides malloc, qsort and free
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Orders extents by start LBA, then by size.
+ */
+static int compare_extents(const void *a, const void *b)
+{
+    const FREE_Extent *x = a, *y = b;
+    if (x->start != y->start) return (x->start < y->start) ? -1 : 1;
+    if (x->count != y->count) return (x->count < y->count) ? -1 : 1;
+    return 0;
+}
+
+
+
+/**
+ * Returns the last LBA of an extent (its start for empty extents).
+ */
+static uint64_t extent_end(const FREE_Extent *extent)
+{
+    return extent->count ? extent->start + extent->count - 1 : extent->start;
+}
+
+
+
+/**
+ * Returns the size of a number of sectors in MiB, rounded up (as in the partition tables).
+ */
+static uint64_t sectors_to_mb(uint64_t sectors, uint32_t sector_size)
+{
+    return (sectors * sector_size + (1024 * 1024 - 1)) / (1024 * 1024);
+}
+
+
+
+
+
+
+/**
+ * Walks the sorted extents once, counting the gaps, overlaps and out-of-range partitions,
+ * and printing either the gap table or the problems.
+ *
+ * Overlaps are found in the same pass: the walk keeps the extent reaching furthest so
+ * far, and every extent starting before that end overlaps it. An extended partition
+ * legitimately contains the logical partitions, so it is not part of the extents and is
+ * only checked against the primary partitions.
+ *
+ * The gap table and the problems are printed by separate walks, so the problem lines
+ * never end up between the rows of the table.
+ *
+ * @param gaps: Stream the gap table is printed to, or NULL.
+ * @param problems: Stream the overlaps and out-of-range partitions are printed to, or NULL.
+ * @param table: The partitions, with the usable range and the sector size.
+ * @param map: The map with its sorted extents; the counters are filled in.
+ */
+static void sweep(FILE *gaps, FILE *problems, const PARSE_Table *table, FREE_Map *map)
+{
+    uint32_t sector_size = table->sector_size;
+    uint64_t min_gap = FREE_MIN_GAP_SIZE / sector_size;
+    uint64_t cursor = table->first_usable;         // First LBA not yet covered
+    const FREE_Extent *furthest = NULL;             // Extent reaching furthest so far
+    size_t small_gaps = 0;
+    uint64_t small_gap_sectors = 0;
+
+    map->free_sectors = 0;
+    map->gap_count = 0;
+    map->overlap_count = 0;
+    map->outside_count = 0;
+
+    if (gaps != NULL)
+    {
+        fprintf(gaps, "%-12s %-12s %-12s %-10s\n", "Start", "End", "Sectors", "Size(MB)");
+    }
+
+    for (size_t i = 0; i <= map->count; i++)
+    {
+        // Past the last extent, close the range with a sentinel just after it
+        const FREE_Extent *extent = (i < map->count) ? &map->extents[i] : NULL;
+        uint64_t start = extent ? extent->start : table->last_usable + 1;
+
+        if (extent != NULL && extent->count == 0)
+        {
+            continue;
+        }
+
+        // Gap between the covered part and this extent, clipped to the usable range
+        uint64_t gap_end = (start <= table->last_usable + 1) ? start : table->last_usable + 1;
+        if (gap_end > cursor)
+        {
+            uint64_t sectors = gap_end - cursor;
+            map->gap_count++;
+            map->free_sectors += sectors;
+            if (sectors >= min_gap)
+            {
+                if (gaps != NULL)
+                {
+                    fprintf(gaps, "%-12" PRIu64 " %-12" PRIu64 " %-12" PRIu64 " %-10" PRIu64 "\n",
+                            cursor, gap_end - 1, sectors, sectors_to_mb(sectors, sector_size));
+                }
+            }
+            else
+            {
+                small_gaps++;
+                small_gap_sectors += sectors;
+            }
+        }
+        if (extent == NULL)
+        {
+            break;
+        }
+
+        uint64_t end = extent_end(extent);
+        if (extent->start < table->first_usable || end > table->last_usable)
+        {
+            map->outside_count++;
+            if (problems != NULL)
+            {
+                fprintf(problems, "Partition %d (%" PRIu64 "-%" PRIu64 ") lies outside the usable range\n",
+                        extent->index, extent->start, end);
+            }
+        }
+
+        if (furthest != NULL && extent->start <= extent_end(furthest))
+        {
+            map->overlap_count++;
+            if (problems != NULL)
+            {
+                uint64_t shared_end = (end < extent_end(furthest)) ? end : extent_end(furthest);
+                fprintf(problems, "Partition %d (%" PRIu64 "-%" PRIu64 ") overlaps partition %d (%" PRIu64 "-%" PRIu64 ") by %" PRIu64 " sectors\n",
+                        extent->index, extent->start, end, furthest->index, furthest->start,
+                        extent_end(furthest), shared_end - extent->start + 1);
+            }
+        }
+        if (furthest == NULL || end > extent_end(furthest))
+        {
+            furthest = extent;
+        }
+        if (end + 1 > cursor)
+        {
+            cursor = end + 1;
+        }
+    }
+
+    // An extended partition must not overlap a primary partition
+    for (size_t i = 0; i < table->count; i++)
+    {
+        const PARSE_Partition *extended = &table->partitions[i];
+        if (extended->origin != PARSE_ORIGIN_EXTENDED)
+        {
+            continue;
+        }
+        FREE_Extent container = { extended->index, extended->start, extended->count };
+        for (size_t j = 0; j < table->count; j++)
+        {
+            const PARSE_Partition *partition = &table->partitions[j];
+            FREE_Extent primary = { partition->index, partition->start, partition->count };
+            if (partition->origin == PARSE_ORIGIN_PRIMARY && primary.count != 0 && container.count != 0 &&
+                primary.start <= extent_end(&container) && container.start <= extent_end(&primary))
+            {
+                map->overlap_count++;
+                if (problems != NULL)
+                {
+                    fprintf(problems, "Partition %d (%" PRIu64 "-%" PRIu64 ") overlaps extended partition %d (%" PRIu64 "-%" PRIu64 ")\n",
+                            primary.index, primary.start, extent_end(&primary),
+                            container.index, container.start, extent_end(&container));
+                }
+            }
+        }
+    }
+
+    if (gaps != NULL && small_gaps != 0)
+    {
+        fprintf(gaps, "%zu gap%s smaller than %d KiB (%" PRIu64 " sectors) not listed\n",
+                small_gaps, small_gaps == 1 ? "" : "s", FREE_MIN_GAP_SIZE / 1024, small_gap_sectors);
+    }
+}
+
+
+
+
+
+
+/**
+ * Copies the extents of the partition descriptors and sorts them by start LBA.
+ *
+ * Tables written by partitioning tools are usually already in order, so the copy is
+ * checked in one pass and only sorted if needed. Extended partitions (containers) and
+ * reversed GPT entries occupy no space of their own and are left out.
+ *
+ * @return 0 on success, or -1 if memory allocation fails.
+ */
+static int sort_extents(const PARSE_Table *table, FREE_Map *map)
+{
+    map->extents = NULL;
+    map->count = 0;
+    if (table->count == 0)
+    {
+        return 0;
+    }
+
+    map->extents = malloc(table->count * sizeof(FREE_Extent));
+    if (map->extents == NULL)
+    {
+        perror("Failed to allocate free-space map");
+        return -1;
+    }
+
+    int sorted = 1;
+    for (size_t i = 0; i < table->count; i++)
+    {
+        const PARSE_Partition *partition = &table->partitions[i];
+        if (partition->origin == PARSE_ORIGIN_EXTENDED || (partition->flags & PARSE_FLAG_REVERSED))
+        {
+            continue;
+        }
+        FREE_Extent extent = { partition->index, partition->start, partition->count };
+        if (map->count != 0 && compare_extents(&map->extents[map->count - 1], &extent) > 0)
+        {
+            sorted = 0;
+        }
+        map->extents[map->count++] = extent;
+    }
+
+    if (!sorted)
+    {
+        qsort(map->extents, map->count, sizeof(FREE_Extent), compare_extents);
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Builds the free-space map of a partition table.
+ *
+ * Every primary, logical and GPT partition becomes an extent; the extents are sorted by
+ * start LBA and walked once, so tables with thousands of entries cost O(n log n) (O(n)
+ * when the table is already in disk order). The map records the unpartitioned sectors
+ * and the number of gaps, overlaps and partitions outside the usable range.
+ *
+ * @param table: The partition descriptors, with the usable range of the table.
+ * @param map: Receives the map; free it with `FREE_free_map`.
+ *
+ * @return 0 on success, or -1 if memory allocation fails.
+ */
+int FREE_build_map(const PARSE_Table *table, FREE_Map *map)
+{
+    if (sort_extents(table, map) != 0)
+    {
+        return -1;
+    }
+    sweep(NULL, NULL, table, map);
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Frees a free-space map.
+ *
+ * @param map: The map to free.
+ */
+void FREE_free_map(FREE_Map *map)
+{
+    free(map->extents);
+    map->extents = NULL;
+    map->count = 0;
+}
+
+
+
+
+
+
+/**
+ * Prints the free-space map of a partition table (like the `F` command of fdisk).
+ *
+ * This function performs the following tasks:
+ * 1. Prints the unpartitioned space and the usable range (FirstUsableLBA to
+ *    LastUsableLBA for GPT, sector 1 to the last addressable sector for MBR).
+ * 2. Lists every gap of at least `FREE_MIN_GAP_SIZE` in disk order; smaller gaps are
+ *    summarized.
+ * 3. After the gaps, reports overlapping partitions and partitions outside the usable
+ *    range, which only a corrupted or hand-edited table contains.
+ *
+ * @param out: Stream the report is printed to.
+ * @param device: Name of the device.
+ * @param table: The partition descriptors, with the usable range of the table.
+ *
+ * @return The number of overlapping and out-of-range partitions, or -1 on error.
+ */
+int FREE_print_report(FILE *out, const char *device, const PARSE_Table *table)
+{
+    uint32_t sector_size = table->sector_size;
+    FREE_Map map;
+
+    if (table->last_usable == 0)
+    {
+        fprintf(out, "\nNo partition table on %s: no free-space map\n", device);
+        return 0;
+    }
+    if (sort_extents(table, &map) != 0)
+    {
+        return -1;
+    }
+
+    // Count first, so the totals can be printed before the list of gaps
+    sweep(NULL, NULL, table, &map);
+    uint64_t usable = table->last_usable - table->first_usable + 1;
+    fprintf(out, "\nUnpartitioned space %s: %" PRIu64 " MiB, %" PRIu64 " bytes, %" PRIu64 " sectors\n",
+            device, map.free_sectors * sector_size / (1024 * 1024), map.free_sectors * sector_size, map.free_sectors);
+    fprintf(out, "Usable range: %" PRIu64 "-%" PRIu64 " (%" PRIu64 " sectors), %zu partition%s, %" PRIu64 "%% free\n",
+            table->first_usable, table->last_usable, usable, map.count, map.count == 1 ? "" : "s",
+            map.free_sectors * 100 / usable);
+    sweep(out, NULL, table, &map);
+
+    // The problems follow the finished gap table, just before their summary
+    int problems = (int)(map.overlap_count + map.outside_count);
+    if (problems != 0)
+    {
+        fputc('\n', out);
+        sweep(NULL, out, table, &map);
+        fprintf(out, "%zu overlapping and %zu out-of-range partitions: the table is corrupted\n",
+                map.overlap_count, map.outside_count);
+    }
+
+    FREE_free_map(&map);
+    return problems;
+}
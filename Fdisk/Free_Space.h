@@ -0,0 +1,96 @@
+/**
+ *===================================================================================
+ * @file           : Free_Space.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Free_Space (free-space map, gaps and overlaps)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _FREE_SPACE_H_
+#define _FREE_SPACE_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stdio.h>            // Provides FILE
+#include "Partition_Parse.h"  // Provides the partition descriptors the map is built from
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Gaps smaller than this many bytes are summarized instead of listed.
+ *
+ * The sector before every logical partition holds its EBR, and partitioning tools leave
+ * sub-MiB padding to keep partitions aligned; neither is usable free space.
+ */
+#define FREE_MIN_GAP_SIZE           (1024 * 1024)  // 1 MiB, the default alignment grain
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Represents one partition occupying space in the free-space map.
+ *
+ * Fields:
+ *
+ * @param index: Partition number, as printed in the partition table.
+ * @param start: First LBA.
+ * @param count: Number of sectors.
+ */
+typedef struct {
+    int index;                /**< Partition number. */
+    uint64_t start;           /**< First LBA. */
+    uint64_t count;           /**< Number of sectors. */
+} FREE_Extent;
+
+/**
+ * Represents the free-space map of a device.
+ *
+ * Fields:
+ *
+ * @param extents: Partitions occupying space (extended containers excluded), sorted by
+ *                 start LBA.
+ * @param count: Number of extents.
+ * @param free_sectors: Sectors of the usable range not covered by any partition.
+ * @param gap_count: Number of gaps in the usable range.
+ * @param overlap_count: Number of partitions overlapping an earlier one (or, for
+ *                       extended partitions, a primary partition).
+ * @param outside_count: Number of partitions not entirely inside the usable range.
+ */
+typedef struct {
+    FREE_Extent *extents;     /**< Sorted extents. */
+    size_t count;             /**< Number of extents. */
+    uint64_t free_sectors;    /**< Unpartitioned sectors. */
+    size_t gap_count;         /**< Number of gaps. */
+    size_t overlap_count;     /**< Number of overlapping partitions. */
+    size_t outside_count;     /**< Partitions outside the usable range. */
+} FREE_Map;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+int FREE_build_map(const PARSE_Table *table, FREE_Map *map);
+void FREE_free_map(FREE_Map *map);
+int FREE_print_report(FILE *out, const char *device, const PARSE_Table *table);
+
+#endif
@@ -0,0 +1,444 @@
+/**
+ *===================================================================================
+ * @file           : GPT_Backup.c
+ * @author         : Ali Mamdouh
+ * @brief          : verify the primary GPT against the backup GPT and repair a damaged copy
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "GPT_Backup.h"   // Includes the GPT copy structure and the verification/repair API
+#include <stdlib.h>       // Provides free
+#include <string.h>       // Provides memcpy, memset and memcmp
+#include <errno.h>        // Provides errno
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Returns the number of logical sectors occupied by the entry array of a header.
+ */
+static uint64_t entry_array_sectors(const BLK_Device *dev, const GPT_Header *header)
+{
+    uint64_t array_size = (uint64_t)header->num_partition_entries * header->size_of_partition_entry;
+    return (array_size + dev->logical_sector_size - 1) / dev->logical_sector_size;
+}
+
+
+
+/**
+ * Returns the last LBA of a device.
+ */
+static uint64_t last_lba(const BLK_Device *dev)
+{
+    uint64_t sectors = dev->size_bytes / dev->logical_sector_size;
+    return sectors ? sectors - 1 : 0;
+}
+
+
+
+
+
+
+/**
+ * Loads one copy of the GPT (header and entry array) from a device.
+ *
+ * The header at `lba` is read, parsed and checksummed; if it is usable, its entry array
+ * is fetched (zero-copy for mapped images, through the sector cache otherwise) and
+ * checksummed. The primary header and a default-sized entry array share the cached block
+ * of the MBR, so reading the whole primary GPT costs no additional read.
+ * The outcome of every step is recorded in the copy instead of aborting, so damaged
+ * copies can still be reported and repaired.
+ *
+ * @param cache: The sector cache of the opened device.
+ * @param lba: LBA of the header (1 for the primary, AlternateLBA for the backup).
+ * @param copy: The structure that receives the copy; free it with `GPT_free_copy`.
+ */
+void GPT_load_copy(CACHE_Cache *cache, uint64_t lba, GPT_Copy *copy)
+{
+    BLK_Device *dev = cache->dev;
+    memset(copy, 0, sizeof(*copy));
+    copy->lba = lba;
+
+    // Read and parse the header
+    if (lba == 0 || lba > last_lba(dev) ||
+        CACHE_read(cache, lba * dev->logical_sector_size, copy->raw_header, GPT_HEADER_SECTOR_SIZE) != 0)
+    {
+        return;
+    }
+    if (GPT_parse_header(copy->raw_header, &copy->header) != 0)
+    {
+        return;
+    }
+    copy->header_valid = 1;
+    copy->header_crc_ok = GPT_verify_header_crc(copy->raw_header, &copy->header);
+
+    // Get the entry array described by the header
+    uint64_t sectors = entry_array_sectors(dev, &copy->header);
+    uint64_t offset = copy->header.partition_entry_lba * dev->logical_sector_size;
+    size_t length = sectors * dev->logical_sector_size;
+    if (dev->map != NULL)
+    {
+        copy->entries = BLK_get(dev, offset, length, NULL);
+    }
+    else
+    {
+        // Copied out of the cache: the array must outlive later cache accesses
+        copy->buffer = BLK_alloc_buffer(dev, length);
+        if (copy->buffer == NULL)
+        {
+            return;
+        }
+        if (CACHE_read(cache, offset, copy->buffer, length) == 0)
+        {
+            copy->entries = copy->buffer;
+        }
+    }
+    if (copy->entries != NULL)
+    {
+        copy->entries_crc_ok = GPT_verify_entry_array(&copy->header, copy->entries);
+    }
+}
+
+
+
+
+
+
+/**
+ * Frees the entry array buffer owned by a GPT copy.
+ *
+ * @param copy: The copy to free.
+ */
+void GPT_free_copy(GPT_Copy *copy)
+{
+    free(copy->buffer);
+    copy->buffer = NULL;
+    copy->entries = NULL;
+}
+
+
+
+
+
+
+/**
+ * Checks whether a GPT copy is fully intact (valid header, both CRC32s match).
+ *
+ * @param copy: The copy to check.
+ *
+ * @return 1 if the copy is intact, 0 otherwise.
+ */
+int GPT_copy_is_intact(const GPT_Copy *copy)
+{
+    return copy->header_valid && copy->header_crc_ok && copy->entries != NULL && copy->entries_crc_ok;
+}
+
+
+
+
+
+
+/**
+ * Chooses the GPT copy to display.
+ *
+ * An intact primary is preferred, then an intact backup. If neither is intact, a copy
+ * whose header parsed and whose entries could be read is used so that a damaged table
+ * can still be inspected.
+ *
+ * @param primary: The primary copy.
+ * @param backup: The backup copy.
+ *
+ * @return The copy to display, or NULL if neither copy is usable.
+ */
+const GPT_Copy *GPT_select_copy(const GPT_Copy *primary, const GPT_Copy *backup)
+{
+    if (GPT_copy_is_intact(primary)) return primary;
+    if (GPT_copy_is_intact(backup))  return backup;
+    if (primary->header_valid && primary->entries != NULL) return primary;
+    if (backup->header_valid && backup->entries != NULL)   return backup;
+    return NULL;
+}
+
+
+
+
+
+
+/**
+ * Reports the problems of a single GPT copy.
+ *
+ * @param out: Stream the report is printed to.
+ * @param name: "primary" or "backup".
+ * @param copy: The copy to check.
+ *
+ * @return The number of problems found.
+ */
+static int report_copy(FILE *out, const char *name, const GPT_Copy *copy)
+{
+    if (!copy->header_valid)
+    {
+        fprintf(out, "GPT check: %s header at LBA %" PRIu64 " is missing or invalid\n", name, copy->lba);
+        return 1;
+    }
+
+    int problems = 0;
+
+    if (!copy->header_crc_ok)
+    {
+        fprintf(out, "GPT check: %s header CRC32 mismatch\n", name);
+        problems++;
+    }
+    if (copy->header.my_lba != copy->lba)
+    {
+        fprintf(out, "GPT check: %s header MyLBA %" PRIu64 " does not match its location %" PRIu64 "\n",
+                name, copy->header.my_lba, copy->lba);
+        problems++;
+    }
+    if (copy->entries == NULL)
+    {
+        fprintf(out, "GPT check: %s entry array at LBA %" PRIu64 " is unreadable\n", name, copy->header.partition_entry_lba);
+        problems++;
+    }
+    else if (!copy->entries_crc_ok)
+    {
+        fprintf(out, "GPT check: %s entry array CRC32 mismatch\n", name);
+        problems++;
+    }
+
+    return problems;
+}
+
+
+
+
+
+
+/**
+ * Compares the primary and backup headers and entry arrays field by field.
+ *
+ * @param out: Stream the mismatches are printed to, or NULL to only count them.
+ * @param primary: The primary copy (header must be valid).
+ * @param backup: The backup copy (header must be valid).
+ *
+ * @return The number of mismatches found.
+ */
+static int compare_copies(FILE *out, const GPT_Copy *primary, const GPT_Copy *backup)
+{
+    const GPT_Header *p = &primary->header;
+    const GPT_Header *b = &backup->header;
+    int mismatches = 0;
+
+#define GPT_COMPARE(condition, message)                          \
+    do {                                                         \
+        if (!(condition))                                        \
+        {                                                        \
+            if (out != NULL) fprintf(out, "GPT check: %s\n", message); \
+            mismatches++;                                        \
+        }                                                        \
+    } while (0)
+
+    GPT_COMPARE(p->alternate_lba == backup->lba,                     "primary AlternateLBA does not point to the backup header");
+    GPT_COMPARE(b->alternate_lba == primary->lba,                    "backup AlternateLBA does not point to the primary header");
+    GPT_COMPARE(p->first_usable_lba == b->first_usable_lba,          "FirstUsableLBA differs between primary and backup");
+    GPT_COMPARE(p->last_usable_lba == b->last_usable_lba,            "LastUsableLBA differs between primary and backup");
+    GPT_COMPARE(memcmp(p->disk_guid, b->disk_guid, GUID_SIZE) == 0,  "disk GUID differs between primary and backup");
+    GPT_COMPARE(p->num_partition_entries == b->num_partition_entries,     "number of entries differs between primary and backup");
+    GPT_COMPARE(p->size_of_partition_entry == b->size_of_partition_entry, "entry size differs between primary and backup");
+
+    if (p->num_partition_entries == b->num_partition_entries &&
+        p->size_of_partition_entry == b->size_of_partition_entry &&
+        primary->entries != NULL && backup->entries != NULL)
+    {
+        size_t array_size = (size_t)p->num_partition_entries * p->size_of_partition_entry;
+        GPT_COMPARE(memcmp(primary->entries, backup->entries, array_size) == 0, "partition entries differ between primary and backup");
+    }
+
+#undef GPT_COMPARE
+
+    return mismatches;
+}
+
+
+
+
+
+
+/**
+ * Verifies both GPT copies and reports CRC failures and mismatches.
+ *
+ * This function checks each copy on its own (header validity, header CRC32, location,
+ * entry array CRC32), checks that the backup header sits on the last LBA of the device,
+ * and, when both headers are valid, compares them field by field together with their
+ * entry arrays. Nothing is printed for a healthy disk.
+ *
+ * @param out: Stream the report is printed to.
+ * @param dev: The opened device.
+ * @param primary: The primary copy.
+ * @param backup: The backup copy.
+ *
+ * @return The number of problems found (0 for a healthy GPT).
+ */
+int GPT_report_integrity(FILE *out, const BLK_Device *dev, const GPT_Copy *primary, const GPT_Copy *backup)
+{
+    int problems = report_copy(out, "primary", primary);
+    problems += report_copy(out, "backup", backup);
+
+    if (backup->header_valid && backup->lba != last_lba(dev))
+    {
+        fprintf(out, "GPT check: backup header is at LBA %" PRIu64 ", not at the last LBA %" PRIu64 "\n",
+                backup->lba, last_lba(dev));
+        problems++;
+    }
+
+    if (primary->header_valid && backup->header_valid)
+    {
+        problems += compare_copies(out, primary, backup);
+    }
+
+    return problems;
+}
+
+
+
+
+
+
+/**
+ * Rewrites one GPT copy from the other (intact) copy.
+ *
+ * The new header is the good header with MyLBA/AlternateLBA swapped and the entry array
+ * placed where this copy belongs: right after the primary header (LBA 2), or right
+ * before the backup header. The entry array is written first, then the header, each
+ * with a single aligned write (`BLK_write_span`).
+ *
+ * @param out: Stream the result is printed to.
+ * @param dev: The device (opened with `BLK_FLAG_WRITE`).
+ * @param good: The intact copy used as the source.
+ * @param target_lba: LBA of the header to rewrite.
+ * @param name: "primary" or "backup".
+ *
+ * @return 0 on success, or -1 on error.
+ */
+static int rewrite_copy(FILE *out, BLK_Device *dev, const GPT_Copy *good, uint64_t target_lba, const char *name)
+{
+    uint32_t sector_size = dev->logical_sector_size;
+    uint64_t sectors = entry_array_sectors(dev, &good->header);
+    size_t array_size = (size_t)good->header.num_partition_entries * good->header.size_of_partition_entry;
+    int is_primary = (target_lba == GPT_HEADER_LBA);
+
+    // Build the new header
+    GPT_Header header = good->header;
+    header.my_lba = target_lba;
+    header.alternate_lba = good->lba;
+    header.partition_entry_lba = is_primary ? GPT_HEADER_LBA + 1 : target_lba - sectors;
+
+    // The entry array must stay outside the usable area
+    if ((is_primary && header.partition_entry_lba + sectors > header.first_usable_lba) ||
+        (!is_primary && header.partition_entry_lba <= header.last_usable_lba))
+    {
+        fprintf(out, "GPT repair: no room for the %s entry array\n", name);
+        return -1;
+    }
+
+    char header_sector[GPT_HEADER_SECTOR_SIZE];
+    memcpy(header_sector, good->raw_header, sizeof(header_sector));
+    header.header_crc32 = 0;
+    memcpy(header_sector, &header, sizeof(header));
+    header.header_crc32 = CRC32_compute(header_sector, header.header_size);
+    memcpy(header_sector, &header, sizeof(header));
+
+    // Write the entry array, then the header that commits it
+    if (BLK_write_span(dev, header.partition_entry_lba * sector_size, good->entries, array_size) != 0 ||
+        BLK_write_span(dev, target_lba * sector_size, header_sector, sizeof(header_sector)) != 0)
+    {
+        fprintf(out, "GPT repair: failed to write the %s GPT: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    fprintf(out, "GPT repair: rewrote %s header at LBA %" PRIu64 " and entry array at LBA %" PRIu64 "\n",
+            name, target_lba, header.partition_entry_lba);
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Repairs a damaged or mismatching GPT copy from the intact one.
+ *
+ * This function performs the following tasks:
+ * 1. Picks the source copy: the primary if it is intact, otherwise the backup.
+ * 2. If the primary is the source and the backup is damaged, misplaced or different,
+ *    rewrites the backup at the primary's AlternateLBA (or the last LBA if that is
+ *    out of range).
+ * 3. If the backup is the source, rewrites the primary at LBA 1.
+ * 4. Flushes the device with fsync.
+ *
+ * @param out: Stream the result is printed to.
+ * @param dev: The device (opened with `BLK_FLAG_WRITE`).
+ * @param primary: The primary copy.
+ * @param backup: The backup copy.
+ *
+ * @return 0 on success or if nothing needed repair, -1 on error.
+ */
+int GPT_repair(FILE *out, BLK_Device *dev, const GPT_Copy *primary, const GPT_Copy *backup)
+{
+    int status;
+
+    if (GPT_copy_is_intact(primary))
+    {
+        uint64_t target = primary->header.alternate_lba;
+        if (target <= primary->header.last_usable_lba || target > last_lba(dev))
+        {
+            target = last_lba(dev);
+        }
+
+        if (GPT_copy_is_intact(backup) && backup->lba == target && compare_copies(NULL, primary, backup) == 0)
+        {
+            return 0; // Both copies are healthy and consistent
+        }
+
+        status = rewrite_copy(out, dev, primary, target, "backup");
+
+        // Keep the primary pointing at the rewritten backup
+        if (status == 0 && primary->header.alternate_lba != target)
+        {
+            GPT_Copy rebuilt_backup = *primary;
+            rebuilt_backup.lba = target;
+            status = rewrite_copy(out, dev, &rebuilt_backup, GPT_HEADER_LBA, "primary");
+        }
+    }
+    else if (GPT_copy_is_intact(backup))
+    {
+        status = rewrite_copy(out, dev, backup, GPT_HEADER_LBA, "primary");
+    }
+    else
+    {
+        fprintf(out, "GPT repair: no intact GPT copy to repair from\n");
+        return -1;
+    }
+
+    if (status == 0 && BLK_sync(dev) != 0)
+    {
+        fprintf(out, "GPT repair: fsync failed: %s\n", strerror(errno));
+        status = -1;
+    }
+
+    return status;
+}
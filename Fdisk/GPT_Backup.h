@@ -0,0 +1,72 @@
+/**
+ *===================================================================================
+ * @file           : GPT_Backup.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of GPT_Backup (primary/backup GPT verification and repair)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _GPT_BACKUP_H_
+#define _GPT_BACKUP_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "GPT_Parsing.h"  // Provides GPT_Header, GPT_PartitionEntry and the CRC32 checks
+#include "Block_IO.h"     // Provides BLK_Device reads and writes
+#include "Sector_Cache.h" // Provides the read-ahead sector cache the GPT is read through
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Represents one copy (primary or backup) of a GPT: its header and entry array.
+ *
+ * Fields:
+ *
+ * @param lba: LBA the header was read from.
+ * @param raw_header: Raw header bytes as read from the disk (used for the header CRC).
+ * @param header: Parsed header; only meaningful if `header_valid` is set.
+ * @param entries: Entry array (points into the image mapping or into `buffer`), or NULL.
+ * @param buffer: Heap buffer owning the entry array when it had to be read.
+ * @param header_valid: The header was read and has a valid signature and geometry.
+ * @param header_crc_ok: The header CRC32 matches.
+ * @param entries_crc_ok: The entry array was read and its CRC32 matches.
+ */
+typedef struct {
+    uint64_t lba;                                /**< LBA of the header. */
+    char raw_header[GPT_HEADER_SECTOR_SIZE];     /**< Raw header sector. */
+    GPT_Header header;                           /**< Parsed header. */
+    const char *entries;                         /**< Entry array, or NULL. */
+    char *buffer;                                /**< Owned entry array buffer, or NULL. */
+    int header_valid;                            /**< Header signature/geometry valid. */
+    int header_crc_ok;                           /**< Header CRC32 matches. */
+    int entries_crc_ok;                          /**< Entry array CRC32 matches. */
+} GPT_Copy;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+void GPT_load_copy(CACHE_Cache *cache, uint64_t lba, GPT_Copy *copy);
+void GPT_free_copy(GPT_Copy *copy);
+int GPT_copy_is_intact(const GPT_Copy *copy);
+const GPT_Copy *GPT_select_copy(const GPT_Copy *primary, const GPT_Copy *backup);
+int GPT_report_integrity(FILE *out, const BLK_Device *dev, const GPT_Copy *primary, const GPT_Copy *backup);
+int GPT_repair(FILE *out, BLK_Device *dev, const GPT_Copy *primary, const GPT_Copy *backup);
+
+#endif
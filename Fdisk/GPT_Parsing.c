@@ -17,6 +17,10 @@
  ******************************  Includes  ***********************************
  ============================================================================*/ 
 #include "GPT_Parsing.h" // Includes the custom header file for GPT parsing functionalities (e.g., data structures, function declarations for handling GPT)
+#include <stddef.h>      // Provides offsetof, used to locate the CRC field inside the GPT header
+#include <ctype.h>       // Provides isxdigit, used to parse GUID strings
+#include <endian.h>      // Provides le16toh, le32toh and be64toh, used to build type keys
+#include "UTF16.h"       // Provides the conversion of partition names to UTF-8
 
 
 
@@ -27,56 +31,290 @@
  ******************************  Functions  **********************************
  ============================================================================*/
 /**
- * GPT Partition Type Array
+ * GPT Partition Type Table
  *
- * This array defines known GUID Partition Table (GPT) partition types by associating 
- * their GUID (Globally Unique Identifier) with a human-readable description. 
- * These partition types correspond to different filesystems, boot partitions, 
- * and other utilities commonly used in GPT-based partition tables.
+ * This table associates the known GUID Partition Table (GPT) partition type GUIDs with a
+ * human-readable description, covering firmware/boot partitions, Windows, Linux (including
+ * the per-architecture root, /usr and verity types of the Discoverable Partitions
+ * Specification), LVM, RAID and LUKS, the BSDs, macOS, Solaris and ZFS, VMware, ChromeOS
+ * and Ceph.
  *
- * The GUIDs used in GPT are globally unique 128-bit numbers, and they define the
- * type of partition as well as the filesystem or operating system it belongs to.
- * 
- * The following table lists common GPT partition types:
- *
- * - Microsoft basic data: Used for Windows filesystems (e.g., NTFS, FAT32)
- * - EFI System: Contains the boot loader for UEFI systems
- * - Microsoft reserved: Reserved partition for Windows systems
- * - Windows recovery environment: Recovery partition for Windows
- * - Linux filesystem: Common partition for Linux filesystems (e.g., ext4)
- * - Linux swap: Used for swap space in Linux
- * - Apple HFS+: Filesystem used in macOS before APFS
- * - Apple Boot: Boot partition used by macOS systems
- * - VMware VMFS: Filesystem used in VMware environments
- * - Apple APFS: Apple's newer filesystem, used in macOS High Sierra and later
- * - BIOS boot partition: Partition used for BIOS booting on GPT systems
- * - MBR partition scheme: Protective MBR for backward compatibility
- * - Intel Fast Flash: Used by Intel for fast flash technologies
- * - Lenovo boot partition: Specific boot partition used by Lenovo devices
- *
- * @param guid: The partition type GUID as a string.
- * @param description: Human-readable description of the partition type.
+ * Every GUID is stored as a 128-bit binary key split into two 64-bit words, in the order
+ * the GUID is written (`high` = first three groups, `low` = last two groups), so entries
+ * are compared with two integer comparisons and no string is ever formatted. The table is
+ * sorted by (`high`, `low`) for binary search: keep it sorted when adding a type.
+ *
+ * @param high: First 64 bits of the type GUID (XXXXXXXX-XXXX-XXXX).
+ * @param low: Last 64 bits of the type GUID (XXXX-XXXXXXXXXXXX).
+ * @param name: Human-readable description of the partition type.
  */
-GPT_PartitionType partition_types[] = 
+static const GPT_PartitionType partition_types[] =
 {
-    {"EBD0A0A2-B9E5-4433-87C0-68B6B72699C7", "Microsoft basic data"},
-    {"C12A7328-F81F-11D2-BA4B-00A0C93EC93B", "EFI System"},
-    {"E3C9E316-0B5C-4DB8-817D-F92DF00215AE", "Microsoft reserved"},
-    {"DE94BBA4-06D1-4D40-A16A-BFD50179D6AC", "Windows recovery environment"},
-    {"0FC63DAF-8483-4772-8E79-3D69D8477DE4", "Linux filesystem"},
-    {"A19D880F-05FC-4D3B-A006-743F0F84911E", "Linux swap"},
-    {"48465300-0000-11AA-AA11-00306543ECAC", "Apple HFS+"},
-    {"426F6F74-0000-11AA-AA11-00306543ECAC", "Apple Boot"},
-    {"AA31E02A-400F-11DB-9590-000C2911D1B8", "VMware VMFS"},
-    {"9D275380-40AD-11DB-BF97-000C2911D1B8", "VMware reserved"},
-    {"7C3457EF-0000-11AA-AA11-00306543ECAC", "Apple APFS"},
-    {"21686148-6449-6E6F-744E-656564454649", "BIOS boot partition"},
-    {"024DEE41-33E7-11D3-9D69-0008C781F39F", "MBR partition scheme"},
-    {"D3BFE2DE-3DAF-11DF-BA40-E3A556D89593", "Intel Fast Flash"},
-    {"7412F7D5-A156-4B13-81DC-867174929325", "Lenovo boot partition"},
-    {NULL, NULL}
+    { 0x024DEE4133E711D3ULL, 0x9D690008C781F39FULL, "MBR partition scheme" },            // 024DEE41-33E7-11D3-9D69-0008C781F39F
+    { 0x0657FD6DA4AB43C4ULL, 0x84E50933C84B4F4FULL, "Linux swap" },                      // 0657FD6D-A4AB-43C4-84E5-0933C84B4F4F
+    { 0x09845860705F4BB5ULL, 0xB16C8A8A099CAF52ULL, "ChromeOS minios" },                 // 09845860-705F-4BB5-B16C-8A8A099CAF52
+    { 0x0FC63DAF84834772ULL, 0x8E793D69D8477DE4ULL, "Linux filesystem" },                // 0FC63DAF-8483-4772-8E79-3D69D8477DE4
+    { 0x2168614864496E6FULL, 0x744E656564454649ULL, "BIOS boot" },                       // 21686148-6449-6E6F-744E-656564454649
+    { 0x2C7357EDEBD246D9ULL, 0xAEC123D437EC2BF5ULL, "Linux root verity (x86-64)" },      // 2C7357ED-EBD2-46D9-AEC1-23D437EC2BF5
+    { 0x2DB519C4B10F11DCULL, 0xB99B0019D1879648ULL, "NetBSD concatenated" },             // 2DB519C4-B10F-11DC-B99B-0019D1879648
+    { 0x2DB519ECB10F11DCULL, 0xB99B0019D1879648ULL, "NetBSD encrypted" },                // 2DB519EC-B10F-11DC-B99B-0019D1879648
+    { 0x2E0A753D9E4843B0ULL, 0x8337B15192CB1B5EULL, "ChromeOS reserved" },               // 2E0A753D-9E48-43B0-8337-B15192CB1B5E
+    { 0x30CD0809C2B2499CULL, 0x88792D6B78529876ULL, "Ceph block DB" },                   // 30CD0809-C2B2-499C-8879-2D6B78529876
+    { 0x37AFFC90EF7D4E96ULL, 0x91C32D7AE055B174ULL, "IBM General Parallel Fs" },         // 37AFFC90-EF7D-4E96-91C3-2D7AE055B174
+    { 0x381CFCCC728811E0ULL, 0x92EE000C2911D0B2ULL, "VMware Virtual SAN" },              // 381CFCCC-7288-11E0-92EE-000C2911D0B2
+    { 0x3B8F842520E04F3BULL, 0x907F1A25A76F98E8ULL, "Linux server data" },               // 3B8F8425-20E0-4F3B-907F-1A25A76F98E8
+    { 0x3CB8E2023B7E47DDULL, 0x8A3C7FF2A13CFCECULL, "ChromeOS root fs" },                // 3CB8E202-3B7E-47DD-8A3C-7FF2A13CFCEC
+    { 0x3F0F8318F1464E6BULL, 0x8222C28C8F02E0D5ULL, "ChromeOS hibernate" },              // 3F0F8318-F146-4E6B-8222-C28C8F02E0D5
+    { 0x424653313BA310F1ULL, 0x802A4861696B7521ULL, "Haiku BFS" },                       // 42465331-3BA3-10F1-802A-4861696B7521
+    { 0x426F6F74000011AAULL, 0xAA1100306543ECACULL, "Apple boot" },                      // 426F6F74-0000-11AA-AA11-00306543ECAC
+    { 0x44479540F29741B2ULL, 0x9AF7D131D5F0458AULL, "Linux root (x86)" },                // 44479540-F297-41B2-9AF7-D131D5F0458A
+    { 0x45B0969E8AE04982ULL, 0xBF9D5A8D867AF560ULL, "Ceph multipath journal" },          // 45B0969E-8AE0-4982-BF9D-5A8D867AF560
+    { 0x45B0969E9B034F30ULL, 0xB4C65EC00CEFF106ULL, "Ceph Encrypted Journal" },          // 45B0969E-9B03-4F30-B4C6-5EC00CEFF106
+    { 0x45B0969E9B034F30ULL, 0xB4C6B4B80CEFF106ULL, "Ceph Journal" },                    // 45B0969E-9B03-4F30-B4C6-B4B80CEFF106
+    { 0x48465300000011AAULL, 0xAA1100306543ECACULL, "Apple HFS/HFS+" },                  // 48465300-0000-11AA-AA11-00306543ECAC
+    { 0x49F48D32B10E11DCULL, 0xB99B0019D1879648ULL, "NetBSD swap" },                     // 49F48D32-B10E-11DC-B99B-0019D1879648
+    { 0x49F48D5AB10E11DCULL, 0xB99B0019D1879648ULL, "NetBSD FFS" },                      // 49F48D5A-B10E-11DC-B99B-0019D1879648
+    { 0x49F48D82B10E11DCULL, 0xB99B0019D1879648ULL, "NetBSD LFS" },                      // 49F48D82-B10E-11DC-B99B-0019D1879648
+    { 0x49F48DAAB10E11DCULL, 0xB99B0019D1879648ULL, "NetBSD RAID" },                     // 49F48DAA-B10E-11DC-B99B-0019D1879648
+    { 0x4C6162656C0011AAULL, 0xAA1100306543ECACULL, "Apple label" },                     // 4C616265-6C00-11AA-AA11-00306543ECAC
+    { 0x4D21B016B53445C2ULL, 0xA9FB5C16E091FD2DULL, "Linux variable data" },             // 4D21B016-B534-45C2-A9FB-5C16E091FD2D
+    { 0x4F68BCE3E8CD4DB1ULL, 0x96E7FBCAF984B709ULL, "Linux root (x86-64)" },             // 4F68BCE3-E8CD-4DB1-96E7-FBCAF984B709
+    { 0x4FBD7E298AE04982ULL, 0xBF9D5A8D867AF560ULL, "Ceph multipath OSD" },              // 4FBD7E29-8AE0-4982-BF9D-5A8D867AF560
+    { 0x4FBD7E299D2541B8ULL, 0xAFD0062C0CEFF05DULL, "Ceph OSD" },                        // 4FBD7E29-9D25-41B8-AFD0-062C0CEFF05D
+    { 0x4FBD7E299D2541B8ULL, 0xAFD05EC00CEFF05DULL, "Ceph crypt OSD" },                  // 4FBD7E29-9D25-41B8-AFD0-5EC00CEFF05D
+    { 0x516E7CB46ECF11D6ULL, 0x8FF800022D09712BULL, "FreeBSD data" },                    // 516E7CB4-6ECF-11D6-8FF8-00022D09712B
+    { 0x516E7CB56ECF11D6ULL, 0x8FF800022D09712BULL, "FreeBSD swap" },                    // 516E7CB5-6ECF-11D6-8FF8-00022D09712B
+    { 0x516E7CB66ECF11D6ULL, 0x8FF800022D09712BULL, "FreeBSD UFS" },                     // 516E7CB6-6ECF-11D6-8FF8-00022D09712B
+    { 0x516E7CB86ECF11D6ULL, 0x8FF800022D09712BULL, "FreeBSD Vinum" },                   // 516E7CB8-6ECF-11D6-8FF8-00022D09712B
+    { 0x516E7CBA6ECF11D6ULL, 0x8FF800022D09712BULL, "FreeBSD ZFS" },                     // 516E7CBA-6ECF-11D6-8FF8-00022D09712B
+    { 0x52414944000011AAULL, 0xAA1100306543ECACULL, "Apple RAID" },                      // 52414944-0000-11AA-AA11-00306543ECAC
+    { 0x524149445F4F11AAULL, 0xAA1100306543ECACULL, "Apple RAID offline" },              // 52414944-5F4F-11AA-AA11-00306543ECAC
+    { 0x5265636F766511AAULL, 0xAA1100306543ECACULL, "Apple TV recovery" },               // 5265636F-7665-11AA-AA11-00306543ECAC
+    { 0x53746F72616711AAULL, 0xAA1100306543ECACULL, "Apple Core storage" },              // 53746F72-6167-11AA-AA11-00306543ECAC
+    { 0x55465300000011AAULL, 0xAA1100306543ECACULL, "Apple UFS" },                       // 55465300-0000-11AA-AA11-00306543ECAC
+    { 0x558D43C5A1AC43C0ULL, 0xAAC8D1472B2923D1ULL, "Microsoft Storage Replica" },       // 558D43C5-A1AC-43C0-AAC8-D1472B2923D1
+    { 0x5808C8AA7E8F42E0ULL, 0x85D2E1E90434CFB3ULL, "Microsoft LDM metadata" },          // 5808C8AA-7E8F-42E0-85D2-E1E90434CFB3
+    { 0x5CE17FCE40874169ULL, 0xB7FF056CC58473F9ULL, "Ceph block write-ahead log" },      // 5CE17FCE-4087-4169-B7FF-056CC58473F9
+    { 0x5EEAD9A9FE094A1EULL, 0xA1D7520D00531306ULL, "Linux root (S390X)" },              // 5EEAD9A9-FE09-4A1E-A1D7-520D00531306
+    { 0x60D5A7FE8E7D435CULL, 0xB7143DD8162144E1ULL, "Linux root (RISC-V-32)" },          // 60D5A7FE-8E7D-435C-B714-3DD8162144E1
+    { 0x69DAD7102CE44E3CULL, 0xB16C21A1D49ABED3ULL, "Linux root (ARM)" },                // 69DAD710-2CE4-4E3C-B16C-21A1D49ABED3
+    { 0x6A82CB451DD211B2ULL, 0x99A6080020736631ULL, "Solaris boot" },                    // 6A82CB45-1DD2-11B2-99A6-080020736631
+    { 0x6A85CF4D1DD211B2ULL, 0x99A6080020736631ULL, "Solaris root" },                    // 6A85CF4D-1DD2-11B2-99A6-080020736631
+    { 0x6A87C46F1DD211B2ULL, 0x99A6080020736631ULL, "Solaris swap" },                    // 6A87C46F-1DD2-11B2-99A6-080020736631
+    { 0x6A898CC31DD211B2ULL, 0x99A6080020736631ULL, "Solaris /usr & Apple ZFS" },        // 6A898CC3-1DD2-11B2-99A6-080020736631
+    { 0x6A8B642B1DD211B2ULL, 0x99A6080020736631ULL, "Solaris backup" },                  // 6A8B642B-1DD2-11B2-99A6-080020736631
+    { 0x6A8D2AC71DD211B2ULL, 0x99A6080020736631ULL, "Solaris reserved 5" },              // 6A8D2AC7-1DD2-11B2-99A6-080020736631
+    { 0x6A8EF2E91DD211B2ULL, 0x99A6080020736631ULL, "Solaris /var" },                    // 6A8EF2E9-1DD2-11B2-99A6-080020736631
+    { 0x6A90BA391DD211B2ULL, 0x99A6080020736631ULL, "Solaris /home" },                   // 6A90BA39-1DD2-11B2-99A6-080020736631
+    { 0x6A9283A51DD211B2ULL, 0x99A6080020736631ULL, "Solaris alternate sector" },        // 6A9283A5-1DD2-11B2-99A6-080020736631
+    { 0x6A945A3B1DD211B2ULL, 0x99A6080020736631ULL, "Solaris reserved 1" },              // 6A945A3B-1DD2-11B2-99A6-080020736631
+    { 0x6A96237F1DD211B2ULL, 0x99A6080020736631ULL, "Solaris reserved 4" },              // 6A96237F-1DD2-11B2-99A6-080020736631
+    { 0x6A9630D11DD211B2ULL, 0x99A6080020736631ULL, "Solaris reserved 2" },              // 6A9630D1-1DD2-11B2-99A6-080020736631
+    { 0x6A9807671DD211B2ULL, 0x99A6080020736631ULL, "Solaris reserved 3" },              // 6A980767-1DD2-11B2-99A6-080020736631
+    { 0x72EC70A6CF7440E6ULL, 0xBD494BDA08E8F224ULL, "Linux root (RISC-V-64)" },          // 72EC70A6-CF74-40E6-BD49-4BDA08E8F224
+    { 0x7412F7D5A1564B13ULL, 0x81DC867174929325ULL, "ONIE boot" },                       // 7412F7D5-A156-4B13-81DC-867174929325
+    { 0x75250D768CC6458EULL, 0xBD66BD47CC81A812ULL, "Linux /usr (x86)" },                // 75250D76-8CC6-458E-BD66-BD47CC81A812
+    { 0x75894C1E3AEB11D3ULL, 0xB7C17B03A0000000ULL, "HP-UX data" },                      // 75894C1E-3AEB-11D3-B7C1-7B03A0000000
+    { 0x77055800792C4F94ULL, 0xB39A98C91B762BB6ULL, "Linux root (LoongArch-64)" },       // 77055800-792C-4F94-B39A-98C91B762BB6
+    { 0x773F91EF66D449B5ULL, 0xBD83D683BF40AD16ULL, "Linux user's home" },               // 773F91EF-66D4-49B5-BD83-D683BF40AD16
+    { 0x77719A0CA4A011E3ULL, 0xA47E000C29745A24ULL, "VMware Virsto" },                   // 77719A0C-A4A0-11E3-A47E-000C29745A24
+    { 0x7C3457EF000011AAULL, 0xAA1100306543ECACULL, "Apple APFS" },                      // 7C3457EF-0000-11AA-AA11-00306543ECAC
+    { 0x7D0359A302B34F0AULL, 0x865C654403E70625ULL, "Linux /usr (ARM)" },                // 7D0359A3-02B3-4F0A-865C-654403E70625
+    { 0x7EC6F5573BC54ACAULL, 0xB29316EF5DF639D1ULL, "Linux temporary data" },            // 7EC6F557-3BC5-4ACA-B293-16EF5DF639D1
+    { 0x7FFEC5C92D0049B7ULL, 0x89413EA10A5586B7ULL, "Linux plain dm-crypt" },            // 7FFEC5C9-2D00-49B7-8941-3EA10A5586B7
+    { 0x824CC7A036A811E3ULL, 0x890A952519AD3F61ULL, "OpenBSD data" },                    // 824CC7A0-36A8-11E3-890A-952519AD3F61
+    { 0x83BD6B9D7F4111DCULL, 0xBE0B001560B84F0FULL, "FreeBSD boot" },                    // 83BD6B9D-7F41-11DC-BE0B-001560B84F0F
+    { 0x8484680C952148C6ULL, 0x9C11B0720656F69EULL, "Linux /usr (x86-64)" },             // 8484680C-9521-48C6-9C11-B0720656F69E
+    { 0x89C57F982FE54DC0ULL, 0x89C15EC00CEFF2BEULL, "Ceph crypt disk in creation" },     // 89C57F98-2FE5-4DC0-89C1-5EC00CEFF2BE
+    { 0x89C57F982FE54DC0ULL, 0x89C1F3AD0CEFF2BEULL, "Ceph disk in creation" },           // 89C57F98-2FE5-4DC0-89C1-F3AD0CEFF2BE
+    { 0x8C8F8EFFAC954770ULL, 0x814A21994F2DBC8FULL, "VeraCrypt" },                       // 8C8F8EFF-AC95-4770-814A-21994F2DBC8F
+    { 0x8DA63339000760C0ULL, 0xC436083AC8230908ULL, "Linux reserved" },                  // 8DA63339-0007-60C0-C436-083AC8230908
+    { 0x9198EFFC31C011DBULL, 0x8F78000C2911D1B8ULL, "VMware Reserved" },                 // 9198EFFC-31C0-11DB-8F78-000C2911D1B8
+    { 0x933AC7E12EB44F13ULL, 0xB8440E14E2AEF915ULL, "Linux home" },                      // 933AC7E1-2EB4-4F13-B844-0E14E2AEF915
+    { 0x993D8D3DF80E4225ULL, 0x855A9DAF8ED7EA97ULL, "Linux root (IA-64)" },              // 993D8D3D-F80E-4225-855A-9DAF8ED7EA97
+    { 0x9D27538040AD11DBULL, 0xBF97000C2911D1B8ULL, "VMware Diagnostic" },               // 9D275380-40AD-11DB-BF97-000C2911D1B8
+    { 0x9E1A2D38C6124316ULL, 0xAA268B49521E5A8BULL, "PowerPC PReP boot" },               // 9E1A2D38-C612-4316-AA26-8B49521E5A8B
+    { 0xA19D880F05FC4D3BULL, 0xA006743F0F84911EULL, "Linux RAID" },                      // A19D880F-05FC-4D3B-A006-743F0F84911E
+    { 0xAA31E02A400F11DBULL, 0x9590000C2911D1B8ULL, "VMware VMFS" },                     // AA31E02A-400F-11DB-9590-000C2911D1B8
+    { 0xAF9B60A014314F62ULL, 0xBC683311714A69ADULL, "Microsoft LDM data" },              // AF9B60A0-1431-4F62-BC68-3311714A69AD
+    { 0xB0E01050EE5F4390ULL, 0x949A9101B17104E9ULL, "Linux /usr (ARM-64)" },             // B0E01050-EE5F-4390-949A-9101B17104E9
+    { 0xB921B0451DF041C3ULL, 0xAF444C6F280D3FAEULL, "Linux root (ARM-64)" },             // B921B045-1DF0-41C3-AF44-4C6F280D3FAE
+    { 0xBC13C2FF59E64262ULL, 0xA352B275FD6F7172ULL, "Linux extended boot" },             // BC13C2FF-59E6-4262-A352-B275FD6F7172
+    { 0xBFBFAFE7A34F448AULL, 0x9A5B6213EB736C22ULL, "Lenovo boot partition" },           // BFBFAFE7-A34F-448A-9A5B-6213EB736C22
+    { 0xC12A7328F81F11D2ULL, 0xBA4B00A0C93EC93BULL, "EFI System" },                      // C12A7328-F81F-11D2-BA4B-00A0C93EC93B
+    { 0xC31C45E63F39412EULL, 0x80FB4809C4980599ULL, "Linux root (PPC64LE)" },            // C31C45E6-3F39-412E-80FB-4809C4980599
+    { 0xC91818F9802547AFULL, 0x89D2F030D7000C2CULL, "Plan 9 partition" },                // C91818F9-8025-47AF-89D2-F030D7000C2C
+    { 0xCA7D7CCB63ED4C53ULL, 0x861C1742536059CCULL, "Linux LUKS" },                      // CA7D7CCB-63ED-4C53-861C-1742536059CC
+    { 0xCAB6E88EABF34102ULL, 0xA07AD4BB9BE3C1D3ULL, "ChromeOS firmware" },               // CAB6E88E-ABF3-4102-A07A-D4BB9BE3C1D3
+    { 0xCAFECAFE9B034F30ULL, 0xB4C6B4B80CEFF106ULL, "Ceph block" },                      // CAFECAFE-9B03-4F30-B4C6-B4B80CEFF106
+    { 0xCEF5A9AD73BC4601ULL, 0x89F3CDEEEEE321A1ULL, "QNX6 file system" },                // CEF5A9AD-73BC-4601-89F3-CDEEEEE321A1
+    { 0xD3BFE2DE3DAF11DFULL, 0xBA40E3A556D89593ULL, "Intel Fast Flash" },                // D3BFE2DE-3DAF-11DF-BA40-E3A556D89593
+    { 0xD4E6E2CD446946F3ULL, 0xB5CB1BFF57AFC149ULL, "ONIE config" },                     // D4E6E2CD-4469-46F3-B5CB-1BFF57AFC149
+    { 0xDE94BBA406D14D40ULL, 0xA16ABFD50179D6ACULL, "Windows recovery environment" },    // DE94BBA4-06D1-4D40-A16A-BFD50179D6AC
+    { 0xDF3300CED69F4C92ULL, 0x978C9BFB0F38D820ULL, "Linux root verity (ARM-64)" },      // DF3300CE-D69F-4C92-978C-9BFB0F38D820
+    { 0xE2A1E72832E311D6ULL, 0xA6827B03A0000000ULL, "HP-UX service" },                   // E2A1E728-32E3-11D6-A682-7B03A0000000
+    { 0xE3C9E3160B5C4DB8ULL, 0x817DF92DF00215AEULL, "Microsoft reserved" },              // E3C9E316-0B5C-4DB8-817D-F92DF00215AE
+    { 0xE6D6D379F50744C2ULL, 0xA23C238F2A3DF928ULL, "Linux LVM" },                       // E6D6D379-F507-44C2-A23C-238F2A3DF928
+    { 0xE75CAF8FF6804CEEULL, 0xAFA3B001E56EFC2DULL, "Microsoft Storage Spaces" },        // E75CAF8F-F680-4CEE-AFA3-B001E56EFC2D
+    { 0xEBD0A0A2B9E54433ULL, 0x87C068B6B72699C7ULL, "Microsoft basic data" },            // EBD0A0A2-B9E5-4433-87C0-68B6B72699C7
+    { 0xF4019732066E4E12ULL, 0x8273346C5641494FULL, "Sony boot partition" },             // F4019732-066E-4E12-8273-346C5641494F
+    { 0xFB3AABF9D25F47CCULL, 0xBF5E721D1816496BULL, "Ceph lockbox for dm-crypt keys" },  // FB3AABF9-D25F-47CC-BF5E-721D1816496B
+    { 0xFE3A2A5D4F3241A7ULL, 0xB725ACCC3285A309ULL, "ChromeOS kernel" },                 // FE3A2A5D-4F32-41A7-B725-ACCC3285A309
 };
 
+/**
+ * Number of entries in `partition_types`.
+ */
+#define PARTITION_TYPE_COUNT        (sizeof(partition_types) / sizeof(partition_types[0]))
+
+
+
+
+
+
+
+
+/**
+ * Sanity-checks the fields of a GPT header, without printing anything.
+ *
+ * This function validates the parts of the header that the parsers rely on:
+ * 1. The "EFI PART" signature.
+ * 2. `header_size` lies between `GPT_HEADER_MIN_SIZE` and `GPT_HEADER_SECTOR_SIZE`.
+ * 3. `size_of_partition_entry` is at least `GPT_ENTRY_SIZE` and a multiple of 8.
+ * 4. The entry array (count * entry size) is not empty and fits `GPT_MAX_ENTRY_ARRAY_SIZE`.
+ *
+ * The CRC32 fields are not checked here; see `GPT_verify_header_crc` and `GPT_verify_entry_array`.
+ *
+ * @param header: Pointer to the header copied out of its sector.
+ *
+ * @return `GPT_HEADER_OK`, or the first check that failed.
+ */
+GPT_HeaderCheck GPT_check_header(const GPT_Header *header)
+{
+    if (header->signature != GPT_HEADER_SIGNATURE) 
+    {
+        return GPT_HEADER_BAD_SIGNATURE;
+    }
+
+    if (header->header_size < GPT_HEADER_MIN_SIZE || header->header_size > GPT_HEADER_SECTOR_SIZE) 
+    {
+        return GPT_HEADER_BAD_SIZE;
+    }
+
+    if (header->size_of_partition_entry < GPT_ENTRY_SIZE || (header->size_of_partition_entry % 8) != 0) 
+    {
+        return GPT_HEADER_BAD_ENTRY_SIZE;
+    }
+
+    uint64_t array_size = (uint64_t)header->num_partition_entries * header->size_of_partition_entry;
+    if (array_size == 0 || array_size > GPT_MAX_ENTRY_ARRAY_SIZE) 
+    {
+        return GPT_HEADER_BAD_ARRAY_SIZE;
+    }
+
+    return GPT_HEADER_OK;
+}
+
+
+
+
+
+
+
+/**
+ * Parses and sanity-checks a GPT header from a raw sector.
+ *
+ * This function copies the header fields out of the sector, checks them with
+ * `GPT_check_header` and prints which check failed.
+ *
+ * @param sector: Pointer to the raw sector holding the header (at least `GPT_HEADER_SECTOR_SIZE` bytes).
+ * @param header: Pointer to the structure that receives the parsed header.
+ *
+ * @return 0 on success, or -1 if the sector does not hold a usable GPT header.
+ */
+int GPT_parse_header(const char *sector, GPT_Header *header) 
+{
+    // Validate input parameters
+    if (sector == NULL || header == NULL) 
+    {
+        fprintf(stderr, "Error: Invalid input - sector or header cannot be NULL\n");
+        return -1;
+    }
+
+    memcpy(header, sector, sizeof(GPT_Header));
+
+    switch (GPT_check_header(header))
+    {
+        case GPT_HEADER_OK:
+            return 0;
+        case GPT_HEADER_BAD_SIGNATURE:
+            fprintf(stderr, "Error: Invalid GPT header signature\n");
+            break;
+        case GPT_HEADER_BAD_SIZE:
+            fprintf(stderr, "Error: Invalid GPT header size: %" PRIu32 "\n", header->header_size);
+            break;
+        case GPT_HEADER_BAD_ENTRY_SIZE:
+            fprintf(stderr, "Error: Invalid GPT entry size: %" PRIu32 "\n", header->size_of_partition_entry);
+            break;
+        case GPT_HEADER_BAD_ARRAY_SIZE:
+            fprintf(stderr, "Error: Invalid GPT entry array size: %" PRIu64 " bytes\n",
+                    (uint64_t)header->num_partition_entries * header->size_of_partition_entry);
+            break;
+    }
+    return -1;
+}
+
+
+
+
+
+
+
+/**
+ * Verifies the CRC32 of a GPT header.
+ *
+ * The header CRC covers `header_size` bytes of the header with the `header_crc32` field 
+ * itself set to zero, so the check is done on a local copy of the sector.
+ *
+ * @param sector: Pointer to the raw sector holding the header.
+ * @param header: Pointer to the parsed header (provides `header_size` and the stored CRC).
+ *
+ * @return true if the stored CRC matches the computed one, false otherwise.
+ */
+bool GPT_verify_header_crc(const char *sector, const GPT_Header *header) 
+{
+    char copy[GPT_HEADER_SECTOR_SIZE];
+
+    memcpy(copy, sector, header->header_size);
+    memset(copy + offsetof(GPT_Header, header_crc32), 0, sizeof(header->header_crc32));
+
+    return CRC32_compute(copy, header->header_size) == header->header_crc32;
+}
+
+
+
+
+
+
+
+/**
+ * Verifies the CRC32 of a GPT partition entry array.
+ *
+ * The CRC covers `num_partition_entries * size_of_partition_entry` bytes starting at the 
+ * first entry, exactly as the array is laid out on disk.
+ *
+ * @param header: Pointer to the parsed header (provides the geometry and the stored CRC).
+ * @param entries: Pointer to the whole entry array as read from the disk.
+ *
+ * @return true if the stored CRC matches the computed one, false otherwise.
+ */
+bool GPT_verify_entry_array(const GPT_Header *header, const void *entries) 
+{
+    size_t array_size = (size_t)header->num_partition_entries * header->size_of_partition_entry;
+
+    return CRC32_compute(entries, array_size) == header->partition_entry_array_crc32;
+}
+
 
 
 
@@ -130,45 +368,257 @@ bool convert_guid_to_string(const unsigned char *guid, char *guid_str)
 
 
 /**
- * Maps a GUID string to the corresponding GPT partition type.
+ * Converts a GUID string (XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX) into its 16-byte binary form.
  *
- * This function takes a GUID string and searches the partition_types array for a match.
- * If the GUID matches a known type, it returns the corresponding partition name.
- * If no match is found, it returns "Unknown Type".
+ * This is the inverse of `convert_guid_to_string`: the first three groups are stored 
+ * little-endian, the last two big-endian. Upper and lower case hex digits are accepted.
  *
- * @param type_guid: A string representing the GUID of the partition type.
- * @return: A string describing the partition type, or "Unknown Type" if no match is found.
+ * @param guid_str: The GUID string.
+ * @param guid: Buffer receiving the 16-byte binary GUID.
+ * @return: Returns true if successful, false if the string is not a valid GUID.
  */
-const char* GPT_get_partition_type(const char *type_guid) 
+bool convert_string_to_guid(const char *guid_str, unsigned char *guid) 
 {
-    // Validate the input parameter
-    if (type_guid == NULL) 
+    // Byte order of the string digits pairs inside the binary GUID
+    static const int order[GUID_SIZE] = { 3, 2, 1, 0, 5, 4, 7, 6, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+    // Validate input parameters
+    if (guid_str == NULL || guid == NULL || strlen(guid_str) != GUID_LEN) 
     {
-        fprintf(stderr, "Error: Invalid input - type_guid cannot be NULL\n");
-        return "Invalid GUID";
+        return false;
     }
 
-    // Ensure the input GUID string is of valid length
-    if (strlen(type_guid) != GUID_LEN) 
+    const char *p = guid_str;
+    for (int i = 0; i < GUID_SIZE; i++) 
     {
-        fprintf(stderr, "Error: Invalid GUID length\n");
-        return "Invalid GUID";
+        // Dashes separate the groups after bytes 4, 6, 8 and 10
+        if (i == 4 || i == 6 || i == 8 || i == 10) 
+        {
+            if (*p++ != '-') 
+            {
+                return false;
+            }
+        }
+
+        unsigned int byte;
+        if (!isxdigit((unsigned char)p[0]) || !isxdigit((unsigned char)p[1]) || sscanf(p, "%2x", &byte) != 1) 
+        {
+            return false;
+        }
+        guid[order[i]] = (unsigned char)byte;
+        p += 2;
+    }
+
+    return true;
+}
+
+
+
+
+
+
+/**
+ * Converts a binary GUID, as stored in a partition entry, into the two 64-bit words of a
+ * `partition_types` key (first three groups little-endian, last 8 bytes big-endian).
+ *
+ * @param guid: The 16-byte GUID.
+ * @param high: Receives the first three groups (XXXXXXXX-XXXX-XXXX).
+ * @param low: Receives the last two groups (XXXX-XXXXXXXXXXXX).
+ */
+static void guid_to_key(const unsigned char *guid, uint64_t *high, uint64_t *low)
+{
+    uint32_t time_low;
+    uint16_t time_mid, time_high;
+    uint64_t tail;
+
+    memcpy(&time_low, &guid[0], sizeof(time_low));
+    memcpy(&time_mid, &guid[4], sizeof(time_mid));
+    memcpy(&time_high, &guid[6], sizeof(time_high));
+    memcpy(&tail, &guid[8], sizeof(tail));
+    *high = ((uint64_t)le32toh(time_low) << 32) | ((uint64_t)le16toh(time_mid) << 16) | le16toh(time_high);
+    *low = be64toh(tail);
+}
+
+
+
+
+
+
+/**
+ * Maps a binary type GUID to the corresponding GPT partition type.
+ *
+ * The 16 bytes of the GUID, as stored in a partition entry (first three groups
+ * little-endian, last two big-endian), are converted into the two 64-bit words of the
+ * `partition_types` keys, which are then binary searched. No string is formatted or
+ * compared, so resolving a type costs a handful of integer comparisons.
+ *
+ * @param type_guid: The 16-byte partition type GUID of a partition entry.
+ * @return: A string describing the partition type, or NULL if the type is not known.
+ */
+const char* GPT_get_partition_type(const unsigned char *type_guid)
+{
+    uint64_t high, low;
+    guid_to_key(type_guid, &high, &low);
+
+    // Branchless binary search of the sorted table: the comparisons compile to conditional
+    // moves, so a table mixing many types does not pay for mispredicted branches
+    const GPT_PartitionType *base = partition_types;
+    size_t count = PARTITION_TYPE_COUNT;
+    while (count > 1)
+    {
+        size_t half = count / 2;
+        const GPT_PartitionType *middle = base + half;
+        int before = (middle->high < high) | ((middle->high == high) & (middle->low <= low));
+        base = before ? middle : base;
+        count -= half;
+    }
+
+    if (base->high == high && base->low == low)
+    {
+        return base->name;  // Return the matching partition type
+    }
+    return NULL;
+}
+
+
+
+
+
+
+
+/**
+ * Appends a word to an attribute text, separated from the previous word by a space.
+ *
+ * @param text: The attribute text.
+ * @param length: Current length of the text, updated.
+ * @param size: Size of the text buffer.
+ * @param word: The word to append.
+ * @param word_length: Length of the word.
+ */
+static void append_word(char *text, size_t *length, size_t size, const char *word, size_t word_length)
+{
+    size_t needed = word_length + (*length > 0);
+    if (*length + needed >= size)
+    {
+        return;  // Truncate: the buffer is smaller than GPT_ATTR_TEXT_SIZE
+    }
+    if (*length > 0)
+    {
+        text[(*length)++] = ' ';
     }
+    memcpy(text + *length, word, word_length);
+    *length += word_length;
+    text[*length] = '\0';
+}
+
+
 
-    // Iterate through the known partition types and check for a match
-    for (int i = 0; partition_types[i].guid_prefix != NULL; i++) 
+
+
+
+/**
+ * Formats GPT partition attributes as text.
+ *
+ * The UEFI bits are named as in sfdisk scripts (`RequiredPartition`, `NoBlockIOProtocol`,
+ * `LegacyBIOSBootable`). The type-specific bits 48-63 are decoded for the types that
+ * define them:
+ * - ChromeOS kernel: `priority=N` (bits 48-51), `tries=N` (bits 52-55), `successful` (bit 56).
+ * - Microsoft basic data: `ReadOnly` (60), `ShadowCopy` (61), `Hidden` (62), `NoDriveLetter` (63).
+ * Other type-specific bits are listed as `GUID:48,49,...` and reserved bits as `bitN`.
+ *
+ * With `script_syntax`, the text only uses the words `SCRIPT_parse` accepts in an `attrs=`
+ * field (UEFI names and `GUID:` bit lists, reserved bits are left out), so it can be fed
+ * back to `--script`.
+ *
+ * Most partitions have no attribute: that case returns before any formatting.
+ *
+ * @param attributes: The attribute bits of the partition entry.
+ * @param type_guid: The 16-byte partition type GUID (selects the type-specific names).
+ * @param script_syntax: Non-zero to produce sfdisk script syntax.
+ * @param text: Receives the NUL-terminated text (empty if no attribute is set).
+ * @param size: Size of `text` in bytes (`GPT_ATTR_TEXT_SIZE` always suffices).
+ *
+ * @return The length of the text.
+ */
+size_t GPT_format_attributes(uint64_t attributes, const unsigned char *type_guid, bool script_syntax, char *text, size_t size)
+{
+    static const char *const uefi_names[] = { "RequiredPartition", "NoBlockIOProtocol", "LegacyBIOSBootable" };
+    static const char *const windows_names[] = { "ReadOnly", "ShadowCopy", "Hidden", "NoDriveLetter" };
+    char word[32];
+    size_t length = 0;
+
+    text[0] = '\0';
+    if (attributes == 0)
     {
-        // Compare the GUID prefixes
-        if (strncmp(partition_types[i].guid_prefix, type_guid, GUID_LEN) == GUID_STRING_MATCH) 
+        return 0;
+    }
+
+    // UEFI bits, then the reserved bits 3-47
+    for (int bit = 0; bit < GPT_ATTR_TYPE_SPECIFIC; bit++)
+    {
+        if ((attributes & (1ULL << bit)) == 0)
+        {
+            continue;
+        }
+        if (bit <= GPT_ATTR_LEGACY_BOOTABLE)
         {
-            return partition_types[i].name;  // Return the matching partition type
+            append_word(text, &length, size, uefi_names[bit], strlen(uefi_names[bit]));
+        }
+        else if (!script_syntax)
+        {
+            append_word(text, &length, size, word, (size_t)snprintf(word, sizeof(word), "bit%d", bit));
         }
     }
 
-    // If no match is found, return "Unknown Type"
-    return "Unknown Type";  
-}
+    uint64_t type_bits = attributes >> GPT_ATTR_TYPE_SPECIFIC;
+    if (type_bits == 0)
+    {
+        return length;
+    }
+
+    // Type-specific bits, decoded for the known layouts
+    uint64_t high, low;
+    guid_to_key(type_guid, &high, &low);
+    if (!script_syntax && high == 0xFE3A2A5D4F3241A7ULL && low == 0xB725ACCC3285A309ULL)  // ChromeOS kernel
+    {
+        append_word(text, &length, size, word, (size_t)snprintf(word, sizeof(word), "priority=%u", (unsigned)(type_bits & 0xF)));
+        append_word(text, &length, size, word, (size_t)snprintf(word, sizeof(word), "tries=%u", (unsigned)((type_bits >> 4) & 0xF)));
+        if (type_bits & (1ULL << 8))
+        {
+            append_word(text, &length, size, "successful", strlen("successful"));
+        }
+        type_bits &= ~0x1FFULL;
+    }
+    else if (!script_syntax && high == 0xEBD0A0A2B9E54433ULL && low == 0x87C068B6B72699C7ULL)  // Microsoft basic data
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            if (type_bits & (1ULL << (12 + i)))
+            {
+                append_word(text, &length, size, windows_names[i], strlen(windows_names[i]));
+            }
+        }
+        type_bits &= 0x0FFFULL;
+    }
 
+    // Remaining type-specific bits as a GUID:<bit>,<bit> list
+    if (type_bits != 0)
+    {
+        char list[64] = "GUID:";
+        size_t list_length = 5;
+        for (int bit = 0; bit < 64 - GPT_ATTR_TYPE_SPECIFIC; bit++)
+        {
+            if (type_bits & (1ULL << bit))
+            {
+                list_length += (size_t)snprintf(list + list_length, sizeof(list) - list_length, "%s%d",
+                                                (list_length > 5) ? "," : "", GPT_ATTR_TYPE_SPECIFIC + bit);
+            }
+        }
+        append_word(text, &length, size, list, list_length);
+    }
+
+    return length;
+}
 
 
 
@@ -178,48 +628,62 @@ const char* GPT_get_partition_type(const char *type_guid)
 /**
  * Prints information about a GPT partition.
  *
- * This function prints detailed information about a GPT partition entry,
- * including its start and end LBA, size in megabytes, and partition type.
- * It skips empty partitions where both starting and ending LBA are zero.
+ * This function prints detailed information about a GPT partition descriptor
+ * (see `PARSE_read_table`), including its start and end LBA, size in megabytes,
+ * partition type, name and attributes. The type GUID is only formatted as a string
+ * when the type is not known; ASCII names are converted 8 UTF-16 units at a time and
+ * attributes are only formatted when one is set, so long tables print at stream speed.
  *
+ * @param out: The stream the partition information is printed to (e.g., stdout).
  * @param device: The name or identifier of the device where the partition resides.
- * @param index: The index of the partition.
- * @param entry: Pointer to the GPT partition entry structure containing partition details.
+ * @param partition: The descriptor of the partition.
+ * @param sector_size: The logical sector size of the device in bytes.
  */
-void GPT_print_partition_info(const char *device, int index, GPT_PartitionEntry *entry) 
+void GPT_print_partition_info(FILE *out, const char *device, const PARSE_Partition *partition, uint32_t sector_size) 
 {
     // Validate input parameters
-    if (device == NULL || entry == NULL) 
+    if (out == NULL || device == NULL || partition == NULL) 
     {
-        fprintf(stderr, "Error: Invalid input - device or entry cannot be NULL\n");
+        fprintf(stderr, "Error: Invalid input - device or partition cannot be NULL\n");
         return;
     }
 
-    // Skip empty partitions
-    if (entry->starting_lba == 0 && entry->ending_lba == 0) 
+    // Map GUID to partition type, or print the GUID of an unknown type
+    char guid_str[GUID_STR_LEN];
+    const char *partition_type = GPT_get_partition_type(partition->type_guid);
+    if (partition_type == NULL)
     {
-        return;  // Empty partition; no information to print
+        convert_guid_to_string(partition->type_guid, guid_str);
+        partition_type = guid_str;
     }
 
-    // Convert GUID to string
-    char guid_str[GUID_STR_LEN]; 
-    convert_guid_to_string(entry->type_guid, guid_str);
+    // Decode the name, padded by characters (not bytes) so multibyte names stay aligned
+    char name[UTF16_UTF8_SIZE(PARSE_NAME_LENGTH)];
+    UTF16_to_utf8(partition->name, PARSE_NAME_LENGTH, name, sizeof(name));
+    int characters = 0;
+    for (const char *c = name; *c != '\0'; c++)
+    {
+        characters += ((*c & 0xC0) != 0x80);
+    }
+    int padding = (characters < GPT_NAME_COLUMN_WIDTH) ? GPT_NAME_COLUMN_WIDTH - characters : 0;
 
-    // Map GUID to partition type
-    const char *partition_type = GPT_get_partition_type(guid_str);
+    char attributes[GPT_ATTR_TEXT_SIZE];
+    GPT_format_attributes(partition->attributes, partition->type_guid, false, attributes, sizeof(attributes));
 
-    // Calculate size in megabytes
-    uint64_t sector_count = entry->ending_lba - entry->starting_lba + 1;
-    uint64_t size_mb = (sector_count * SECTOR_SIZE) / (1024 * 1024);
+    // Calculate size in megabytes; a reversed entry (end before start) occupies no sectors
+    uint64_t sector_count = (partition->flags & PARSE_FLAG_REVERSED) ? 0 : partition->end - partition->start + 1;
+    uint64_t size_mb = (sector_count * sector_size) / (1024 * 1024);
 
     // Print partition information
-    printf("%-16s%-6d %-10llu %-10llu %-10llu %-10llu %-36s\n",
+    fprintf(out, "%-16s%-6d %-10llu %-10llu %-10llu %-10llu %-36s %s%*s %s\n",
            device,                         // Device name
-           index,                          // Partition index
-           (unsigned long long)entry->starting_lba,  // Starting LBA
-           (unsigned long long)entry->ending_lba,    // Ending LBA
+           partition->index,               // Partition index
+           (unsigned long long)partition->start,     // Starting LBA
+           (unsigned long long)partition->end,       // Ending LBA
            (unsigned long long)sector_count,          // Number of sectors
            (unsigned long long)size_mb,               // Size in megabytes
-           partition_type                     // Partition type description
+           partition_type,                    // Partition type description
+           name, padding, "",                 // Partition name, padded to its column
+           attributes                         // Decoded attributes
           );
 }
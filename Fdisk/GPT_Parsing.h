@@ -26,6 +26,9 @@
 #include <inttypes.h>  // Provides integer types with specified widths and formatting (e.g., int32_t, PRIu32)
 #include <string.h>    // Provides functions for string manipulation (e.g., memcpy, memset, strcmp)
 #include <stdbool.h>   // Defines the boolean type and values (e.g., bool, true, false)
+#include "CRC32.h"     // Provides the slice-by-8 CRC32 used to validate the GPT header and entry array
+#include "Block_IO.h"  // Provides sector-size-aware aligned reads (BLK_Device)
+#include "Partition_Parse.h" // Provides the partition descriptors printed by GPT_print_partition_info
 
 
 
@@ -36,12 +39,14 @@
  ============================================================================*/ 
 
 /**
- * Defines the size of a sector in bytes.
+ * Defines the number of bytes read for a GPT header.
  *
- * The sector size is a fundamental unit of storage, representing the smallest addressable unit on a storage 
- * device. In this context, it is set to 512 bytes, which is a common sector size for hard drives and SSDs.
+ * The header lives at the start of its logical sector (512 or 4096 bytes) and must fit in 
+ * the smallest logical sector, so only the first 512 bytes are read and checksummed. 
+ * LBAs stored in the header are converted to byte offsets with the device's logical 
+ * sector size (see `BLK_Device`).
  */
-#define SECTOR_SIZE                 512  // Size of a sector in bytes
+#define GPT_HEADER_SECTOR_SIZE      BLK_DEFAULT_SECTOR_SIZE  // Bytes read for the GPT header
 
 /**
  * Specifies the Logical Block Address (LBA) for the GPT (GUID Partition Table) header.
@@ -52,28 +57,36 @@
 #define GPT_HEADER_LBA              1  // LBA of the GPT header
 
 /**
- * Defines the LBA where the GPT partition entry array begins.
+ * Specifies the minimum size of each GPT partition entry in bytes.
  *
- * The GPT partition entry array starts at LBA 2 in the GPT layout. This is where the entries for each 
- * partition in the GPT are stored.
+ * The UEFI specification requires each entry to be at least 128 bytes (128 * 2^n). The real 
+ * entry size and count are read from the GPT header (`size_of_partition_entry`, 
+ * `num_partition_entries`) instead of being assumed.
  */
-#define GPT_ENTRY_ARRAY_LBA         2  // LBA of the GPT partition entry array
+#define GPT_ENTRY_SIZE              128  // Minimum size of each GPT partition entry in bytes
 
 /**
- * Specifies the size of each GPT partition entry in bytes.
+ * Represents the "EFI PART" signature found at the start of a GPT header.
  *
- * Each entry in the GPT partition entry array has a fixed size of 128 bytes. This defines the structure of 
- * each partition entry within the GPT.
+ * The 8 ASCII characters "EFI PART" read as a little-endian 64-bit value.
  */
-#define GPT_ENTRY_SIZE              128  // Size of each GPT partition entry in bytes
+#define GPT_HEADER_SIGNATURE        0x5452415020494645ULL  // "EFI PART"
 
 /**
- * Defines the number of GPT partition entries.
+ * Defines the minimum size of the GPT header in bytes.
  *
- * The GPT format supports a maximum of 128 partition entries, allowing up to 128 partitions to be defined 
- * in a GPT partition table.
+ * The UEFI specification defines a 92-byte header; `header_size` must be at least this 
+ * value and no larger than `GPT_HEADER_SECTOR_SIZE`. The CRC32 is computed over `header_size` bytes.
  */
-#define GPT_ENTRIES_NUM             128  // Number of GPT partition entries
+#define GPT_HEADER_MIN_SIZE         92  // Minimum GPT header size in bytes
+
+/**
+ * Defines an upper bound for the size of the GPT partition entry array in bytes.
+ *
+ * The entry array is read with a single `pread`, so its size (count * entry size) taken from 
+ * a possibly corrupted header is bounded before allocating a buffer for it.
+ */
+#define GPT_MAX_ENTRY_ARRAY_SIZE    (16 * 1024 * 1024)  // 16 MiB
 
 /**
  * Represents the signature used to identify GPT (GUID Partition Table).
@@ -115,12 +128,28 @@
 #define GUID_LEN                    36  // Length of a GUID string (without null terminator)
 
 /**
- * Represents a constant value used to indicate a specific GUID match condition.
+ * Bit numbers of the GPT partition attributes defined by the UEFI specification.
+ *
+ * Bits 3-47 are reserved; bits 48-63 are defined by the partition type (see
+ * `GPT_format_attributes` for the ChromeOS kernel and Microsoft basic data layouts).
+ */
+#define GPT_ATTR_REQUIRED           0   // Platform required partition
+#define GPT_ATTR_NO_BLOCK_IO        1   // No EFI block I/O protocol
+#define GPT_ATTR_LEGACY_BOOTABLE    2   // Legacy BIOS bootable
+#define GPT_ATTR_TYPE_SPECIFIC      48  // First type-specific bit
+
+/**
+ * Size of a buffer that always holds the text of `GPT_format_attributes`.
  *
- * This constant is used in comparisons or checks related to GUID string matching. The value of 0 typically signifies 
- * a successful string match
+ * The longest text names the 3 UEFI bits, all 45 reserved bits and 16 type-specific bits.
  */
-#define GUID_STRING_MATCH           0  // Value indicating a GUID string match
+#define GPT_ATTR_TEXT_SIZE          384
+
+/**
+ * Number of columns the partition name is padded to in the partition listing.
+ */
+#define GPT_NAME_COLUMN_WIDTH       20
+
 
 
 
@@ -185,30 +214,91 @@ typedef struct {
 
 
 
+/**
+ * Represents the GPT header located at LBA 1 (primary) and at the last LBA (backup).
+ *
+ * The header describes the geometry of the partition table: where the entry array 
+ * starts, how many entries it holds and the size of each entry, together with the 
+ * CRC32 checksums of the header itself and of the entry array.
+ *
+ * Fields:
+ * 
+ * @param signature: "EFI PART" (`GPT_HEADER_SIGNATURE`).
+ * @param revision: GPT revision (0x00010000 for version 1.0).
+ * @param header_size: Size of the header in bytes, covered by `header_crc32`.
+ * @param header_crc32: CRC32 of the header, computed with this field set to zero.
+ * @param reserved: Must be zero.
+ * @param my_lba: LBA that contains this header.
+ * @param alternate_lba: LBA of the other (backup or primary) header.
+ * @param first_usable_lba: First LBA that may be used by a partition.
+ * @param last_usable_lba: Last LBA that may be used by a partition.
+ * @param disk_guid: GUID identifying the disk.
+ * @param partition_entry_lba: Starting LBA of the partition entry array.
+ * @param num_partition_entries: Number of entries in the partition entry array.
+ * @param size_of_partition_entry: Size of each partition entry in bytes.
+ * @param partition_entry_array_crc32: CRC32 of the whole partition entry array.
+ */
+typedef struct __attribute__((packed)) {
+    uint64_t signature;                   /**< "EFI PART" signature. */
+    uint32_t revision;                    /**< GPT revision. */
+    uint32_t header_size;                 /**< Size of the header in bytes. */
+    uint32_t header_crc32;                /**< CRC32 of the header. */
+    uint32_t reserved;                    /**< Reserved, must be zero. */
+    uint64_t my_lba;                      /**< LBA of this header. */
+    uint64_t alternate_lba;               /**< LBA of the alternate header. */
+    uint64_t first_usable_lba;            /**< First usable LBA for partitions. */
+    uint64_t last_usable_lba;             /**< Last usable LBA for partitions. */
+    uint8_t  disk_guid[16];               /**< Disk GUID. */
+    uint64_t partition_entry_lba;         /**< Starting LBA of the partition entry array. */
+    uint32_t num_partition_entries;       /**< Number of partition entries. */
+    uint32_t size_of_partition_entry;     /**< Size of each partition entry. */
+    uint32_t partition_entry_array_crc32; /**< CRC32 of the partition entry array. */
+} GPT_Header;
+
+
+
+
+
 /**
  * Represents the type of a partition in the GUID Partition Table (GPT).
  *
- * This structure is used to define and describe the type of partitions based on 
- * their GUID prefixes and human-readable names. It helps in categorizing partitions 
+ * This structure is used to define and describe the type of partitions based on
+ * their type GUID and human-readable names. It helps in categorizing partitions
  * according to the type of data they hold or the operating system they are used with.
  *
  * Fields:
- * 
- * @param guid_prefix: 
- *        A pointer to a string that represents the GUID prefix associated with 
- *        the partition type. This prefix is used to identify and categorize 
- *        partitions based on their type.
- * 
+ *
+ * @param high:
+ *        The first 64 bits of the type GUID, in the order the GUID is written
+ *        (e.g., 0xC12A7328F81F11D2 for C12A7328-F81F-11D2-BA4B-00A0C93EC93B).
+ *
+ * @param low:
+ *        The last 64 bits of the type GUID, in the order the GUID is written
+ *        (e.g., 0xBA4B00A0C93EC93B). Together with `high` this is the binary key
+ *        partition entries are matched against.
+ *
  * @param name: 
  *        A pointer to a string that provides a human-readable name for the partition 
  *        type. This name is used to display the type of partition in a more user-friendly 
  *        format, making it easier for users to understand the partition's purpose.
  */
 typedef struct {
-    const char *guid_prefix; /**< GUID prefix representing the partition type. */
+    uint64_t high;           /**< First 64 bits of the type GUID. */
+    uint64_t low;            /**< Last 64 bits of the type GUID. */
     const char *name;        /**< Human-readable name of the partition type. */
 } GPT_PartitionType;
 
+/**
+ * Outcome of the sanity checks of a GPT header (see `GPT_check_header`).
+ */
+typedef enum {
+    GPT_HEADER_OK,               /**< The header is usable. */
+    GPT_HEADER_BAD_SIGNATURE,    /**< Not "EFI PART". */
+    GPT_HEADER_BAD_SIZE,         /**< header_size out of range. */
+    GPT_HEADER_BAD_ENTRY_SIZE,   /**< Entry size too small or not a multiple of 8. */
+    GPT_HEADER_BAD_ARRAY_SIZE    /**< Entry array empty or too large. */
+} GPT_HeaderCheck;
+
 
 
 
@@ -217,8 +307,14 @@ typedef struct {
 /*============================================================================
  *************************  Functions API Decleration  ***********************
  ============================================================================*/
+GPT_HeaderCheck GPT_check_header(const GPT_Header *header);
+int GPT_parse_header(const char *sector, GPT_Header *header);
+bool GPT_verify_header_crc(const char *sector, const GPT_Header *header);
+bool GPT_verify_entry_array(const GPT_Header *header, const void *entries);
 bool convert_guid_to_string(const unsigned char *guid, char *guid_str);
-const char* get_partition_type(const char *type_guid);
-void GPT_print_partition_info(const char *device, int index, GPT_PartitionEntry *entry);
+bool convert_string_to_guid(const char *guid_str, unsigned char *guid);
+const char* GPT_get_partition_type(const unsigned char *type_guid);
+size_t GPT_format_attributes(uint64_t attributes, const unsigned char *type_guid, bool script_syntax, char *text, size_t size);
+void GPT_print_partition_info(FILE *out, const char *device, const PARSE_Partition *partition, uint32_t sector_size);
 
 #endif
@@ -0,0 +1,804 @@
+/**
+ *===================================================================================
+ * @file           : Image_Format.c
+ * @author         : Ali Mamdouh
+ * @brief          : source file to read guest sectors of qcow2 and VHD disk images
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Image_Format.h"   // Includes the image backend API and configuration macros
+#include <stdlib.h>         // Provides calloc and free
+#include <string.h>         // Provides memcpy, memcmp and memset
+#include <errno.h>          // Provides errno
+#include <zlib.h>           // Provides inflate for compressed qcow2 clusters
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+#define QCOW2_MAGIC                 0x514649FBu            // "QFI\xfb"
+#define QCOW2_OFFSET_MASK           0x00FFFFFFFFFFFE00ull  // Bits 9-55 of L1/L2 entries
+#define QCOW2_FLAG_COMPRESSED       (1ull << 62)           // L2 entry: compressed cluster
+#define QCOW2_FLAG_ZERO             1ull                   // L2 entry (v3): cluster reads as zeros
+#define QCOW2_INCOMPAT_DIRTY        0x01ull                // Refcounts may be stale (harmless for reads)
+#define QCOW2_INCOMPAT_CORRUPT      0x02ull                // Metadata marked corrupt (read-only use allowed)
+#define QCOW2_INCOMPAT_COMPRESSION  0x08ull                // Compression type field present
+#define QCOW2_MIN_CLUSTER_BITS      9                      // 512-byte clusters
+#define QCOW2_MAX_CLUSTER_BITS      21                     // 2 MiB clusters
+
+#define VHD_FOOTER_SIZE             512                    // Footer (and its copy at offset 0)
+#define VHD_DYNAMIC_HEADER_SIZE     1024                   // Dynamic disk header
+#define VHD_TYPE_FIXED              2
+#define VHD_TYPE_DYNAMIC            3
+#define VHD_TYPE_DIFFERENCING       4
+#define VHD_UNALLOCATED             0xFFFFFFFFu            // BAT entry of a block never written
+#define VHD_MAX_BLOCK_SIZE          (256u * 1024 * 1024)   // Sanity limit on the block size
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Where the guest bytes of one cluster or block are stored.
+ */
+typedef enum {
+    EXTENT_ZERO,        /**< Unallocated or zero cluster: reads as zeros. */
+    EXTENT_DATA,        /**< Stored uncompressed at `host`. */
+    EXTENT_COMPRESSED   /**< Stored compressed: `size` bytes at `host`. */
+} extent_kind;
+
+/**
+ * Result of translating a cluster or block through the lookup tables.
+ */
+typedef struct {
+    extent_kind kind;   /**< How the unit is stored. */
+    uint64_t host;      /**< Offset of the unit data in the image file. */
+    size_t size;        /**< Size of the compressed data. */
+} extent;
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Reads a big-endian 32-bit value.
+ */
+static uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+
+
+/**
+ * Reads a big-endian 64-bit value.
+ */
+static uint64_t be64(const uint8_t *p)
+{
+    return ((uint64_t)be32(p) << 32) | be32(p + 4);
+}
+
+
+
+/**
+ * Checks the one's complement checksum of a VHD footer (field at byte 64).
+ */
+static int vhd_checksum_ok(const uint8_t *footer)
+{
+    uint32_t sum = 0;
+
+    for (int i = 0; i < VHD_FOOTER_SIZE; i++)
+    {
+        if (i < 64 || i >= 68)
+        {
+            sum += footer[i];
+        }
+    }
+
+    return (uint32_t)~sum == be32(footer + 64);
+}
+
+
+
+
+
+
+/**
+ * Returns a lookup table of the image, reading it on a miss.
+ *
+ * On a miss the least recently used slot is reused. A table that runs past the end of
+ * the image file (the last page of a short BAT) is padded with entries that read as
+ * unallocated (0xFF for the VHD BAT, 0 for qcow2 L2 tables).
+ *
+ * @param image: The image.
+ * @param offset: Offset of the table in the image file.
+ *
+ * @return The table data, or NULL on read error (errno is set).
+ */
+static const uint8_t *load_table(IMAGE_Image *image, uint64_t offset)
+{
+    IMAGE_Table *victim = &image->tables[0];
+
+    image->clock++;
+    for (int i = 0; i < IMAGE_TABLE_COUNT; i++)
+    {
+        IMAGE_Table *table = &image->tables[i];
+        if (table->last_use != 0 && table->offset == offset)
+        {
+            table->last_use = image->clock;
+            return table->data;
+        }
+        if (table->last_use < victim->last_use)
+        {
+            victim = table;
+        }
+    }
+
+    if (victim->data == NULL)
+    {
+        victim->data = BLK_alloc_buffer(&image->file, image->table_size);
+        if (victim->data == NULL)
+        {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+
+    if (offset >= image->file_size)
+    {
+        errno = EIO; // The table pointer leads outside the image file
+        return NULL;
+    }
+
+    uint64_t remaining = image->file_size - offset;
+    size_t length = (remaining < image->table_size) ? (size_t)remaining : image->table_size;
+    victim->last_use = 0;
+    memset(victim->data + length, (image->format == IMAGE_FORMAT_QCOW2) ? 0 : 0xFF, image->table_size - length);
+    if (BLK_read(&image->file, offset, victim->data, length) != 0)
+    {
+        return NULL;
+    }
+
+    victim->offset = offset;
+    victim->last_use = image->clock;
+    return victim->data;
+}
+
+
+
+
+
+
+/**
+ * Translates a qcow2 cluster through the L1 and L2 tables.
+ *
+ * @param image: The qcow2 image.
+ * @param index: Guest cluster number.
+ * @param result: Receives where the cluster is stored.
+ *
+ * @return 0 on success, or -1 on error (errno is set).
+ */
+static int map_qcow2_cluster(IMAGE_Image *image, uint64_t index, extent *result)
+{
+    uint64_t l1_index = index >> image->l2_bits;
+    uint64_t l2_index = index & (((uint64_t)1 << image->l2_bits) - 1);
+
+    result->kind = EXTENT_ZERO;
+    if (l1_index >= image->l1_size)
+    {
+        return 0;
+    }
+
+    uint64_t l2_offset = image->l1[l1_index] & QCOW2_OFFSET_MASK;
+    if (l2_offset == 0)
+    {
+        return 0; // No L2 table: the whole range was never written
+    }
+
+    const uint8_t *l2 = load_table(image, l2_offset);
+    if (l2 == NULL)
+    {
+        return -1;
+    }
+
+    uint64_t entry = be64(l2 + l2_index * 8);
+    if (entry & QCOW2_FLAG_COMPRESSED)
+    {
+        // Compressed: the size field sits above the offset, its width depends on the cluster size
+        uint32_t cluster_bits = image->l2_bits + 3;
+        uint32_t size_shift = 62 - (cluster_bits - 8);
+        uint64_t sectors = ((entry >> size_shift) & (((uint64_t)1 << (cluster_bits - 8)) - 1)) + 1;
+
+        result->kind = EXTENT_COMPRESSED;
+        result->host = entry & (((uint64_t)1 << size_shift) - 1);
+        result->size = (size_t)(sectors * 512 - (result->host & 511));
+        return 0;
+    }
+
+    if (image->qcow2_version >= 3 && (entry & QCOW2_FLAG_ZERO))
+    {
+        return 0;
+    }
+
+    result->host = entry & QCOW2_OFFSET_MASK;
+    if (result->host != 0)
+    {
+        result->kind = EXTENT_DATA;
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Translates a dynamic VHD block through the Block Allocation Table.
+ *
+ * The sector bitmap in front of the block is skipped: as in QEMU, every sector of an
+ * allocated block of a dynamic (not differencing) disk is read from the block.
+ *
+ * @param image: The dynamic VHD image.
+ * @param index: Guest block number.
+ * @param result: Receives where the block is stored.
+ *
+ * @return 0 on success, or -1 on error (errno is set).
+ */
+static int map_vhd_block(IMAGE_Image *image, uint64_t index, extent *result)
+{
+    uint64_t entries_per_page = IMAGE_VHD_BAT_PAGE_SIZE / 4;
+
+    result->kind = EXTENT_ZERO;
+    if (index >= image->bat_entries)
+    {
+        return 0;
+    }
+
+    const uint8_t *page = load_table(image, image->bat_offset + (index / entries_per_page) * IMAGE_VHD_BAT_PAGE_SIZE);
+    if (page == NULL)
+    {
+        return -1;
+    }
+
+    uint32_t sector = be32(page + (index % entries_per_page) * 4);
+    if (sector != VHD_UNALLOCATED)
+    {
+        result->kind = EXTENT_DATA;
+        result->host = (uint64_t)sector * 512 + image->bitmap_size;
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Translates a cluster or block of any format.
+ */
+static int map_unit(IMAGE_Image *image, uint64_t index, extent *result)
+{
+    if (image->format == IMAGE_FORMAT_QCOW2)
+    {
+        return map_qcow2_cluster(image, index, result);
+    }
+    return map_vhd_block(image, index, result);
+}
+
+
+
+
+
+
+/**
+ * Returns the decompressed data of a compressed qcow2 cluster.
+ *
+ * The last cluster is kept, so the sectors of one cluster read one at a time (an EBR
+ * chain, the GPT header followed by its entries) are inflated once.
+ *
+ * @param image: The qcow2 image.
+ * @param compressed: Where the compressed cluster is stored.
+ *
+ * @return The cluster, or NULL on read or decompression error (errno is set).
+ */
+static const uint8_t *inflate_cluster(IMAGE_Image *image, const extent *compressed)
+{
+    if (image->cluster_offset == compressed->host)
+    {
+        return image->cluster;
+    }
+
+    if (image->cluster == NULL)
+    {
+        image->cluster = malloc((size_t)image->unit_size);
+        image->compressed = malloc((size_t)image->unit_size * 2); // Largest size the entry can encode
+        if (image->cluster == NULL || image->compressed == NULL)
+        {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+
+    // The compressed data is rounded up to whole sectors and may end past the end of the file
+    if (compressed->host >= image->file_size || compressed->size > image->unit_size * 2)
+    {
+        errno = EIO;
+        return NULL;
+    }
+    uint64_t remaining = image->file_size - compressed->host;
+    size_t length = (remaining < compressed->size) ? (size_t)remaining : compressed->size;
+
+    image->cluster_offset = UINT64_MAX;
+    if (BLK_read(&image->file, compressed->host, image->compressed, length) != 0)
+    {
+        return NULL;
+    }
+
+    // Raw deflate stream with a 4 KiB window, as written by QEMU
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -12) != Z_OK)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    stream.next_in = image->compressed;
+    stream.avail_in = (uInt)length;
+    stream.next_out = image->cluster;
+    stream.avail_out = (uInt)image->unit_size;
+
+    int status = inflate(&stream, Z_FINISH);
+    int complete = (status == Z_STREAM_END || status == Z_BUF_ERROR) && stream.avail_out == 0;
+    inflateEnd(&stream);
+    if (!complete)
+    {
+        errno = EIO; // Corrupt or truncated compressed cluster
+        return NULL;
+    }
+
+    image->cluster_offset = compressed->host;
+    return image->cluster;
+}
+
+
+
+
+
+
+/**
+ * Reads guest bytes of an image.
+ *
+ * The range is split at cluster (qcow2) or block (VHD) boundaries and every piece is
+ * translated through the lookup tables: unallocated pieces read as zeros, compressed
+ * clusters are inflated, and consecutive pieces stored back to back in the image file
+ * are read with a single read.
+ *
+ * @param image: The image.
+ * @param offset: Guest byte offset of the first byte to read.
+ * @param buf: Destination buffer of at least `length` bytes.
+ * @param length: Number of bytes to read.
+ *
+ * @return 0 on success, or -1 on error or if the range lies beyond the end of the guest
+ *         disk (errno is set).
+ */
+int IMAGE_read(IMAGE_Image *image, uint64_t offset, void *buf, size_t length)
+{
+    uint8_t *out = buf;
+
+    if (offset > image->virtual_size || length > image->virtual_size - offset)
+    {
+        errno = EIO; // The range extends past the end of the guest disk
+        return -1;
+    }
+
+    // Fixed VHD: the guest disk is stored as is in front of the footer
+    if (image->format == IMAGE_FORMAT_VHD_FIXED)
+    {
+        return BLK_read(&image->file, offset, buf, length);
+    }
+
+    while (length > 0)
+    {
+        uint64_t index = offset / image->unit_size;
+        uint64_t within = offset % image->unit_size;
+        size_t chunk = (image->unit_size - within < length) ? (size_t)(image->unit_size - within) : length;
+        extent unit;
+
+        if (map_unit(image, index, &unit) != 0)
+        {
+            return -1;
+        }
+
+        if (unit.kind == EXTENT_ZERO)
+        {
+            memset(out, 0, chunk);
+        }
+        else if (unit.kind == EXTENT_COMPRESSED)
+        {
+            const uint8_t *cluster = inflate_cluster(image, &unit);
+            if (cluster == NULL)
+            {
+                return -1;
+            }
+            memcpy(out, cluster + within, chunk);
+        }
+        else
+        {
+            // Extend the read over the following units while they are contiguous in the file
+            uint64_t host = unit.host + within;
+            uint64_t next_host = unit.host + image->unit_size;
+            extent next;
+
+            while (chunk < length)
+            {
+                if (map_unit(image, ++index, &next) != 0)
+                {
+                    return -1;
+                }
+                if (next.kind != EXTENT_DATA || next.host != next_host)
+                {
+                    break;
+                }
+                chunk += (image->unit_size < length - chunk) ? (size_t)image->unit_size : length - chunk;
+                next_host += image->unit_size;
+            }
+
+            if (BLK_read(&image->file, host, out, chunk) != 0)
+            {
+                return -1;
+            }
+        }
+
+        out += chunk;
+        offset += chunk;
+        length -= chunk;
+    }
+
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Reads the qcow2 header and the L1 table.
+ *
+ * Images that need data from elsewhere (backing file, external data file) or that cannot
+ * be decoded (encryption, zstd compression, extended L2 entries) are rejected.
+ *
+ * @param image: The image being opened; `file` and `file_size` are set.
+ * @param header: The first 512 bytes of the image file.
+ *
+ * @return 0 on success, or -1 on error (a message is printed, errno is set).
+ */
+static int open_qcow2(IMAGE_Image *image, const uint8_t *header)
+{
+    uint32_t version = be32(header + 4);
+    uint32_t cluster_bits = be32(header + 20);
+    uint64_t incompatible = 0;
+
+    if (version != 2 && version != 3)
+    {
+        fprintf(stderr, "qcow2 version %" PRIu32 " is not supported.\n", version);
+        errno = ENOTSUP;
+        return -1;
+    }
+    if (cluster_bits < QCOW2_MIN_CLUSTER_BITS || cluster_bits > QCOW2_MAX_CLUSTER_BITS)
+    {
+        fprintf(stderr, "Invalid qcow2 cluster size (2^%" PRIu32 " bytes).\n", cluster_bits);
+        errno = EINVAL;
+        return -1;
+    }
+    if (be64(header + 8) != 0)
+    {
+        fprintf(stderr, "qcow2 images with a backing file are not supported: unallocated clusters live in the backing file.\n");
+        errno = ENOTSUP;
+        return -1;
+    }
+    if (be32(header + 32) != 0)
+    {
+        fprintf(stderr, "Encrypted qcow2 images are not supported.\n");
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    if (version >= 3)
+    {
+        uint32_t header_length = be32(header + 100);
+        incompatible = be64(header + 72);
+        if ((incompatible & QCOW2_INCOMPAT_COMPRESSION) && (header_length <= 104 || header[104] != 0))
+        {
+            fprintf(stderr, "qcow2 images compressed with zstd are not supported.\n");
+            errno = ENOTSUP;
+            return -1;
+        }
+        incompatible &= ~(QCOW2_INCOMPAT_DIRTY | QCOW2_INCOMPAT_CORRUPT | QCOW2_INCOMPAT_COMPRESSION);
+        if (incompatible != 0)
+        {
+            fprintf(stderr, "qcow2 incompatible features 0x%" PRIx64 " are not supported (external data file or extended L2 entries).\n",
+                    incompatible);
+            errno = ENOTSUP;
+            return -1;
+        }
+    }
+
+    image->format = IMAGE_FORMAT_QCOW2;
+    image->qcow2_version = version;
+    image->unit_size = (uint64_t)1 << cluster_bits;
+    image->l2_bits = cluster_bits - 3;
+    image->table_size = (size_t)image->unit_size; // An L2 table is one cluster
+    image->virtual_size = be64(header + 24);
+    image->l1_size = be32(header + 36);
+
+    // The L1 table must cover the whole guest disk
+    uint64_t bytes_per_l1 = image->unit_size << image->l2_bits;
+    uint64_t needed = image->virtual_size / bytes_per_l1 + (image->virtual_size % bytes_per_l1 != 0);
+    uint64_t l1_offset = be64(header + 40);
+    if (image->l1_size < needed || (uint64_t)image->l1_size * 8 > IMAGE_QCOW2_MAX_L1_SIZE ||
+        l1_offset >= image->file_size || (uint64_t)image->l1_size * 8 > image->file_size - l1_offset)
+    {
+        fprintf(stderr, "Invalid qcow2 L1 table (%" PRIu32 " entries at offset %" PRIu64 ").\n", image->l1_size, l1_offset);
+        errno = EINVAL;
+        return -1;
+    }
+
+    image->l1 = malloc(image->l1_size ? (size_t)image->l1_size * 8 : 1);
+    if (image->l1 == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (image->l1_size != 0 && BLK_read(&image->file, l1_offset, image->l1, (size_t)image->l1_size * 8) != 0)
+    {
+        return -1;
+    }
+
+    // Convert in place: the bytes of entry i are consumed before entry i is written
+    for (uint32_t i = 0; i < image->l1_size; i++)
+    {
+        image->l1[i] = be64((const uint8_t *)&image->l1[i]);
+    }
+
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Reads the VHD footer and, for dynamic disks, the dynamic header.
+ *
+ * @param image: The image being opened; `file` and `file_size` are set.
+ * @param footer: The footer (from the end of the file, or its copy at offset 0).
+ *
+ * @return 0 on success, or -1 on error (a message is printed, errno is set).
+ */
+static int open_vhd(IMAGE_Image *image, const uint8_t *footer)
+{
+    uint32_t type = be32(footer + 60);
+
+    image->virtual_size = be64(footer + 48);
+
+    if (type == VHD_TYPE_FIXED)
+    {
+        if (image->virtual_size > image->file_size - VHD_FOOTER_SIZE)
+        {
+            fprintf(stderr, "Fixed VHD is shorter than its disk size.\n");
+            errno = EINVAL;
+            return -1;
+        }
+        image->format = IMAGE_FORMAT_VHD_FIXED;
+        return 0;
+    }
+    if (type == VHD_TYPE_DIFFERENCING)
+    {
+        fprintf(stderr, "Differencing VHD images are not supported: unallocated blocks live in the parent image.\n");
+        errno = ENOTSUP;
+        return -1;
+    }
+    if (type != VHD_TYPE_DYNAMIC)
+    {
+        fprintf(stderr, "Unknown VHD disk type %" PRIu32 ".\n", type);
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint8_t header[VHD_DYNAMIC_HEADER_SIZE];
+    uint64_t header_offset = be64(footer + 16);
+    if (header_offset >= image->file_size || image->file_size - header_offset < sizeof(header) ||
+        BLK_read(&image->file, header_offset, header, sizeof(header)) != 0 || memcmp(header, "cxsparse", 8) != 0)
+    {
+        fprintf(stderr, "Dynamic VHD header not found at offset %" PRIu64 ".\n", header_offset);
+        errno = EINVAL;
+        return -1;
+    }
+
+    image->format = IMAGE_FORMAT_VHD_DYNAMIC;
+    image->bat_offset = be64(header + 16);
+    image->bat_entries = be32(header + 28);
+    image->unit_size = be32(header + 32);
+    image->table_size = IMAGE_VHD_BAT_PAGE_SIZE;
+
+    // Bitmap of one bit per sector, padded to whole sectors
+    uint64_t bitmap_bytes = (image->unit_size / 512 + 7) / 8;
+    image->bitmap_size = (uint32_t)((bitmap_bytes + 511) & ~(uint64_t)511);
+
+    uint64_t needed = (image->unit_size == 0) ? 0 : image->virtual_size / image->unit_size + (image->virtual_size % image->unit_size != 0);
+    if (image->unit_size < 512 || image->unit_size > VHD_MAX_BLOCK_SIZE || (image->unit_size % 512) != 0 ||
+        image->bat_entries < needed || image->bat_offset >= image->file_size)
+    {
+        fprintf(stderr, "Invalid dynamic VHD (block size %" PRIu64 ", %" PRIu32 " BAT entries).\n",
+                image->unit_size, image->bat_entries);
+        errno = EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Detects a qcow2 or VHD image and attaches it to an opened image file.
+ *
+ * This function performs the following tasks:
+ * 1. Looks for the qcow2 magic at offset 0, the VHD footer copy of a dynamic disk at
+ *    offset 0, or the VHD footer in the last 512 bytes (checksum verified).
+ * 2. Reads the format headers and the qcow2 L1 table.
+ * 3. Moves the opened file into the image and turns `dev` into the guest disk: its size
+ *    is the virtual size, it has no file descriptor or mapping of its own, and
+ *    `BLK_read` on it goes through `IMAGE_read`.
+ *
+ * Raw images are left untouched.
+ *
+ * @param dev: An image file opened by `BLK_open` (not yet attached to an image).
+ *
+ * @return 0 if the file is a raw image or was attached, or -1 if it is an image that
+ *         cannot be read (a message is printed, errno is set).
+ */
+int IMAGE_open(BLK_Device *dev)
+{
+    uint8_t head[VHD_FOOTER_SIZE];
+    uint8_t tail[VHD_FOOTER_SIZE];
+    const uint8_t *footer = NULL;
+    int qcow2 = 0;
+
+    if (dev->is_block_device || dev->size_bytes < VHD_FOOTER_SIZE || BLK_read(dev, 0, head, sizeof(head)) != 0)
+    {
+        return 0;
+    }
+
+    if (be32(head) == QCOW2_MAGIC)
+    {
+        qcow2 = 1;
+    }
+    else if (memcmp(head, "conectix", 8) == 0 && vhd_checksum_ok(head))
+    {
+        footer = head;
+    }
+    else if (BLK_read(dev, dev->size_bytes - VHD_FOOTER_SIZE, tail, sizeof(tail)) == 0 &&
+             memcmp(tail, "conectix", 8) == 0 && vhd_checksum_ok(tail))
+    {
+        footer = tail;
+    }
+
+    if (!qcow2 && footer == NULL)
+    {
+        return 0; // Raw image
+    }
+
+    IMAGE_Image *image = calloc(1, sizeof(*image));
+    if (image == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    image->file = *dev;
+    image->file_size = dev->size_bytes;
+    image->cluster_offset = UINT64_MAX;
+
+    int status = qcow2 ? open_qcow2(image, head) : open_vhd(image, footer);
+    if (status != 0)
+    {
+        int saved_errno = errno;
+        memset(&image->file, 0, sizeof(image->file)); // Still owned by dev
+        image->file.fd = -1;
+        IMAGE_close(image);
+        errno = saved_errno;
+        return -1;
+    }
+
+    // The image now owns the file; dev becomes the guest disk
+    dev->fd = -1;
+    dev->map = NULL;
+    dev->map_length = 0;
+    dev->alignment = BLK_DEFAULT_SECTOR_SIZE;
+    dev->size_bytes = image->virtual_size;
+    memset(&dev->stats, 0, sizeof(dev->stats)); // Counted by the image file when it is closed
+    dev->image = image;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Closes the image file and frees the tables of an image.
+ *
+ * @param image: The image to free (may be NULL).
+ */
+void IMAGE_close(IMAGE_Image *image)
+{
+    if (image == NULL)
+    {
+        return;
+    }
+
+    for (int i = 0; i < IMAGE_TABLE_COUNT; i++)
+    {
+        free(image->tables[i].data);
+    }
+    free(image->l1);
+    free(image->compressed);
+    free(image->cluster);
+    BLK_close(&image->file);
+    free(image);
+}
+
+
+
+
+
+
+/**
+ * Returns the name of the format of an image.
+ *
+ * @param image: The image, or NULL for a raw device or image.
+ *
+ * @return "qcow2", "VHD (fixed)", "VHD (dynamic)" or "raw".
+ */
+const char *IMAGE_format_name(const IMAGE_Image *image)
+{
+    if (image == NULL)
+    {
+        return "raw";
+    }
+
+    switch (image->format)
+    {
+        case IMAGE_FORMAT_QCOW2:        return "qcow2";
+        case IMAGE_FORMAT_VHD_FIXED:    return "VHD (fixed)";
+        case IMAGE_FORMAT_VHD_DYNAMIC:  return "VHD (dynamic)";
+    }
+    return "raw";
+}
@@ -0,0 +1,144 @@
+/**
+ *===================================================================================
+ * @file           : Image_Format.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Image_Format (qcow2 and VHD disk image backends)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _IMAGE_FORMAT_H_
+#define _IMAGE_FORMAT_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stddef.h>         // Defines size_t
+#include <inttypes.h>       // Provides integer types with specified widths (e.g., uint64_t)
+#include "Block_IO.h"       // Provides the device the image file is read through
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Number of lookup tables kept by an image (least recently used table is replaced).
+ *
+ * A qcow2 L2 table maps one cluster of entries (8192 clusters, 512 MiB of guest data
+ * with 64 KiB clusters), a VHD BAT page maps 1024 blocks (2 GiB with 2 MiB blocks), so
+ * the start of the disk, the backup GPT at the end and an EBR chain fit in a few tables.
+ */
+#define IMAGE_TABLE_COUNT           4
+
+/**
+ * Size in bytes of a cached page of the VHD Block Allocation Table (1024 entries).
+ */
+#define IMAGE_VHD_BAT_PAGE_SIZE     4096
+
+/**
+ * Largest qcow2 L1 table accepted, in bytes (the limit QEMU uses as well).
+ */
+#define IMAGE_QCOW2_MAX_L1_SIZE     (32 * 1024 * 1024)
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Container format of a disk image.
+ */
+typedef enum {
+    IMAGE_FORMAT_QCOW2,         /**< QEMU copy-on-write v2/v3 (sparse, optionally zlib-compressed). */
+    IMAGE_FORMAT_VHD_FIXED,     /**< Fixed VHD: raw data followed by a 512-byte footer. */
+    IMAGE_FORMAT_VHD_DYNAMIC    /**< Dynamic VHD: blocks allocated through the BAT. */
+} IMAGE_Format;
+
+/**
+ * Represents one cached lookup table (a qcow2 L2 table or a page of the VHD BAT).
+ *
+ * Fields:
+ *
+ * @param offset: Byte offset of the table in the image file.
+ * @param last_use: Value of the image clock when the table was last used (0 = empty).
+ * @param data: The table as stored in the file (big-endian entries).
+ */
+typedef struct {
+    uint64_t offset;     /**< Offset of the table in the image file. */
+    uint64_t last_use;   /**< LRU timestamp, 0 if the slot is empty. */
+    uint8_t *data;       /**< Table data. */
+} IMAGE_Table;
+
+/**
+ * Represents a qcow2 or VHD image attached to a device (see `IMAGE_open`).
+ *
+ * The device then reads guest sectors: every read is translated through the lookup
+ * tables into reads of the image file, unallocated ranges read as zeros.
+ * Not thread-safe: the tables and the decompressed cluster are shared by all reads.
+ *
+ * Fields:
+ *
+ * @param format: Container format.
+ * @param file: The image file itself (raw reads, mmap backend if available).
+ * @param file_size: Size of the image file in bytes.
+ * @param virtual_size: Size of the guest disk in bytes.
+ * @param unit_size: Guest bytes mapped by one table entry (qcow2 cluster, VHD block).
+ * @param qcow2_version: qcow2 version (2 or 3), 0 for VHD.
+ * @param l1: qcow2 L1 table, converted to host byte order.
+ * @param l1_size: Number of L1 entries.
+ * @param l2_bits: log2 of the number of entries of an L2 table.
+ * @param bat_offset: Offset of the VHD Block Allocation Table in the image file.
+ * @param bat_entries: Number of BAT entries.
+ * @param bitmap_size: Size of the sector bitmap in front of every VHD block.
+ * @param table_size: Size of a cached lookup table in bytes.
+ * @param tables: Cached lookup tables.
+ * @param clock: Counter incremented on every table access (LRU order).
+ * @param compressed: Buffer of the compressed cluster read from the file.
+ * @param cluster: Last decompressed qcow2 cluster.
+ * @param cluster_offset: File offset of the compressed data of `cluster` (UINT64_MAX if none).
+ */
+typedef struct IMAGE_Image {
+    IMAGE_Format format;                      /**< qcow2, fixed or dynamic VHD. */
+    BLK_Device file;                          /**< Image file. */
+    uint64_t file_size;                       /**< Size of the image file. */
+    uint64_t virtual_size;                    /**< Size of the guest disk. */
+    uint64_t unit_size;                       /**< Cluster or block size. */
+    uint32_t qcow2_version;                   /**< qcow2 version. */
+    uint64_t *l1;                             /**< qcow2 L1 table. */
+    uint32_t l1_size;                         /**< L1 entries. */
+    uint32_t l2_bits;                         /**< log2 of the L2 entries. */
+    uint64_t bat_offset;                      /**< VHD BAT offset. */
+    uint32_t bat_entries;                     /**< VHD BAT entries. */
+    uint32_t bitmap_size;                     /**< VHD sector bitmap size. */
+    size_t table_size;                        /**< Size of a cached table. */
+    IMAGE_Table tables[IMAGE_TABLE_COUNT];    /**< Cached lookup tables. */
+    uint64_t clock;                           /**< LRU clock. */
+    uint8_t *compressed;                      /**< Compressed cluster buffer. */
+    uint8_t *cluster;                         /**< Decompressed cluster. */
+    uint64_t cluster_offset;                  /**< Compressed data of `cluster`. */
+} IMAGE_Image;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+int IMAGE_open(BLK_Device *dev);
+void IMAGE_close(IMAGE_Image *image);
+int IMAGE_read(IMAGE_Image *image, uint64_t offset, void *buf, size_t length);
+const char *IMAGE_format_name(const IMAGE_Image *image);
+
+#endif
@@ -31,13 +31,14 @@
  * This helper function calculates the size in megabytes from the given sector count.
  *
  * @param sector_count: The number of sectors.
+ * @param sector_size: The logical sector size of the device in bytes.
  *
  * @return The size in megabytes.
  */
-static uint32_t convert_sectors_to_mb(uint32_t sector_count) 
+static uint32_t convert_sectors_to_mb(uint32_t sector_count, uint32_t sector_size) 
 {
     // Calculate and return size in MB
-    return (uint32_t)((((uint64_t)sector_count * SECTOR_SIZE) + (1024 * 1024 - 1)) / (1024 * 1024));
+    return (uint32_t)((((uint64_t)sector_count * sector_size) + (1024 * 1024 - 1)) / (1024 * 1024));
 }
 
 
@@ -46,27 +47,6 @@ static uint32_t convert_sectors_to_mb(uint32_t sector_count)
 
 
 
-/**
- * Check if a partition entry is empty.
- *
- * This helper function determines if a partition entry is empty based on its LBA and sector count.
- *
- * @param entry: Pointer to the MBR partition entry.
- *
- * @return 1 if the partition is empty, 0 otherwise.
- */
-static int is_partition_empty(const MBR_PartitionEntry *entry) 
-{
-    return (entry->lba == 0 && entry->sector_count == 0);
-}
-
-
-
-
-
-
-
-
 /**
  * Get the description of an MBR partition type based on the type code.
  *
@@ -154,180 +134,41 @@ const char* MBR_get_partition_type(unsigned char type)
 /**
  * Print formatted information about an MBR partition.
  *
- * This function prints details of a partition entry including its status, start and end LBA,
- * sector count, size in megabytes, and type. It skips empty partitions.
+ * This function prints details of a partition descriptor (see `PARSE_read_table`) including
+ * its status, start and end LBA, sector count, size in megabytes, and type.
  *
+ * @param out: The stream the partition information is printed to (e.g., stdout).
  * @param device: The device name or identifier to be printed.
- * @param index: The index of the partition.
- * @param entry: Pointer to the MBR partition entry.
- * @param base_lba: The base LBA from which to calculate the absolute start and end LBA.
+ * @param partition: The descriptor of the primary, extended or logical partition.
+ * @param sector_size: The logical sector size of the device in bytes.
  */
-void MBR_print_partition_info(const char *device, int index, MBR_PartitionEntry *entry, uint32_t base_lba) 
+void MBR_print_partition_info(FILE *out, const char *device, const PARSE_Partition *partition, uint32_t sector_size) 
 {
     // Check for invalid arguments
-    if (device == NULL || entry == NULL) 
+    if (out == NULL || device == NULL || partition == NULL) 
     {
         fprintf(stderr, "Invalid arguments: NULL pointer provided.\n");
         return;
     }
 
-    // Check if the partition is empty; if so, skip processing
-    if (is_partition_empty(entry)) 
-    {
-        return;
-    }
-
-    // Calculate the starting and ending LBA of the partition
-    uint32_t start_lba = base_lba + entry->lba;
-    uint32_t end_lba = start_lba + entry->sector_count - 1;
-
     // Determine the boot indicator based on the status byte
-    char boot_indicator = (entry->status == 0x80) ? '*' : ' ';
+    char boot_indicator = (partition->flags & PARSE_FLAG_BOOTABLE) ? '*' : ' ';
 
     // Retrieve a descriptive string for the partition type
-    const char *partition_type_desc = MBR_get_partition_type(entry->partition_type);
+    const char *partition_type_desc = MBR_get_partition_type(partition->mbr_type);
 
     // Calculate the size in megabytes
-    uint32_t size_mb = convert_sectors_to_mb(entry->sector_count);
+    uint32_t size_mb = convert_sectors_to_mb((uint32_t)partition->count, sector_size);
 
     // Print the partition information in a formatted manner
-    printf("%-20s%-6d %-6c %-10u %-10u %-10u %-10u %-6X %-6s\n",
+    fprintf(out, "%-20s%-6d %-6c %-10" PRIu64 " %-10" PRIu64 " %-10" PRIu64 " %-10u %-6X %-6s\n",
            device,                        // Device name
-           index,                         // Partition index
+           partition->index,              // Partition index
            boot_indicator,                // Boot indicator ('*' if active, ' ' otherwise)
-           start_lba,                     // Starting LBA of the partition
-           end_lba,                       // Ending LBA of the partition
-           entry->sector_count,           // Number of sectors in the partition
+           partition->start,              // Starting LBA of the partition
+           partition->end,                // Ending LBA of the partition
+           partition->count,              // Number of sectors in the partition
            size_mb,                       // Size of the partition in MB
-           entry->partition_type,         // Partition type code
+           partition->mbr_type,           // Partition type code
            partition_type_desc);          // Description of the partition type
 }
-
-
-
-
-
-
-/**
- * Reads a sector from the disk at a specific LBA.
- *
- * This helper function reads a single sector from the disk and stores it in the buffer.
- *
- * @param fd: File descriptor for the disk.
- * @param lba: Logical Block Address (LBA) to read from.
- * @param buf: Buffer to store the read data.
- *
- * @return 0 on success, -1 on failure.
- */
-static int read_sector(int fd, uint32_t lba, char *buf) 
-{
-    if (lseek(fd, lba * SECTOR_SIZE, SEEK_SET) == -1) 
-    {
-        perror("lseek error");
-        return -1;
-    }
-
-    if (read(fd, buf, SECTOR_SIZE) != SECTOR_SIZE) 
-    {
-        perror("read error");
-        return -1;
-    }
-
-    return 0;
-}
-
-
-
-
-
-
-/**
- * Moves to the next logical partition entry in the EBR.
- *
- * This helper function checks the second entry in the EBR to determine if there is another
- * logical partition and returns its LBA if present.
- *
- * @param entry: Pointer to the first partition entry in the EBR.
- * @param first_ebr_lba: The LBA of the first EBR to calculate the absolute LBA of the next logical partition.
- *
- * @return The LBA of the next logical partition if it exists, or 0 if there are no more logical partitions.
- */
-static uint32_t get_next_ebr_lba(const MBR_PartitionEntry *entry, uint32_t first_ebr_lba) 
-{
-    // The second partition entry in the EBR points to the next EBR (if any)
-    if (entry[1].lba != 0) 
-    {
-        return first_ebr_lba + entry[1].lba;
-    } 
-    else 
-    {
-        return 0;  // No more logical partitions
-    }
-}
-
-
-
-
-
-
-
-/**
- * Parse and print information from the Extended Boot Record (EBR).
- *
- * This function traverses through the Extended Boot Record (EBR) chain to parse and print
- * details of all logical partitions within the EBR. It starts from the first EBR (given by 
- * `first_ebr_lba`) and continues to the next linked EBR until no more logical partitions 
- * are found.
- *
- * It prints the information for each logical partition using the `MBR_print_partition_info` 
- * function and increments the partition index for each logical partition.
- *
- * @param fd: The file descriptor representing the disk device. The file must be opened
- *            and point to the appropriate disk (e.g., `/dev/sda`).
- * @param device: A string representing the device name or identifier (e.g., `/dev/sda`), 
- *                which is printed as part of the partition information.
- * @param first_ebr_lba: The LBA (Logical Block Addressing) of the first EBR in the chain. 
- *                       This LBA is used as the starting point to traverse the linked EBRs.
- * @param index: A pointer to an integer representing the partition index. This index will 
- *               be incremented with each logical partition found and printed. It is passed 
- *               by reference so the calling function can keep track of the current partition number.
- * 
- * 
- */
-void MBR_parse_ebr(int fd, const char *device, uint32_t first_ebr_lba, int *index) 
-{
-    // Validate input arguments
-    if (device == NULL || index == NULL) 
-    {
-        fprintf(stderr, "Invalid arguments: NULL pointer provided.\n");
-        return;
-    }
-
-    char buf[SECTOR_SIZE];  // Buffer to store the sector data
-    MBR_PartitionEntry *entry;  // Pointer to the partition entry structure
-
-    uint32_t current_partition_lba = first_ebr_lba;  // Start with the first EBR
-
-    // Loop through each linked EBR until there are no more logical partitions
-    while (current_partition_lba != 0) 
-    {
-        // Read the current EBR sector into the buffer
-        if (read_sector(fd, current_partition_lba, buf) == -1) 
-        {
-            fprintf(stderr, "Error reading EBR at LBA: %u\n", current_partition_lba);
-            return;
-        }
-
-        // Skip the first 446 bytes (boot code) to get to the partition entries
-        entry = (MBR_PartitionEntry *)&buf[446];
-
-        // Print the partition information using the helper function
-        MBR_print_partition_info(device, *index, entry, current_partition_lba);
-
-        // Increment the partition index
-        (*index)++;  
-
-        // Move to the next linked EBR (if any)
-        current_partition_lba = get_next_ebr_lba(entry, first_ebr_lba);
-    }
-}
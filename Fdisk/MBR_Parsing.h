@@ -27,6 +27,8 @@
 #include <inttypes.h>  // Provides integer types with specified widths and formatting (e.g., int32_t, PRIu32)
 #include <string.h>    // Provides functions for string manipulation (e.g., memcpy, memset, strcmp)
 #include <stdlib.h>    // Provides functions for memory allocation and process control (e.g., malloc, free, exit)
+#include "Block_IO.h"  // Provides sector-size-aware aligned reads (BLK_Device)
+#include "Partition_Parse.h" // Provides the partition descriptors printed by MBR_print_partition_info
 
 
 
@@ -37,14 +39,13 @@
  ********************************* Macros ************************************
  ============================================================================*/
 /**
- * Defines the size of a sector in bytes.
+ * Defines the size of an MBR/EBR record in bytes.
  *
- * This macro represents the standard size of a disk sector, which is 512 bytes.
- * A sector is the smallest addressable unit of data on most storage devices,
- * such as hard drives, SSDs, and other block storage systems. This value is 
- * commonly used in partition management, disk I/O operations, and file systems.
+ * The MBR (and every EBR) always occupies the first 512 bytes of its sector, whatever the 
+ * logical sector size of the device. Partition LBAs and sector counts, on the other hand, 
+ * are expressed in logical sectors of the device (512 or 4096 bytes, see `BLK_Device`).
  */
-#define SECTOR_SIZE                 512  // 512 bytes per sector
+#define SECTOR_SIZE                 BLK_DEFAULT_SECTOR_SIZE  // 512 bytes per MBR/EBR record
 
 /**
  * Represents the partition type for CHS-based extended partitions in the MBR.
@@ -168,7 +169,6 @@ typedef struct {
  *************************  Functions API Decleration  ***********************
  ============================================================================*/
 void MBR_print_size(uint64_t size_in_sectors);
-void MBR_print_partition_info(const char *device, int index, MBR_PartitionEntry *entry, uint32_t base_lba);
-void MBR_parse_ebr(int fd, const char *device, uint32_t First_EBR_LBA, int *index);
+void MBR_print_partition_info(FILE *out, const char *device, const PARSE_Partition *partition, uint32_t sector_size);
 
 #endif
@@ -0,0 +1,695 @@
+/**
+ *===================================================================================
+ * @file           : Partition_Parse.c
+ * @author         : Ali Mamdouh
+ * @brief          : libpartparse: parses MBR, EBR and GPT tables into caller-provided descriptors
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Partition_Parse.h"  // Includes the descriptor structures and API
+#include "MBR_Parsing.h"      // Provides MBR_PartitionEntry and the MBR/EBR constants
+#include "GPT_Parsing.h"      // Provides GPT_Header, GPT_PartitionEntry and the header checks
+#include "CRC32.h"            // Provides CRC32_update, used to checksum the entry array in pieces
+#include <string.h>           // Provides memcpy, memset and memcmp
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Represents what is known about one copy (primary or backup) of a GPT.
+ *
+ * Unlike `GPT_Copy` (GPT_Backup), the entry array is never kept: it is checksummed while
+ * it is walked through the sector cache, so no buffer is needed.
+ *
+ * Fields:
+ *
+ * @param lba: LBA the header was read from.
+ * @param header: Parsed header; only meaningful if `header_valid` is set.
+ * @param header_valid: The header was read and has a valid signature and geometry.
+ * @param header_crc_ok: The header CRC32 matches.
+ * @param entries_readable: The whole entry array lies on the device and was read.
+ * @param entries_crc_ok: The entry array CRC32 matches.
+ * @param entries_crc: CRC32 computed over the entry array.
+ */
+typedef struct {
+    uint64_t lba;             /**< LBA of the header. */
+    GPT_Header header;        /**< Parsed header. */
+    int header_valid;         /**< Header signature/geometry valid. */
+    int header_crc_ok;        /**< Header CRC32 matches. */
+    int entries_readable;     /**< Entry array read. */
+    int entries_crc_ok;       /**< Entry array CRC32 matches. */
+    uint32_t entries_crc;     /**< Computed entry array CRC32. */
+} gpt_copy;
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Returns the last LBA of a device.
+ */
+static uint64_t last_lba(const BLK_Device *dev)
+{
+    uint64_t sectors = dev->size_bytes / dev->logical_sector_size;
+    return sectors ? sectors - 1 : 0;
+}
+
+
+
+/**
+ * Appends a descriptor to the table, or only counts it if the caller's array is full.
+ */
+static void add_partition(PARSE_Table *table, const PARSE_Partition *partition)
+{
+    if (table->count < table->capacity)
+    {
+        table->partitions[table->count++] = *partition;
+    }
+    table->total++;
+}
+
+
+
+/**
+ * Records why an EBR chain stopped early (only the first broken chain is kept).
+ */
+static void stop_chain(PARSE_Table *table, uint32_t problem, int extended_index, uint64_t lba)
+{
+    if ((table->problems & PARSE_PROBLEM_EBR) == 0)
+    {
+        table->ebr_index = extended_index;
+        table->ebr_lba = lba;
+    }
+    table->problems |= problem;
+}
+
+
+
+
+
+
+/**
+ * Fills a descriptor from an MBR or EBR partition entry.
+ *
+ * @param partition: The descriptor to fill.
+ * @param index: Partition number.
+ * @param origin: Primary, extended or logical.
+ * @param entry: The partition entry.
+ * @param base_lba: LBA the entry's start is relative to (0 for the MBR, the EBR for a
+ *                  logical partition), which is also the sector holding the entry.
+ */
+static void fill_mbr_partition(PARSE_Partition *partition, int index, PARSE_Origin origin, const MBR_PartitionEntry *entry, uint64_t base_lba)
+{
+    memset(partition, 0, sizeof(*partition));
+    partition->index = index;
+    partition->origin = origin;
+    partition->flags = (entry->status == 0x80) ? PARSE_FLAG_BOOTABLE : 0;
+    partition->mbr_type = entry->partition_type;
+    partition->start = base_lba + entry->lba;
+    partition->count = entry->sector_count;
+    partition->end = partition->start + partition->count - 1;
+    partition->table_lba = base_lba;
+}
+
+
+
+
+
+
+/**
+ * Reads the two partition entries of an EBR.
+ *
+ * The entries are copied out of the sector cache, so they are naturally aligned and stay
+ * valid across later cache accesses.
+ *
+ * @param cache: The sector cache of the opened device.
+ * @param lba: LBA of the EBR.
+ * @param entries: Receives the logical partition entry and the link to the next EBR.
+ *
+ * @return 0 on success, or -1 if the EBR cannot be read.
+ */
+static int read_ebr(CACHE_Cache *cache, uint64_t lba, MBR_PartitionEntry entries[2])
+{
+    return CACHE_read(cache, lba * cache->dev->logical_sector_size + 446, entries, 2 * sizeof(MBR_PartitionEntry));
+}
+
+
+
+/**
+ * Returns the LBA of the EBR following the one at `lba`, or 0 at the end of the chain
+ * (or if the EBR cannot be read). Links are relative to the first EBR and computed in
+ * 64 bits, so a corrupted link cannot wrap around to an earlier sector.
+ */
+static uint64_t next_ebr(CACHE_Cache *cache, uint64_t first_ebr_lba, uint64_t lba)
+{
+    MBR_PartitionEntry entries[2];
+    if (read_ebr(cache, lba, entries) != 0 || entries[1].lba == 0)
+    {
+        return 0;
+    }
+    return first_ebr_lba + entries[1].lba;
+}
+
+
+
+
+
+
+/**
+ * Cuts an EBR chain found to loop back on itself right before its first repeated EBR.
+ *
+ * The walk only learns the length of the cycle (Brent's algorithm), some EBRs after the
+ * repeat. The first EBR of the cycle is found with two cursors `cycle` EBRs apart, which
+ * meet on it; the chain is then the `mu + cycle` EBRs before the repeat, and the logical
+ * partitions collected beyond it are dropped. The EBRs re-read here are all cached.
+ *
+ * @param cache: The sector cache of the opened device.
+ * @param table: The table being filled.
+ * @param extended_index: Index of the extended partition.
+ * @param first_ebr_lba: LBA of the first EBR of the chain.
+ * @param cycle: Length of the cycle.
+ * @param total_before: `table->total` before the chain was walked.
+ * @param first_index: Index of the first logical partition of the chain.
+ * @param index: Receives the index following the last logical partition kept.
+ */
+static void cut_loop(CACHE_Cache *cache, PARSE_Table *table, int extended_index, uint64_t first_ebr_lba,
+                     uint64_t cycle, size_t total_before, int first_index, int *index)
+{
+    // Find the first EBR of the cycle
+    uint64_t slow = first_ebr_lba, fast = first_ebr_lba;
+    for (uint64_t i = 0; i < cycle; i++)
+    {
+        fast = next_ebr(cache, first_ebr_lba, fast);
+    }
+    uint64_t mu = 0;
+    while (slow != fast)
+    {
+        slow = next_ebr(cache, first_ebr_lba, slow);
+        fast = next_ebr(cache, first_ebr_lba, fast);
+        mu++;
+    }
+
+    // Keep the logical partitions of the EBRs before the repeat
+    MBR_PartitionEntry entries[2];
+    uint64_t lba = first_ebr_lba;
+    table->total = total_before;
+    for (uint64_t i = 0; i < mu + cycle && lba != 0; i++)
+    {
+        if (read_ebr(cache, lba, entries) != 0)
+        {
+            break;
+        }
+        if (entries[0].lba != 0 || entries[0].sector_count != 0)
+        {
+            table->total++;
+        }
+        lba = (entries[1].lba != 0) ? first_ebr_lba + entries[1].lba : 0;
+    }
+    table->count = (table->total < table->capacity) ? table->total : table->capacity;
+    *index = first_index + (int)(mu + cycle);
+
+    stop_chain(table, PARSE_PROBLEM_EBR_LOOP, extended_index, slow);
+}
+
+
+
+
+
+
+/**
+ * Walks the EBR chain of an extended partition and collects its logical partitions.
+ *
+ * The chain comes from the disk and is not trusted: the walk stops when a link points
+ * outside the extended partition (or the device), when an EBR cannot be read, or when
+ * the chain loops back to an EBR already visited, so corrupted or crafted chains always
+ * terminate. Loops are detected with Brent's algorithm, which remembers a single EBR
+ * instead of the set of visited ones, so the walk needs no memory however long the chain.
+ * Logical partitions extending beyond the extended partition are flagged.
+ *
+ * @param cache: The sector cache of the opened device.
+ * @param table: The table the logical partitions are appended to.
+ * @param extended_index: Index of the extended partition.
+ * @param first_ebr_lba: LBA of the first EBR (the start of the extended partition).
+ * @param extended_sector_count: Size of the extended partition in sectors.
+ * @param index: Index of the next logical partition; advanced for every EBR.
+ */
+static void parse_ebr_chain(CACHE_Cache *cache, PARSE_Table *table, int extended_index,
+                            uint32_t first_ebr_lba, uint32_t extended_sector_count, int *index)
+{
+    MBR_PartitionEntry entries[2];
+    PARSE_Partition partition;
+
+    // Every EBR and logical partition must lie inside the extended partition and the device
+    uint64_t device_sectors = cache->dev->size_bytes / cache->dev->logical_sector_size;
+    uint64_t extended_end = (uint64_t)first_ebr_lba + extended_sector_count;
+    if (extended_sector_count == 0 || extended_end > device_sectors)
+    {
+        extended_end = device_sectors;
+    }
+
+    size_t total_before = table->total;
+    int first_index = *index;
+    uint64_t saved = 0;               // Brent: EBR the following ones are compared with
+    uint64_t power = 1, steps = 0;    // Brent: steps since `saved`, and when to move it
+    uint64_t lba = first_ebr_lba;
+
+    while (lba != 0)
+    {
+        // Check the link before following it
+        if (lba < first_ebr_lba || lba >= extended_end)
+        {
+            stop_chain(table, PARSE_PROBLEM_EBR_OUTSIDE, extended_index, lba);
+            return;
+        }
+        if (lba == saved)
+        {
+            cut_loop(cache, table, extended_index, first_ebr_lba, steps, total_before, first_index, index);
+            return;
+        }
+        if (steps == power)
+        {
+            saved = lba;
+            power *= 2;
+            steps = 0;
+        }
+        steps++;
+
+        if (read_ebr(cache, lba, entries) != 0)
+        {
+            stop_chain(table, PARSE_PROBLEM_EBR_READ, extended_index, lba);
+            return;
+        }
+
+        // The first entry describes the logical partition, relative to its EBR
+        if (entries[0].lba != 0 || entries[0].sector_count != 0)
+        {
+            fill_mbr_partition(&partition, *index, PARSE_ORIGIN_LOGICAL, &entries[0], lba);
+            if (partition.start + partition.count > extended_end)
+            {
+                partition.flags |= PARSE_FLAG_OUTSIDE_EXTENDED;
+            }
+            add_partition(table, &partition);
+        }
+        (*index)++;
+
+        // The second entry links to the next EBR, relative to the first EBR
+        lba = (entries[1].lba != 0) ? (uint64_t)first_ebr_lba + entries[1].lba : 0;
+    }
+}
+
+
+
+
+
+
+/**
+ * Collects the primary, extended and logical partitions of an MBR.
+ *
+ * Primary entries with a start LBA of 0 are unused; the others are numbered 1, 2, ... in
+ * table order, and logical partitions from 5, following the EBR chain of every extended
+ * partition (types 0x05, 0x0F and 0x85) right after it.
+ *
+ * @param cache: The sector cache of the opened device.
+ * @param entries: The four primary entries of the MBR.
+ * @param table: The table the partitions are appended to.
+ */
+static void parse_mbr(CACHE_Cache *cache, const MBR_PartitionEntry *entries, PARSE_Table *table)
+{
+    PARSE_Partition partition;
+    int partition_index = 1;
+    int logical_partition_index = 5; // Logical partitions start at index 5
+
+    for (int i = 0; i < MBR_PARTITIONS_NUM; i++)
+    {
+        if (entries[i].lba == 0)
+        {
+            continue;
+        }
+
+        int extended = (entries[i].partition_type == CHS_EXTENDED_PARTITION ||
+                        entries[i].partition_type == LBA_EXTENDED_PARTITION ||
+                        entries[i].partition_type == LINUX_EXTENDED_PARTITION);
+        fill_mbr_partition(&partition, partition_index++, extended ? PARSE_ORIGIN_EXTENDED : PARSE_ORIGIN_PRIMARY, &entries[i], 0);
+        add_partition(table, &partition);
+
+        if (extended)
+        {
+            parse_ebr_chain(cache, table, partition.index, entries[i].lba, entries[i].sector_count, &logical_partition_index);
+        }
+    }
+}
+
+
+
+
+
+
+/**
+ * Reads and checks the header of one GPT copy.
+ *
+ * @param cache: The sector cache of the opened device.
+ * @param lba: LBA of the header (1 for the primary, AlternateLBA for the backup).
+ * @param copy: Receives the header and the outcome of the checks.
+ */
+static void load_header(CACHE_Cache *cache, uint64_t lba, gpt_copy *copy)
+{
+    BLK_Device *dev = cache->dev;
+    char sector[GPT_HEADER_SECTOR_SIZE];
+
+    memset(copy, 0, sizeof(*copy));
+    copy->lba = lba;
+
+    if (lba == 0 || lba > last_lba(dev) ||
+        CACHE_read(cache, lba * dev->logical_sector_size, sector, GPT_HEADER_SECTOR_SIZE) != 0)
+    {
+        return;
+    }
+    memcpy(&copy->header, sector, sizeof(GPT_Header));
+    if (GPT_check_header(&copy->header) != GPT_HEADER_OK)
+    {
+        return;
+    }
+    copy->header_valid = 1;
+    copy->header_crc_ok = GPT_verify_header_crc(sector, &copy->header);
+}
+
+
+
+
+
+
+/**
+ * Walks the entry array of a GPT copy, checksumming it and optionally collecting its
+ * partitions.
+ *
+ * The array is never held in memory: every entry is checksummed in pieces that stay
+ * inside one cache block (zero-copy from the cached block, or from the mapping of an
+ * image file), and only the 128 bytes of a used entry are copied into its descriptor.
+ * A default 128-entry array costs no read beyond the block holding the primary header.
+ * If the array cannot be read, the partitions collected from it are dropped.
+ *
+ * @param cache: The sector cache of the opened device.
+ * @param copy: The copy (header must be valid); the entry array fields are filled in.
+ * @param table: The table the partitions are appended to.
+ * @param collect: Non-zero to append the used entries to the table.
+ */
+static void scan_entries(CACHE_Cache *cache, gpt_copy *copy, PARSE_Table *table, int collect)
+{
+    BLK_Device *dev = cache->dev;
+    const GPT_Header *header = &copy->header;
+    uint32_t entry_size = header->size_of_partition_entry;
+    uint64_t array_size = (uint64_t)header->num_partition_entries * entry_size;
+    uint64_t array_sectors = (array_size + dev->logical_sector_size - 1) / dev->logical_sector_size;
+    size_t count_before = table->count, total_before = table->total;
+    uint32_t crc = 0;
+
+    // The whole array, in whole sectors, must lie on the device
+    if (header->partition_entry_lba > last_lba(dev) ||
+        array_sectors > last_lba(dev) + 1 - header->partition_entry_lba)
+    {
+        return;
+    }
+    uint64_t offset = header->partition_entry_lba * dev->logical_sector_size;
+
+    for (uint32_t i = 0; i < header->num_partition_entries; i++)
+    {
+        uint64_t entry_offset = offset + (uint64_t)i * entry_size;
+
+        for (uint64_t done = 0; done < entry_size; )
+        {
+            uint64_t position = entry_offset + done;
+            size_t piece = CACHE_BLOCK_SIZE - position % CACHE_BLOCK_SIZE;
+            if (piece > entry_size - done)
+            {
+                piece = entry_size - done;
+            }
+            const void *data = CACHE_get(cache, position, piece, NULL);
+            if (data == NULL)
+            {
+                table->count = count_before;
+                table->total = total_before;
+                return;
+            }
+            crc = CRC32_update(crc, data, piece);
+            done += piece;
+        }
+
+        if (!collect)
+        {
+            continue;
+        }
+
+        GPT_PartitionEntry entry;
+        if (CACHE_read(cache, entry_offset, &entry, sizeof(entry)) != 0)
+        {
+            table->count = count_before;
+            table->total = total_before;
+            return;
+        }
+        if (entry.starting_lba == 0 && entry.ending_lba == 0)
+        {
+            continue; // Unused entry
+        }
+
+        PARSE_Partition partition;
+        memset(&partition, 0, sizeof(partition));
+        partition.index = (int)i + 1;
+        partition.origin = PARSE_ORIGIN_GPT;
+        partition.flags = (entry.attributes & (1ULL << 2)) ? PARSE_FLAG_BOOTABLE : 0;
+        partition.start = entry.starting_lba;
+        partition.end = entry.ending_lba;
+        if (entry.ending_lba >= entry.starting_lba)
+        {
+            partition.count = entry.ending_lba - entry.starting_lba + 1;
+        }
+        else
+        {
+            partition.flags |= PARSE_FLAG_REVERSED;
+        }
+        partition.table_lba = header->partition_entry_lba + (uint64_t)i * entry_size / dev->logical_sector_size;
+        partition.attributes = entry.attributes;
+        memcpy(partition.type_guid, entry.type_guid, PARSE_GUID_SIZE);
+        memcpy(partition.partition_guid, entry.partition_guid, PARSE_GUID_SIZE);
+        memcpy(partition.name, entry.partition_name, sizeof(partition.name));
+        add_partition(table, &partition);
+    }
+
+    copy->entries_readable = 1;
+    copy->entries_crc = crc;
+    copy->entries_crc_ok = (crc == header->partition_entry_array_crc32);
+}
+
+
+
+
+
+
+/**
+ * Checks whether a GPT copy is intact and where its header says it is.
+ */
+static int copy_is_healthy(const gpt_copy *copy)
+{
+    return copy->header_valid && copy->header_crc_ok && copy->header.my_lba == copy->lba &&
+           copy->entries_readable && copy->entries_crc_ok;
+}
+
+
+
+/**
+ * Checks whether the primary and backup headers (both valid) describe the same table.
+ *
+ * The entry arrays are compared through their CRC32s, which were computed while they
+ * were walked, instead of byte by byte.
+ */
+static int copies_differ(const gpt_copy *primary, const gpt_copy *backup)
+{
+    const GPT_Header *p = &primary->header;
+    const GPT_Header *b = &backup->header;
+
+    if (p->alternate_lba != backup->lba || b->alternate_lba != primary->lba ||
+        p->first_usable_lba != b->first_usable_lba || p->last_usable_lba != b->last_usable_lba ||
+        memcmp(p->disk_guid, b->disk_guid, GUID_SIZE) != 0 ||
+        p->num_partition_entries != b->num_partition_entries ||
+        p->size_of_partition_entry != b->size_of_partition_entry)
+    {
+        return 1;
+    }
+    return primary->entries_readable && backup->entries_readable && primary->entries_crc != backup->entries_crc;
+}
+
+
+
+
+
+
+/**
+ * Collects the partitions of a GPT and checks both of its copies.
+ *
+ * This function performs the following tasks:
+ * 1. Reads the primary header (LBA 1), and the backup header from the primary's
+ *    AlternateLBA, or from the last LBA of the device if the primary header is unusable.
+ * 2. Walks the primary entry array, collecting its partitions while checksumming it, then
+ *    checksums the backup entry array.
+ * 3. Keeps the partitions of an intact primary; otherwise collects them again from the
+ *    copy `GPT_select_copy` would choose (intact backup, then any readable copy).
+ * 4. Sets the GPT problem bits the way `GPT_report_integrity` counts problems: a damaged
+ *    or misplaced copy, a backup not on the last LBA, or copies that disagree.
+ *
+ * @param cache: The sector cache of the opened device.
+ * @param table: The table the partitions and the GPT fields are filled into.
+ *
+ * @return 0 on success, or -1 if neither copy is usable.
+ */
+static int parse_gpt(CACHE_Cache *cache, PARSE_Table *table)
+{
+    uint64_t last = last_lba(cache->dev);
+    gpt_copy primary, backup;
+
+    load_header(cache, GPT_HEADER_LBA, &primary);
+    load_header(cache, primary.header_valid ? primary.header.alternate_lba : last, &backup);
+
+    if (primary.header_valid)
+    {
+        scan_entries(cache, &primary, table, 1);
+    }
+    if (backup.header_valid)
+    {
+        scan_entries(cache, &backup, table, 0);
+    }
+
+    // Choose the copy to describe, as GPT_select_copy does
+    gpt_copy *selected = NULL;
+    int primary_usable = primary.header_valid && primary.entries_readable;
+    int backup_usable = backup.header_valid && backup.entries_readable;
+    if (primary_usable && primary.header_crc_ok && primary.entries_crc_ok)     selected = &primary;
+    else if (backup_usable && backup.header_crc_ok && backup.entries_crc_ok)   selected = &backup;
+    else if (primary_usable)                                                   selected = &primary;
+    else if (backup_usable)                                                    selected = &backup;
+
+    if (selected != &primary)
+    {
+        table->count = 0;
+        table->total = 0;
+        if (selected != NULL)
+        {
+            scan_entries(cache, selected, table, 1);
+        }
+    }
+
+    if (!copy_is_healthy(&primary))
+    {
+        table->problems |= PARSE_PROBLEM_GPT_PRIMARY;
+    }
+    if (!copy_is_healthy(&backup) || (backup.header_valid && backup.lba != last))
+    {
+        table->problems |= PARSE_PROBLEM_GPT_BACKUP;
+    }
+    if (primary.header_valid && backup.header_valid && copies_differ(&primary, &backup))
+    {
+        table->problems |= PARSE_PROBLEM_GPT_MISMATCH;
+    }
+
+    if (selected == NULL)
+    {
+        return -1;
+    }
+    table->first_usable = selected->header.first_usable_lba;
+    table->last_usable = selected->header.last_usable_lba;
+    memcpy(table->disk_guid, selected->header.disk_guid, PARSE_GUID_SIZE);
+    table->gpt_lba = selected->lba;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Parses the partition table of a device into caller-provided descriptors.
+ *
+ * This is the whole parsing library ("libpartparse"): it allocates no memory and prints
+ * nothing, so it can be used by tools that have their own output (myfdisk is a printer
+ * over it) or that must not allocate. Every sector is read through the caller's sector
+ * cache (zero-copy for mapped image files).
+ *
+ * This function performs the following tasks:
+ * 1. Reads the MBR. A protective entry (type 0xEE in the first slot) means a GPT,
+ *    otherwise the 0xAA55 signature means an MBR; anything else is no partition table.
+ * 2. For an MBR, collects the primary and extended partitions and walks the EBR chain of
+ *    every extended partition for its logical partitions. The usable range is sector 1
+ *    to the last sector 32-bit LBAs can address.
+ * 3. For a GPT, checks the primary and backup copies, collects the partitions of the
+ *    copy that can be trusted and takes the usable range and disk GUID from it.
+ * 4. Records the problems found (broken EBR chains, damaged or mismatching GPT copies)
+ *    in `table->problems` instead of reporting them.
+ *
+ * Descriptors are written in table order, up to `capacity`; `table->total` counts every
+ * partition found, so a caller whose array was too small can call again with an array
+ * of `table->total` descriptors (the sectors are still cached).
+ *
+ * @param cache: The sector cache of the opened device.
+ * @param partitions: Array receiving the descriptors (may be NULL if `capacity` is 0).
+ * @param capacity: Number of descriptors in the array.
+ * @param table: Receives the table type, its fields and the number of descriptors.
+ *
+ * @return 0 on success (including a device without a partition table), or -1 if the
+ *         MBR cannot be read or no usable GPT copy was found.
+ */
+int PARSE_read_table(CACHE_Cache *cache, PARSE_Partition *partitions, size_t capacity, PARSE_Table *table)
+{
+    char mbr[SECTOR_SIZE];
+    uint16_t signature;
+
+    memset(table, 0, sizeof(*table));
+    table->partitions = partitions;
+    table->capacity = (partitions != NULL) ? capacity : 0;
+    table->sector_size = cache->dev->logical_sector_size;
+
+    if (CACHE_read(cache, 0, mbr, SECTOR_SIZE) != 0)
+    {
+        return -1;
+    }
+
+    // Check if the device contains a GPT partition table
+    if ((uint8_t)mbr[450] == GPT_SIGNATURE)
+    {
+        table->label = PARSE_LABEL_GPT;
+        return parse_gpt(cache, table);
+    }
+
+    // Check if the device contains an MBR partition table
+    memcpy(&signature, &mbr[510], sizeof(signature));
+    if (signature == MBR_SIGNATURE)
+    {
+        MBR_PartitionEntry entries[MBR_PARTITIONS_NUM];
+        memcpy(entries, &mbr[446], sizeof(entries));
+
+        table->label = PARSE_LABEL_MBR;
+        parse_mbr(cache, entries, table);
+
+        // Everything after the MBR sector that 32-bit LBAs can address is usable
+        uint64_t last = last_lba(cache->dev);
+        table->first_usable = 1;
+        table->last_usable = (last > UINT32_MAX) ? UINT32_MAX : last;
+    }
+
+    return 0;
+}
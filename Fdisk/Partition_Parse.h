@@ -0,0 +1,186 @@
+/**
+ *===================================================================================
+ * @file           : Partition_Parse.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Partition_Parse (libpartparse: MBR, EBR and GPT to descriptors)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _PARTITION_PARSE_H_
+#define _PARTITION_PARSE_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stddef.h>         // Defines size_t
+#include <inttypes.h>       // Provides integer types with specified widths (e.g., uint64_t)
+#include "Sector_Cache.h"   // Provides the sector cache the tables are read through
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Number of descriptors a caller typically provides on the stack.
+ *
+ * Covers the default 128-entry GPT and any realistic MBR; larger tables report the
+ * number of descriptors they need in `PARSE_Table.total` (see `PARSE_read_table`).
+ */
+#define PARSE_DEFAULT_CAPACITY      128  // Descriptors of a default GPT
+
+/**
+ * Size of a binary GUID in bytes.
+ */
+#define PARSE_GUID_SIZE             16  // Bytes per GUID
+
+/**
+ * Length of a GPT partition name in UTF-16 code units.
+ */
+#define PARSE_NAME_LENGTH           36  // 72 bytes of UTF-16LE
+
+/**
+ * Flags of a partition descriptor (`PARSE_Partition.flags`).
+ *
+ * PARSE_FLAG_BOOTABLE: MBR boot indicator 0x80, or GPT attribute bit 2 (legacy BIOS bootable).
+ * PARSE_FLAG_OUTSIDE_EXTENDED: a logical partition extends beyond its extended partition.
+ * PARSE_FLAG_REVERSED: a GPT entry ends before it starts; its `count` is 0 and it occupies
+ *                      no space.
+ */
+#define PARSE_FLAG_BOOTABLE         0x01  // Active / legacy bootable
+#define PARSE_FLAG_OUTSIDE_EXTENDED 0x02  // Logical partition overruns its container
+#define PARSE_FLAG_REVERSED         0x04  // Ending LBA before starting LBA
+
+/**
+ * Problems found in the partition table (`PARSE_Table.problems`).
+ *
+ * The GPT bits only say that something is wrong; `GPT_report_integrity` (GPT_Backup)
+ * explains what, and `GPT_repair` fixes it.
+ */
+#define PARSE_PROBLEM_EBR_OUTSIDE   0x01  // An EBR link points outside the extended partition
+#define PARSE_PROBLEM_EBR_LOOP      0x02  // The EBR chain loops back to an earlier EBR
+#define PARSE_PROBLEM_EBR_READ      0x04  // An EBR could not be read
+#define PARSE_PROBLEM_GPT_PRIMARY   0x08  // Primary GPT missing, damaged or misplaced
+#define PARSE_PROBLEM_GPT_BACKUP    0x10  // Backup GPT missing, damaged or misplaced
+#define PARSE_PROBLEM_GPT_MISMATCH  0x20  // Primary and backup GPT disagree
+
+#define PARSE_PROBLEM_EBR           (PARSE_PROBLEM_EBR_OUTSIDE | PARSE_PROBLEM_EBR_LOOP | PARSE_PROBLEM_EBR_READ)
+#define PARSE_PROBLEM_GPT           (PARSE_PROBLEM_GPT_PRIMARY | PARSE_PROBLEM_GPT_BACKUP | PARSE_PROBLEM_GPT_MISMATCH)
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Partition table found on a device.
+ */
+typedef enum {
+    PARSE_LABEL_NONE,       /**< Neither a GPT nor an MBR signature. */
+    PARSE_LABEL_MBR,        /**< MBR, with EBR chains for the logical partitions. */
+    PARSE_LABEL_GPT         /**< GPT (protective MBR type 0xEE in the first entry). */
+} PARSE_Label;
+
+/**
+ * Where a partition was found.
+ */
+typedef enum {
+    PARSE_ORIGIN_PRIMARY,   /**< MBR primary partition. */
+    PARSE_ORIGIN_EXTENDED,  /**< MBR extended partition (container of the logical partitions). */
+    PARSE_ORIGIN_LOGICAL,   /**< Logical partition from an EBR. */
+    PARSE_ORIGIN_GPT        /**< GPT partition entry. */
+} PARSE_Origin;
+
+/**
+ * Describes one partition, independent of the partition table type.
+ *
+ * Fields:
+ *
+ * @param index: Partition number as printed (1-4 primary, 5+ logical, GPT entry number).
+ * @param origin: Where the partition was found.
+ * @param flags: `PARSE_FLAG_*` values.
+ * @param mbr_type: MBR partition type code (0 for GPT partitions).
+ * @param start: First LBA.
+ * @param end: Last LBA as stored in the table (`start + count - 1` for MBR partitions).
+ * @param count: Number of logical sectors (0 for a reversed GPT entry).
+ * @param table_lba: LBA of the sector holding the entry (0 for the MBR, the EBR of a
+ *                   logical partition, the entry array sector for GPT).
+ * @param attributes: GPT attribute bits (0 for MBR partitions).
+ * @param type_guid: GPT partition type GUID, as stored on disk (zero for MBR partitions).
+ * @param partition_guid: GPT unique partition GUID, as stored on disk.
+ * @param name: GPT partition name, raw UTF-16LE as stored on disk.
+ */
+typedef struct {
+    int index;                                  /**< Partition number. */
+    PARSE_Origin origin;                        /**< Primary, extended, logical or GPT. */
+    uint32_t flags;                             /**< PARSE_FLAG_* bits. */
+    uint8_t mbr_type;                           /**< MBR type code. */
+    uint64_t start;                             /**< First LBA. */
+    uint64_t end;                               /**< Last LBA. */
+    uint64_t count;                             /**< Number of sectors. */
+    uint64_t table_lba;                         /**< Sector holding the entry. */
+    uint64_t attributes;                        /**< GPT attributes. */
+    uint8_t type_guid[PARSE_GUID_SIZE];         /**< GPT type GUID. */
+    uint8_t partition_guid[PARSE_GUID_SIZE];    /**< GPT partition GUID. */
+    uint16_t name[PARSE_NAME_LENGTH];           /**< GPT name (UTF-16LE). */
+} PARSE_Partition;
+
+/**
+ * Describes the partition table of a device and the descriptors filled from it.
+ *
+ * Fields:
+ *
+ * @param label: Partition table type.
+ * @param sector_size: Logical sector size of the device in bytes.
+ * @param first_usable: First LBA partitions may use (GPT FirstUsableLBA, 1 for MBR).
+ * @param last_usable: Last LBA partitions may use (GPT LastUsableLBA, or the last LBA
+ *                     addressable by the MBR); 0 if no table was found.
+ * @param disk_guid: GPT disk GUID (zero for MBR).
+ * @param gpt_lba: LBA of the GPT header the partitions were taken from (1 for the
+ *                 primary, the backup LBA otherwise; 0 for MBR).
+ * @param partitions: The caller's descriptor array.
+ * @param capacity: Number of descriptors the array holds.
+ * @param count: Number of descriptors filled in (at most `capacity`).
+ * @param total: Number of partitions in the table; larger than `count` when the array
+ *               was too small.
+ * @param problems: `PARSE_PROBLEM_*` values.
+ * @param ebr_index: Index of the extended partition whose EBR chain stopped early.
+ * @param ebr_lba: LBA the chain stopped at (the bad link, the repeated or the unreadable EBR).
+ */
+typedef struct {
+    PARSE_Label label;                      /**< MBR, GPT or none. */
+    uint32_t sector_size;                   /**< Logical sector size. */
+    uint64_t first_usable;                  /**< First usable LBA. */
+    uint64_t last_usable;                   /**< Last usable LBA. */
+    uint8_t disk_guid[PARSE_GUID_SIZE];     /**< GPT disk GUID. */
+    uint64_t gpt_lba;                       /**< GPT header used. */
+    PARSE_Partition *partitions;            /**< Descriptors. */
+    size_t capacity;                        /**< Size of the descriptor array. */
+    size_t count;                           /**< Descriptors filled in. */
+    size_t total;                           /**< Partitions found. */
+    uint32_t problems;                      /**< PARSE_PROBLEM_* bits. */
+    int ebr_index;                          /**< Extended partition of the broken chain. */
+    uint64_t ebr_lba;                       /**< LBA the EBR chain stopped at. */
+} PARSE_Table;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+int PARSE_read_table(CACHE_Cache *cache, PARSE_Partition *partitions, size_t capacity, PARSE_Table *table);
+
+#endif
@@ -0,0 +1,1177 @@
+/**
+ *===================================================================================
+ * @file           : Partition_Script.c
+ * @author         : Ali Mamdouh
+ * @brief          : create a whole GPT or MBR partition table from an sfdisk-like script
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Partition_Script.h"  // Includes the script layout structures and API
+#include <stdlib.h>            // Provides strtoull, calloc and free
+#include <string.h>            // Provides strchr, strcmp and memcpy
+#include <strings.h>           // Provides strcasecmp
+#include <ctype.h>             // Provides isspace
+#include <errno.h>             // Provides errno
+#include <sys/random.h>        // Provides getrandom, used for new GUIDs and disk signatures
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Maximum length of a script line.
+ */
+#define SCRIPT_LINE_LENGTH          4096  // Maximum length of a script line
+
+/**
+ * Number of UTF-16 code units in a GPT partition name.
+ */
+#define SCRIPT_NAME_UNITS           36  // UTF-16 units in GPT_PartitionEntry.partition_name
+
+/**
+ * GPT attribute bit set for bootable partitions (legacy BIOS bootable).
+ */
+#define SCRIPT_ATTR_LEGACY_BOOTABLE 2  // Bit number of the legacy BIOS bootable attribute
+
+/**
+ * GPT header revision written to new tables (1.0).
+ */
+#define SCRIPT_GPT_REVISION         0x00010000  // GPT revision 1.0
+
+/**
+ * Boot indicator of a bootable MBR partition.
+ */
+#define SCRIPT_MBR_BOOTABLE         0x80  // MBR boot indicator
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Associates a one-letter sfdisk type shortcut with a GPT type GUID and an MBR id.
+ *
+ * Fields:
+ *
+ * @param alias: The shortcut (e.g., "L").
+ * @param guid: GPT type GUID string.
+ * @param mbr_id: MBR type id (0 if the shortcut has no MBR equivalent).
+ */
+typedef struct {
+    const char *alias;   /**< sfdisk shortcut. */
+    const char *guid;    /**< GPT type GUID. */
+    uint8_t mbr_id;      /**< MBR type id. */
+} SCRIPT_TypeAlias;
+
+/**
+ * Resolved position of one partition, in logical sectors.
+ */
+typedef struct {
+    uint64_t start;   /**< First LBA. */
+    uint64_t end;     /**< Last LBA (inclusive). */
+} SCRIPT_Extent;
+
+
+
+
+
+/*============================================================================
+ **********************  Global Variables Decleration  ***********************
+ ============================================================================*/
+/**
+ * sfdisk type shortcuts.
+ *
+ * - L: Linux filesystem
+ * - S: Linux swap
+ * - U: EFI System
+ * - H: Linux /home
+ * - V: Linux LVM
+ * - R: Linux RAID
+ * - E: extended (MBR only)
+ * - X: Linux extended (MBR only)
+ */
+static const SCRIPT_TypeAlias type_aliases[] =
+{
+    { "L", "0FC63DAF-8483-4772-8E79-3D69D8477DE4", 0x83 },
+    { "S", "0657FD6D-A4AB-43C4-84E5-0933C84B4F4F", 0x82 },
+    { "U", "C12A7328-F81F-11D2-BA4B-00A0C93EC93B", 0xEF },
+    { "H", "933AC7E1-2EB4-4F13-B844-0E14E2AEF915", 0x83 },
+    { "V", "E6D6D379-F507-44C2-A23C-238F2A3DF928", 0x8E },
+    { "R", "A19D880F-05FC-4D3B-A006-743F0F84911E", 0xFD },
+    { "E", NULL,                                   CHS_EXTENDED_PARTITION },
+    { "X", NULL,                                   LINUX_EXTENDED_PARTITION },
+    { NULL, NULL, 0 }
+};
+
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Removes leading and trailing white space from a string in place.
+ */
+static char *trim(char *text)
+{
+    while (isspace((unsigned char)*text))
+    {
+        text++;
+    }
+
+    char *end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1]))
+    {
+        *--end = '\0';
+    }
+    return text;
+}
+
+
+
+/**
+ * Rounds a value up to a multiple of `grain`.
+ */
+static uint64_t round_up(uint64_t value, uint64_t grain)
+{
+    return ((value + grain - 1) / grain) * grain;
+}
+
+
+
+/**
+ * Fills a buffer with random bytes from the kernel.
+ */
+static int random_bytes(void *buf, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t count = getrandom((char *)buf + done, length - done, 0);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        done += (size_t)count;
+    }
+    return 0;
+}
+
+
+
+/**
+ * Generates a random (version 4) GUID in its on-disk byte order.
+ */
+static int random_guid(uint8_t *guid)
+{
+    if (random_bytes(guid, GUID_SIZE) != 0)
+    {
+        return -1;
+    }
+    guid[7] = (uint8_t)((guid[7] & 0x0F) | 0x40);  // Version 4
+    guid[8] = (uint8_t)((guid[8] & 0x3F) | 0x80);  // RFC 4122 variant
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Splits the next field off a script line.
+ *
+ * Fields are separated by white space and/or a single comma, so that both
+ * `start=2048, size=4096` and the positional form `2048,,L` work; two commas in a row
+ * produce an empty field. Double quotes group text containing separators and are removed.
+ *
+ * @param cursor: Current position in the line; advanced past the field.
+ *
+ * @return The field (NUL-terminated, inside the line), or NULL at the end of the line.
+ */
+static char *next_field(char **cursor)
+{
+    char *p = *cursor;
+    while (*p == ' ' || *p == '\t')
+    {
+        p++;
+    }
+    if (*p == '\0')
+    {
+        return NULL;
+    }
+
+    char *field = p;
+    char *w = p;
+    int quoted = 0;
+    for (; *p != '\0'; p++)
+    {
+        if (*p == '"')
+        {
+            quoted = !quoted;
+            continue;
+        }
+        if (!quoted && (*p == ' ' || *p == '\t' || *p == ','))
+        {
+            break;
+        }
+        *w++ = *p;
+    }
+
+    // Skip the separator: white space and at most one comma
+    while (*p == ' ' || *p == '\t')
+    {
+        p++;
+    }
+    if (*p == ',')
+    {
+        p++;
+    }
+
+    *w = '\0';
+    *cursor = p;
+    return field;
+}
+
+
+
+
+
+
+/**
+ * Parses a sector count or, with a K/M/G/T suffix (optionally followed by "iB"), a byte count.
+ *
+ * @param text: The number.
+ * @param value: Receives the value.
+ * @param in_bytes: Set to 1 if a suffix was given (value in bytes), 0 otherwise (sectors).
+ *
+ * @return 0 on success, or -1 if the text is not a number.
+ */
+static int parse_number(const char *text, uint64_t *value, int *in_bytes)
+{
+    char *end;
+    errno = 0;
+    unsigned long long number = strtoull(text, &end, 0);
+    if (errno != 0 || end == text || text[0] == '-')
+    {
+        return -1;
+    }
+
+    int shift = 0;
+    switch (toupper((unsigned char)*end))
+    {
+        case '\0': break;
+        case 'K':  shift = 10; break;
+        case 'M':  shift = 20; break;
+        case 'G':  shift = 30; break;
+        case 'T':  shift = 40; break;
+        default:   return -1;
+    }
+    if (shift != 0 && end[1] != '\0' && strcasecmp(end + 1, "iB") != 0 && strcasecmp(end + 1, "B") != 0)
+    {
+        return -1;
+    }
+    if (shift != 0 && number > (UINT64_MAX >> shift))
+    {
+        return -1;
+    }
+
+    *value = (uint64_t)number << shift;
+    *in_bytes = (shift != 0);
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Parses a partition type: a GUID or shortcut for GPT, a hex id or shortcut for MBR.
+ *
+ * @param text: The type text.
+ * @param label: The partition table type the type is for.
+ * @param partition: Receives the type.
+ *
+ * @return 0 on success, or -1 if the type is not valid for the label.
+ */
+static int parse_type(const char *text, SCRIPT_LabelType label, SCRIPT_Partition *partition)
+{
+    for (int i = 0; type_aliases[i].alias != NULL; i++)
+    {
+        if (strcasecmp(text, type_aliases[i].alias) == 0)
+        {
+            if (label == SCRIPT_LABEL_GPT)
+            {
+                return (type_aliases[i].guid != NULL && convert_string_to_guid(type_aliases[i].guid, partition->type_guid)) ? 0 : -1;
+            }
+            partition->mbr_id = type_aliases[i].mbr_id;
+            return 0;
+        }
+    }
+
+    if (label == SCRIPT_LABEL_GPT)
+    {
+        return convert_string_to_guid(text, partition->type_guid) ? 0 : -1;
+    }
+
+    char *end;
+    unsigned long id = strtoul(text, &end, 16);
+    if (end == text || *end != '\0' || id == 0 || id > 0xFF)
+    {
+        return -1;
+    }
+    partition->mbr_id = (uint8_t)id;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Parses GPT attributes: `RequiredPartition`, `NoBlockIOProtocol`, `LegacyBIOSBootable`
+ * and `GUID:<bit>` (bits 48-63), separated by spaces.
+ *
+ * @param text: The attribute list.
+ * @param attributes: Receives the attribute bits.
+ *
+ * @return 0 on success, or -1 on an unknown attribute.
+ */
+static int parse_attributes(char *text, uint64_t *attributes)
+{
+    *attributes = 0;
+    for (char *word = strtok(text, " \t"); word != NULL; word = strtok(NULL, " \t"))
+    {
+        if (strcmp(word, "RequiredPartition") == 0)
+        {
+            *attributes |= 1ULL << 0;
+        }
+        else if (strcmp(word, "NoBlockIOProtocol") == 0)
+        {
+            *attributes |= 1ULL << 1;
+        }
+        else if (strcmp(word, "LegacyBIOSBootable") == 0)
+        {
+            *attributes |= 1ULL << SCRIPT_ATTR_LEGACY_BOOTABLE;
+        }
+        else if (strncmp(word, "GUID:", 5) == 0)
+        {
+            // Type-specific bits, possibly a comma-separated list of bit numbers
+            for (char *bit = word + 5; *bit != '\0'; )
+            {
+                char *end;
+                unsigned long number = strtoul(bit, &end, 10);
+                if (end == bit || number < 48 || number > 63)
+                {
+                    return -1;
+                }
+                *attributes |= 1ULL << number;
+                bit = (*end == ',') ? end + 1 : end;
+                if (*end != ',' && *end != '\0')
+                {
+                    return -1;
+                }
+            }
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Encodes a UTF-8 partition name as the UTF-16LE GPT partition name.
+ *
+ * @param utf8: The name.
+ * @param name: Receives the UTF-16 code units (zero padded), may be NULL to only validate.
+ *
+ * @return 0 on success, or -1 if the name is not valid UTF-8 or longer than 36 UTF-16 units.
+ */
+static int encode_name(const char *utf8, uint16_t *name)
+{
+    uint16_t units[SCRIPT_NAME_UNITS] = { 0 };
+    size_t count = 0;
+    const unsigned char *p = (const unsigned char *)utf8;
+
+    while (*p != '\0')
+    {
+        uint32_t code;
+        int extra;
+        if (*p < 0x80)                { code = *p;        extra = 0; }
+        else if ((*p & 0xE0) == 0xC0) { code = *p & 0x1F; extra = 1; }
+        else if ((*p & 0xF0) == 0xE0) { code = *p & 0x0F; extra = 2; }
+        else if ((*p & 0xF8) == 0xF0) { code = *p & 0x07; extra = 3; }
+        else                          { return -1; }
+        p++;
+
+        for (int i = 0; i < extra; i++, p++)
+        {
+            if ((*p & 0xC0) != 0x80)
+            {
+                return -1;
+            }
+            code = (code << 6) | (*p & 0x3F);
+        }
+
+        if (code >= 0x10000)
+        {
+            // Surrogate pair
+            if (count + 2 > SCRIPT_NAME_UNITS)
+            {
+                return -1;
+            }
+            code -= 0x10000;
+            units[count++] = (uint16_t)(0xD800 | (code >> 10));
+            units[count++] = (uint16_t)(0xDC00 | (code & 0x3FF));
+        }
+        else
+        {
+            if (count + 1 > SCRIPT_NAME_UNITS)
+            {
+                return -1;
+            }
+            units[count++] = (uint16_t)code;
+        }
+    }
+
+    if (name != NULL)
+    {
+        memcpy(name, units, sizeof(units));
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Parses a header line (`key: value`).
+ *
+ * Supported keys: `label` (gpt or dos), `label-id`, `first-lba`, `last-lba`,
+ * `table-length`, `unit` (sectors only); `device`, `sector-size` and `grain` are
+ * accepted and ignored so the output of `sfdisk -d` can be replayed.
+ *
+ * @return 0 on success, or -1 on error (a message is printed).
+ */
+static int parse_header_line(char *key, char *value, SCRIPT_Layout *layout, int line_number)
+{
+    int in_bytes = 0;
+
+    key = trim(key);
+    value = trim(value);
+
+    if (strcmp(key, "label") == 0)
+    {
+        if (layout->count != 0)
+        {
+            fprintf(stderr, "Script line %d: label must come before the partitions\n", line_number);
+            return -1;
+        }
+        if (strcmp(value, "gpt") == 0)      layout->label = SCRIPT_LABEL_GPT;
+        else if (strcmp(value, "dos") == 0) layout->label = SCRIPT_LABEL_DOS;
+        else
+        {
+            fprintf(stderr, "Script line %d: unsupported label '%s' (gpt or dos)\n", line_number, value);
+            return -1;
+        }
+    }
+    else if (strcmp(key, "label-id") == 0)
+    {
+        char *end;
+        unsigned long long signature = strtoull(value, &end, 16);
+        if (convert_string_to_guid(value, layout->disk_guid))
+        {
+            layout->has_label_id = 1;
+        }
+        else if (end != value && *end == '\0' && signature <= 0xFFFFFFFFULL)
+        {
+            layout->disk_signature = (uint32_t)signature;
+            layout->has_label_id = 1;
+        }
+        else
+        {
+            fprintf(stderr, "Script line %d: invalid label-id '%s'\n", line_number, value);
+            return -1;
+        }
+    }
+    else if (strcmp(key, "first-lba") == 0 || strcmp(key, "last-lba") == 0)
+    {
+        uint64_t lba;
+        if (parse_number(value, &lba, &in_bytes) != 0 || in_bytes)
+        {
+            fprintf(stderr, "Script line %d: invalid %s '%s'\n", line_number, key, value);
+            return -1;
+        }
+        *(key[0] == 'f' ? &layout->first_lba : &layout->last_lba) = lba;
+    }
+    else if (strcmp(key, "table-length") == 0)
+    {
+        uint64_t length;
+        if (parse_number(value, &length, &in_bytes) != 0 || in_bytes ||
+            length < SCRIPT_MAX_PARTITIONS || length * GPT_ENTRY_SIZE > GPT_MAX_ENTRY_ARRAY_SIZE)
+        {
+            fprintf(stderr, "Script line %d: invalid table-length '%s'\n", line_number, value);
+            return -1;
+        }
+        layout->table_length = (uint32_t)length;
+    }
+    else if (strcmp(key, "unit") == 0)
+    {
+        if (strcmp(value, "sectors") != 0)
+        {
+            fprintf(stderr, "Script line %d: unsupported unit '%s'\n", line_number, value);
+            return -1;
+        }
+    }
+    else if (strcmp(key, "device") != 0 && strcmp(key, "sector-size") != 0 && strcmp(key, "grain") != 0)
+    {
+        fprintf(stderr, "Script line %d: unknown header '%s'\n", line_number, key);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Parses a partition line.
+ *
+ * Named fields (`start=`, `size=`, `type=`, `name=`, `uuid=`, `attrs=`, `bootable`) and the
+ * positional form (`start, size, type, bootable`, where `*` marks a bootable partition)
+ * are accepted. A leading `<device> :` (as printed by `sfdisk -d`) is ignored.
+ *
+ * @return 0 on success, or -1 on error (a message is printed).
+ */
+static int parse_partition_line(char *line, SCRIPT_Layout *layout, int line_number)
+{
+    if (layout->count == SCRIPT_MAX_PARTITIONS)
+    {
+        fprintf(stderr, "Script line %d: too many partitions (maximum %d)\n", line_number, SCRIPT_MAX_PARTITIONS);
+        return -1;
+    }
+
+    SCRIPT_Partition *partition = &layout->partitions[layout->count];
+    memset(partition, 0, sizeof(*partition));
+    if (layout->label == SCRIPT_LABEL_GPT)
+    {
+        convert_string_to_guid(type_aliases[0].guid, partition->type_guid);  // Linux filesystem
+    }
+    else
+    {
+        partition->mbr_id = type_aliases[0].mbr_id;
+    }
+
+    // Skip the "<device> :" prefix of sfdisk dumps
+    char *colon = strstr(line, " :");
+    char *equal = strchr(line, '=');
+    if (colon != NULL && (equal == NULL || colon < equal))
+    {
+        line = colon + 2;
+    }
+
+    char *cursor = line;
+    char *field;
+    int position = 0;
+    while ((field = next_field(&cursor)) != NULL)
+    {
+        char *value = strchr(field, '=');
+        char empty[1] = "";
+        int error = 0;
+        const char *key;
+
+        if (value != NULL)
+        {
+            *value++ = '\0';
+            key = field;
+            // "start=   2048": the value is the next field
+            if (*value == '\0' && (value = next_field(&cursor)) == NULL)
+            {
+                value = empty;
+            }
+        }
+        else
+        {
+            static const char *const positional[] = { "start", "size", "type", "bootable" };
+            if (strcmp(field, "bootable") == 0)
+            {
+                key = "bootable";
+            }
+            else if (position < 4)
+            {
+                key = positional[position++];
+            }
+            else
+            {
+                fprintf(stderr, "Script line %d: unexpected field '%s'\n", line_number, field);
+                return -1;
+            }
+            value = field;
+        }
+
+        if (strcmp(key, "start") == 0)
+        {
+            error = (*value != '\0' && parse_number(value, &partition->start, &partition->start_in_bytes) != 0);
+        }
+        else if (strcmp(key, "size") == 0)
+        {
+            // An empty size or "+" takes the rest of the disk
+            if (*value != '\0' && strcmp(value, "+") != 0)
+            {
+                error = (parse_number(value, &partition->size, &partition->size_in_bytes) != 0 || partition->size == 0);
+            }
+        }
+        else if (strcmp(key, "type") == 0 || strcmp(key, "Id") == 0)
+        {
+            error = (*value != '\0' && parse_type(value, layout->label, partition) != 0);
+        }
+        else if (strcmp(key, "bootable") == 0)
+        {
+            partition->bootable = (strcmp(value, "-") != 0 && *value != '\0');
+        }
+        else if (strcmp(key, "name") == 0)
+        {
+            error = (strlen(value) >= SCRIPT_NAME_LENGTH || encode_name(value, NULL) != 0);
+            if (!error)
+            {
+                strcpy(partition->name, value);
+            }
+        }
+        else if (strcmp(key, "uuid") == 0)
+        {
+            error = !convert_string_to_guid(value, partition->uuid);
+            partition->has_uuid = 1;
+        }
+        else if (strcmp(key, "attrs") == 0)
+        {
+            error = (parse_attributes(value, &partition->attributes) != 0);
+        }
+        else
+        {
+            fprintf(stderr, "Script line %d: unknown field '%s'\n", line_number, key);
+            return -1;
+        }
+
+        if (error)
+        {
+            fprintf(stderr, "Script line %d: invalid %s '%s'\n", line_number, key, value);
+            return -1;
+        }
+    }
+
+    layout->count++;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Reads a partition layout script.
+ *
+ * The script follows the `sfdisk` input format: header lines (`label: gpt`,
+ * `label-id: ...`, `first-lba: ...`, `table-length: ...`) followed by one line per partition,
+ * e.g. `start=2048, size=1G, type=U, name="EFI system"`. Omitted starts are placed on the
+ * next 1 MiB boundary after the previous partition, and an omitted size takes the rest of
+ * the disk. Sizes and starts are in sectors, or in bytes with a K/M/G/T suffix. Empty lines
+ * and lines starting with '#' are ignored.
+ *
+ * Only the syntax is checked here; the geometry is validated by `SCRIPT_apply` against
+ * each target device.
+ *
+ * @param in: The script stream.
+ * @param layout: Receives the layout.
+ *
+ * @return 0 on success, or -1 on a syntax error (a message with the line number is printed).
+ */
+int SCRIPT_parse(FILE *in, SCRIPT_Layout *layout)
+{
+    char buffer[SCRIPT_LINE_LENGTH];
+    int line_number = 0;
+
+    memset(layout, 0, sizeof(*layout));
+    layout->label = SCRIPT_LABEL_DOS;  // sfdisk default
+    layout->table_length = SCRIPT_MAX_PARTITIONS;
+
+    while (fgets(buffer, sizeof(buffer), in) != NULL)
+    {
+        line_number++;
+        char *line = trim(buffer);
+        if (*line == '\0' || *line == '#')
+        {
+            continue;
+        }
+
+        char *colon = strchr(line, ':');
+        int status;
+        if (colon != NULL && strchr(line, '=') == NULL && strchr(line, ',') == NULL)
+        {
+            *colon = '\0';
+            status = parse_header_line(line, colon + 1, layout, line_number);
+        }
+        else
+        {
+            status = parse_partition_line(line, layout, line_number);
+        }
+
+        if (status != 0)
+        {
+            return -1;
+        }
+    }
+
+    if (ferror(in))
+    {
+        perror("Failed to read script");
+        return -1;
+    }
+    if (layout->count == 0)
+    {
+        fprintf(stderr, "Script: no partitions\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Converts an LBA to the CHS address stored in MBR entries (255 heads, 63 sectors per track).
+ *
+ * Addresses beyond the CHS limit are stored as the conventional 0xFE 0xFF 0xFF.
+ */
+static void lba_to_chs(uint64_t lba, uint8_t chs[3])
+{
+    if (lba >= 1024ULL * 255 * 63)
+    {
+        chs[0] = 0xFE;
+        chs[1] = 0xFF;
+        chs[2] = 0xFF;
+        return;
+    }
+
+    uint64_t cylinder = lba / (255 * 63);
+    chs[0] = (uint8_t)((lba / 63) % 255);                                    // Head
+    chs[1] = (uint8_t)(((lba % 63) + 1) | ((cylinder >> 2) & 0xC0));         // Sector, cylinder bits 8-9
+    chs[2] = (uint8_t)(cylinder & 0xFF);                                     // Cylinder bits 0-7
+}
+
+
+
+/**
+ * Fills an MBR partition entry.
+ */
+static void fill_mbr_entry(MBR_PartitionEntry *entry, uint8_t status, uint8_t type, uint64_t start, uint64_t count)
+{
+    entry->status = status;
+    entry->partition_type = type;
+    entry->lba = (uint32_t)start;
+    entry->sector_count = (uint32_t)count;
+    lba_to_chs(start, entry->first_chs);
+    lba_to_chs(start + count - 1, entry->last_chs);
+}
+
+
+
+
+
+
+/**
+ * Computes the position of every partition and validates the layout against a device.
+ *
+ * @param out: Stream errors are printed to.
+ * @param layout: The layout.
+ * @param sector_size: Logical sector size of the device.
+ * @param first_usable: First LBA partitions may use.
+ * @param last_usable: Last LBA partitions may use.
+ * @param extents: Receives the position of every partition.
+ *
+ * @return 0 if the layout fits, or -1 otherwise.
+ */
+static int resolve_layout(FILE *out, const SCRIPT_Layout *layout, uint32_t sector_size,
+                          uint64_t first_usable, uint64_t last_usable, SCRIPT_Extent *extents)
+{
+    uint64_t grain = SCRIPT_DEFAULT_GRAIN / sector_size;
+    uint64_t next = round_up(first_usable, grain);
+
+    for (size_t i = 0; i < layout->count; i++)
+    {
+        const SCRIPT_Partition *partition = &layout->partitions[i];
+
+        uint64_t start = next;
+        if (partition->start != 0)
+        {
+            start = partition->start_in_bytes ? round_up(partition->start, sector_size) / sector_size : partition->start;
+        }
+
+        uint64_t size;
+        if (partition->size != 0)
+        {
+            size = partition->size_in_bytes ? partition->size / sector_size : partition->size;
+        }
+        else
+        {
+            size = (start <= last_usable) ? last_usable - start + 1 : 0;
+        }
+
+        if (size == 0 || start < first_usable || start > last_usable || size - 1 > last_usable - start)
+        {
+            fprintf(out, "Partition %zu: %" PRIu64 "+%" PRIu64 " does not fit the usable area %" PRIu64 "-%" PRIu64 "\n",
+                    i + 1, start, size, first_usable, last_usable);
+            return -1;
+        }
+
+        extents[i].start = start;
+        extents[i].end = start + size - 1;
+        next = round_up(extents[i].end + 1, grain);
+    }
+
+    // Partitions must not overlap
+    for (size_t i = 0; i < layout->count; i++)
+    {
+        for (size_t j = i + 1; j < layout->count; j++)
+        {
+            if (extents[i].start <= extents[j].end && extents[j].start <= extents[i].end)
+            {
+                fprintf(out, "Partitions %zu and %zu overlap\n", i + 1, j + 1);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Builds and writes a GPT: protective MBR, primary header and entry array in one write,
+ * backup entry array and header in a second write.
+ *
+ * @return 0 on success, or -1 on error.
+ */
+static int write_gpt(FILE *out, BLK_Device *dev, const SCRIPT_Layout *layout, const SCRIPT_Extent *extents,
+                     uint64_t first_usable, uint64_t last_usable)
+{
+    uint32_t sector_size = dev->logical_sector_size;
+    uint64_t last_lba = dev->size_bytes / sector_size - 1;
+    size_t array_size = (size_t)layout->table_length * GPT_ENTRY_SIZE;
+    uint64_t array_sectors = (array_size + sector_size - 1) / sector_size;
+
+    // Primary region: LBA 0 (protective MBR), LBA 1 (header), LBA 2.. (entries)
+    size_t primary_size = (size_t)(2 + array_sectors) * sector_size;
+    // Backup region: entries, then the header on the last LBA
+    size_t backup_size = (size_t)(array_sectors + 1) * sector_size;
+
+    char *primary = BLK_alloc_buffer(dev, primary_size);
+    char *backup = BLK_alloc_buffer(dev, backup_size);
+    if (primary == NULL || backup == NULL)
+    {
+        free(primary);
+        free(backup);
+        return -1;
+    }
+    memset(primary, 0, primary_size);
+    memset(backup, 0, backup_size);
+
+    // Protective MBR: keep the boot code and disk signature, replace the table
+    int status = BLK_read(dev, 0, primary, sector_size);
+    // The table at offset 446 is not 4-byte aligned: fill the entries aside, then copy them
+    MBR_PartitionEntry pmbr[MBR_PARTITIONS_NUM];
+    memset(pmbr, 0, sizeof(pmbr));
+    uint64_t pmbr_count = (last_lba > 0xFFFFFFFFULL) ? 0xFFFFFFFFULL : last_lba;
+    fill_mbr_entry(&pmbr[0], 0, GPT_SIGNATURE, GPT_HEADER_LBA, pmbr_count);
+    memset(primary + 446, 0, SECTOR_SIZE - 446);
+    memcpy(primary + 446, pmbr, sizeof(pmbr));
+    *(uint16_t *)(primary + 510) = MBR_SIGNATURE;
+
+    // Entry array
+    char *entries = primary + 2 * (size_t)sector_size;
+    for (size_t i = 0; i < layout->count && status == 0; i++)
+    {
+        const SCRIPT_Partition *partition = &layout->partitions[i];
+        GPT_PartitionEntry *entry = (GPT_PartitionEntry *)(entries + i * GPT_ENTRY_SIZE);
+
+        memcpy(entry->type_guid, partition->type_guid, GUID_SIZE);
+        if (partition->has_uuid)
+        {
+            memcpy(entry->partition_guid, partition->uuid, GUID_SIZE);
+        }
+        else
+        {
+            status = random_guid(entry->partition_guid);
+        }
+        entry->starting_lba = extents[i].start;
+        entry->ending_lba = extents[i].end;
+        entry->attributes = partition->attributes | (partition->bootable ? 1ULL << SCRIPT_ATTR_LEGACY_BOOTABLE : 0);
+        encode_name(partition->name, entry->partition_name);
+    }
+    memcpy(backup, entries, (size_t)array_sectors * sector_size);
+
+    // Primary header
+    GPT_Header header;
+    memset(&header, 0, sizeof(header));
+    header.signature = GPT_HEADER_SIGNATURE;
+    header.revision = SCRIPT_GPT_REVISION;
+    header.header_size = GPT_HEADER_MIN_SIZE;
+    header.my_lba = GPT_HEADER_LBA;
+    header.alternate_lba = last_lba;
+    header.first_usable_lba = first_usable;
+    header.last_usable_lba = last_usable;
+    header.partition_entry_lba = GPT_HEADER_LBA + 1;
+    header.num_partition_entries = layout->table_length;
+    header.size_of_partition_entry = GPT_ENTRY_SIZE;
+    header.partition_entry_array_crc32 = CRC32_compute(entries, array_size);
+    if (layout->has_label_id)
+    {
+        memcpy(header.disk_guid, layout->disk_guid, GUID_SIZE);
+    }
+    else if (status == 0)
+    {
+        status = random_guid(header.disk_guid);
+    }
+    header.header_crc32 = CRC32_compute(&header, header.header_size);
+    memcpy(primary + sector_size, &header, sizeof(header));
+
+    // Backup header: same table, mirrored locations
+    header.my_lba = last_lba;
+    header.alternate_lba = GPT_HEADER_LBA;
+    header.partition_entry_lba = last_lba - array_sectors;
+    header.header_crc32 = 0;
+    header.header_crc32 = CRC32_compute(&header, header.header_size);
+    memcpy(backup + array_sectors * sector_size, &header, sizeof(header));
+
+    // Write the backup first, then the primary that commits the new table
+    if (status == 0)
+    {
+        status = BLK_write_span(dev, (last_lba - array_sectors) * sector_size, backup, backup_size);
+    }
+    if (status == 0)
+    {
+        status = BLK_write_span(dev, 0, primary, primary_size);
+    }
+    if (status != 0)
+    {
+        fprintf(out, "Failed to write the GPT: %s\n", strerror(errno));
+    }
+
+    free(primary);
+    free(backup);
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Builds and writes an MBR partition table in one write.
+ *
+ * The boot code is kept. A stale GPT header at LBA 1 is wiped in the same write, and a
+ * stale backup GPT header on the last LBA with a second write, so that the disk is not
+ * detected as GPT afterwards.
+ *
+ * @return 0 on success, or -1 on error.
+ */
+static int write_dos(FILE *out, BLK_Device *dev, const SCRIPT_Layout *layout, const SCRIPT_Extent *extents)
+{
+    static const char gpt_signature[8] = { 'E', 'F', 'I', ' ', 'P', 'A', 'R', 'T' };
+    uint32_t sector_size = dev->logical_sector_size;
+    uint64_t last_lba = dev->size_bytes / sector_size - 1;
+    size_t region_size = 2 * (size_t)sector_size;
+
+    char *region = BLK_alloc_buffer(dev, region_size);
+    if (region == NULL)
+    {
+        return -1;
+    }
+
+    int status = BLK_read(dev, 0, region, region_size);
+    if (status == 0)
+    {
+        char *mbr = region;
+        uint32_t signature = layout->disk_signature;
+        if (!layout->has_label_id)
+        {
+            status = random_bytes(&signature, sizeof(signature));
+        }
+        memcpy(mbr + 440, &signature, sizeof(signature));
+        memset(mbr + 446, 0, SECTOR_SIZE - 446);
+
+        // Filled aside and copied, since the table at offset 446 is not 4-byte aligned
+        MBR_PartitionEntry table[MBR_PARTITIONS_NUM];
+        memset(table, 0, sizeof(table));
+        for (size_t i = 0; i < layout->count; i++)
+        {
+            const SCRIPT_Partition *partition = &layout->partitions[i];
+            fill_mbr_entry(&table[i], partition->bootable ? SCRIPT_MBR_BOOTABLE : 0, partition->mbr_id,
+                           extents[i].start, extents[i].end - extents[i].start + 1);
+        }
+        memcpy(mbr + 446, table, sizeof(table));
+        *(uint16_t *)(mbr + 510) = MBR_SIGNATURE;
+
+        // Wipe a primary GPT header left over from a previous label
+        int wipe_primary = (memcmp(region + sector_size, gpt_signature, sizeof(gpt_signature)) == 0);
+        if (wipe_primary)
+        {
+            memset(region + sector_size, 0, sector_size);
+        }
+
+        if (status == 0)
+        {
+            status = BLK_write_span(dev, 0, region, wipe_primary ? region_size : sector_size);
+        }
+    }
+
+    // Wipe a backup GPT header left over from a previous label
+    if (status == 0 && BLK_read(dev, last_lba * sector_size, region, sector_size) == 0 &&
+        memcmp(region, gpt_signature, sizeof(gpt_signature)) == 0)
+    {
+        memset(region, 0, sector_size);
+        status = BLK_write_span(dev, last_lba * sector_size, region, sector_size);
+    }
+
+    if (status != 0)
+    {
+        fprintf(out, "Failed to write the MBR: %s\n", strerror(errno));
+    }
+
+    free(region);
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Writes a whole partition table described by a script to a device.
+ *
+ * This function performs the following tasks:
+ * 1. Computes the usable area of the device for the label (for GPT: after the primary
+ *    entry array and before the backup entry array, or the `first-lba`/`last-lba` given).
+ * 2. Places every partition (default start on the next 1 MiB boundary, default size up
+ *    to the end of the usable area) and checks that all partitions fit and do not overlap.
+ * 3. Builds the whole table in memory, including the CRC32s of a GPT.
+ * 4. Writes it with as few aligned writes as possible: for GPT one write for the
+ *    protective MBR, primary header and entries, and one for the backup entries and
+ *    header; for MBR one write for the first sector.
+ * 5. Flushes the device with a single `fsync` and asks the kernel to re-read the
+ *    partition table (`BLKRRPART`).
+ *
+ * Nothing is written if the layout does not fit the device.
+ *
+ * @param out: Stream messages are printed to.
+ * @param dev: The device, opened with `BLK_FLAG_WRITE`.
+ * @param layout: The layout read by `SCRIPT_parse`.
+ *
+ * @return 0 on success, or -1 on error.
+ */
+int SCRIPT_apply(FILE *out, BLK_Device *dev, const SCRIPT_Layout *layout)
+{
+    uint32_t sector_size = dev->logical_sector_size;
+    uint64_t total_sectors = dev->size_bytes / sector_size;
+    uint64_t min_first, max_last;
+    SCRIPT_Extent extents[SCRIPT_MAX_PARTITIONS];
+
+    // Usable area of the device for this label
+    if (layout->label == SCRIPT_LABEL_GPT)
+    {
+        uint64_t array_sectors = ((uint64_t)layout->table_length * GPT_ENTRY_SIZE + sector_size - 1) / sector_size;
+        min_first = 2 + array_sectors;
+        max_last = (total_sectors > 2 * min_first) ? total_sectors - 2 - array_sectors : 0;
+    }
+    else
+    {
+        if (layout->count > MBR_PARTITIONS_NUM)
+        {
+            fprintf(out, "A dos label holds at most %d partitions\n", MBR_PARTITIONS_NUM);
+            return -1;
+        }
+        min_first = 1;
+        max_last = (total_sectors > 0xFFFFFFFFULL) ? 0xFFFFFFFEULL : total_sectors - 1;
+    }
+
+    uint64_t first_usable = layout->first_lba ? layout->first_lba : min_first;
+    uint64_t last_usable = layout->last_lba ? layout->last_lba : max_last;
+    if (first_usable < min_first || last_usable > max_last || first_usable > last_usable)
+    {
+        fprintf(out, "The usable area %" PRIu64 "-%" PRIu64 " does not fit the device (%" PRIu64 " sectors)\n",
+                first_usable, last_usable, total_sectors);
+        return -1;
+    }
+
+    if (resolve_layout(out, layout, sector_size, first_usable, last_usable, extents) != 0)
+    {
+        return -1;
+    }
+
+    // Write the table, flush it and let the kernel pick it up
+    int status = (layout->label == SCRIPT_LABEL_GPT)
+               ? write_gpt(out, dev, layout, extents, first_usable, last_usable)
+               : write_dos(out, dev, layout, extents);
+    if (status != 0)
+    {
+        return -1;
+    }
+
+    if (BLK_sync(dev) != 0)
+    {
+        fprintf(out, "fsync failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (BLK_reread_partitions(dev) != 0)
+    {
+        fprintf(out, "Warning: the kernel still uses the old partition table (%s)\n", strerror(errno));
+    }
+
+    fprintf(out, "Created a new %s label with %zu partition%s\n",
+            layout->label == SCRIPT_LABEL_GPT ? "GPT" : "DOS", layout->count, layout->count == 1 ? "" : "s");
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ *===================================================================================
+ * @file           : Partition_Script.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Partition_Script (sfdisk-like script-driven partitioning)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _PARTITION_SCRIPT_H_
+#define _PARTITION_SCRIPT_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "GPT_Parsing.h"  // Provides GPT_Header, GPT_PartitionEntry, GUID helpers and CRC32
+#include "MBR_Parsing.h"  // Provides MBR_PartitionEntry and the MBR constants
+#include "Block_IO.h"     // Provides BLK_Device writes, fsync and BLKRRPART
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Maximum number of partition lines in a script.
+ *
+ * This is also the default (and minimum) number of entries of a GPT entry array; a larger
+ * array can be requested with `table-length:`, but only this many entries can be filled.
+ */
+#define SCRIPT_MAX_PARTITIONS       128  // Maximum number of partitions in a script
+
+/**
+ * Default partition alignment (grain) in bytes.
+ *
+ * Partitions without an explicit start are placed on the next 1 MiB boundary, which is
+ * aligned for every common physical sector, RAID stripe and SSD erase block size.
+ */
+#define SCRIPT_DEFAULT_GRAIN        (1024 * 1024)  // 1 MiB
+
+/**
+ * Maximum length in bytes of a partition name (UTF-8) in a script.
+ */
+#define SCRIPT_NAME_LENGTH          256  // UTF-8 bytes, encoded into 36 UTF-16 units
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Partition table type requested by the `label:` line.
+ */
+typedef enum {
+    SCRIPT_LABEL_GPT,   /**< GUID Partition Table (with protective MBR). */
+    SCRIPT_LABEL_DOS    /**< MBR partition table (primary partitions only). */
+} SCRIPT_LabelType;
+
+/**
+ * Represents one partition line of a script.
+ *
+ * Fields:
+ *
+ * @param start: First sector (or byte offset if `start_in_bytes`), 0 to use the default.
+ * @param size: Size in sectors (or bytes if `size_in_bytes`), 0 to use the rest of the disk.
+ * @param start_in_bytes: `start` was given with a K/M/G/T suffix.
+ * @param size_in_bytes: `size` was given with a K/M/G/T suffix.
+ * @param type_guid: GPT partition type GUID.
+ * @param mbr_id: MBR partition type id.
+ * @param has_uuid: `uuid` was given; otherwise a random partition GUID is generated.
+ * @param uuid: GPT unique partition GUID.
+ * @param name: GPT partition name (UTF-8).
+ * @param attributes: GPT attribute bits.
+ * @param bootable: Bootable flag (MBR boot indicator, GPT legacy BIOS bootable bit).
+ */
+typedef struct {
+    uint64_t start;                       /**< First sector or byte offset. */
+    uint64_t size;                        /**< Size in sectors or bytes. */
+    int start_in_bytes;                   /**< `start` is in bytes. */
+    int size_in_bytes;                    /**< `size` is in bytes. */
+    uint8_t type_guid[GUID_SIZE];         /**< GPT type GUID. */
+    uint8_t mbr_id;                       /**< MBR type id. */
+    int has_uuid;                         /**< `uuid` given. */
+    uint8_t uuid[GUID_SIZE];              /**< GPT partition GUID. */
+    char name[SCRIPT_NAME_LENGTH];        /**< GPT name (UTF-8). */
+    uint64_t attributes;                  /**< GPT attributes. */
+    int bootable;                         /**< Bootable flag. */
+} SCRIPT_Partition;
+
+/**
+ * Represents a whole partition layout read from a script.
+ *
+ * Fields:
+ *
+ * @param label: Partition table type.
+ * @param has_label_id: `label-id` was given; otherwise a random disk GUID/signature is used.
+ * @param disk_guid: GPT disk GUID.
+ * @param disk_signature: MBR disk signature.
+ * @param first_lba: First usable LBA requested with `first-lba:`, or 0 for the default.
+ * @param last_lba: Last usable LBA requested with `last-lba:`, or 0 for the default.
+ * @param table_length: Number of GPT entries (at least `SCRIPT_MAX_PARTITIONS`).
+ * @param count: Number of partitions.
+ * @param partitions: The partitions, in script order.
+ */
+typedef struct {
+    SCRIPT_LabelType label;                           /**< gpt or dos. */
+    int has_label_id;                                 /**< `label-id` given. */
+    uint8_t disk_guid[GUID_SIZE];                     /**< GPT disk GUID. */
+    uint32_t disk_signature;                          /**< MBR disk signature. */
+    uint64_t first_lba;                               /**< First usable LBA, or 0. */
+    uint64_t last_lba;                                /**< Last usable LBA, or 0. */
+    uint32_t table_length;                            /**< GPT entry count. */
+    size_t count;                                     /**< Number of partitions. */
+    SCRIPT_Partition partitions[SCRIPT_MAX_PARTITIONS];  /**< Partitions. */
+} SCRIPT_Layout;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+int SCRIPT_parse(FILE *in, SCRIPT_Layout *layout);
+int SCRIPT_apply(FILE *out, BLK_Device *dev, const SCRIPT_Layout *layout);
+
+#endif
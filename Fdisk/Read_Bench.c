@@ -0,0 +1,393 @@
+/**
+ *===================================================================================
+ * @file           : Read_Bench.c
+ * @author         : Ali Mamdouh
+ * @brief          : per-partition sequential read throughput and random read IOPS
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Read_Bench.h"   // Includes the benchmark configuration macros and API
+#include <stdlib.h>       // Provides free
+#include <string.h>       // Provides memset and strerror
+#include <errno.h>        // Provides errno for error reporting
+#include "Image_Format.h" // Provides the name of the image format of a device
+#include <time.h>         // Provides clock_gettime
+#include <pthread.h>      // Provides the threads that keep several reads in flight
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * State of one thread of a measurement; `depth` threads keep `depth` reads in flight.
+ */
+typedef struct {
+    BLK_Device dev;            /**< Copy of the device (same descriptor), with its own counters. */
+    uint64_t base;             /**< Byte offset of the measured range. */
+    uint64_t length;           /**< Length of the measured range. */
+    uint64_t *cursor;          /**< Sequential: next offset, shared by all threads. */
+    uint64_t deadline;         /**< Random: time the measurement ends (ns). */
+    uint64_t random;           /**< Random: pseudo-random generator state. */
+    uint64_t operations;       /**< Reads completed. */
+    uint64_t bytes;            /**< Bytes read. */
+    int error;                 /**< errno of a failed read, or 0. */
+} bench_worker;
+
+
+
+
+
+/*============================================================================
+ **********************  Global Variables Decleration  ***********************
+ ============================================================================*/
+/**
+ * Partition sample positions, relative to the partition.
+ */
+static const char *const sample_names[] = { "Start", "Middle", "End" };
+
+/**
+ * Queue depths measured.
+ */
+static const unsigned int queue_depths[] = { 1, 4, BENCH_MAX_QUEUE_DEPTH };
+
+/**
+ * Number of samples and of queue depths.
+ */
+#define SAMPLE_COUNT                (sizeof(sample_names) / sizeof(sample_names[0]))
+#define DEPTH_COUNT                 (sizeof(queue_depths) / sizeof(queue_depths[0]))
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Returns the monotonic time in nanoseconds.
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+
+/**
+ * Returns the next value of a xorshift64 pseudo-random generator.
+ */
+static uint64_t next_random(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+
+
+
+
+
+/**
+ * Thread body of a sequential measurement.
+ *
+ * Every thread takes the next block from the shared cursor, so with `depth` threads the
+ * device sees `depth` consecutive reads in flight, as with `fio --rw=read --iodepth`.
+ */
+static void *sequential_worker(void *arg)
+{
+    bench_worker *worker = arg;
+    char *buf = BLK_alloc_buffer(&worker->dev, BENCH_SEQUENTIAL_BLOCK);
+    if (buf == NULL)
+    {
+        worker->error = ENOMEM;
+        return NULL;
+    }
+
+    for (;;)
+    {
+        uint64_t offset = __atomic_fetch_add(worker->cursor, BENCH_SEQUENTIAL_BLOCK, __ATOMIC_RELAXED);
+        if (offset >= worker->length)
+        {
+            break;
+        }
+        size_t length = (worker->length - offset < BENCH_SEQUENTIAL_BLOCK) ? (size_t)(worker->length - offset) : BENCH_SEQUENTIAL_BLOCK;
+        if (BLK_read(&worker->dev, worker->base + offset, buf, length) != 0)
+        {
+            worker->error = errno;
+            break;
+        }
+        worker->operations++;
+        worker->bytes += length;
+    }
+
+    free(buf);
+    return NULL;
+}
+
+
+
+
+
+
+/**
+ * Thread body of a random measurement: aligned 4 KiB reads anywhere in the range until
+ * the deadline.
+ */
+static void *random_worker(void *arg)
+{
+    bench_worker *worker = arg;
+    uint64_t blocks = worker->length / BENCH_RANDOM_BLOCK;
+    char *buf = BLK_alloc_buffer(&worker->dev, BENCH_RANDOM_BLOCK);
+    if (buf == NULL)
+    {
+        worker->error = ENOMEM;
+        return NULL;
+    }
+
+    while (now_ns() < worker->deadline)
+    {
+        uint64_t offset = (next_random(&worker->random) % blocks) * BENCH_RANDOM_BLOCK;
+        if (BLK_read(&worker->dev, worker->base + offset, buf, BENCH_RANDOM_BLOCK) != 0)
+        {
+            worker->error = errno;
+            break;
+        }
+        worker->operations++;
+        worker->bytes += BENCH_RANDOM_BLOCK;
+    }
+
+    free(buf);
+    return NULL;
+}
+
+
+
+
+
+
+/**
+ * Runs one measurement with `depth` threads reading the range [base, base + length).
+ *
+ * The threads read through copies of the device, so the system call counters are not
+ * updated concurrently; they are added to the device when the threads have finished.
+ *
+ * @param dev: The device (opened for reading).
+ * @param base: Byte offset of the range.
+ * @param length: Length of the range in bytes.
+ * @param depth: Number of reads kept in flight.
+ * @param sequential: Non-zero for sequential 1 MiB reads of the whole range, zero for
+ *                    random 4 KiB reads during `BENCH_RANDOM_TIME_MS`.
+ * @param result: Receives the sum of the threads (operations, bytes).
+ *
+ * @return The elapsed time in seconds, or a negative value on error (errno is set).
+ */
+static double run_measurement(BLK_Device *dev, uint64_t base, uint64_t length, unsigned int depth,
+                              int sequential, bench_worker *result)
+{
+    bench_worker workers[BENCH_MAX_QUEUE_DEPTH];
+    pthread_t threads[BENCH_MAX_QUEUE_DEPTH];
+    uint64_t cursor = 0;
+    unsigned int started = 0;
+    int error = 0;
+
+    uint64_t start = now_ns();
+    for (unsigned int i = 0; i < depth; i++)
+    {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].dev = *dev;
+        memset(&workers[i].dev.stats, 0, sizeof(workers[i].dev.stats));
+        workers[i].base = base;
+        workers[i].length = length;
+        workers[i].cursor = &cursor;
+        workers[i].deadline = start + BENCH_RANDOM_TIME_MS * 1000000ULL;
+        workers[i].random = (base + 1) * 0x9E3779B97F4A7C15ULL + i + 1;
+        if (pthread_create(&threads[i], NULL, sequential ? sequential_worker : random_worker, &workers[i]) != 0)
+        {
+            error = EAGAIN;
+            break;
+        }
+        started++;
+    }
+
+    memset(result, 0, sizeof(*result));
+    for (unsigned int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+        result->operations += workers[i].operations;
+        result->bytes += workers[i].bytes;
+        if (workers[i].error != 0)
+        {
+            error = workers[i].error;
+        }
+        dev->stats.syscalls += workers[i].dev.stats.syscalls;
+        dev->stats.reads += workers[i].dev.stats.reads;
+        dev->stats.read_bytes += workers[i].dev.stats.read_bytes;
+    }
+    double seconds = (double)(now_ns() - start) / 1e9;
+
+    if (error != 0)
+    {
+        errno = error;
+        return -1.0;
+    }
+    return seconds;
+}
+
+
+
+
+
+
+/**
+ * Measures and prints one partition: a row per queue depth with the sequential
+ * throughput of every sample and the random read IOPS over the whole partition.
+ *
+ * @return 0 on success, or -1 on read error (a message is printed).
+ */
+static int measure_partition(FILE *out, BLK_Device *dev, const char *device, const PARSE_Partition *partition)
+{
+    uint64_t base = partition->start * dev->logical_sector_size;
+    uint64_t length = partition->count * dev->logical_sector_size;
+
+    // Only measure what exists: the table may describe more than the device holds
+    if (base >= dev->size_bytes)
+    {
+        fprintf(out, "%-16s%-6d beyond the end of the device, skipped\n", device, partition->index);
+        return 0;
+    }
+    if (length > dev->size_bytes - base)
+    {
+        length = dev->size_bytes - base;
+    }
+
+    // Three samples of up to BENCH_SAMPLE_SIZE, aligned for O_DIRECT
+    uint64_t sample = (length / SAMPLE_COUNT < BENCH_SAMPLE_SIZE) ? length / SAMPLE_COUNT : BENCH_SAMPLE_SIZE;
+    sample -= sample % BENCH_RANDOM_BLOCK;
+    if (sample == 0)
+    {
+        fprintf(out, "%-16s%-6d too small to measure\n", device, partition->index);
+        return 0;
+    }
+    uint64_t offsets[SAMPLE_COUNT] = { 0, (length - sample) / 2, length - sample };
+    for (size_t s = 0; s < SAMPLE_COUNT; s++)
+    {
+        offsets[s] -= offsets[s] % BENCH_RANDOM_BLOCK;
+    }
+
+    for (size_t d = 0; d < DEPTH_COUNT; d++)
+    {
+        bench_worker result;
+
+        if (d == 0)
+        {
+            fprintf(out, "%-16s%-6d %-4u", device, partition->index, queue_depths[d]);
+        }
+        else
+        {
+            fprintf(out, "%-16s%-6s %-4u", "", "", queue_depths[d]);
+        }
+
+        for (size_t s = 0; s < SAMPLE_COUNT; s++)
+        {
+            double seconds = run_measurement(dev, base + offsets[s], sample, queue_depths[d], 1, &result);
+            if (seconds < 0)
+            {
+                fprintf(out, "\nRead error in partition %d of %s: %s\n", partition->index, device, strerror(errno));
+                return -1;
+            }
+            fprintf(out, " %-12.1f", (double)result.bytes / 1e6 / seconds);
+        }
+
+        double seconds = run_measurement(dev, base, length - length % BENCH_RANDOM_BLOCK, queue_depths[d], 0, &result);
+        if (seconds < 0)
+        {
+            fprintf(out, "\nRead error in partition %d of %s: %s\n", partition->index, device, strerror(errno));
+            return -1;
+        }
+        fprintf(out, " %.0f\n", (double)result.operations / seconds);
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Measures the read performance of every partition of a device (`--bench`).
+ *
+ * This function performs the following tasks:
+ * 1. Opens the device read-only with O_DIRECT, so the page cache does not inflate the
+ *    results; nothing is ever written. qcow2 and VHD images are refused: their reads
+ *    measure the table lookups and decompression rather than the storage, and their
+ *    backend is not shared between threads.
+ * 2. For every partition (extended containers excluded) and every queue depth, measures
+ *    the sequential throughput of 1 MiB reads over a sample at the start, the middle and
+ *    the end of the partition (HDD zones are slower towards the end of the disk).
+ * 3. Measures the random 4 KiB read IOPS over the whole partition at the same queue depths.
+ *
+ * Queue depths are obtained with one thread per read in flight, each issuing blocking
+ * `pread` calls, so no asynchronous I/O interface is required.
+ *
+ * @param out: Stream the results are printed to.
+ * @param device: Path of the device or image file.
+ * @param table: The partition descriptors.
+ *
+ * @return 0 on success, or -1 if the device cannot be opened or a read fails.
+ */
+int BENCH_print_report(FILE *out, const char *device, const PARSE_Table *table)
+{
+    BLK_Device dev;
+
+    if (BLK_open(&dev, device, BLK_FLAG_DIRECT | BLK_FLAG_NO_MMAP) != 0)
+    {
+        fprintf(out, "\nFailed to open %s for the read benchmark: %s\n", device, strerror(errno));
+        return -1;
+    }
+    if (dev.image != NULL)
+    {
+        fprintf(out, "\nRead benchmark not available for %s: %s images are not benchmarked, convert to raw first.\n",
+                device, IMAGE_format_name(dev.image));
+        BLK_close(&dev);
+        return -1;
+    }
+
+    fprintf(out, "\nRead benchmark %s (%s): sequential %d KiB reads over %d MiB samples, random %d KiB reads for %d ms\n",
+            device, dev.direct ? "O_DIRECT" : "buffered, the page cache may inflate the results",
+            BENCH_SEQUENTIAL_BLOCK / 1024, BENCH_SAMPLE_SIZE / (1024 * 1024), BENCH_RANDOM_BLOCK / 1024, BENCH_RANDOM_TIME_MS);
+    fprintf(out, "%-16s%-6s %-4s %-12s %-12s %-12s %s\n",
+            "Device", "Index", "QD", "Start(MB/s)", "Middle(MB/s)", "End(MB/s)", "Random(IOPS)");
+
+    int status = 0;
+    for (size_t i = 0; i < table->count && status == 0; i++)
+    {
+        const PARSE_Partition *partition = &table->partitions[i];
+        if (partition->origin == PARSE_ORIGIN_EXTENDED || partition->count == 0)
+        {
+            continue;
+        }
+        status = measure_partition(out, &dev, device, partition);
+    }
+
+    BLK_close(&dev);
+    return status;
+}
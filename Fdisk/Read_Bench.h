@@ -0,0 +1,69 @@
+/**
+ *===================================================================================
+ * @file           : Read_Bench.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Read_Bench (per-partition read throughput and IOPS)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _READ_BENCH_H_
+#define _READ_BENCH_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stdio.h>            // Provides FILE
+#include "Block_IO.h"         // Provides aligned O_DIRECT reads
+#include "Partition_Parse.h"  // Provides the partition descriptors to measure
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Size of each sequential read in bytes.
+ *
+ * Large enough that per-request overhead is negligible, like `fio --bs=1M`.
+ */
+#define BENCH_SEQUENTIAL_BLOCK      (1024 * 1024)  // 1 MiB
+
+/**
+ * Bytes read sequentially per sample (start, middle and end of a partition) and queue depth.
+ */
+#define BENCH_SAMPLE_SIZE           (64 * 1024 * 1024)  // 64 MiB
+
+/**
+ * Size of each random read in bytes.
+ */
+#define BENCH_RANDOM_BLOCK          4096  // 4 KiB
+
+/**
+ * Duration of each random read measurement in milliseconds.
+ */
+#define BENCH_RANDOM_TIME_MS        250  // 0.25 s per queue depth
+
+/**
+ * Largest queue depth measured (number of reads kept in flight).
+ */
+#define BENCH_MAX_QUEUE_DEPTH       16  // Deepest queue measured
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+int BENCH_print_report(FILE *out, const char *device, const PARSE_Table *table);
+
+#endif
@@ -0,0 +1,229 @@
+/**
+ *===================================================================================
+ * @file           : Sector_Cache.c
+ * @author         : Ali Mamdouh
+ * @brief          : read-ahead sector cache shared by the MBR, EBR and GPT parsers
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Sector_Cache.h"   // Includes the cache structures and API
+#include <errno.h>          // Provides errno for error reporting
+#include <stdlib.h>         // Provides free
+#include <string.h>         // Provides memset and memcpy
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Initializes an empty cache over an opened device.
+ *
+ * No memory is allocated until a block is first read.
+ *
+ * @param cache: The cache to initialize; free it with `CACHE_free`.
+ * @param dev: The device the cache reads from.
+ */
+void CACHE_init(CACHE_Cache *cache, BLK_Device *dev)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->dev = dev;
+}
+
+
+
+
+
+
+/**
+ * Frees the blocks of a cache.
+ *
+ * @param cache: The cache to free.
+ */
+void CACHE_free(CACHE_Cache *cache)
+{
+    for (int i = 0; i < CACHE_BLOCK_COUNT; i++)
+    {
+        free(cache->blocks[i].data);
+        cache->blocks[i].data = NULL;
+        cache->blocks[i].last_use = 0;
+    }
+}
+
+
+
+
+
+
+/**
+ * Drops every cached block, keeping the buffers for reuse.
+ *
+ * Must be called after writing to the device through `BLK_write`/`BLK_write_span`.
+ *
+ * @param cache: The cache to invalidate.
+ */
+void CACHE_invalidate(CACHE_Cache *cache)
+{
+    for (int i = 0; i < CACHE_BLOCK_COUNT; i++)
+    {
+        cache->blocks[i].last_use = 0;
+    }
+}
+
+
+
+
+
+
+/**
+ * Returns the cached block starting at `block_offset`, reading it on a miss.
+ *
+ * On a miss the least recently used slot is reused and the whole block (truncated at the
+ * end of the device) is read with one aligned read.
+ *
+ * @return The block, or NULL on read error (errno is set).
+ */
+static CACHE_Block *lookup_block(CACHE_Cache *cache, uint64_t block_offset)
+{
+    CACHE_Block *victim = &cache->blocks[0];
+
+    cache->clock++;
+    for (int i = 0; i < CACHE_BLOCK_COUNT; i++)
+    {
+        CACHE_Block *block = &cache->blocks[i];
+        if (block->last_use != 0 && block->offset == block_offset)
+        {
+            block->last_use = cache->clock;
+            cache->hits++;
+            return block;
+        }
+        if (block->last_use < victim->last_use)
+        {
+            victim = block;
+        }
+    }
+
+    // Miss: read the whole block into the least recently used slot
+    cache->misses++;
+    if (victim->data == NULL)
+    {
+        victim->data = BLK_alloc_buffer(cache->dev, CACHE_BLOCK_SIZE);
+        if (victim->data == NULL)
+        {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+
+    uint64_t remaining = cache->dev->size_bytes - block_offset;
+    size_t length = (remaining < CACHE_BLOCK_SIZE) ? (size_t)remaining : CACHE_BLOCK_SIZE;
+    victim->last_use = 0;
+    if (BLK_read(cache->dev, block_offset, victim->data, length) != 0)
+    {
+        return NULL;
+    }
+
+    victim->offset = block_offset;
+    victim->length = length;
+    victim->last_use = cache->clock;
+    return victim;
+}
+
+
+
+
+
+
+/**
+ * Returns a pointer to a byte range of the device, reading it through the cache.
+ *
+ * Ranges inside one block are served from the cache: the first access reads the whole
+ * block around it (read-ahead), later accesses to the block cost no read. Ranges that
+ * cross a block boundary are read into `scratch` without being cached. Mapped image
+ * files bypass the cache, `BLK_get` already returns a pointer into the mapping.
+ *
+ * The returned pointer must be treated as read-only. A pointer into a cached block is
+ * only valid until the next call on the cache; copy what must outlive it, or use
+ * `CACHE_read`.
+ *
+ * @param cache: The cache.
+ * @param offset: Byte offset of the first byte.
+ * @param length: Number of bytes needed.
+ * @param scratch: Buffer of at least `length` bytes used for uncached ranges, or NULL
+ *                 if the range is known to fit in a block.
+ *
+ * @return Pointer to the requested bytes, or NULL on error or if the range lies beyond
+ *         the end of the device (errno is set).
+ */
+const void *CACHE_get(CACHE_Cache *cache, uint64_t offset, size_t length, void *scratch)
+{
+    BLK_Device *dev = cache->dev;
+
+    if (dev->map != NULL)
+    {
+        return BLK_get(dev, offset, length, scratch);
+    }
+
+    if (offset > dev->size_bytes || length > dev->size_bytes - offset)
+    {
+        errno = EIO; // The range extends past the end of the device
+        return NULL;
+    }
+
+    uint64_t block_offset = offset - (offset % CACHE_BLOCK_SIZE);
+    if (offset + length > block_offset + CACHE_BLOCK_SIZE)
+    {
+        // Crosses a block boundary: read it directly
+        if (scratch == NULL)
+        {
+            errno = EINVAL;
+            return NULL;
+        }
+        cache->misses++;
+        return (BLK_read(dev, offset, scratch, length) == 0) ? scratch : NULL;
+    }
+
+    CACHE_Block *block = lookup_block(cache, block_offset);
+    return (block != NULL) ? block->data + (offset - block_offset) : NULL;
+}
+
+
+
+
+
+
+/**
+ * Copies a byte range of the device into a buffer, reading it through the cache.
+ *
+ * @param cache: The cache.
+ * @param offset: Byte offset of the first byte.
+ * @param buf: Destination buffer of at least `length` bytes.
+ * @param length: Number of bytes to read.
+ *
+ * @return 0 on success, or -1 on error (errno is set).
+ */
+int CACHE_read(CACHE_Cache *cache, uint64_t offset, void *buf, size_t length)
+{
+    const void *data = CACHE_get(cache, offset, length, buf);
+    if (data == NULL)
+    {
+        return -1;
+    }
+    if (data != buf)
+    {
+        memcpy(buf, data, length);
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ *===================================================================================
+ * @file           : Sector_Cache.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of Sector_Cache (read-ahead sector cache for table parsing)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _SECTOR_CACHE_H_
+#define _SECTOR_CACHE_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Block_IO.h"   // Provides BLK_Device reads
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Size in bytes of the block read around a missed sector (read-ahead window).
+ *
+ * Blocks are aligned to their size, so the MBR, the primary GPT header and a 128-entry
+ * GPT array (LBA 0-33, 17 KiB) come from a single read, and so do all EBRs of logical
+ * partitions packed within 64 KiB of each other. A multiple of every supported sector
+ * size, so blocks can be read with O_DIRECT.
+ */
+#define CACHE_BLOCK_SIZE            (64 * 1024)  // 64 KiB read-ahead
+
+/**
+ * Number of blocks kept by a cache (least recently used block is replaced).
+ *
+ * Partition tables live at a handful of places: the start of the disk, the backup GPT at
+ * the end, and EBRs spread over the extended partition.
+ */
+#define CACHE_BLOCK_COUNT           8
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Represents one cached block of a device.
+ *
+ * Fields:
+ *
+ * @param offset: Byte offset of the block (a multiple of `CACHE_BLOCK_SIZE`).
+ * @param length: Number of valid bytes (less than the block size at the end of a device).
+ * @param last_use: Value of the cache clock when the block was last used (0 = empty).
+ * @param data: Aligned buffer holding the block, allocated on first use.
+ */
+typedef struct {
+    uint64_t offset;     /**< Byte offset of the block. */
+    size_t length;       /**< Valid bytes in the block. */
+    uint64_t last_use;   /**< LRU timestamp, 0 if the slot is empty. */
+    uint8_t *data;       /**< Block data. */
+} CACHE_Block;
+
+/**
+ * Represents a sector cache over an opened device.
+ *
+ * Shared by the MBR, EBR and GPT parsers of a device, so the structures they read near
+ * each other cost one read. Not thread-safe: each device probe owns its own cache.
+ *
+ * Fields:
+ *
+ * @param dev: The device the blocks are read from.
+ * @param blocks: The cached blocks.
+ * @param clock: Counter incremented on every access (LRU order).
+ * @param hits: Number of requests served from a cached block.
+ * @param misses: Number of requests that needed a read.
+ */
+typedef struct {
+    BLK_Device *dev;                          /**< Underlying device. */
+    CACHE_Block blocks[CACHE_BLOCK_COUNT];    /**< Cached blocks. */
+    uint64_t clock;                           /**< LRU clock. */
+    uint64_t hits;                            /**< Requests served from the cache. */
+    uint64_t misses;                          /**< Requests that read the device. */
+} CACHE_Cache;
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+void CACHE_init(CACHE_Cache *cache, BLK_Device *dev);
+void CACHE_free(CACHE_Cache *cache);
+void CACHE_invalidate(CACHE_Cache *cache);
+const void *CACHE_get(CACHE_Cache *cache, uint64_t offset, size_t length, void *scratch);
+int CACHE_read(CACHE_Cache *cache, uint64_t offset, void *buf, size_t length);
+
+#endif
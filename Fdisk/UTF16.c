@@ -0,0 +1,156 @@
+/**
+ *===================================================================================
+ * @file           : UTF16.c
+ * @author         : Ali Mamdouh
+ * @brief          : source file to convert UTF-16LE partition names to UTF-8
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "UTF16.h"        // Includes the converter API and configuration macros
+#ifdef __SSE2__
+#include <emmintrin.h>    // Provides the SSE2 intrinsics of the ASCII fast path
+#endif
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Converts up to 8 ASCII code units at once.
+ *
+ * The units are checked in one register: every unit must be in 0x01-0x7F (no high bits,
+ * no terminator). If so they are narrowed to bytes with a saturating pack and stored as
+ * one 64-bit write.
+ *
+ * @return Non-zero if the 8 units were converted, zero if the scalar path must handle them.
+ */
+static int convert_ascii_block(const uint16_t *units, char *utf8)
+{
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    __m128i block = _mm_loadu_si128((const __m128i *)units);
+    __m128i high = _mm_and_si128(block, _mm_set1_epi16((short)0xFF80));
+    int ascii = _mm_movemask_epi8(_mm_cmpeq_epi16(high, zero));
+    int terminator = _mm_movemask_epi8(_mm_cmpeq_epi16(block, zero));
+
+    if (ascii != 0xFFFF || terminator != 0)
+    {
+        return 0;
+    }
+    _mm_storel_epi64((__m128i *)utf8, _mm_packus_epi16(block, block));
+    return 1;
+#else
+    for (int i = 0; i < UTF16_BLOCK_UNITS; i++)
+    {
+        if (units[i] == 0 || units[i] >= 0x80)
+        {
+            return 0;
+        }
+    }
+    for (int i = 0; i < UTF16_BLOCK_UNITS; i++)
+    {
+        utf8[i] = (char)units[i];
+    }
+    return 1;
+#endif
+}
+
+
+
+
+
+
+/**
+ * Converts UTF-16LE code units (a GPT partition name) to a NUL-terminated UTF-8 string.
+ *
+ * The conversion stops at the first NUL unit or after `count` units. Runs of 8 ASCII
+ * units, by far the most common names, take the SSE2 fast path; other units are encoded
+ * one at a time, surrogate pairs as one 4-byte sequence and unpaired surrogates as
+ * U+FFFD. If `utf8` is too small (less than `UTF16_UTF8_SIZE(count)`), the string is cut
+ * at a character boundary.
+ *
+ * @param units: The UTF-16 code units, in host order (GPT names are little-endian).
+ * @param count: Maximum number of units (36 for a GPT name).
+ * @param utf8: Receives the UTF-8 string.
+ * @param size: Size of `utf8` in bytes (at least 1).
+ *
+ * @return The length of the UTF-8 string in bytes.
+ */
+size_t UTF16_to_utf8(const uint16_t *units, size_t count, char *utf8, size_t size)
+{
+    size_t i = 0;
+    size_t out = 0;
+
+    while (i < count)
+    {
+        // ASCII fast path: 8 units in, 8 bytes out
+        if (i + UTF16_BLOCK_UNITS <= count && out + UTF16_BLOCK_UNITS < size &&
+            convert_ascii_block(units + i, utf8 + out))
+        {
+            i += UTF16_BLOCK_UNITS;
+            out += UTF16_BLOCK_UNITS;
+            continue;
+        }
+
+        // Scalar path: one code point
+        uint32_t code = units[i];
+        size_t used = 1;
+        if (code == 0)
+        {
+            break;
+        }
+        if (code >= 0xD800 && code <= 0xDBFF && i + 1 < count && units[i + 1] >= 0xDC00 && units[i + 1] <= 0xDFFF)
+        {
+            code = 0x10000 + ((code - 0xD800) << 10) + (units[i + 1] - 0xDC00u);
+            used = 2;
+        }
+        else if (code >= 0xD800 && code <= 0xDFFF)
+        {
+            code = 0xFFFD; // Unpaired surrogate
+        }
+
+        size_t length = (code < 0x80) ? 1 : (code < 0x800) ? 2 : (code < 0x10000) ? 3 : 4;
+        if (out + length >= size)
+        {
+            break;
+        }
+        switch (length)
+        {
+            case 1:
+                utf8[out++] = (char)code;
+                break;
+            case 2:
+                utf8[out++] = (char)(0xC0 | (code >> 6));
+                utf8[out++] = (char)(0x80 | (code & 0x3F));
+                break;
+            case 3:
+                utf8[out++] = (char)(0xE0 | (code >> 12));
+                utf8[out++] = (char)(0x80 | ((code >> 6) & 0x3F));
+                utf8[out++] = (char)(0x80 | (code & 0x3F));
+                break;
+            default:
+                utf8[out++] = (char)(0xF0 | (code >> 18));
+                utf8[out++] = (char)(0x80 | ((code >> 12) & 0x3F));
+                utf8[out++] = (char)(0x80 | ((code >> 6) & 0x3F));
+                utf8[out++] = (char)(0x80 | (code & 0x3F));
+                break;
+        }
+        i += used;
+    }
+
+    utf8[out] = '\0';
+    return out;
+}
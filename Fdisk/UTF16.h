@@ -0,0 +1,53 @@
+/**
+ *===================================================================================
+ * @file           : UTF16.h
+ * @author         : Ali Mamdouh
+ * @brief          : header of UTF16 (UTF-16LE to UTF-8 conversion of GPT partition names)
+ * @Reviewer       : Eng Reda
+ * @Version        : 2.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _UTF16_H_
+#define _UTF16_H_
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stddef.h>    // Defines size_t
+#include <inttypes.h>  // Provides integer types with specified widths (e.g., uint16_t)
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Size of a UTF-8 buffer that always holds `units` UTF-16 code units and a terminator.
+ *
+ * A unit of the BMP takes at most 3 UTF-8 bytes; a surrogate pair (2 units) takes 4.
+ */
+#define UTF16_UTF8_SIZE(units)      ((units) * 3 + 1)
+
+/**
+ * Number of code units the SSE2 fast path converts per iteration.
+ */
+#define UTF16_BLOCK_UNITS           8  // One 128-bit register of UTF-16 units
+
+
+
+
+
+/*============================================================================
+ *************************  Functions API Decleration  ***********************
+ ============================================================================*/
+size_t UTF16_to_utf8(const uint16_t *units, size_t count, char *utf8, size_t size);
+
+#endif
@@ -0,0 +1,1010 @@
+/*===================================================================================
+* @file           : mkimage.c
+* @author         : Ali Mamdouh
+* @brief          : synthetic disk image generator (test inputs and parsing benchmark)
+* @Reviewer       : Eng Reda
+* @Version        : 2.0.0
+*===================================================================================
+*
+*===================================================================================
+*/
+
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "MBR_Parsing.h" // Provides MBR_PartitionEntry and the MBR/EBR constants
+#include "GPT_Parsing.h" // Provides GPT_Header, GPT_PartitionEntry and convert_string_to_guid
+#include "CRC32.h"       // Provides CRC32_compute for the GPT header and entry array checksums
+#include <getopt.h>      // Provides getopt_long for command-line option parsing
+#include <errno.h>       // Provides errno for error reporting
+#include <limits.h>      // Provides PATH_MAX
+
+
+
+
+
+/*============================================================================
+ ********************************* Macros ************************************
+ ============================================================================*/
+/**
+ * Default size of a generated image in bytes.
+ *
+ * Images are sparse: only the partition tables are written, so the size costs no disk space.
+ */
+#define IMG_DEFAULT_SIZE            (1024ULL * 1024 * 1024)  // 1 GiB
+
+/**
+ * Alignment of the partitions in bytes, as used by partitioning tools.
+ *
+ * Partitions too small for it (deep EBR chains on small images) are packed instead.
+ */
+#define IMG_GRAIN                   (1024 * 1024)  // 1 MiB
+
+/**
+ * GPT revision written to the headers (1.0).
+ */
+#define IMG_GPT_REVISION            0x00010000  // GPT revision 1.0
+
+/**
+ * Number of bytes changed in the partition tables by the `fuzz` corruption.
+ */
+#define IMG_FUZZ_BYTES              8  // Bytes changed by -c fuzz
+
+/**
+ * Name of every image generated into a directory (`-N`), numbered from 0.
+ */
+#define IMG_NAME_FORMAT             "%s/disk%05lu.img"  // Image path inside the output directory
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * Partition table written to an image.
+ */
+typedef enum {
+    IMG_LABEL_MBR,      /**< MBR, with an extended partition and EBR chain if logicals are requested. */
+    IMG_LABEL_GPT,      /**< GPT with a protective MBR. */
+    IMG_LABEL_HYBRID    /**< GPT with a hybrid MBR mirroring up to three GPT partitions. */
+} IMG_Label;
+
+/**
+ * Deliberate damage applied to an image after its tables are written.
+ */
+typedef enum {
+    IMG_CORRUPT_NONE,           /**< Valid tables. */
+    IMG_CORRUPT_NO_SIGNATURE,   /**< The 0x55AA MBR signature is missing. */
+    IMG_CORRUPT_OVERLAP,        /**< The second partition starts inside the first (consistent tables). */
+    IMG_CORRUPT_OUTSIDE,        /**< The last partition ends beyond the disk or the usable range. */
+    IMG_CORRUPT_TRUNCATED,      /**< The image is cut to half its size after the tables are written. */
+    IMG_CORRUPT_FUZZ,           /**< `IMG_FUZZ_BYTES` random bytes of the tables are changed. */
+    IMG_CORRUPT_EBR_LOOP,       /**< The last EBR links back into the chain. */
+    IMG_CORRUPT_EBR_OUTSIDE,    /**< The last EBR links beyond the extended partition. */
+    IMG_CORRUPT_HEADER_CRC,     /**< The primary GPT header no longer matches its CRC32. */
+    IMG_CORRUPT_ENTRIES_CRC,    /**< The primary GPT entry array no longer matches its CRC32. */
+    IMG_CORRUPT_NO_PRIMARY,     /**< The primary GPT header is wiped. */
+    IMG_CORRUPT_NO_BACKUP       /**< The backup GPT header is wiped. */
+} IMG_Corruption;
+
+/**
+ * Describes the image to generate.
+ *
+ * Fields:
+ *
+ * @param label: Partition table type.
+ * @param sector_size: Logical sector size (512 or 4096).
+ * @param size: Image size in bytes.
+ * @param primaries: MBR: number of primary partitions.
+ * @param logicals: MBR: number of logical partitions (EBR chain length); an extended
+ *                  partition takes one of the four primary slots.
+ * @param partitions: GPT: number of partitions.
+ * @param entries: GPT: number of entries of the entry array.
+ * @param entry_size: GPT: size of an entry in bytes (128 * 2^n).
+ * @param corruption: Damage applied after the tables are written.
+ */
+typedef struct {
+    IMG_Label label;              /**< Partition table type. */
+    uint32_t sector_size;         /**< Logical sector size. */
+    uint64_t size;                /**< Image size in bytes. */
+    unsigned int primaries;       /**< MBR primary partitions. */
+    unsigned int logicals;        /**< MBR logical partitions. */
+    unsigned int partitions;      /**< GPT partitions. */
+    unsigned int entries;         /**< GPT entry array length. */
+    unsigned int entry_size;      /**< GPT entry size. */
+    IMG_Corruption corruption;    /**< Deliberate damage. */
+} IMG_Layout;
+
+/**
+ * Byte range of an image holding a partition table structure.
+ */
+typedef struct {
+    uint64_t offset;              /**< Byte offset. */
+    size_t length;                /**< Length in bytes. */
+} IMG_Region;
+
+/**
+ * State of the image being written.
+ *
+ * Fields:
+ *
+ * @param fd: File descriptor of the image.
+ * @param layout: The layout being written.
+ * @param last_lba: Last LBA of the image.
+ * @param random: State of the pseudo-random generator (GUIDs and fuzzing).
+ * @param regions: Every structure written (MBR, EBRs, GPT headers and arrays), the
+ *                 targets of the `fuzz` corruption.
+ * @param region_count: Number of regions.
+ * @param region_capacity: Allocated number of regions.
+ */
+typedef struct {
+    int fd;                       /**< Image file descriptor. */
+    const IMG_Layout *layout;     /**< Layout being written. */
+    uint64_t last_lba;            /**< Last LBA of the image. */
+    uint64_t random;              /**< Pseudo-random generator state. */
+    IMG_Region *regions;          /**< Structures written. */
+    size_t region_count;          /**< Number of regions. */
+    size_t region_capacity;       /**< Allocated regions. */
+} IMG_Writer;
+
+/**
+ * Partition type written for the n-th partition (cycled), as a GPT type and an MBR id.
+ */
+typedef struct {
+    const char *guid;             /**< GPT type GUID. */
+    uint8_t mbr_type;             /**< MBR partition type. */
+} IMG_PartitionType;
+
+
+
+
+
+/*============================================================================
+ **********************  Global Variables Decleration  ***********************
+ ============================================================================*/
+/**
+ * Partition types given to the generated partitions, in turn.
+ */
+static const IMG_PartitionType partition_types[] =
+{
+    { "C12A7328-F81F-11D2-BA4B-00A0C93EC93B", 0xEF },  // EFI System
+    { "0FC63DAF-8483-4772-8E79-3D69D8477DE4", 0x83 },  // Linux filesystem
+    { "0657FD6D-A4AB-43C4-84E5-0933C84B4F4F", 0x82 },  // Linux swap
+    { "EBD0A0A2-B9E5-4433-87C0-68B6B72699C7", 0x07 },  // Microsoft basic data
+    { "E6D6D379-F507-44C2-A23C-238F2A3DF928", 0x8E },  // Linux LVM
+    { "A19D880F-05FC-4D3B-A006-743F0F84911E", 0xFD },  // Linux RAID
+};
+
+/**
+ * Names of the corruptions accepted by -c, indexed by `IMG_Corruption`.
+ */
+static const char *const corruption_names[] =
+{
+    "none", "no-signature", "overlap", "outside", "truncated", "fuzz",
+    "ebr-loop", "ebr-outside", "header-crc", "entries-crc", "no-primary", "no-backup"
+};
+
+/**
+ * Number of corruptions.
+ */
+#define CORRUPTION_COUNT            (sizeof(corruption_names) / sizeof(corruption_names[0]))
+
+/**
+ * Number of partition types.
+ */
+#define PARTITION_TYPE_COUNT        (sizeof(partition_types) / sizeof(partition_types[0]))
+
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Returns the next value of a splitmix64 pseudo-random generator.
+ *
+ * Images are generated from a seed, so a corpus can be regenerated byte for byte.
+ */
+static uint64_t next_random(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+
+/**
+ * Generates a pseudo-random (version 4) GUID in its on-disk byte order.
+ */
+static void random_guid(uint64_t *state, uint8_t *guid)
+{
+    uint64_t words[2] = { next_random(state), next_random(state) };
+    memcpy(guid, words, GUID_SIZE);
+    guid[7] = (uint8_t)((guid[7] & 0x0F) | 0x40);  // Version 4
+    guid[8] = (uint8_t)((guid[8] & 0x3F) | 0x80);  // RFC 4122 variant
+}
+
+
+
+/**
+ * Rounds a value down to a multiple of `grain`.
+ */
+static uint64_t round_down(uint64_t value, uint64_t grain)
+{
+    return value - (value % grain);
+}
+
+
+
+/**
+ * Fills an MBR partition entry (LBA addressing, CHS fields set to the "beyond CHS" value).
+ */
+static void fill_mbr_entry(MBR_PartitionEntry *entry, uint8_t status, uint8_t type, uint64_t start, uint64_t count)
+{
+    static const uint8_t no_chs[3] = { 0xFE, 0xFF, 0xFF };
+
+    entry->status = status;
+    entry->partition_type = type;
+    entry->lba = (uint32_t)start;
+    entry->sector_count = (uint32_t)count;
+    memcpy(entry->first_chs, no_chs, sizeof(no_chs));
+    memcpy(entry->last_chs, no_chs, sizeof(no_chs));
+}
+
+
+
+
+
+
+/**
+ * Writes a partition table structure to the image and records it as a fuzzing target.
+ *
+ * @param writer: The image being written.
+ * @param offset: Byte offset of the structure.
+ * @param data: The structure.
+ * @param length: Length in bytes.
+ *
+ * @return 0 on success, or -1 on error (errno is set).
+ */
+static int write_region(IMG_Writer *writer, uint64_t offset, const void *data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t count = pwrite(writer->fd, (const char *)data + done, length - done, (off_t)(offset + done));
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        done += (size_t)count;
+    }
+
+    if (writer->region_count == writer->region_capacity)
+    {
+        size_t capacity = writer->region_capacity ? writer->region_capacity * 2 : 16;
+        IMG_Region *regions = realloc(writer->regions, capacity * sizeof(IMG_Region));
+        if (regions == NULL)
+        {
+            return -1;
+        }
+        writer->regions = regions;
+        writer->region_capacity = capacity;
+    }
+    writer->regions[writer->region_count].offset = offset;
+    writer->regions[writer->region_count].length = length;
+    writer->region_count++;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Changes `IMG_FUZZ_BYTES` random bytes of the structures written so far.
+ *
+ * Every byte is XORed with a non-zero value, so each change is effective.
+ *
+ * @return 0 on success, or -1 on error (errno is set).
+ */
+static int fuzz_regions(IMG_Writer *writer)
+{
+    for (int i = 0; i < IMG_FUZZ_BYTES && writer->region_count != 0; i++)
+    {
+        const IMG_Region *region = &writer->regions[next_random(&writer->random) % writer->region_count];
+        uint64_t offset = region->offset + next_random(&writer->random) % region->length;
+        uint8_t byte;
+
+        if (pread(writer->fd, &byte, 1, (off_t)offset) != 1)
+        {
+            return -1;
+        }
+        byte ^= (uint8_t)(1 + next_random(&writer->random) % 255);
+        if (pwrite(writer->fd, &byte, 1, (off_t)offset) != 1)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Writes an MBR, and for logical partitions an extended partition and its EBR chain.
+ *
+ * The space after the first MiB is split evenly between the primary slots; the extended
+ * partition takes the last slot and is split evenly between the logical partitions. Each
+ * logical partition is preceded by its EBR, 1 MiB before it when the pieces are large
+ * enough, otherwise in the sector just before it (packed chains). The `outside`
+ * corruption stretches the last logical partition, if any, so no EBR lies beyond the
+ * end of the image.
+ *
+ * @return 0 on success, or -1 on error (a message is printed).
+ */
+static int write_mbr(IMG_Writer *writer)
+{
+    const IMG_Layout *layout = writer->layout;
+    uint32_t sector_size = layout->sector_size;
+    uint64_t grain = IMG_GRAIN / sector_size;
+    uint64_t limit = (writer->last_lba > UINT32_MAX) ? UINT32_MAX : writer->last_lba;
+    unsigned int slots = layout->primaries + (layout->logicals != 0);
+    uint8_t mbr[SECTOR_SIZE] = { 0 };
+    MBR_PartitionEntry *table = (MBR_PartitionEntry *)(mbr + 446);
+
+    uint64_t share = slots ? (limit + 1 - grain) / slots : 0;
+    if (share >= grain)
+    {
+        share = round_down(share, grain);
+    }
+    if (slots != 0 && share < 2)
+    {
+        fprintf(stderr, "Image too small for %u partitions\n", slots);
+        return -1;
+    }
+
+    uint64_t starts[MBR_PARTITIONS_NUM], counts[MBR_PARTITIONS_NUM];
+    for (unsigned int i = 0; i < slots; i++)
+    {
+        starts[i] = grain + i * share;
+        counts[i] = share;
+    }
+    if (layout->corruption == IMG_CORRUPT_OVERLAP && slots >= 2)
+    {
+        starts[1] -= share / 2;
+    }
+    if (layout->corruption == IMG_CORRUPT_OUTSIDE && layout->logicals == 0 && slots >= 1)
+    {
+        counts[slots - 1] = writer->last_lba + grain - starts[slots - 1];
+    }
+
+    for (unsigned int i = 0; i < layout->primaries; i++)
+    {
+        fill_mbr_entry(&table[i], i == 0 ? 0x80 : 0x00, partition_types[i % PARTITION_TYPE_COUNT].mbr_type,
+                       starts[i], counts[i]);
+    }
+
+    if (layout->logicals != 0)
+    {
+        uint64_t ext_start = starts[slots - 1], ext_count = counts[slots - 1];
+        uint64_t piece = ext_count / layout->logicals;
+        uint64_t offset = 1;
+        if (piece >= 2 * grain)
+        {
+            piece = round_down(piece, grain);
+            offset = grain;
+        }
+        if (piece < 2)
+        {
+            fprintf(stderr, "Image too small for %u logical partitions\n", layout->logicals);
+            return -1;
+        }
+        fill_mbr_entry(&table[slots - 1], 0x00, LBA_EXTENDED_PARTITION, ext_start, ext_count);
+
+        for (unsigned int j = 0; j < layout->logicals; j++)
+        {
+            uint8_t ebr[SECTOR_SIZE] = { 0 };
+            MBR_PartitionEntry *links = (MBR_PartitionEntry *)(ebr + 446);
+            uint64_t next = (j + 1 < layout->logicals) ? (uint64_t)(j + 1) * piece : 0;
+
+            if (j + 1 == layout->logicals && layout->corruption == IMG_CORRUPT_EBR_LOOP)
+            {
+                next = (uint64_t)(layout->logicals / 2) * piece;
+            }
+            if (j + 1 == layout->logicals && layout->corruption == IMG_CORRUPT_EBR_OUTSIDE)
+            {
+                next = ext_count + grain;
+            }
+
+            uint64_t size = piece - offset;
+            if (j + 1 == layout->logicals && layout->corruption == IMG_CORRUPT_OUTSIDE)
+            {
+                size = writer->last_lba + grain - (ext_start + (uint64_t)j * piece + offset);
+            }
+
+            fill_mbr_entry(&links[0], 0x00, partition_types[(layout->primaries + j) % PARTITION_TYPE_COUNT].mbr_type,
+                           offset, size);
+            if (next != 0)
+            {
+                fill_mbr_entry(&links[1], 0x00, CHS_EXTENDED_PARTITION, next, piece);
+            }
+            ebr[510] = 0x55;
+            ebr[511] = 0xAA;
+            if (write_region(writer, (ext_start + (uint64_t)j * piece) * sector_size, ebr, SECTOR_SIZE) != 0)
+            {
+                perror("Failed to write EBR");
+                return -1;
+            }
+        }
+    }
+
+    mbr[510] = 0x55;
+    mbr[511] = 0xAA;
+    if (write_region(writer, 0, mbr, SECTOR_SIZE) != 0)
+    {
+        perror("Failed to write MBR");
+        return -1;
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Writes a GPT: protective (or hybrid) MBR, primary header and entry array, backup entry
+ * array and header.
+ *
+ * The space between the first aligned LBA and LastUsableLBA is split evenly between the
+ * partitions. Corruptions that keep the tables consistent (overlap, outside) are applied
+ * to the entries before the checksums are computed; the others after.
+ *
+ * @return 0 on success, or -1 on error (a message is printed).
+ */
+static int write_gpt(IMG_Writer *writer)
+{
+    const IMG_Layout *layout = writer->layout;
+    uint32_t sector_size = layout->sector_size;
+    uint64_t grain = IMG_GRAIN / sector_size;
+    size_t array_size = (size_t)layout->entries * layout->entry_size;
+    uint64_t array_sectors = (array_size + sector_size - 1) / sector_size;
+    uint64_t first_usable = GPT_HEADER_LBA + 1 + array_sectors;
+    uint64_t last_usable = writer->last_lba - 1 - array_sectors;
+
+    if (writer->last_lba < 2 * (array_sectors + 2))
+    {
+        fprintf(stderr, "Image too small for %u GPT entries\n", layout->entries);
+        return -1;
+    }
+
+    uint64_t first = ((first_usable + grain - 1) / grain) * grain;
+    uint64_t share = (last_usable >= first && layout->partitions) ? (last_usable + 1 - first) / layout->partitions : 0;
+    if (share >= grain)
+    {
+        share = round_down(share, grain);
+    }
+    if (layout->partitions != 0 && share == 0)
+    {
+        fprintf(stderr, "Image too small for %u partitions\n", layout->partitions);
+        return -1;
+    }
+
+    char *array = calloc(1, (size_t)array_sectors * sector_size);
+    if (array == NULL)
+    {
+        perror("Failed to allocate the GPT entry array");
+        return -1;
+    }
+
+    // Entry array
+    for (unsigned int i = 0; i < layout->partitions; i++)
+    {
+        GPT_PartitionEntry *entry = (GPT_PartitionEntry *)(array + (size_t)i * layout->entry_size);
+        uint64_t start = first + (uint64_t)i * share;
+        uint64_t end = start + share - 1;
+        char name[16];
+
+        if (i == 1 && layout->corruption == IMG_CORRUPT_OVERLAP)
+        {
+            start -= share / 2;
+        }
+        if (i + 1 == layout->partitions && layout->corruption == IMG_CORRUPT_OUTSIDE)
+        {
+            end = writer->last_lba + grain;
+        }
+
+        convert_string_to_guid(partition_types[i % PARTITION_TYPE_COUNT].guid, entry->type_guid);
+        random_guid(&writer->random, entry->partition_guid);
+        entry->starting_lba = start;
+        entry->ending_lba = end;
+        int length = snprintf(name, sizeof(name), "part%u", i + 1);
+        for (int c = 0; c < length; c++)
+        {
+            entry->partition_name[c] = (uint16_t)name[c];  // ASCII in UTF-16LE
+        }
+    }
+
+    // Headers
+    GPT_Header header;
+    memset(&header, 0, sizeof(header));
+    header.signature = GPT_HEADER_SIGNATURE;
+    header.revision = IMG_GPT_REVISION;
+    header.header_size = GPT_HEADER_MIN_SIZE;
+    header.my_lba = GPT_HEADER_LBA;
+    header.alternate_lba = writer->last_lba;
+    header.first_usable_lba = first_usable;
+    header.last_usable_lba = last_usable;
+    random_guid(&writer->random, header.disk_guid);
+    header.partition_entry_lba = GPT_HEADER_LBA + 1;
+    header.num_partition_entries = layout->entries;
+    header.size_of_partition_entry = layout->entry_size;
+    header.partition_entry_array_crc32 = CRC32_compute(array, array_size);
+    header.header_crc32 = CRC32_compute(&header, header.header_size);
+
+    GPT_Header backup = header;
+    backup.my_lba = writer->last_lba;
+    backup.alternate_lba = GPT_HEADER_LBA;
+    backup.partition_entry_lba = writer->last_lba - array_sectors;
+    backup.header_crc32 = 0;
+    backup.header_crc32 = CRC32_compute(&backup, backup.header_size);
+
+    int status = 0;
+    if (write_region(writer, backup.partition_entry_lba * sector_size, array, (size_t)array_sectors * sector_size) != 0 ||
+        write_region(writer, backup.my_lba * sector_size, &backup, sizeof(backup)) != 0)
+    {
+        status = -1;
+    }
+
+    // Damage the primary copy only: the backup stays intact for recovery
+    if (layout->corruption == IMG_CORRUPT_HEADER_CRC)
+    {
+        header.disk_guid[0] ^= 0xFF;
+    }
+    if (layout->corruption == IMG_CORRUPT_ENTRIES_CRC)
+    {
+        array[0] ^= 0xFF;
+    }
+    if (status == 0 && layout->corruption != IMG_CORRUPT_NO_PRIMARY &&
+        (write_region(writer, GPT_HEADER_LBA * sector_size, &header, sizeof(header)) != 0 ||
+         write_region(writer, header.partition_entry_lba * sector_size, array, (size_t)array_sectors * sector_size) != 0))
+    {
+        status = -1;
+    }
+    if (status == 0 && layout->corruption == IMG_CORRUPT_NO_BACKUP)
+    {
+        static const GPT_Header zero;
+        status = (pwrite(writer->fd, &zero, sizeof(zero), (off_t)(backup.my_lba * sector_size)) == (ssize_t)sizeof(zero)) ? 0 : -1;
+    }
+
+    // Protective MBR covering the whole disk, or hybrid MBR mirroring the first partitions
+    uint8_t mbr[SECTOR_SIZE] = { 0 };
+    MBR_PartitionEntry *table = (MBR_PartitionEntry *)(mbr + 446);
+    uint64_t limit = (writer->last_lba > UINT32_MAX) ? UINT32_MAX : writer->last_lba;
+    if (layout->label == IMG_LABEL_HYBRID && layout->partitions != 0)
+    {
+        fill_mbr_entry(&table[0], 0x00, GPT_SIGNATURE, GPT_HEADER_LBA, first - GPT_HEADER_LBA);
+        for (unsigned int i = 0; i < layout->partitions && i < MBR_PARTITIONS_NUM - 1; i++)
+        {
+            const GPT_PartitionEntry *entry = (const GPT_PartitionEntry *)(array + (size_t)i * layout->entry_size);
+            if (entry->ending_lba <= limit)
+            {
+                fill_mbr_entry(&table[i + 1], 0x00, partition_types[i % PARTITION_TYPE_COUNT].mbr_type,
+                               entry->starting_lba, entry->ending_lba - entry->starting_lba + 1);
+            }
+        }
+    }
+    else
+    {
+        fill_mbr_entry(&table[0], 0x00, GPT_SIGNATURE, GPT_HEADER_LBA, limit);
+    }
+    mbr[510] = 0x55;
+    mbr[511] = 0xAA;
+    if (status == 0 && write_region(writer, 0, mbr, SECTOR_SIZE) != 0)
+    {
+        status = -1;
+    }
+
+    if (status != 0)
+    {
+        perror("Failed to write the GPT");
+    }
+    free(array);
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Generates one image.
+ *
+ * This function performs the following tasks:
+ * 1. Creates the image and sets its size with `ftruncate` (a sparse file).
+ * 2. Writes the MBR or GPT structures of the layout.
+ * 3. Applies the corruptions that are not part of the table construction (missing
+ *    signature, truncation, fuzzing).
+ *
+ * @param path: Path of the image to create (overwritten if it exists).
+ * @param layout: The layout to write.
+ * @param seed: Seed of the GUIDs and of the fuzzing.
+ *
+ * @return 0 on success, or -1 on error (a message is printed).
+ */
+static int generate_image(const char *path, const IMG_Layout *layout, uint64_t seed)
+{
+    IMG_Writer writer = { 0 };
+    writer.layout = layout;
+    writer.last_lba = layout->size / layout->sector_size - 1;
+    writer.random = seed;
+
+    writer.fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (writer.fd < 0)
+    {
+        fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int status = (ftruncate(writer.fd, (off_t)layout->size) == 0) ? 0 : -1;
+    if (status != 0)
+    {
+        fprintf(stderr, "Failed to size %s: %s\n", path, strerror(errno));
+    }
+    if (status == 0)
+    {
+        status = (layout->label == IMG_LABEL_MBR) ? write_mbr(&writer) : write_gpt(&writer);
+    }
+
+    if (status == 0)
+    {
+        static const uint8_t zero[2] = { 0 };
+        int damaged = 0;
+        switch (layout->corruption)
+        {
+            case IMG_CORRUPT_NO_SIGNATURE: damaged = (pwrite(writer.fd, zero, sizeof(zero), 510) == (ssize_t)sizeof(zero)) ? 0 : -1; break;
+            case IMG_CORRUPT_FUZZ:         damaged = fuzz_regions(&writer);                                                       break;
+            case IMG_CORRUPT_TRUNCATED:    damaged = ftruncate(writer.fd, (off_t)(layout->size / 2));                              break;
+            default:                                                                                                              break;
+        }
+        if (damaged != 0)
+        {
+            fprintf(stderr, "Failed to corrupt %s: %s\n", path, strerror(errno));
+            status = -1;
+        }
+    }
+
+    free(writer.regions);
+    close(writer.fd);
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Checks that a corruption applies to a layout.
+ *
+ * @return 1 if the corruption can be applied, 0 otherwise.
+ */
+static int corruption_applies(const IMG_Layout *layout, IMG_Corruption corruption)
+{
+    int gpt = (layout->label != IMG_LABEL_MBR);
+    unsigned int partitions = gpt ? layout->partitions : layout->primaries + (layout->logicals != 0);
+
+    switch (corruption)
+    {
+        case IMG_CORRUPT_OVERLAP:      return partitions >= 2;
+        case IMG_CORRUPT_OUTSIDE:      return partitions >= 1;
+        case IMG_CORRUPT_EBR_LOOP:     return !gpt && layout->logicals >= 2;
+        case IMG_CORRUPT_EBR_OUTSIDE:  return !gpt && layout->logicals >= 1;
+        case IMG_CORRUPT_HEADER_CRC:
+        case IMG_CORRUPT_ENTRIES_CRC:
+        case IMG_CORRUPT_NO_PRIMARY:
+        case IMG_CORRUPT_NO_BACKUP:    return gpt;
+        default:                       return 1;
+    }
+}
+
+
+
+
+
+
+/**
+ * Draws the layout of one image of a mixed corpus (-m).
+ *
+ * The table type and sector size are drawn at random, the partition counts between 1
+ * and the requested values, and one image in four gets a random applicable corruption.
+ * MBR images always use 512-byte sectors: without a GPT header, myfdisk only recognises
+ * a 4Kn MBR by its EBR chain, and the corpus must parse without `--sector-size`.
+ *
+ * @param base: The layout given on the command line (maximum counts).
+ * @param state: Pseudo-random generator state.
+ * @param layout: Receives the drawn layout.
+ */
+static void draw_layout(const IMG_Layout *base, uint64_t *state, IMG_Layout *layout)
+{
+    *layout = *base;
+    layout->label = (IMG_Label)(next_random(state) % 3);
+    uint32_t sector_size = (next_random(state) % 2) ? 4096 : 512;
+    layout->sector_size = (layout->label == IMG_LABEL_MBR) ? 512 : sector_size;
+    layout->logicals = base->logicals ? (unsigned int)(next_random(state) % (base->logicals + 1)) : 0;
+    layout->primaries = 1 + (unsigned int)(next_random(state) % (layout->logicals ? 3 : 4));
+    layout->partitions = 1 + (unsigned int)(next_random(state) % base->partitions);
+
+    layout->corruption = IMG_CORRUPT_NONE;
+    if (next_random(state) % 4 == 0)
+    {
+        IMG_Corruption corruption = (IMG_Corruption)(1 + next_random(state) % (CORRUPTION_COUNT - 1));
+        if (corruption_applies(layout, corruption))
+        {
+            layout->corruption = corruption;
+        }
+    }
+}
+
+
+
+
+
+
+/**
+ * Parses a size in bytes with an optional K/M/G/T suffix (powers of 1024).
+ *
+ * @return 0 on success, or -1 if the text is not a size.
+ */
+static int parse_size(const char *text, uint64_t *size)
+{
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 0);
+    if (errno != 0 || end == text)
+    {
+        return -1;
+    }
+
+    int shift = 0;
+    switch (*end)
+    {
+        case 'K': case 'k': shift = 10; end++; break;
+        case 'M': case 'm': shift = 20; end++; break;
+        case 'G': case 'g': shift = 30; end++; break;
+        case 'T': case 't': shift = 40; end++; break;
+        default: break;
+    }
+    if (*end != '\0' || (value << shift) >> shift != value)
+    {
+        return -1;
+    }
+
+    *size = (uint64_t)value << shift;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Prints the command-line usage.
+ *
+ * @param program The program name (argv[0]).
+ */
+static void print_usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [-t mbr|gpt|hybrid] [-b sector_size] [-s size] [-p primaries] [-l logicals]\n"
+                    "          [-n partitions] [-e entries] [-E entry_size] [-c corruption] [-r seed] <image>\n"
+                    "       %s -N count [-m] [options] <directory>\n"
+                    "  -t, --label type         partition table: mbr, gpt (default) or hybrid (GPT with a hybrid MBR)\n"
+                    "  -b, --sector-size bytes  logical sector size, 512 (default) or 4096\n"
+                    "  -s, --size bytes         image size, with a K/M/G/T suffix (default 1G); images are sparse\n"
+                    "  -p, --primaries count    MBR primary partitions (default 4, or 3 with logical partitions)\n"
+                    "  -l, --logicals count     MBR logical partitions, i.e. the length of the EBR chain (default 0)\n"
+                    "  -n, --partitions count   GPT partitions (default 4)\n"
+                    "  -e, --entries count      GPT entry array length (default 128)\n"
+                    "  -E, --entry-size bytes   GPT entry size, 128 * 2^n (default 128)\n"
+                    "  -c, --corrupt type       damage the image: no-signature, overlap, outside, truncated, fuzz,\n"
+                    "                           ebr-loop, ebr-outside (MBR), header-crc, entries-crc, no-primary,\n"
+                    "                           no-backup (GPT)\n"
+                    "  -r, --seed value         seed of the GUIDs and of the fuzzing (default 1)\n"
+                    "  -N, --count count        generate count images into a directory (disk00000.img, ...)\n"
+                    "  -m, --mix                with -N, draw the table type, sector size, partition counts (up to\n"
+                    "                           the given ones) and corruption of every image\n",
+            program, program);
+}
+
+
+
+
+
+
+/*============================================================================
+ ******************************  Main Code  **********************************
+ ============================================================================*/
+/**
+ * Main function of the image generator.
+ *
+ * This function performs the following tasks:
+ * 1. Parses and validates the layout options.
+ * 2. Without -N, writes one image. With -N, writes `count` images into a directory,
+ *    each with its own seed (`seed + index`), and with -m its own drawn layout.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ *
+ * @return 0 if every image was written, 1 if an error occurs.
+ */
+int main(int argc, char **argv)
+{
+    IMG_Layout layout = { IMG_LABEL_GPT, BLK_DEFAULT_SECTOR_SIZE, IMG_DEFAULT_SIZE, 0, 0, 4, 128, GPT_ENTRY_SIZE, IMG_CORRUPT_NONE };
+    int primaries_set = 0, mix = 0;
+    unsigned long count = 0;
+    uint64_t seed = 1;
+    int opt;
+
+    static const struct option long_options[] =
+    {
+        { "label",       required_argument, NULL, 't' },
+        { "sector-size", required_argument, NULL, 'b' },
+        { "size",        required_argument, NULL, 's' },
+        { "primaries",   required_argument, NULL, 'p' },
+        { "logicals",    required_argument, NULL, 'l' },
+        { "partitions",  required_argument, NULL, 'n' },
+        { "entries",     required_argument, NULL, 'e' },
+        { "entry-size",  required_argument, NULL, 'E' },
+        { "corrupt",     required_argument, NULL, 'c' },
+        { "seed",        required_argument, NULL, 'r' },
+        { "count",       required_argument, NULL, 'N' },
+        { "mix",         no_argument,       NULL, 'm' },
+        { NULL,          0,                 NULL, 0   }
+    };
+
+    /* Parse command-line options */
+    while ((opt = getopt_long(argc, argv, "t:b:s:p:l:n:e:E:c:r:N:m", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                if (strcmp(optarg, "mbr") == 0)         layout.label = IMG_LABEL_MBR;
+                else if (strcmp(optarg, "gpt") == 0)    layout.label = IMG_LABEL_GPT;
+                else if (strcmp(optarg, "hybrid") == 0) layout.label = IMG_LABEL_HYBRID;
+                else { fprintf(stderr, "Unknown partition table type: %s\n", optarg); return 1; }
+                break;
+            case 'b': layout.sector_size = (uint32_t)strtoul(optarg, NULL, 0);                break;
+            case 's':
+                if (parse_size(optarg, &layout.size) != 0)
+                {
+                    fprintf(stderr, "Invalid size: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'p': layout.primaries = (unsigned int)strtoul(optarg, NULL, 0); primaries_set = 1; break;
+            case 'l': layout.logicals = (unsigned int)strtoul(optarg, NULL, 0);                break;
+            case 'n': layout.partitions = (unsigned int)strtoul(optarg, NULL, 0);              break;
+            case 'e': layout.entries = (unsigned int)strtoul(optarg, NULL, 0);                 break;
+            case 'E': layout.entry_size = (unsigned int)strtoul(optarg, NULL, 0);              break;
+            case 'r': seed = strtoull(optarg, NULL, 0);                                         break;
+            case 'N': count = strtoul(optarg, NULL, 0);                                         break;
+            case 'm': mix = 1;                                                                  break;
+            case 'c':
+            {
+                size_t i = 0;
+                while (i < CORRUPTION_COUNT && strcmp(optarg, corruption_names[i]) != 0)
+                {
+                    i++;
+                }
+                if (i == CORRUPTION_COUNT)
+                {
+                    fprintf(stderr, "Unknown corruption: %s\n", optarg);
+                    return 1;
+                }
+                layout.corruption = (IMG_Corruption)i;
+                break;
+            }
+            default:  print_usage(argv[0]);                                                     return 1;
+        }
+    }
+
+    if (argc - optind != 1 || (mix && count == 0))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (!primaries_set)
+    {
+        layout.primaries = layout.logicals ? MBR_PARTITIONS_NUM - 1 : MBR_PARTITIONS_NUM;
+    }
+
+    /* Validate the layout */
+    if (layout.sector_size != 512 && layout.sector_size != 4096)
+    {
+        fprintf(stderr, "Sector size must be 512 or 4096\n");
+        return 1;
+    }
+    if (layout.primaries + (layout.logicals != 0) > MBR_PARTITIONS_NUM)
+    {
+        fprintf(stderr, "An MBR holds %d primary partitions, including the extended partition\n", MBR_PARTITIONS_NUM);
+        return 1;
+    }
+    if (layout.entry_size < GPT_ENTRY_SIZE || (layout.entry_size & (layout.entry_size - 1)) != 0 ||
+        layout.entries < layout.partitions || (uint64_t)layout.entries * layout.entry_size > GPT_MAX_ENTRY_ARRAY_SIZE)
+    {
+        fprintf(stderr, "Invalid GPT entry array: %u entries of %u bytes for %u partitions\n",
+                layout.entries, layout.entry_size, layout.partitions);
+        return 1;
+    }
+    if (layout.size < 4 * IMG_GRAIN)
+    {
+        fprintf(stderr, "Image too small: at least %d MiB\n", 4 * IMG_GRAIN / (1024 * 1024));
+        return 1;
+    }
+    if (mix && layout.partitions == 0)
+    {
+        fprintf(stderr, "A mixed corpus needs at least one GPT partition\n");
+        return 1;
+    }
+    if (!mix && !corruption_applies(&layout, layout.corruption))
+    {
+        fprintf(stderr, "Corruption %s does not apply to this layout\n", corruption_names[layout.corruption]);
+        return 1;
+    }
+
+    if (!mix && layout.label == IMG_LABEL_MBR && layout.sector_size == 4096 && layout.logicals == 0)
+    {
+        fprintf(stderr, "Note: a 4Kn MBR image without logical partitions is read with 512-byte sectors "
+                        "unless myfdisk is given --sector-size 4096\n");
+    }
+
+    /* One image */
+    if (count == 0)
+    {
+        return (generate_image(argv[optind], &layout, seed) == 0) ? 0 : 1;
+    }
+
+    /* A corpus of images in a directory */
+    if (mkdir(argv[optind], 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Failed to create %s: %s\n", argv[optind], strerror(errno));
+        return 1;
+    }
+    uint64_t state = seed;
+    for (unsigned long i = 0; i < count; i++)
+    {
+        char path[PATH_MAX];
+        IMG_Layout image = layout;
+        if (mix)
+        {
+            draw_layout(&layout, &state, &image);
+        }
+        snprintf(path, sizeof(path), IMG_NAME_FORMAT, argv[optind], i);
+        if (generate_image(path, &image, seed + i) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
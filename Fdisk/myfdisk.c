@@ -18,7 +18,69 @@
  ============================================================================*/ 
 #include "MBR_Parsing.h" // Includes the custom header file for MBR parsing functionalities (e.g., data structures, function declarations for handling MBR)
 #include "GPT_Parsing.h" // Includes the custom header file for GPT parsing functionalities (e.g., data structures, function declarations for handling GPT)
+#include "GPT_Backup.h"  // Includes the primary/backup GPT verification and repair
+#include "Partition_Parse.h" // Includes the allocation-free partition table parser (libpartparse)
+#include "Partition_Script.h" // Includes the sfdisk-like script-driven partitioning
+#include "FS_Probe.h"    // Includes the filesystem and volume signature probing
+#include "Alignment.h"   // Includes the partition alignment analysis
+#include "Free_Space.h"  // Includes the free-space map (gaps and overlaps)
+#include "Read_Bench.h"  // Includes the per-partition read throughput benchmark
+#include "Content_Scan.h" // Includes the one-pass partition content scan
+#include "Device_Scan.h" // Includes the parallel multi-device scan (thread pool, sysfs enumeration)
 #include <sys/types.h>   // Defines data types used in system calls (e.g., ssize_t, off_t)
+#include <getopt.h>      // Provides getopt_long for command-line option parsing
+#include <errno.h>       // Provides errno for error reporting
+#include <time.h>        // Provides clock_gettime, used by --stats
+#include <limits.h>      // Provides UINT_MAX, used to check -j
+
+
+
+
+
+/*============================================================================
+ **********************  Global Variables Decleration  ***********************
+ ============================================================================*/
+/**
+ * Options selected on the command line, shared by every device probe.
+ *
+ * Fields:
+ *
+ * @param open_flags: `BLK_FLAG_*` values passed to `BLK_open` (e.g., O_DIRECT).
+ * @param repair: Rewrite a damaged or mismatching GPT copy from the intact one.
+ * @param script: Partition layout written to every device (--script), or NULL.
+ * @param probe_filesystems: Probe every partition for a filesystem signature (-p).
+ * @param check_alignment: Check every partition against the device geometry (-a).
+ * @param free_space: Print the unpartitioned space and overlapping partitions (-F).
+ * @param bench: Measure the read throughput and IOPS of every partition (--bench).
+ * @param scan: Read every partition once for zeros, entropy and digest (--scan).
+ * @param geometry_override: Geometry values given on the command line (0 = detect).
+ */
+static struct {
+    int open_flags;                 /**< Flags used to open every device. */
+    int repair;                     /**< Repair the GPT (--repair). */
+    int probe_filesystems;          /**< Print filesystems (--probe). */
+    int check_alignment;            /**< Print the alignment report (--align). */
+    int free_space;                 /**< Print the free-space map (--free). */
+    int bench;                      /**< Run the read benchmark (--bench). */
+    int scan;                       /**< Run the content scan (--scan). */
+    ALIGN_Geometry geometry_override; /**< Overrides of the detected geometry. */
+    const SCRIPT_Layout *script;    /**< Layout to write, or NULL. */
+} options;
+
+/**
+ * Value returned by getopt_long for options that only have a long form.
+ */
+enum {
+    OPTION_REPAIR = 256,        /**< --repair */
+    OPTION_PHYSICAL_SIZE,       /**< --physical-size */
+    OPTION_MIN_IO,              /**< --min-io */
+    OPTION_OPTIMAL_IO,          /**< --optimal-io */
+    OPTION_ALIGNMENT_OFFSET,    /**< --alignment-offset */
+    OPTION_STATS,               /**< --stats */
+    OPTION_BENCH,               /**< --bench */
+    OPTION_SCAN,                /**< --scan */
+    OPTION_SECTOR_SIZE          /**< --sector-size */
+};
 
 
 
@@ -31,43 +93,37 @@
  ******************************  Functions  **********************************
  ============================================================================*/
 /**
- * Initializes the device file and reads the first sector into a buffer.
+ * Initializes the device file and its sector cache.
  *
  * This function performs the following tasks:
- * 1. Opens the specified device file for reading.
- * 2. Checks if the file descriptor is valid. If not, prints an error message and returns an error code.
- * 3. Reads the specified amount of data from the device file into the provided buffer.
- * 4. Verifies that the read operation was successful. If not, prints an error message, closes the file descriptor, and returns an error code.
- * 5. Returns the file descriptor if the operations are successful.
+ * 1. Opens the specified device file for reading through the block I/O layer, which 
+ *    determines the logical/physical sector size (and uses O_DIRECT if requested).
+ * 2. Checks if the device could be opened. If not, prints an error message and returns an error code.
+ * 3. Sets up the sector cache of the device, through which the partition tables are read.
+ * 4. Returns 0 if the operations are successful.
  *
  * @param device The path to the device file to be opened.
- * @param buf Pointer to a buffer where the read data will be stored.
- * @param buf_size The size of the buffer to read from the device file.
+ * @param dev Pointer to the structure that receives the opened device.
+ * @param cache Pointer to the sector cache to set up for the device (see `CACHE_free`).
+ * @param flags Combination of `BLK_FLAG_*` values (e.g., `BLK_FLAG_DIRECT`).
  * 
- * @return The file descriptor of the opened device file on success, or -1 if an error occurs.
+ * @return 0 on success, or -1 if an error occurs.
  */
-int initialize_device(const char *device, char *buf, size_t buf_size) 
+int initialize_device(const char *device, BLK_Device *dev, CACHE_Cache *cache, int flags)  
 {
     // Open the device file for reading
-    int fd = open(device, O_RDONLY);
-    if (fd < 0) 
+    if (BLK_open(dev, device, flags) != 0) 
     {
         // Print error message if the file cannot be opened
-        perror("Failed to open device");
+        fprintf(stderr, "Failed to open device %s: %s\n", device, strerror(errno));
         return -1; // Return an error code indicating failure
     }
 
-    // Read the specified amount of data from the device file into the buffer
-    if (read(fd, buf, buf_size) != buf_size) 
-    {
-        // Print error message if the read operation fails
-        perror("Failed to read sector");
-        close(fd); // Close the file descriptor
-        return -1; // Return an error code indicating failure
-    }
+    // Set up the sector cache the partition tables are read through
+    CACHE_init(cache, dev);
 
-    // Return the file descriptor if the operations are successful
-    return fd;
+    // Return success if the operations are successful
+    return 0;
 }
 
 
@@ -87,14 +143,18 @@ int initialize_device(const char *device, char *buf, size_t buf_size)
  * 5. Sectors: The total number of sectors in the partition.
  * 6. Size(MB): The size of the partition in megabytes.
  * 7. Type: The type of the partition, as identified by the GUID.
+ * 8. Name: The partition name, decoded from UTF-16LE.
+ * 9. Attributes: The decoded attribute bits (see `GPT_format_attributes`).
  *
  * The header is printed in a tabular format, with each column having a fixed width for alignment.
+ *
+ * @param out: The stream the header is printed to.
  */
-void print_gpt_header_info() 
+void print_gpt_header_info(FILE *out) 
 {
     // Print the GPT header information with fixed column widths
-    printf("%-16s%-6s %-10s %-10s %-10s %-10s %-36s\n",
-           "Device", "Index", "Start", "End", "Sectors", "Size(MB)", "Type");
+    fprintf(out, "%-16s%-6s %-10s %-10s %-10s %-10s %-36s %-*s %s\n",
+           "Device", "Index", "Start", "End", "Sectors", "Size(MB)", "Type", GPT_NAME_COLUMN_WIDTH, "Name", "Attributes");
 }
 
 
@@ -103,40 +163,23 @@ void print_gpt_header_info()
 
 
 /**
- * Reads the GPT (GUID Partition Table) header from a device.
- *
- * This function seeks to the location of the GPT header on the device and reads
- * the GPT header into the provided buffer. The function performs the following
- * operations:
- * 1. Seeks to the GPT header location using `lseek`.
- * 2. Reads the GPT header data from the device into the buffer using `read`.
+ * Prints the GPT (GUID Partition Table) partitions of a parsed table.
  *
- * If any operation fails, an error message is printed, and the function returns
- * a non-zero error code. On success, the function returns 0.
+ * The descriptors were filled by `PARSE_read_table` from the GPT copy that can be
+ * trusted; each one is printed using the `GPT_print_partition_info` function.
  *
- * @param fd: The file descriptor of the device from which to read the GPT header.
- * @param buf: Pointer to a buffer where the GPT header data will be stored. 
- *             The buffer must be at least `SECTOR_SIZE` bytes in size.
+ * @param out: The stream the partition information is printed to.
+ * @param device: The name of the device, used for printing the partition information.
+ * @param table: The parsed partition table.
  *
- * @return 0 on success, or -1 if an error occurs during seeking or reading.
+ * @return void
  */
-int read_gpt_header(int fd, char *buf) 
+void print_gpt_entries(FILE *out, const char *device, const PARSE_Table *table) 
 {
-    // Seek to the GPT header location (LBA 1) on the device
-    if (lseek(fd, GPT_HEADER_LBA * SECTOR_SIZE, SEEK_SET) == (off_t)-1) // Casting with same return type of lseek
+    for (size_t i = 0; i < table->count; i++) 
     {
-        perror("Failed to seek to GPT header");
-        return -1; // Return an error code indicating failure to seek
+        GPT_print_partition_info(out, device, &table->partitions[i], table->sector_size);
     }
-
-    // Read the GPT header data into the buffer
-    if (read(fd, buf, SECTOR_SIZE) != SECTOR_SIZE) 
-    {
-        perror("Failed to read GPT header");
-        return -1; // Return an error code indicating failure to read
-    }
-
-    return 0; // Return success code if seeking and reading were successful
 }
 
 
@@ -144,54 +187,49 @@ int read_gpt_header(int fd, char *buf)
 
 
 
-
-
 /**
- * Reads GPT (GUID Partition Table) partition entries from a device and prints them.
+ * Reports the integrity problems of a GPT and optionally repairs them.
  *
- * This function iterates through all GPT partition entries, reads each entry
- * from the device, and prints the partition information using the `GPT_print_partition_info` function.
- * The function performs the following operations:
- * 1. Iterates through the number of GPT entries defined by `GPT_ENTRIES_NUM`.
- * 2. Seeks to the location of each GPT entry using `lseek`.
- * 3. Reads the GPT entry data from the device into a local `GPT_PartitionEntry` structure.
- * 4. Prints the partition information.
+ * `PARSE_read_table` only flags that a copy is damaged or that the copies disagree; this
+ * function loads both copies in full to explain what is wrong, and rewrites the damaged
+ * copy from the intact one if `--repair` was given.
  *
- * If any operation fails, an error message is printed, and the function stops processing further entries.
+ * This function performs the following tasks:
+ * 1. Loads the primary GPT (header at LBA 1 and its entry array).
+ * 2. Loads the backup GPT from the primary's AlternateLBA, or from the last LBA of the 
+ *    device if the primary header is unusable.
+ * 3. Reports CRC32 failures and primary/backup mismatches.
+ * 4. If `--repair` was given, rewrites the damaged copy from the intact one.
  *
- * @param fd: The file descriptor of the device from which to read the GPT partition entries.
- * @param device: The name of the device, used for printing the partition information.
+ * @param out: The stream the report is printed to.
+ * @param cache: The sector cache of the opened device.
  *
- * @return void
+ * @return 0 on success, or -1 if the repair failed.
  */
-void read_and_print_gpt_entries(int fd, const char *device) 
+int check_gpt(FILE *out, CACHE_Cache *cache)
 {
-    GPT_PartitionEntry entry;
-    int partition_index = 1;
+    BLK_Device *dev = cache->dev;
+    GPT_Copy primary, backup;
+    uint64_t last_lba = dev->size_bytes / dev->logical_sector_size - 1;
 
-    // Iterate through all GPT partition entries
-    for (int i = 0; i < GPT_ENTRIES_NUM; i++) 
-    {
-        // Calculate the offset for the current GPT entry
-        off_t offset = (u_int64_t)(GPT_ENTRY_ARRAY_LBA * SECTOR_SIZE) + (u_int64_t)(i * GPT_ENTRY_SIZE);
-        
-        // Seek to the GPT entry location
-        if (lseek(fd, offset, SEEK_SET) == (off_t)-1) 
-        {
-            perror("Failed to seek to GPT entry");
-            return; // Stop processing if seeking fails
-        }
+    /* Load both copies of the GPT */
+    GPT_load_copy(cache, GPT_HEADER_LBA, &primary);
+    GPT_load_copy(cache, primary.header_valid ? primary.header.alternate_lba : last_lba, &backup);
 
-        // Read the GPT entry data into the entry structure
-        if (read(fd, &entry, GPT_ENTRY_SIZE) != GPT_ENTRY_SIZE) 
+    /* Report integrity problems and repair them if requested */
+    int status = 0;
+    if (GPT_report_integrity(out, dev, &primary, &backup) != 0 && options.repair) 
+    {
+        if (GPT_repair(out, dev, &primary, &backup) != 0)
         {
-            perror("Failed to read GPT entry");
-            return; // Stop processing if reading fails
+            status = -1;
         }
-
-        // Print the partition information for the current entry
-        GPT_print_partition_info(device, partition_index++, &entry);
+        CACHE_invalidate(cache); // The cached sectors may have been rewritten
     }
+
+    GPT_free_copy(&primary);
+    GPT_free_copy(&backup);
+    return status;
 }
 
 
@@ -215,12 +253,13 @@ void read_and_print_gpt_entries(int fd, const char *device)
  * - Id: The partition ID or type code.
  * - Type: The partition type as a descriptive string.
  *
+ * @param out: The stream the header is printed to.
  *
  * @return void
  */
-void print_mbr_header_info() 
+void print_mbr_header_info(FILE *out) 
 {
-    printf("%-20s%-6s %-6s %-10s %-10s %-10s %-10s %-6s %-6s\n",
+    fprintf(out, "%-20s%-6s %-6s %-10s %-10s %-10s %-10s %-6s %-6s\n",
            "Device", "Index", "Boot", "Start", "End", "Sectors", "Size(MB)", "Id", "Type");
 }
 
@@ -229,21 +268,44 @@ void print_mbr_header_info()
 
 
 /**
- * Reads the MBR partition entries from a buffer and sets a pointer to the partition entries.
+ * Prints the MBR partitions of a parsed table and the problems of its EBR chains.
  *
- * This function extracts the MBR partition entries from the provided buffer and sets the `table_entry_ptr` 
- * to point to the start of the partition entries within the buffer.
- * 
+ * The descriptors were filled by `PARSE_read_table` in table order: every primary
+ * partition, each extended partition followed by the logical partitions of its EBR chain.
+ * Logical partitions extending beyond their extended partition, and an EBR chain that had
+ * to be cut (bad link, loop, unreadable EBR), are reported on stderr.
  *
- * @param buf Pointer to the buffer containing the MBR data.
- * @param table_entry_ptr Pointer to a pointer where the address of the partition entries will be stored.
+ * @param out Stream the partition information is printed to.
+ * @param device Name of the device to be printed in the partition information.
+ * @param table The parsed partition table.
  * 
- * @return int Returns 0 on success. No errors are expected in this function.
+ * @return void
  */
-int read_mbr_partition_entries(const char *buf, MBR_PartitionEntry **table_entry_ptr) 
+void print_mbr_partitions(FILE *out, const char *device, const PARSE_Table *table)  
 {
-    *table_entry_ptr = (MBR_PartitionEntry *)&buf[446];
-    return 0; // Success
+    for (size_t i = 0; i < table->count; i++) 
+    {
+        const PARSE_Partition *partition = &table->partitions[i];
+        MBR_print_partition_info(out, device, partition, table->sector_size);
+        if (partition->flags & PARSE_FLAG_OUTSIDE_EXTENDED)
+        {
+            fprintf(stderr, "Logical partition %d of %s extends beyond the extended partition\n", partition->index, device);
+        }
+    }
+
+    if (table->problems & PARSE_PROBLEM_EBR_OUTSIDE)
+    {
+        fprintf(stderr, "EBR chain of %s points outside the extended partition (LBA %" PRIu64 "), stopping\n",
+                device, table->ebr_lba);
+    }
+    else if (table->problems & PARSE_PROBLEM_EBR_LOOP)
+    {
+        fprintf(stderr, "EBR chain of %s loops back to LBA %" PRIu64 ", stopping\n", device, table->ebr_lba);
+    }
+    else if (table->problems & PARSE_PROBLEM_EBR_READ)
+    {
+        fprintf(stderr, "Error reading EBR of %s at LBA %" PRIu64 ", stopping\n", device, table->ebr_lba);
+    }
 }
 
 
@@ -253,40 +315,287 @@ int read_mbr_partition_entries(const char *buf, MBR_PartitionEntry **table_entry
 
 
 /**
- * Processes and prints information about MBR partitions and handles extended partitions.
+ * Prints the filesystem or volume found inside every partition.
  *
- * This function iterates through the MBR partition entries, prints information for each valid partition, 
- * and processes any extended partitions to handle logical partitions within them.
- * 
- * The function starts by printing the MBR partition information, then checks for extended partitions. 
- * If an extended partition is detected, it parses and prints logical partitions contained within that extended partition.
+ * Each partition is probed with `FS_probe`, which fetches the few kilobytes holding all 
+ * known signatures with at most two reads. Extended partitions are containers and are skipped,
+ * and so are reversed GPT entries, which occupy no space.
+ * The columns are:
+ * - Device: The device name.
+ * - Index: The partition index, as in the partition table above.
+ * - Filesystem: The type as reported by blkid (e.g., ext4, vfat, LVM2_member), or "-".
+ * - Label: The volume label.
+ * - UUID: The volume UUID (serial number for FAT and NTFS).
  *
- * @param fd File descriptor for the device. Used for seeking and reading extended boot records (EBRs).
- * @param device Name of the device to be printed in the partition information.
- * @param table_entry_ptr Pointer to the array of MBR partition entries.
+ * @param out Stream the table is printed to.
+ * @param dev The opened device.
+ * @param device Name of the device to be printed.
+ * @param table The parsed partition table.
+ */
+void print_filesystems(FILE *out, BLK_Device *dev, const char *device, const PARSE_Table *table) 
+{
+    fprintf(out, "\n%-16s%-6s %-18s %-16s %s\n", "Device", "Index", "Filesystem", "Label", "UUID");
+
+    for (size_t i = 0; i < table->count; i++) 
+    {
+        const PARSE_Partition *partition = &table->partitions[i];
+        if (partition->origin == PARSE_ORIGIN_EXTENDED || (partition->flags & PARSE_FLAG_REVERSED)) 
+        {
+            continue;
+        }
+
+        FS_Info info;
+        int status = FS_probe(dev, partition->start * dev->logical_sector_size,
+                              partition->count * dev->logical_sector_size, &info);
+
+        fprintf(out, "%-16s%-6d %-18s %-16s %s\n", device, partition->index,
+                (status > 0) ? info.type : (status < 0) ? "read error" : "-", info.label, info.uuid);
+    }
+}
+
+
+
+
+
+
+/**
+ * Probes one device and prints its partition table.
+ *
+ * This function performs the following tasks:
+ * 1. Opens the specified device file, reads its first sector and parses the partition
+ *    table into descriptors with `PARSE_read_table`. The descriptors live on the stack;
+ *    a table with more partitions than `PARSE_DEFAULT_CAPACITY` is parsed a second time
+ *    into a heap array of the size the first pass reported.
+ * 2. Based on the partition table type (GPT or MBR), performs the following:
+ *    - For GPT (GUID Partition Table):
+ *      - Prints header information for GPT partition entries.
+ *      - Prints the partitions of the intact copy.
+ *      - If the parser flagged a damaged or mismatching copy, loads both copies to report
+ *        the damage; with `--repair`, rewrites the damaged copy from the intact one.
+ *    - For MBR (Master Boot Record):
+ *      - Prints header information for MBR partition entries.
+ *      - Prints the primary, extended and logical partitions and reports broken EBR chains.
+ * 3. With `-p`, probes every partition for a filesystem or volume signature and prints 
+ *    its type, label and UUID.
+ * 4. With `-a`, checks every partition against the physical sector, RAID chunk and
+ *    stripe geometry and suggests an aligned layout.
+ * 5. With `-F`, prints the unpartitioned space of the usable range and reports
+ *    overlapping or out-of-range partitions.
+ * 6. With `--bench`, measures the sequential read throughput (start, middle and end of
+ *    every partition) and the random read IOPS at several queue depths.
+ * 7. With `--scan`, reads every partition once and prints its share of zero blocks,
+ *    its byte entropy and its XXH64 digest.
+ * 8. Closes the device file.
+ *
+ * @param device The path of the device or image file to probe.
+ * @param out The stream the partition table is printed to.
  * 
- * @return void This function does not return a value. It prints partition information and handles extended partitions.
+ * @return 0 if the device was probed successfully, 1 if an error occurs.
  */
-void process_mbr_partitions(int fd, const char *device, MBR_PartitionEntry *table_entry_ptr) 
+int probe_device(const char *device, FILE *out) 
 {
-    int partition_index = 1;
-    int logical_partition_index = 5; // Start logical partitions at index 5
+    BLK_Device dev;
+    CACHE_Cache cache;
+    PARSE_Partition descriptors[PARSE_DEFAULT_CAPACITY];
+    PARSE_Partition *partitions = descriptors;
+    PARSE_Table table;
+    int status = 0;
+    if (initialize_device(device, &dev, &cache, options.open_flags) != 0)  
+    {
+        return 1; // Error occurred during device initialization
+    }
+
+    /* Parse the partition table, again into a larger array if it did not fit */
+    int parsed = PARSE_read_table(&cache, partitions, PARSE_DEFAULT_CAPACITY, &table);
+    if (table.total > table.capacity)
+    {
+        partitions = malloc(table.total * sizeof(PARSE_Partition));
+        if (partitions == NULL)
+        {
+            perror("Failed to allocate partition descriptors");
+            CACHE_free(&cache);
+            BLK_close(&dev);
+            return 1;
+        }
+        parsed = PARSE_read_table(&cache, partitions, table.total, &table);
+    }
+
+    /* Only a failed read of the first sector leaves no table type with an error */
+    if (parsed != 0 && table.label == PARSE_LABEL_NONE)
+    {
+        perror("Failed to read sector");
+        if (partitions != descriptors) free(partitions);
+        CACHE_free(&cache);
+        BLK_close(&dev);
+        return 1;
+    }
+
+    /* Check if the device contains a GPT partition table */
+    if (table.label == PARSE_LABEL_GPT) 
+    {
+        /* Print the header information and the partitions of the trusted copy */
+        print_gpt_header_info(out);
+        print_gpt_entries(out, device, &table);
+
+        /* Explain the damage the parser found and repair it if requested */
+        if (((table.problems & PARSE_PROBLEM_GPT) || options.repair) && check_gpt(out, &cache) != 0)
+        {
+            parsed = -1;
+        }
+        if (parsed != 0)
+        {
+            if (partitions != descriptors) free(partitions);
+            CACHE_free(&cache);
+            BLK_close(&dev);
+            return 1; // No usable GPT, or the repair failed
+        }
+    }
+
+    /* Check if the device contains an MBR partition table */
+    else if (table.label == PARSE_LABEL_MBR)
+    {
+        /* Print the header information and the MBR partition details */
+        print_mbr_header_info(out);
+        print_mbr_partitions(out, device, &table);
+    }
+
+    /* Print the filesystems found inside the partitions */
+    if (options.probe_filesystems) 
+    {
+        print_filesystems(out, &dev, device, &table);
+    }
 
-    for (int i = 0; i < MBR_PARTITIONS_NUM; i++) 
+    /* Check the partitions against the device geometry */
+    if (options.check_alignment)
     {
-        if (table_entry_ptr[i].lba != 0) 
+        ALIGN_Geometry geometry;
+        ALIGN_get_geometry(device, &dev, &geometry);
+        if (options.geometry_override.physical_sector_size) geometry.physical_sector_size = options.geometry_override.physical_sector_size;
+        if (options.geometry_override.minimum_io_size)      geometry.minimum_io_size = options.geometry_override.minimum_io_size;
+        if (options.geometry_override.optimal_io_size)      geometry.optimal_io_size = options.geometry_override.optimal_io_size;
+        if (options.geometry_override.alignment_offset)     geometry.alignment_offset = options.geometry_override.alignment_offset;
+        if (geometry.minimum_io_size < geometry.physical_sector_size) geometry.minimum_io_size = geometry.physical_sector_size;
+
+        // An override smaller than the logical sector of this device cannot be honoured
+        int small_physical = geometry.physical_sector_size < geometry.logical_sector_size;
+        if (small_physical || geometry.minimum_io_size < geometry.logical_sector_size)
         {
-            MBR_print_partition_info(device, partition_index++, &table_entry_ptr[i], 0);
-
-            // Check if this is an extended partition
-            if (table_entry_ptr[i].partition_type == CHS_EXTENDED_PARTITION || 
-                table_entry_ptr[i].partition_type == LBA_EXTENDED_PARTITION || 
-                table_entry_ptr[i].partition_type == LINUX_EXTENDED_PARTITION) 
-            { 
-                MBR_parse_ebr(fd, device, table_entry_ptr[i].lba, &logical_partition_index);
-            }
+            fprintf(stderr, "Invalid geometry for %s: %s of %u B is smaller than the %u-byte logical sector\n",
+                    device, small_physical ? "physical sector size" : "minimum I/O size",
+                    small_physical ? geometry.physical_sector_size : geometry.minimum_io_size,
+                    geometry.logical_sector_size);
+            status = 1;
         }
+        else
+        {
+            ALIGN_print_report(out, device, &geometry, &table);
+        }
+    }
+
+    /* Print the free-space map */
+    if (options.free_space)
+    {
+        FREE_print_report(out, device, &table);
+    }
+
+    /* Measure the read performance of the partitions */
+    if (options.bench)
+    {
+        BENCH_print_report(out, device, &table);
+    }
+
+    /* Analyse the content of the partitions */
+    if (options.scan)
+    {
+        CONTENT_print_report(out, device, &table);
+    }
+
+    /* Close the device */
+    if (partitions != descriptors) free(partitions);
+    CACHE_free(&cache);
+    BLK_close(&dev);
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Probes one device as part of a multi-device scan.
+ *
+ * Same as `probe_device`, preceded by a "Disk <device>" line so the output of 
+ * several devices can be told apart.
+ *
+ * @param device The path of the device or image file to probe.
+ * @param out The stream the partition table is printed to.
+ * 
+ * @return 0 if the device was probed successfully, 1 if an error occurs.
+ */
+static int scan_device(const char *device, FILE *out) 
+{
+    fprintf(out, "Disk %s\n", device);
+    return probe_device(device, out);
+}
+
+
+
+
+
+
+/**
+ * Writes the script layout to one device and prints the new partition table.
+ *
+ * This function performs the following tasks:
+ * 1. Opens the device read-write.
+ * 2. Validates the layout against the device and writes the whole partition table 
+ *    (see `SCRIPT_apply`), followed by fsync and BLKRRPART.
+ * 3. Probes the device again and prints the partition table as it is now on disk.
+ *
+ * @param device The path of the device or image file to partition.
+ * @param out The stream the result is printed to.
+ * 
+ * @return 0 if the table was written, 1 if an error occurs.
+ */
+static int partition_device(const char *device, FILE *out) 
+{
+    BLK_Device dev;
+    if (BLK_open(&dev, device, options.open_flags | BLK_FLAG_WRITE) != 0) 
+    {
+        fprintf(stderr, "Failed to open device %s: %s\n", device, strerror(errno));
+        return 1;
     }
+
+    int status = SCRIPT_apply(out, &dev, options.script);
+    BLK_close(&dev);
+    if (status != 0) 
+    {
+        return 1;
+    }
+
+    return probe_device(device, out);
+}
+
+
+
+
+
+
+/**
+ * Partitions one device as part of a multi-device run.
+ *
+ * Same as `partition_device`, preceded by a "Disk <device>" line.
+ *
+ * @param device The path of the device or image file to partition.
+ * @param out The stream the result is printed to.
+ * 
+ * @return 0 if the table was written, 1 if an error occurs.
+ */
+static int scan_partition_device(const char *device, FILE *out) 
+{
+    fprintf(out, "Disk %s\n", device);
+    return partition_device(device, out);
 }
 
 
@@ -294,6 +603,188 @@ void process_mbr_partitions(int fd, const char *device, MBR_PartitionEntry *tabl
 
 
 
+/**
+ * Reads the layout script given to --script ("-" for the standard input).
+ *
+ * @param path The script path.
+ * @param layout Receives the layout.
+ * 
+ * @return 0 on success, or -1 on error.
+ */
+static int load_script(const char *path, SCRIPT_Layout *layout) 
+{
+    FILE *in = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+    if (in == NULL) 
+    {
+        fprintf(stderr, "Failed to open script %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int status = SCRIPT_parse(in, layout);
+    if (in != stdin) 
+    {
+        fclose(in);
+    }
+    return status;
+}
+
+
+
+
+
+
+/**
+ * Prints the time and block I/O system calls of a run to the standard error (--stats).
+ *
+ * Combined with images from `mkimage`, this is the parsing benchmark: the partition
+ * tables go to the standard output (usually /dev/null) and the totals, per run and per
+ * device, to the standard error.
+ *
+ * @param device_count The number of devices probed.
+ * @param start The time the first device was opened (CLOCK_MONOTONIC).
+ */
+static void print_stats(size_t device_count, const struct timespec *start) 
+{
+    struct timespec end;
+    BLK_Stats stats;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    BLK_get_stats(&stats);
+
+    double seconds = (double)(end.tv_sec - start->tv_sec) + (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+    double per_device = device_count ? 1.0 / (double)device_count : 0.0;
+
+    fprintf(stderr, "%zu device%s in %.3f s (%.1f us per device, %.0f devices/s)\n",
+            device_count, device_count == 1 ? "" : "s", seconds, seconds * 1e6 * per_device,
+            seconds > 0 ? (double)device_count / seconds : 0.0);
+    fprintf(stderr, "syscalls: %" PRIu64 " (%.1f per device), pread: %" PRIu64 " (%" PRIu64 " bytes), "
+                    "pwrite: %" PRIu64 " (%" PRIu64 " bytes), mapped images: %" PRIu64 "\n",
+            stats.syscalls, (double)stats.syscalls * per_device, stats.reads, stats.read_bytes,
+            stats.writes, stats.write_bytes, stats.maps);
+}
+
+
+
+
+
+
+/**
+ * Parses the thread count of `-j`.
+ *
+ * @param text The option argument.
+ * @param threads Receives the thread count.
+ * @return 0 on success, -1 if `text` is not a positive decimal number.
+ */
+static int parse_thread_count(const char *text, unsigned int *threads) 
+{
+    char *end;
+
+    errno = 0;
+    unsigned long value = strtoul(text, &end, 10);
+    if (text[0] < '0' || text[0] > '9' || *end != '\0' || errno != 0 || value == 0 || value > UINT_MAX) 
+    {
+        fprintf(stderr, "Invalid thread count: '%s'\n", text);
+        return -1;
+    }
+
+    *threads = (unsigned int)value;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Parses a size in bytes given to a long option, like `parse_thread_count`.
+ *
+ * @param text The option argument.
+ * @param what Name of the value, for the error message (e.g., "sector size").
+ * @param size Receives the size.
+ * @return 0 on success, -1 if `text` is not a decimal number of at most 32 bits.
+ */
+static int parse_byte_size(const char *text, const char *what, uint32_t *size) 
+{
+    char *end;
+
+    errno = 0;
+    unsigned long value = strtoul(text, &end, 10);
+    if (text[0] < '0' || text[0] > '9' || *end != '\0' || errno != 0 || value > UINT32_MAX) 
+    {
+        fprintf(stderr, "Invalid %s: '%s'\n", what, text);
+        return -1;
+    }
+
+    *size = (uint32_t)value;
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Parses a physical sector or minimum I/O size: a power of two of at least 512 bytes.
+ *
+ * @param text The option argument.
+ * @param what Name of the value, for the error message.
+ * @param size Receives the size.
+ * @return 0 on success, -1 if `text` is not such a size.
+ */
+static int parse_power_of_two(const char *text, const char *what, uint32_t *size) 
+{
+    if (parse_byte_size(text, what, size) != 0) 
+    {
+        return -1;
+    }
+    if (*size < BLK_DEFAULT_SECTOR_SIZE || (*size & (*size - 1)) != 0) 
+    {
+        fprintf(stderr, "Invalid %s: '%s' (a power of two, at least %d bytes)\n", what, text, BLK_DEFAULT_SECTOR_SIZE);
+        return -1;
+    }
+    return 0;
+}
+
+
+
+
+
+
+/**
+ * Prints the command-line usage.
+ *
+ * @param program The program name (argv[0]).
+ */
+static void print_usage(const char *program) 
+{
+    fprintf(stderr, "Usage: %s [-d] [-p] [-a] [-F] [-j threads] [--repair] <device|image>...\n"
+                    "       %s -l [-d] [-p] [-a] [-F] [-j threads] [device|image...]\n"
+                    "       %s -s script [-d] [-j threads] <device|image>...\n"
+                    "  -l, --list          list all block devices from " SCAN_SYSFS_BLOCK_DIR " (or the given devices)\n"
+                    "  -j, --jobs threads  number of devices probed in parallel (default %d)\n"
+                    "  -d, --direct        read with O_DIRECT (bypass the page cache)\n"
+                    "  -p, --probe         show the filesystem/volume type, label and UUID of every partition\n"
+                    "  -a, --align         check partition alignment against the physical sector and RAID geometry\n"
+                    "      --physical-size bytes, --min-io bytes, --optimal-io bytes, --alignment-offset bytes\n"
+                    "                      override the detected geometry (e.g., for images)\n"
+                    "      --sector-size bytes  logical sector size of image files, 512 or 4096 (only 4Kn GPT\n"
+                    "                      images and MBR images with an extended partition are detected)\n"
+                    "  -F, --free          show unpartitioned space and overlapping partitions\n"
+                    "      --repair        rewrite a damaged GPT copy (primary or backup) from the intact one\n"
+                    "      --stats         print the run time and block I/O system calls to stderr (benchmark)\n"
+                    "      --bench         measure sequential read MB/s (partition start, middle, end) and random 4K\n"
+                    "                      read IOPS of every partition at queue depths 1, 4 and 16 (read-only)\n"
+                    "      --scan          read every partition once: zero blocks, byte entropy and XXH64 digest\n"
+                    "  -s, --script file   write the partition layout described by an sfdisk-like script (\"-\" for stdin)\n",
+            program, program, program, SCAN_DEFAULT_THREADS);
+}
+
+
+
+
+
 
 /*============================================================================
  ******************************  Main Code  **********************************
@@ -302,19 +793,16 @@ void process_mbr_partitions(int fd, const char *device, MBR_PartitionEntry *tabl
  * Main function for partition table analysis.
  *
  * This function performs the following tasks:
- * 1. Validates command-line arguments to ensure the correct usage.
- * 2. Opens the specified device file for reading.
- * 3. Reads the first sector of the device to determine the partition table type.
- * 4. Based on the partition table type (GPT or MBR), performs the following:
- *    - For GPT (GUID Partition Table):
- *      - Prints header information for GPT partition entries.
- *      - Reads the GPT header and verifies its integrity.
- *      - Reads and prints GPT partition entries.
- *    - For MBR (Master Boot Record):
- *      - Prints header information for MBR partition entries.
- *      - Reads MBR partition entries.
- *      - Processes and prints details of MBR partitions, including handling extended partitions.
- * 5. Closes the device file and exits the program.
+ * 1. Parses the command-line options (-l, -j, -d, -p, -a, -F, -s, --repair, geometry overrides). With -s, reads the 
+ *    layout script once; every device given is then partitioned with it instead of probed.
+ * 2. With a single device and no -l, probes it and prints its partition table 
+ *    exactly as before.
+ * 3. Otherwise, builds the device list (all block devices from sysfs for a bare -l, 
+ *    or every device/image given on the command line) and probes them concurrently 
+ *    on a bounded thread pool, printing the results in list order.
+ * 4. With --stats, prints the run time and the block I/O system calls. With --bench, devices
+ *    are measured one at a time so the measurements do not disturb each other; with --scan,
+ *    one at a time as well, since every scan already keeps all CPUs busy.
  *
  * @param argc The number of command-line arguments.
  * @param argv The command-line arguments.
@@ -323,56 +811,145 @@ void process_mbr_partitions(int fd, const char *device, MBR_PartitionEntry *tabl
  */
 int main(int argc, char **argv) 
 {
-    /* Open the device specified by the user */
-    if (argc != 2) 
+    int list_all = 0;
+    const char *script_path = NULL;
+    unsigned int threads = SCAN_DEFAULT_THREADS;
+    uint32_t size;
+    int invalid = 0;
+    int show_stats = 0;
+    struct timespec start;
+    int opt;
+
+    static const struct option long_options[] = 
     {
-        fprintf(stderr, "Usage: %s <device>\n", argv[0]);
-        return 1;
+        { "list",   no_argument,       NULL, 'l' },
+        { "jobs",   required_argument, NULL, 'j' },
+        { "direct", no_argument,       NULL, 'd' },
+        { "repair", no_argument,       NULL, OPTION_REPAIR },
+        { "script", required_argument, NULL, 's' },
+        { "probe",  no_argument,       NULL, 'p' },
+        { "align",  no_argument,       NULL, 'a' },
+        { "free",   no_argument,       NULL, 'F' },
+        { "physical-size",    required_argument, NULL, OPTION_PHYSICAL_SIZE },
+        { "min-io",           required_argument, NULL, OPTION_MIN_IO },
+        { "optimal-io",       required_argument, NULL, OPTION_OPTIMAL_IO },
+        { "alignment-offset", required_argument, NULL, OPTION_ALIGNMENT_OFFSET },
+        { "stats",            no_argument,       NULL, OPTION_STATS },
+        { "bench",            no_argument,       NULL, OPTION_BENCH },
+        { "scan",             no_argument,       NULL, OPTION_SCAN },
+        { "sector-size",      required_argument, NULL, OPTION_SECTOR_SIZE },
+        { NULL,     0,                 NULL, 0   }
+    };
+
+    /* Parse command-line options */
+    while ((opt = getopt_long(argc, argv, "lj:ds:paF", long_options, NULL)) != -1) 
+    {
+        switch (opt) 
+        {
+            case 'l': list_all = 1;                              break;
+            case 'j':
+                if (parse_thread_count(optarg, &threads) != 0) 
+                {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'd': options.open_flags |= BLK_FLAG_DIRECT;     break;
+            case 's': script_path = optarg;                      break;
+            case 'p': options.probe_filesystems = 1;             break;
+            case 'a': options.check_alignment = 1;               break;
+            case 'F': options.free_space = 1;                    break;
+            case OPTION_PHYSICAL_SIZE:    invalid = parse_power_of_two(optarg, "physical sector size", &options.geometry_override.physical_sector_size); break;
+            case OPTION_MIN_IO:           invalid = parse_power_of_two(optarg, "minimum I/O size", &options.geometry_override.minimum_io_size);         break;
+            case OPTION_OPTIMAL_IO:       invalid = parse_byte_size(optarg, "optimal I/O size", &options.geometry_override.optimal_io_size);            break;
+            case OPTION_ALIGNMENT_OFFSET: invalid = parse_byte_size(optarg, "alignment offset", &options.geometry_override.alignment_offset);           break;
+            case OPTION_STATS:            show_stats = 1;                                                                      break;
+            case OPTION_BENCH:            options.bench = 1;                                                                   break;
+            case OPTION_SCAN:             options.scan = 1;                                                                    break;
+            case OPTION_SECTOR_SIZE:
+                if (parse_byte_size(optarg, "sector size", &size) != 0) 
+                {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                if ((size != 512 && size != 4096) || BLK_set_image_sector_size(size) != 0) 
+                {
+                    fprintf(stderr, "Invalid sector size: '%s' (512 or 4096)\n", optarg);
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case OPTION_REPAIR:
+                options.repair = 1;
+                options.open_flags |= BLK_FLAG_WRITE;
+                break;
+            default:  print_usage(argv[0]);                      return 1;
+        }
+        if (invalid) 
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
     }
 
-    char buf[SECTOR_SIZE];
-    int fd = initialize_device(argv[1], buf, SECTOR_SIZE);
-    if (fd < 0) 
+    int device_count = argc - optind;
+    if (options.bench || options.scan) 
     {
-        return 1; // Error occurred during device initialization
+        threads = 1; // Concurrent measurements would share the disks and the CPU
     }
-
-    /* Check if the device contains a GPT partition table */
-    if ((uint8_t)buf[450] == GPT_SIGNATURE) 
+    if ((device_count == 0 && !list_all) || (script_path != NULL && (device_count == 0 || list_all))) 
     {
-        /* Print the header information for GPT partitions */
-        print_gpt_header_info();
+        print_usage(argv[0]);
+        return 1;
+    }
 
-        /* Read the GPT header and handle any errors */
-        if (read_gpt_header(fd, buf) != 0) 
+    /* Script mode: read and check the layout once for all devices */
+    static SCRIPT_Layout layout;
+    SCAN_ProbeFunction scan_function = scan_device;
+    if (script_path != NULL) 
+    {
+        if (load_script(script_path, &layout) != 0) 
         {
-            close(fd);
-            return 1; // Error reading GPT header
+            return 1;
         }
+        options.script = &layout;
+        scan_function = scan_partition_device;
+    }
 
-        /* Read and print GPT partition entries */
-        read_and_print_gpt_entries(fd, argv[1]);
+    /* Single device: print its partition table directly */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (device_count == 1 && !list_all) 
+    {
+        int result = (options.script != NULL) ? partition_device(argv[optind], stdout) : probe_device(argv[optind], stdout);
+        if (show_stats) 
+        {
+            print_stats(1, &start);
+        }
+        return result;
     }
 
-    /* Check if the device contains an MBR partition table */
-    else if (*(uint16_t*)&buf[510] == MBR_SIGNATURE)
+    /* Multiple devices: build the device list */
+    SCAN_DeviceList devices = { 0 };
+    int status = 0;
+    if (device_count == 0) 
+    {
+        status = SCAN_enumerate_block_devices(&devices);
+    }
+    for (int i = optind; i < argc && status == 0; i++) 
     {
-        /* Print the header information for MBR partitions */
-        print_mbr_header_info();
+        status = SCAN_add_device(&devices, argv[i]);
+    }
 
-        /* Read the MBR partition entries */
-        MBR_PartitionEntry *table_entry_ptr;
-        if (read_mbr_partition_entries(buf, &table_entry_ptr) != 0) 
+    /* Probe all devices in parallel and print them in order */
+    if (status == 0) 
+    {
+        status = SCAN_run(&devices, scan_function, threads);
+        if (show_stats) 
         {
-            close(fd);
-            return 1; // Error reading MBR partition entries
+            print_stats(devices.count, &start);
         }
-
-        /* Process and print MBR partition details */
-        process_mbr_partitions(fd, argv[1], table_entry_ptr);
     }
 
-    /* Close the device file descriptor */
-    close(fd);
-    return 0;
+    SCAN_free_device_list(&devices);
+    return (status == 0) ? 0 : 1;
 }
@@ -0,0 +1,421 @@
+ /*===================================================================================
+ * @file           : Dir_Reader.c
+ * @author         : Ali Mamdouh
+ * @brief          : Reads directories with getdents64 into a name arena.
+ * @Reviewer       : Eng Reda
+ * @Version        : 1.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#define _GNU_SOURCE      // Exposes statx
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <limits.h>
+#include <sys/syscall.h>
+
+#include "Dir_Reader.h"
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * @brief Directory record returned by `getdents64` (see getdents64(2)).
+ */
+struct linux_dirent64
+{
+    ino64_t        d_ino;       /**< Inode number. */
+    off64_t        d_off;       /**< Offset of the next record. */
+    unsigned short d_reclen;    /**< Size of this record. */
+    unsigned char  d_type;      /**< File type. */
+    char           d_name[];    /**< NUL-terminated file name. */
+};
+
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Makes room for `length` more bytes in the name arena, doubling it if needed.
+ *
+ * @param listing: The listing being read.
+ * @param length: Number of bytes to append.
+ *
+ * @return: 0 on success, -1 if memory allocation fails.
+ */
+static int reserve_names(DirListing *listing, size_t length)
+{
+    if (listing->names_size + length <= listing->names_capacity)
+    {
+        return 0;
+    }
+
+    size_t capacity = listing->names_capacity ? listing->names_capacity : DIR_NAME_ARENA_INITIAL_SIZE;
+    while (listing->names_size + length > capacity)
+    {
+        capacity *= 2;
+    }
+
+    char *names = realloc(listing->names, capacity);
+    if (names == NULL)
+    {
+        return -1;
+    }
+    listing->names = names;
+    listing->names_capacity = capacity;
+    return 0;
+}
+
+
+
+
+/**
+ * Makes room for one more entry record, doubling the array if needed.
+ *
+ * @param listing: The listing being read.
+ *
+ * @return: 0 on success, -1 if memory allocation fails.
+ */
+static int reserve_entry(DirListing *listing)
+{
+    if (listing->count < listing->capacity)
+    {
+        return 0;
+    }
+
+    int capacity = listing->capacity ? listing->capacity * 2 : DIR_ENTRIES_INITIAL_COUNT;
+    FileEntry *entries = realloc(listing->entries, (size_t)capacity * sizeof(FileEntry));
+    if (entries == NULL)
+    {
+        return -1;
+    }
+    listing->entries = entries;
+    listing->capacity = capacity;
+    return 0;
+}
+
+
+
+
+/**
+ * Appends a directory record to the listing: the name is copied into the arena and a
+ * record refers to it by offset, next to the type and inode number of the entry.
+ *
+ * @param listing: The listing being read.
+ * @param record: The directory record (name, type and inode number).
+ *
+ * @return: 0 on success, -1 if memory allocation fails.
+ */
+static int append_entry(DirListing *listing, const struct linux_dirent64 *record)
+{
+    const char *name = record->d_name;
+    size_t length = strlen(name);
+
+    if (reserve_names(listing, length + 1) != 0 || reserve_entry(listing) != 0)
+    {
+        return -1;
+    }
+
+    FileEntry *entry = &listing->entries[listing->count++];
+    entry->name = NULL;
+    entry->name_offset = listing->names_size;
+    entry->name_length = length;
+    entry->key_offset = entry->name_offset;  // Until BuildSortKeys: the name itself
+    entry->key_length = length;
+    entry->type = record->d_type;
+    entry->inode = record->d_ino;
+    entry->has_status = 0;
+
+    memcpy(listing->names + listing->names_size, name, length + 1);
+    listing->names_size += length + 1;
+    return 0;
+}
+
+
+
+
+/**
+ * Resolves the name and key offsets of the records into pointers, once the arena no
+ * longer moves.
+ *
+ * @param listing: The listing.
+ *
+ * @return: Void.
+ */
+static void resolve_offsets(DirListing *listing)
+{
+    for (int i = 0; i < listing->count; i++)
+    {
+        listing->entries[i].name = listing->names + listing->entries[i].name_offset;
+        listing->entries[i].key = listing->names + listing->entries[i].key_offset;
+    }
+}
+
+
+
+
+/**
+ * Reads all the entries of a directory.
+ *
+ * The directory is read with `getdents64` into a large buffer, so thousands of entries
+ * come back per system call, and the names are copied into the arena of `listing`. When
+ * the whole directory has been read, the records get pointers into the arena. Hidden
+ * entries (names starting with '.') are skipped unless `show_hidden` is set.
+ *
+ * The directory stays open (`listing->dir_fd`) so metadata can be resolved relative to
+ * it; `FreeDirectory` closes it.
+ *
+ * @param dir: Path of the directory.
+ * @param show_hidden: Non-zero to keep hidden entries (the `-a` option).
+ * @param listing: Receives the entries.
+ *
+ * @return: 0 on success, -1 on error (an error message is printed and nothing has to be freed).
+ */
+int ReadDirectory(const char *dir, int show_hidden, DirListing *listing)
+{
+    memset(listing, 0, sizeof(*listing));
+
+    listing->dir_fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (listing->dir_fd < 0)
+    {
+        fprintf(stderr, "Cannot open directory '%s': %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    char *buffer = malloc(DIR_READ_BUFFER_SIZE);
+    if (buffer == NULL)
+    {
+        perror("Memory allocation failed");
+        FreeDirectory(listing);
+        return -1;
+    }
+
+    /* Read batches of records until the end of the directory */
+    for (;;)
+    {
+        long length = syscall(SYS_getdents64, listing->dir_fd, buffer, DIR_READ_BUFFER_SIZE);
+        if (length == 0)
+        {
+            break;
+        }
+        if (length < 0)
+        {
+            fprintf(stderr, "Cannot read directory '%s': %s\n", dir, strerror(errno));
+            free(buffer);
+            FreeDirectory(listing);
+            return -1;
+        }
+
+        for (long offset = 0; offset < length; )
+        {
+            const struct linux_dirent64 *record = (const struct linux_dirent64 *)(buffer + offset);
+            offset += record->d_reclen;
+
+            /* Skip hidden files unless the option to show them is enabled */
+            if (!show_hidden && record->d_name[0] == '.')
+            {
+                continue;
+            }
+
+            if (append_entry(listing, record) != 0)
+            {
+                perror("Memory allocation failed");
+                free(buffer);
+                FreeDirectory(listing);
+                return -1;
+            }
+        }
+    }
+    free(buffer);
+
+    resolve_offsets(listing);
+    return 0;
+}
+
+
+
+
+/**
+ * Releases a listing filled by `ReadDirectory` and closes its directory.
+ *
+ * @param listing: The listing to release.
+ *
+ * @return: Void.
+ */
+void FreeDirectory(DirListing *listing)
+{
+    if (listing->dir_fd >= 0)
+    {
+        close(listing->dir_fd);
+    }
+    free(listing->names);
+    free(listing->entries);
+    memset(listing, 0, sizeof(*listing));
+    listing->dir_fd = -1;
+}
+
+
+
+
+/**
+ * Writes the lowercase sort key of an entry at the end of the name arena.
+ *
+ * @param listing: The listing.
+ * @param entry: The entry.
+ *
+ * @return: The length of the key, or -1 if memory allocation fails.
+ */
+static long write_lowercase_key(DirListing *listing, const FileEntry *entry)
+{
+    if (reserve_names(listing, entry->name_length) != 0)
+    {
+        return -1;
+    }
+
+    const char *name = listing->names + entry->name_offset;
+    char *key = listing->names + listing->names_size;
+    for (size_t i = 0; i < entry->name_length; i++)
+    {
+        key[i] = (char)tolower((unsigned char)name[i]);
+    }
+    return (long)entry->name_length;
+}
+
+
+
+
+/**
+ * Writes the collation key of an entry (`strxfrm` in the `LC_COLLATE` locale) at the end
+ * of the name arena. The byte order of the keys is the `strcoll` order of the names.
+ *
+ * @param listing: The listing.
+ * @param entry: The entry.
+ *
+ * @return: The length of the key, or -1 if memory allocation fails.
+ */
+static long write_locale_key(DirListing *listing, const FileEntry *entry)
+{
+    size_t length = strxfrm(NULL, listing->names + entry->name_offset, 0);
+    if (reserve_names(listing, length + 1) != 0)
+    {
+        return -1;
+    }
+
+    strxfrm(listing->names + listing->names_size, listing->names + entry->name_offset, length + 1);
+    return (long)length;
+}
+
+
+
+
+/**
+ * Writes the natural version sort key of an entry at the end of the name arena.
+ *
+ * The name is lowercased like the default key, and every run of digits is replaced by a
+ * '0' marker, the number of significant digits and the digits without leading zeros. A
+ * digit run therefore compares with other characters like a digit does, and with another
+ * digit run by numeric value: "file9" sorts before "file10".
+ *
+ * @param listing: The listing.
+ * @param entry: The entry.
+ *
+ * @return: The length of the key, or -1 if memory allocation fails.
+ */
+static long write_version_key(DirListing *listing, const FileEntry *entry)
+{
+    /* A one-digit run takes 3 bytes (marker, digit count, digit) */
+    if (reserve_names(listing, 3 * entry->name_length) != 0)
+    {
+        return -1;
+    }
+
+    const char *name = listing->names + entry->name_offset;
+    char *key = listing->names + listing->names_size;
+    size_t length = entry->name_length;
+    size_t used = 0;
+    for (size_t i = 0; i < length; )
+    {
+        if (!isdigit((unsigned char)name[i]))
+        {
+            key[used++] = (char)tolower((unsigned char)name[i++]);
+            continue;
+        }
+
+        size_t start = i;
+        while (i < length && isdigit((unsigned char)name[i]))
+        {
+            i++;
+        }
+        while (start < i - 1 && name[start] == '0')
+        {
+            start++;  // Leading zeros do not change the value
+        }
+        size_t digits = i - start;
+
+        key[used++] = '0';
+        key[used++] = (char)((digits < UCHAR_MAX) ? digits : UCHAR_MAX);
+        memcpy(key + used, name + start, digits);
+        used += digits;
+    }
+    return (long)used;
+}
+
+
+
+
+/**
+ * Computes the sort key of every entry once and stores it in the name arena.
+ *
+ * Sorting then compares keys with `memcmp` (see `CompareFileNamesAlphabetically`)
+ * instead of converting both names in every comparison:
+ * - `SORT_KEY_LOWERCASE`: the lowercase name (case-insensitive byte order).
+ * - `SORT_KEY_LOCALE`: the `strxfrm` transform of the name in the `LC_COLLATE` locale.
+ * - `SORT_KEY_VERSION`: the natural version key (`-v`), see `write_version_key`.
+ *
+ * @param listing: The listing read by `ReadDirectory`.
+ * @param kind: The kind of key.
+ *
+ * @return: 0 on success, -1 if memory allocation fails (an error message is printed).
+ */
+int BuildSortKeys(DirListing *listing, SortKeyKind kind)
+{
+    for (int i = 0; i < listing->count; i++)
+    {
+        FileEntry *entry = &listing->entries[i];
+        long length = (kind == SORT_KEY_VERSION) ? write_version_key(listing, entry) :
+                      (kind == SORT_KEY_LOCALE) ? write_locale_key(listing, entry) :
+                      write_lowercase_key(listing, entry);
+        if (length < 0)
+        {
+            perror("Memory allocation failed");
+            return -1;
+        }
+
+        entry->key_offset = listing->names_size;
+        entry->key_length = (size_t)length;
+        listing->names_size += (size_t)length;
+    }
+
+    resolve_offsets(listing);
+    return 0;
+}
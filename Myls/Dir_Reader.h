@@ -0,0 +1,107 @@
+ /*===================================================================================
+ * @file           : Dir_Reader.h
+ * @author         : Ali Mamdouh
+ * @brief          : Header of Dir_Reader (getdents64 directory reader).
+ * @Reviewer       : Eng Reda
+ * @Version        : 1.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _DIR_READER_H_
+#define _DIR_READER_H_
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stddef.h>
+#include "Helper.h"
+
+
+
+
+
+/*============================================================================
+ **********************************  Macros  *********************************
+ ============================================================================*/
+/**
+ * @brief Size of the buffer filled by each `getdents64` call.
+ *
+ * A large buffer returns thousands of entries per system call.
+ */
+#define DIR_READ_BUFFER_SIZE                (256 * 1024)
+
+/**
+ * @brief Initial size of the name arena in bytes (doubled when full).
+ */
+#define DIR_NAME_ARENA_INITIAL_SIZE         (64 * 1024)
+
+/**
+ * @brief Initial number of entry records (doubled when full).
+ */
+#define DIR_ENTRIES_INITIAL_COUNT           1024
+
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * @brief Kind of sort key computed by `BuildSortKeys`.
+ */
+typedef enum
+{
+    SORT_KEY_LOWERCASE,      /**< Case-insensitive byte order (C/POSIX collation). */
+    SORT_KEY_LOCALE,         /**< strxfrm collation key of the LC_COLLATE locale. */
+    SORT_KEY_VERSION         /**< Natural version order (-v). */
+} SortKeyKind;
+
+/**
+ * @brief Contents of one directory.
+ *
+ * The names are stored one after the other, NUL-terminated, in a single growable arena;
+ * each entry record refers to its name by offset while the directory is read, and gets
+ * a pointer once the arena no longer moves. The sort keys of the entries are stored in
+ * the same arena (see `BuildSortKeys`). Both arrays grow by doubling, so reading a
+ * directory makes no allocation per entry and has no size limit.
+ *
+ * Fields:
+ *
+ * @param dir_fd: Open descriptor of the directory (metadata is resolved relative to it).
+ * @param names: The name arena.
+ * @param names_size: Bytes used in the arena.
+ * @param names_capacity: Size of the arena.
+ * @param entries: The entry records.
+ * @param count: Number of entry records.
+ * @param capacity: Number of allocated entry records.
+ */
+typedef struct
+{
+    int dir_fd;              /**< Directory descriptor. */
+    char *names;             /**< Name arena. */
+    size_t names_size;       /**< Bytes used in the arena. */
+    size_t names_capacity;   /**< Arena size. */
+    FileEntry *entries;      /**< Entry records. */
+    int count;               /**< Number of records. */
+    int capacity;            /**< Allocated records. */
+} DirListing;
+
+
+
+
+
+
+/*============================================================================
+ ********************************  Functions  ********************************
+ ============================================================================*/
+int ReadDirectory(const char *dir, int show_hidden, DirListing *listing);
+int BuildSortKeys(DirListing *listing, SortKeyKind kind);
+void FreeDirectory(DirListing *listing);
+
+#endif
@@ -0,0 +1,472 @@
+ /*===================================================================================
+ * @file           : Entry_Sorter.c
+ * @author         : Ali Mamdouh
+ * @brief          : Sorts entry records, with several threads for very large directories.
+ * @Reviewer       : Eng Reda
+ * @Version        : 1.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#define _GNU_SOURCE      // Exposes statx and qsort_r
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "Entry_Sorter.h"
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * @brief What the comparisons read from the records, one array per field.
+ *
+ * A comparison touches a few bytes of two rows instead of two whole records (the
+ * `statx` result alone is 256 bytes), so the sorted data stays in the caches.
+ *
+ * Fields:
+ *
+ * @param keys: Sort key of every entry.
+ * @param key_lengths: Length of every sort key.
+ * @param names: Name of every entry (tie-break of identical keys).
+ * @param seconds: Sort time of every entry, seconds part.
+ * @param nanoseconds: Sort time of every entry, nanoseconds part.
+ * @param has_time: 1 if the sort time of the entry is known (time orders only).
+ * @param by_time: 1 for the time orders, where entries without a time go last.
+ */
+typedef struct
+{
+    const char **keys;           /**< Sort keys. */
+    size_t *key_lengths;         /**< Sort key lengths. */
+    const char **names;          /**< Names. */
+    long long *seconds;          /**< Sort times (seconds). */
+    unsigned int *nanoseconds;   /**< Sort times (nanoseconds). */
+    unsigned char *has_time;     /**< 1 if the sort time is known. */
+    int by_time;                 /**< 1 for a time order. */
+} sort_table;
+
+/**
+ * @brief Share of the work of one thread.
+ *
+ * Fields:
+ *
+ * @param table: The columns compared.
+ * @param source: Row indexes read by the task.
+ * @param destination: Row indexes written by the task (merge).
+ * @param entries: The records to reorder (gather).
+ * @param sorted: Receives the reordered records (gather).
+ * @param begin: First position of the task.
+ * @param middle: End of the first sorted run (merge).
+ * @param end: End of the task.
+ */
+typedef struct
+{
+    const sort_table *table;     /**< Compared columns. */
+    int *source;                 /**< Input indexes. */
+    int *destination;            /**< Output indexes. */
+    const FileEntry *entries;    /**< Records to reorder. */
+    FileEntry *sorted;           /**< Reordered records. */
+    int begin;                   /**< First position. */
+    int middle;                  /**< End of the first run. */
+    int end;                     /**< End position. */
+} sort_task;
+
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Compares two rows of the table, in the order of the comparators of Helper.c: for the
+ * time orders, entries without metadata after the others and the newest sort time first
+ * when both times are known; then the sort keys, then the raw names.
+ *
+ * Names are unique in a directory, so this is a total order: any correct sort gives the
+ * same result as `qsort` with the matching comparator.
+ *
+ * @param table: The columns.
+ * @param row1: The first row.
+ * @param row2: The second row.
+ *
+ * @return: A negative value if `row1` comes first, a positive value if `row2` does.
+ */
+static int compare_rows(const sort_table *table, int row1, int row2)
+{
+    if (table->by_time && table->has_time[row1] != table->has_time[row2])
+    {
+        return table->has_time[row1] ? -1 : 1;
+    }
+    if (table->has_time[row1] && table->has_time[row2])
+    {
+        if (table->seconds[row1] != table->seconds[row2])
+        {
+            return (table->seconds[row1] > table->seconds[row2]) ? -1 : 1;
+        }
+        if (table->nanoseconds[row1] != table->nanoseconds[row2])
+        {
+            return (table->nanoseconds[row1] > table->nanoseconds[row2]) ? -1 : 1;
+        }
+    }
+
+    size_t length1 = table->key_lengths[row1];
+    size_t length2 = table->key_lengths[row2];
+    int result = memcmp(table->keys[row1], table->keys[row2], (length1 < length2) ? length1 : length2);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (length1 != length2)
+    {
+        return (length1 < length2) ? -1 : 1;
+    }
+    return strcmp(table->names[row1], table->names[row2]);
+}
+
+
+
+
+/**
+ * `qsort_r` adapter of `compare_rows`.
+ *
+ * @param p1: A pointer to the first row index.
+ * @param p2: A pointer to the second row index.
+ * @param table: The columns.
+ *
+ * @return: See `compare_rows`.
+ */
+static int compare_row_indexes(const void *p1, const void *p2, void *table)
+{
+    return compare_rows(table, *(const int *)p1, *(const int *)p2);
+}
+
+
+
+
+/**
+ * Task sorting the row indexes of its range in place.
+ *
+ * @param arg: The task.
+ *
+ * @return: NULL.
+ */
+static void *sort_range(void *arg)
+{
+    sort_task *task = arg;
+
+    qsort_r(task->source + task->begin, (size_t)(task->end - task->begin), sizeof(int),
+            compare_row_indexes, (void *)task->table);
+    return NULL;
+}
+
+
+
+
+/**
+ * Task merging the two sorted runs [begin, middle) and [middle, end) of `source` into
+ * the same range of `destination`.
+ *
+ * @param arg: The task.
+ *
+ * @return: NULL.
+ */
+static void *merge_runs(void *arg)
+{
+    sort_task *task = arg;
+    const int *source = task->source;
+    int *destination = task->destination;
+    int left = task->begin;
+    int right = task->middle;
+    int out = task->begin;
+
+    while (left < task->middle && right < task->end)
+    {
+        /* Equal rows cannot happen (total order); take the left one first anyway */
+        if (compare_rows(task->table, source[right], source[left]) < 0)
+        {
+            destination[out++] = source[right++];
+        }
+        else
+        {
+            destination[out++] = source[left++];
+        }
+    }
+    memcpy(destination + out, source + left, (size_t)(task->middle - left) * sizeof(int));
+    out += task->middle - left;
+    memcpy(destination + out, source + right, (size_t)(task->end - right) * sizeof(int));
+    return NULL;
+}
+
+
+
+
+/**
+ * Task copying the records of its range of positions in sorted order.
+ *
+ * @param arg: The task.
+ *
+ * @return: NULL.
+ */
+static void *gather_records(void *arg)
+{
+    sort_task *task = arg;
+
+    for (int i = task->begin; i < task->end; i++)
+    {
+        task->sorted[i] = task->entries[task->source[i]];
+    }
+    return NULL;
+}
+
+
+
+
+/**
+ * Runs tasks concurrently, one thread each; the calling thread runs the last task and
+ * any task whose thread cannot be created.
+ *
+ * @param tasks: The tasks.
+ * @param task_count: Number of tasks.
+ * @param routine: Function run for every task.
+ *
+ * @return: Void.
+ */
+static void run_tasks(sort_task tasks[], int task_count, void *(*routine)(void *))
+{
+    pthread_t threads[SORT_MAX_THREADS];
+    int started[SORT_MAX_THREADS];
+
+    for (int t = 0; t < task_count - 1; t++)
+    {
+        started[t] = (pthread_create(&threads[t], NULL, routine, &tasks[t]) == 0);
+        if (!started[t])
+        {
+            routine(&tasks[t]);
+        }
+    }
+
+    routine(&tasks[task_count - 1]);
+
+    for (int t = 0; t < task_count - 1; t++)
+    {
+        if (started[t])
+        {
+            pthread_join(threads[t], NULL);
+        }
+    }
+}
+
+
+
+
+/**
+ * Returns the sort time of an entry for the order.
+ *
+ * @param entry: The entry record.
+ * @param order: A time order.
+ *
+ * @return: The timestamp compared for `order`.
+ */
+static const struct statx_timestamp *sort_time(const FileEntry *entry, SortOrder order)
+{
+    switch (order)
+    {
+        case SORT_BY_ACCESS_TIME:
+            return &entry->status.stx_atime;
+        case SORT_BY_CHANGE_TIME:
+            return &entry->status.stx_ctime;
+        default:
+            return &entry->status.stx_mtime;
+    }
+}
+
+
+
+
+/**
+ * Sorts the records with several threads (parallel merge sort).
+ *
+ * The compared fields are copied into a `sort_table`, one array per field, and the
+ * threads sort row indexes: each one sorts a slice with `qsort_r`, then the sorted slices
+ * are merged pairwise, the merges of a round running concurrently. The records are
+ * finally copied once, in sorted order.
+ *
+ * @param entries: The records to sort.
+ * @param file_count: Number of records.
+ * @param order: The order.
+ * @param thread_count: Number of threads (at most `SORT_MAX_THREADS`).
+ *
+ * @return: 0 on success, -1 if memory allocation fails (the records are left unchanged).
+ */
+static int sort_in_parallel(FileEntry entries[], int file_count, SortOrder order, int thread_count)
+{
+    size_t count = (size_t)file_count;
+    sort_table table;
+    table.keys = malloc(count * sizeof(*table.keys));
+    table.key_lengths = malloc(count * sizeof(*table.key_lengths));
+    table.names = malloc(count * sizeof(*table.names));
+    table.seconds = malloc(count * sizeof(*table.seconds));
+    table.nanoseconds = malloc(count * sizeof(*table.nanoseconds));
+    table.has_time = malloc(count * sizeof(*table.has_time));
+    int *indexes = malloc(count * sizeof(int));
+    int *scratch = malloc(count * sizeof(int));
+    FileEntry *sorted = malloc(count * sizeof(FileEntry));
+
+    int status = -1;
+    if (table.keys != NULL && table.key_lengths != NULL && table.names != NULL &&
+        table.seconds != NULL && table.nanoseconds != NULL && table.has_time != NULL &&
+        indexes != NULL && scratch != NULL && sorted != NULL)
+    {
+        /* Fill the columns */
+        table.by_time = (order != SORT_BY_NAME);
+        for (int i = 0; i < file_count; i++)
+        {
+            const FileEntry *entry = &entries[i];
+            table.keys[i] = entry->key;
+            table.key_lengths[i] = entry->key_length;
+            table.names[i] = entry->name;
+            table.has_time[i] = (order != SORT_BY_NAME && entry->has_status);
+            if (table.has_time[i])
+            {
+                const struct statx_timestamp *time = sort_time(entry, order);
+                table.seconds[i] = time->tv_sec;
+                table.nanoseconds[i] = time->tv_nsec;
+            }
+            indexes[i] = i;
+        }
+
+        /* Sort one slice per thread */
+        sort_task tasks[SORT_MAX_THREADS];
+        int bounds[SORT_MAX_THREADS + 1];
+        for (int t = 0; t <= thread_count; t++)
+        {
+            bounds[t] = (int)((long long)file_count * t / thread_count);
+        }
+        for (int t = 0; t < thread_count; t++)
+        {
+            memset(&tasks[t], 0, sizeof(tasks[t]));
+            tasks[t].table = &table;
+            tasks[t].source = indexes;
+            tasks[t].begin = bounds[t];
+            tasks[t].end = bounds[t + 1];
+        }
+        run_tasks(tasks, thread_count, sort_range);
+
+        /* Merge the sorted slices pairwise until one run is left */
+        int *source = indexes;
+        int *destination = scratch;
+        for (int width = 1; width < thread_count; width *= 2)
+        {
+            int task_count = 0;
+            for (int t = 0; t < thread_count; t += 2 * width)
+            {
+                sort_task *task = &tasks[task_count++];
+                task->table = &table;
+                task->source = source;
+                task->destination = destination;
+                task->begin = bounds[t];
+                task->middle = bounds[(t + width < thread_count) ? t + width : thread_count];
+                task->end = bounds[(t + 2 * width < thread_count) ? t + 2 * width : thread_count];
+            }
+            run_tasks(tasks, task_count, merge_runs);
+
+            int *swap = source;
+            source = destination;
+            destination = swap;
+        }
+
+        /* Copy the records in sorted order, one slice per thread */
+        for (int t = 0; t < thread_count; t++)
+        {
+            tasks[t].source = source;
+            tasks[t].entries = entries;
+            tasks[t].sorted = sorted;
+            tasks[t].begin = bounds[t];
+            tasks[t].end = bounds[t + 1];
+        }
+        run_tasks(tasks, thread_count, gather_records);
+        memcpy(entries, sorted, count * sizeof(FileEntry));
+        status = 0;
+    }
+
+    free(table.keys);
+    free(table.key_lengths);
+    free(table.names);
+    free(table.seconds);
+    free(table.nanoseconds);
+    free(table.has_time);
+    free(indexes);
+    free(scratch);
+    free(sorted);
+    return status;
+}
+
+
+
+
+/**
+ * Sorts the entry records of a listing.
+ *
+ * Directories of up to `SORT_PARALLEL_THRESHOLD` entries are sorted by `qsort` with the
+ * comparator of the order (see Helper.c). Larger ones are sorted by up to
+ * `SORT_MAX_THREADS` threads when there are several CPUs, each one given at least
+ * `SORT_MIN_ENTRIES_PER_THREAD` entries; the resulting order is identical, and the
+ * serial sort is used if the parallel one cannot allocate its memory.
+ *
+ * The sort keys (`BuildSortKeys`) and, for time orders, the metadata must be filled.
+ *
+ * @param entries: The records to sort, in place.
+ * @param file_count: Number of records.
+ * @param order: The order.
+ *
+ * @return: Void.
+ */
+void SortEntries(FileEntry entries[], int file_count, SortOrder order)
+{
+    int (*compare_func)(const void *, const void *) =
+        (order == SORT_BY_MODIFICATION_TIME) ? CompareFileModificationTimes :
+        (order == SORT_BY_ACCESS_TIME) ? CompareFileAccessTimes :
+        (order == SORT_BY_CHANGE_TIME) ? CompareFileChangeTimes :
+        CompareFileNamesAlphabetically;
+
+    /* Nothing to order (an empty directory has no record array) */
+    if (file_count < 2)
+    {
+        return;
+    }
+
+    if (file_count > SORT_PARALLEL_THRESHOLD)
+    {
+        long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+        if (thread_count > file_count / SORT_MIN_ENTRIES_PER_THREAD)
+        {
+            thread_count = file_count / SORT_MIN_ENTRIES_PER_THREAD;
+        }
+        if (thread_count > SORT_MAX_THREADS)
+        {
+            thread_count = SORT_MAX_THREADS;
+        }
+
+        if (thread_count > 1 && sort_in_parallel(entries, file_count, order, (int)thread_count) == 0)
+        {
+            return;
+        }
+    }
+
+    qsort(entries, (size_t)file_count, sizeof(FileEntry), compare_func);
+}
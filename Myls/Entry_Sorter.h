@@ -0,0 +1,75 @@
+ /*===================================================================================
+ * @file           : Entry_Sorter.h
+ * @author         : Ali Mamdouh
+ * @brief          : Header of Entry_Sorter (serial and parallel sorting of entry records).
+ * @Reviewer       : Eng Reda
+ * @Version        : 1.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _ENTRY_SORTER_H_
+#define _ENTRY_SORTER_H_
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Helper.h"
+
+
+
+
+
+/*============================================================================
+ **********************************  Macros  *********************************
+ ============================================================================*/
+/**
+ * @brief Number of entries from which a directory is sorted by several threads.
+ *
+ * Below it, `qsort` finishes before the threads would have started.
+ */
+#define SORT_PARALLEL_THRESHOLD             65536
+
+/**
+ * @brief Maximum number of threads sorting one directory (including the calling thread).
+ */
+#define SORT_MAX_THREADS                    16
+
+/**
+ * @brief Minimum number of entries each sorting thread is given.
+ */
+#define SORT_MIN_ENTRIES_PER_THREAD         16384
+
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * @brief Order of a listing.
+ */
+typedef enum
+{
+    SORT_BY_NAME,                /**< Sort keys of the names (see `BuildSortKeys`). */
+    SORT_BY_MODIFICATION_TIME,   /**< Newest stx_mtime first (-t). */
+    SORT_BY_ACCESS_TIME,         /**< Newest stx_atime first (-tu). */
+    SORT_BY_CHANGE_TIME          /**< Newest stx_ctime first (-tc). */
+} SortOrder;
+
+
+
+
+
+
+/*============================================================================
+ ********************************  Functions  ********************************
+ ============================================================================*/
+void SortEntries(FileEntry entries[], int file_count, SortOrder order);
+
+#endif
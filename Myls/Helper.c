@@ -15,10 +15,11 @@
 /*============================================================================
  ******************************  Includes  ***********************************
  ============================================================================*/ 
+#define _GNU_SOURCE      // Exposes statx
 #include "Helper.h"
 #include "Option_Handler.h"
+#include "Renderer.h"
 #include <string.h>
-#include <ctype.h>
 
 
 
@@ -28,7 +29,7 @@
  *********************  Global Variables Declerations  ***********************
  ============================================================================*/ 
 
-extern int OptionsFlags[9];
+extern int OptionsFlags[OPTIONS_COUNT];
 
 
 
@@ -39,67 +40,102 @@ extern int OptionsFlags[9];
  ******************************  Functions  **********************************
  ============================================================================*/ 
 /**
- * Converts all characters in a string to lowercase.
+ * Compares two file names alphabetically for sorting.
+ *
+ * This function compares the sort keys of two entries to determine their order. The
+ * keys were computed once per entry by `BuildSortKeys` (lowercase name, locale collation
+ * key or natural version key), so a comparison is a single `memcmp` with no allocation.
+ * Names with identical keys (e.g., "A" and "a") are ordered by their raw bytes, so the
+ * order never depends on the sort algorithm.
  *
- * This function iterates through the input string and converts each character to its 
- * lowercase equivalent using the `tolower` function. The conversion is performed in-place,
- * meaning that the original string is modified directly. This is useful for standardizing 
- * string case for consistent comparisons or sorting operations.
+ * The function is used in sorting operations to provide consistent ordering of file names.
  *
- * @param str: A pointer to the string that will be converted to lowercase. 
- *             The string is modified in place, so the original content of `str` 
- *             will be changed after the function execution.
+ * @param p1: A pointer to the first entry record (`FileEntry`).
+ *            Its key is compared against the key of the second entry.
+ * @param p2: A pointer to the second entry record (`FileEntry`).
+ *            Its key is compared against the key of the first entry.
  *
- * @return: Void.
+ * @return: A negative value if the first file name is less than the second.
+ *          Zero if the file names are identical.
+ *          A positive value if the first file name is greater than the second.
  */
-static void to_lowercase(char *str) 
+int CompareFileNamesAlphabetically(const void *p1, const void *p2)
 {
-    while (*str) 
+    const FileEntry *entry1 = p1;
+    const FileEntry *entry2 = p2;
+
+    // Compare the common part of the keys, then the shorter key first
+    size_t length = (entry1->key_length < entry2->key_length) ? entry1->key_length : entry2->key_length;
+    int result = memcmp(entry1->key, entry2->key, length);
+    if (result != 0)
+    {
+        return result;
+    }
+    if (entry1->key_length != entry2->key_length)
     {
-        *str = tolower((unsigned char) *str);
-        str++;
+        return (entry1->key_length < entry2->key_length) ? -1 : 1;
     }
+
+    // Identical keys: fall back to the raw names
+    return strcmp(entry1->name, entry2->name);
 }
 
 
 
+
+
+
+
+
 /**
- * Compares two file names alphabetically for sorting.
- *
- * This function compares two file names to determine their alphabetical order. 
- *
- * The function is used in sorting operations to provide consistent ordering of file names.
+ * Compares two timestamps, the newer one first.
  *
- * @param p1: A pointer to the first file name (pointer to a pointer to char).
- *            The file name is compared against the second file name.
- * @param p2: A pointer to the second file name (pointer to a pointer to char).
- *            The file name is compared against the first file name.
+ * @param t1: The timestamp of the first entry.
+ * @param t2: The timestamp of the second entry.
  *
- * @return: A negative value if the first file name is less than the second.
- *          Zero if the file names are identical.
- *          A positive value if the first file name is greater than the second.
+ * @return: A negative value if `t1` is newer, a positive value if `t2` is newer, 0 if
+ *          both are identical (seconds and nanoseconds).
  */
-int CompareFileNamesAlphabetically(const void *p1, const void *p2)
+static int compare_timestamps(const struct statx_timestamp *t1, const struct statx_timestamp *t2)
 {
-    // Duplicate the two strings to be able to make processing on them
-    char* lowerCasePtr1 = strdup(*(const char **) p1);
-    char* lowerCasePtr2 = strdup(*(const char **) p2);
-
-    // Convert all characters to lowercase for case-insensitive comparison
-    to_lowercase(lowerCasePtr1);
-    to_lowercase(lowerCasePtr2);
+    if (t1->tv_sec != t2->tv_sec)
+    {
+        return (t1->tv_sec > t2->tv_sec) ? -1 : 1;
+    }
+    if (t1->tv_nsec != t2->tv_nsec)
+    {
+        return (t1->tv_nsec > t2->tv_nsec) ? -1 : 1;
+    }
+    return 0;
+}
 
-    // Compare the lowercase file names alphabetically
-    int result = strcmp(lowerCasePtr1, lowerCasePtr2);
 
-    // Free duplicated strings from heap
-    free(lowerCasePtr1);
-    free(lowerCasePtr2);
 
-    return result;
-}
 
+/**
+ * Orders two entries when the metadata of at least one of them is missing.
+ *
+ * Entries without metadata have no time to sort by, so they all go after the entries
+ * that have one, sorted alphabetically among themselves. This keeps the order consistent
+ * (a total order) whatever entries qsort compares.
+ *
+ * @param p1: A pointer to the first entry record (`FileEntry`).
+ * @param p2: A pointer to the second entry record (`FileEntry`).
+ *
+ * @return: A negative value if only the second entry lacks metadata, a positive value if
+ *          only the first does, else the alphabetical comparison of the names.
+ */
+static int compare_missing_status(const void *p1, const void *p2)
+{
+    const FileEntry *entry1 = p1;
+    const FileEntry *entry2 = p2;
 
+    if (entry1->has_status != entry2->has_status)
+    {
+        return entry1->has_status ? -1 : 1;
+    }
+    return CompareFileNamesAlphabetically(p1, p2);
+}
 
 
 
@@ -109,56 +145,36 @@ int CompareFileNamesAlphabetically(const void *p1, const void *p2)
 /**
  * Compares two files based on their modification times.
  *
- * This function is used as a comparison function for sorting files by their last 
- * modification time (st_mtime). It retrieves the modification time for each file 
- * using the lstat system call. Files with newer modification times are sorted 
- * before older ones. If the modification times are identical, the files are sorted 
- * alphabetically by their names.
- *
- * In case of an error while retrieving file statistics (e.g., if a file does not exist),
- * the function falls back to alphabetical sorting of the file names.
- *
- * Additionally, if the modification times (st_mtime) are identical, the function 
- * compares the nanosecond components (st_mtim.tv_nsec) to determine the order. 
- * If both the modification times and nanoseconds are identical, the function sorts 
- * the files alphabetically by their names as a final fallback.
- *
- * @param p1: A pointer to the first file's name to be compared. This is passed as a 
- *            const void * for compatibility with qsort, but it is treated as a pointer
- *            to a string (const char **).
- * @param p2: A pointer to the second file's name to be compared. Similar to p1, it is
- *            cast to a const char **.
- *
- * @return: An integer less than, equal to, or greater than zero if the first file should 
- *          be sorted before, the same as, or after the second file, respectively:
- *          - A positive value indicates p1 should come before p2.
- *          - A negative value indicates p2 should come before p1.
- *          - Zero indicates the files are equal based on the comparison criteria.
+ * This function is used as a comparison function for sorting entry records by their last
+ * modification time (stx_mtime, seconds then nanoseconds). The time comes from the `statx`
+ * result stored in each record when the directory was read, so sorting makes no system
+ * call. Files with newer modification times are sorted before older ones. If the
+ * modification times are identical, the files are sorted alphabetically by their names.
+ *
+ * Files whose metadata could not be retrieved (e.g., the file was removed while the
+ * directory was listed) are sorted after all the others, alphabetically by their names.
+ *
+ * @param p1: A pointer to the first entry record (`FileEntry`). This is passed as a
+ *            const void * for compatibility with qsort.
+ * @param p2: A pointer to the second entry record (`FileEntry`).
+ *
+ * @return: An integer less than, equal to, or greater than zero if the first file should
+ *          be sorted before, the same as, or after the second file, respectively.
  */
 int CompareFileModificationTimes(const void *p1, const void *p2)
 {
-    struct stat buf1, buf2;
-    const char *file1 = *(const char **) p1;
-    const char *file2 = *(const char **) p2;
+    const FileEntry *entry1 = p1;
+    const FileEntry *entry2 = p2;
 
-    /* Attempt to retrieve file statistics for both files */
-    if (lstat(file1, &buf1) < 0 || lstat(file2, &buf2) < 0) 
+    /* Entries without metadata go last, alphabetically */
+    if (!entry1->has_status || !entry2->has_status)
     {
-        /* On error, fall back to alphabetical sorting */
-        return CompareFileNamesAlphabetically(p1, p2);
+        return compare_missing_status(p1, p2);
     }
 
-    /* Compare the modification times (st_mtime) */
-    if (buf1.st_mtime != buf2.st_mtime)
-        return buf2.st_mtime - buf1.st_mtime;  // Newer files first
-
-    /* If st_mtime is the same, compare nanoseconds (st_mtim.tv_nsec) */
-    else if (buf1.st_mtim.tv_nsec != buf2.st_mtim.tv_nsec)
-        return buf2.st_mtim.tv_nsec - buf1.st_mtim.tv_nsec;
-
-    /* If both times are identical, fall back to alphabetical comparison */
-    else
-        return CompareFileNamesAlphabetically(p1, p2);
+    /* Newer files first; identical times fall back to alphabetical comparison */
+    int result = compare_timestamps(&entry1->status.stx_mtime, &entry2->status.stx_mtime);
+    return (result != 0) ? result : CompareFileNamesAlphabetically(p1, p2);
 }
 
 
@@ -168,55 +184,32 @@ int CompareFileModificationTimes(const void *p1, const void *p2)
 /**
  * Compares two files based on their access times.
  *
- * This function is used to sort files by their last access time (st_atime). It retrieves
- * the access time for each file using the lstat system call. Files that have been accessed
- * more recently are sorted before those accessed earlier. If the access times are identical,
- * the files are sorted alphabetically by their names.
- *
- * In case of an error while retrieving file statistics (e.g., if a file does not exist),
- * the function falls back to alphabetical sorting of the file names.
- *
- * Additionally, if the access times (st_atime) are identical, the function compares the 
- * nanosecond components (st_atim.tv_nsec) to further determine the order. If both the 
- * access times and nanoseconds are identical, the files are sorted alphabetically by 
- * their names as a final fallback.
- *
- * @param p1: A pointer to the first file's name to be compared. This is passed as a 
- *            const void * for compatibility with qsort, but it is treated as a pointer
- *            to a string (const char **).
- * @param p2: A pointer to the second file's name to be compared. Similar to p1, it is
- *            cast to a const char **.
- *
- * @return: An integer less than, equal to, or greater than zero if the first file should 
- *          be sorted before, the same as, or after the second file, respectively:
- *          - A positive value indicates p1 should come before p2.
- *          - A negative value indicates p2 should come before p1.
- *          - Zero indicates the files are equal based on the comparison criteria.
+ * This function is used to sort entry records by their last access time (stx_atime,
+ * seconds then nanoseconds), taken from the `statx` result stored in each record. Files
+ * that have been accessed more recently are sorted before those accessed earlier. If the
+ * access times are identical, the files are sorted alphabetically by their names. Files
+ * without metadata are sorted after all the others, alphabetically.
+ *
+ * @param p1: A pointer to the first entry record (`FileEntry`).
+ * @param p2: A pointer to the second entry record (`FileEntry`).
+ *
+ * @return: An integer less than, equal to, or greater than zero if the first file should
+ *          be sorted before, the same as, or after the second file, respectively.
  */
 int CompareFileAccessTimes(const void *p1, const void *p2)
 {
-    struct stat buf1, buf2;
-    const char *file1 = *(const char **) p1;
-    const char *file2 = *(const char **) p2;
+    const FileEntry *entry1 = p1;
+    const FileEntry *entry2 = p2;
 
-    /* Attempt to retrieve file statistics for both files */
-    if (lstat(file1, &buf1) < 0 || lstat(file2, &buf2) < 0) 
+    /* Entries without metadata go last, alphabetically */
+    if (!entry1->has_status || !entry2->has_status)
     {
-        /* On error, fall back to alphabetical sorting */
-        return CompareFileNamesAlphabetically(p1, p2);
+        return compare_missing_status(p1, p2);
     }
 
-    /* Compare the access times (st_atime) */
-    if (buf1.st_atime != buf2.st_atime)
-        return buf2.st_atime - buf1.st_atime;  // More recently accessed files first
-
-    /* If st_atime is the same, compare nanoseconds (st_atim.tv_nsec) */
-    else if (buf1.st_atim.tv_nsec != buf2.st_atim.tv_nsec)
-        return buf2.st_atim.tv_nsec - buf1.st_atim.tv_nsec;
-
-    /* If both times are identical, fall back to alphabetical comparison */
-    else
-        return CompareFileNamesAlphabetically(p1, p2);;
+    /* More recently accessed files first; identical times fall back to alphabetical comparison */
+    int result = compare_timestamps(&entry1->status.stx_atime, &entry2->status.stx_atime);
+    return (result != 0) ? result : CompareFileNamesAlphabetically(p1, p2);
 }
 
 
@@ -227,56 +220,33 @@ int CompareFileAccessTimes(const void *p1, const void *p2)
 /**
  * Compares two files based on their change times.
  *
- * This function is used to sort files by their last change time (st_ctime), which reflects
- * the last time file metadata or content was changed. It retrieves the change time for each 
- * file using the lstat system call. Files that have been changed more recently are sorted 
- * before those changed earlier. If the change times are identical, the files are sorted 
- * alphabetically by their names.
- *
- * In case of an error while retrieving file statistics (e.g., if a file does not exist),
- * the function falls back to alphabetical sorting of the file names.
- *
- * Additionally, if the change times (st_ctime) are identical, the function compares the 
- * nanosecond components (st_ctim.tv_nsec) to further determine the order. If both the 
- * change times and nanoseconds are identical, the files are sorted alphabetically by 
- * their names as a final fallback.
- *
- * @param p1: A pointer to the first file's name to be compared. This is passed as a 
- *            const void * for compatibility with qsort, but it is treated as a pointer
- *            to a string (const char **).
- * @param p2: A pointer to the second file's name to be compared. Similar to p1, it is
- *            cast to a const char **.
- *
- * @return: An integer less than, equal to, or greater than zero if the first file should 
- *          be sorted before, the same as, or after the second file, respectively:
- *          - A positive value indicates p1 should come before p2.
- *          - A negative value indicates p2 should come before p1.
- *          - Zero indicates the files are equal based on the comparison criteria.
+ * This function is used to sort entry records by their last change time (stx_ctime,
+ * seconds then nanoseconds), which reflects the last time file metadata or content was
+ * changed, taken from the `statx` result stored in each record. Files that have been
+ * changed more recently are sorted before those changed earlier. If the change times are
+ * identical, the files are sorted alphabetically by their names. Files without metadata
+ * are sorted after all the others, alphabetically.
+ *
+ * @param p1: A pointer to the first entry record (`FileEntry`).
+ * @param p2: A pointer to the second entry record (`FileEntry`).
+ *
+ * @return: An integer less than, equal to, or greater than zero if the first file should
+ *          be sorted before, the same as, or after the second file, respectively.
  */
 int CompareFileChangeTimes(const void *p1, const void *p2)
 {
-    struct stat buf1, buf2;
-    const char *file1 = *(const char **) p1;
-    const char *file2 = *(const char **) p2;
+    const FileEntry *entry1 = p1;
+    const FileEntry *entry2 = p2;
 
-    /* Attempt to retrieve file statistics for both files */
-    if (lstat(file1, &buf1) < 0 || lstat(file2, &buf2) < 0) 
+    /* Entries without metadata go last, alphabetically */
+    if (!entry1->has_status || !entry2->has_status)
     {
-        /* On error, fall back to alphabetical sorting */
-        return CompareFileNamesAlphabetically(p1, p2);
+        return compare_missing_status(p1, p2);
     }
 
-    /* Compare the change times (st_ctime) */
-    if (buf1.st_ctime != buf2.st_ctime)
-        return buf2.st_ctime - buf1.st_ctime;  // More recently changed files first
-
-    /* If st_ctime is the same, compare nanoseconds (st_ctim.tv_nsec) */
-    else if (buf1.st_ctim.tv_nsec != buf2.st_ctim.tv_nsec)
-        return buf2.st_ctim.tv_nsec - buf1.st_ctim.tv_nsec;
-
-    /* If both times are identical, fall back to alphabetical comparison */
-    else
-        return CompareFileNamesAlphabetically(p1, p2);
+    /* More recently changed files first; identical times fall back to alphabetical comparison */
+    int result = compare_timestamps(&entry1->status.stx_ctime, &entry2->status.stx_ctime);
+    return (result != 0) ? result : CompareFileNamesAlphabetically(p1, p2);
 }
 
 
@@ -330,89 +300,89 @@ int CheckSymbolicLinkTarget(const char *path)
  *
  * @param FileName: The name of the file, used to determine if it is a compressed file based
  *                  on its extension.
- * @param buf: The `stat` structure containing information about the file, including its mode.
+ * @param buf: The `statx` result of the file, including its mode.
  * @param path: The path to the file, used to check if a symbolic link is broken.
  *
  * @return: Void.
  */
-static void Select_Color_BasedOnFileMode(char *FileName, struct stat buf, char* path)
+static void Select_Color_BasedOnFileMode(const char *FileName, const struct statx *buf, char* path)
 {
     /* Choose Output color based on type of files */
-    if (buf.st_mode & S_ISUID) 
+    if (buf->stx_mode & S_ISUID) 
     {
-        printf(WHITE_TEXT_RED_HIGHLIGHT);
+        OutputString(WHITE_TEXT_RED_HIGHLIGHT);
     } 
-    else if (buf.st_mode & S_ISGID) 
+    else if (buf->stx_mode & S_ISGID) 
     {
-        printf(BLACK_TEXT_YELLOW_HIGHLIGHT);
+        OutputString(BLACK_TEXT_YELLOW_HIGHLIGHT);
     }
     /** Check if it's an executable regular file */
-    else if (S_ISREG(buf.st_mode) && (buf.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH))) 
+    else if (S_ISREG(buf->stx_mode) && (buf->stx_mode & (S_IXUSR | S_IXGRP | S_IXOTH))) 
     {
         /** Executable file */
-        printf(EXECUTABLE_FILE);
+        OutputString(EXECUTABLE_FILE);
     }
     /** Check if it's a compressed file */
-    else if (S_ISREG(buf.st_mode) && (strstr(FileName, ".zip") || strstr(FileName, ".tar") || strstr(FileName, ".7z"))) 
+    else if (S_ISREG(buf->stx_mode) && (strstr(FileName, ".zip") || strstr(FileName, ".tar") || strstr(FileName, ".7z"))) 
     {
         /** Compressed file */
-        printf(COMPRESSED_FILE);
+        OutputString(COMPRESSED_FILE);
     }
     /** Check if it's a regular file */
-    else if (S_ISREG(buf.st_mode)) 
+    else if (S_ISREG(buf->stx_mode)) 
     {
         /** Regular file */
-        printf(REGULAR_FILE);
+        OutputString(REGULAR_FILE);
     }
     /** Check if it's a directory */
-    else if (S_ISDIR(buf.st_mode)) 
+    else if (S_ISDIR(buf->stx_mode)) 
     {
         /** Directory */
-        printf(DIRECTORY);
+        OutputString(DIRECTORY);
     }
     /** Check if it's a character special file */
-    else if (S_ISCHR(buf.st_mode)) 
+    else if (S_ISCHR(buf->stx_mode)) 
     {
         /** Character special file (e.g., terminal devices) */
-        printf(CHARACTER_SPECIAL_FILE);
+        OutputString(CHARACTER_SPECIAL_FILE);
     }
     /** Check if it's a block special file */
-    else if (S_ISBLK(buf.st_mode)) 
+    else if (S_ISBLK(buf->stx_mode)) 
     {
         /** Block special file (e.g., disk devices) */
-        printf(BLOCK_SPECIAL_FILE);
+        OutputString(BLOCK_SPECIAL_FILE);
     }
     /** Check if it's a FIFO or named pipe */
-    else if (S_ISFIFO(buf.st_mode)) 
+    else if (S_ISFIFO(buf->stx_mode)) 
     {
         /** FIFO or named pipe */
-        printf(NAMED_PIPE);
+        OutputString(NAMED_PIPE);
     }
     /** Check if it's a socket */
-    else if (S_ISSOCK(buf.st_mode)) 
+    else if (S_ISSOCK(buf->stx_mode)) 
     {
         /** Socket */
-        printf(SOCKET);
+        OutputString(SOCKET);
     }
     /** Check if it's a symbolic link */
-    else if (S_ISLNK(buf.st_mode)) 
+    else if (S_ISLNK(buf->stx_mode)) 
     {
         if (CheckSymbolicLinkTarget(path) == BROKEN_LINK) 
         {
             /** Broken link => color is red */
-            printf(RED_HIGHLIGHT);
+            OutputString(RED_HIGHLIGHT);
         } 
         else 
         {
             /** Proper symbolic link */
-            printf(SOFT_LINK);
+            OutputString(SOFT_LINK);
         }
     }
     /** Default case for unrecognized file type */
     else 
     {
         /** Default case (unrecognized file type) */
-        printf(WHITE);
+        OutputString(WHITE);
     }
 }
 
@@ -424,28 +394,26 @@ static void Select_Color_BasedOnFileMode(char *FileName, struct stat buf, char*
  * This function prints the name of the file or directory, with color or format applied based
  * on the file type and its mode. If the long format option is enabled and the file is a symbolic
  * link, it also prints the target of the symbolic link. The color is reset to default after
- * printing. Memory allocated for the file name is freed after use.
+ * printing. The text is appended to the output buffer (see Renderer.c), and the name is
+ * used in place, without a copy.
  *
  * @param Entry: The name of the file or directory entry to be printed.
- * @param buf: The `stat` structure containing information about the file, including its mode.
+ * @param buf: The `statx` result of the file, including its mode.
  * @param path: The path to the file, used to check if a symbolic link is broken and to read
  *              the link target if needed.
  *
  * @return: Void.
  */
-void PrintEntry(const char *Entry, struct stat buf, char* path)
+void PrintEntry(const char *Entry, const struct statx *buf, char* path)
 {
-    /* To make processing on file name with String Library with more free */
-    char* FileName = strdup(Entry);
-
     /* Choose Output color based on type of files */
-    Select_Color_BasedOnFileMode(FileName, buf, path);
+    Select_Color_BasedOnFileMode(Entry, buf, path);
 
     /** Print the entry name */
-    printf("%s", FileName);
+    OutputString(Entry);
 
     /** Check if long format option is set and if it's a symbolic link => print the target file that symbolic link points to */
-    if (OptionsFlags[LONG_FORMAT_OPTION_l] && S_ISLNK(buf.st_mode)) 
+    if (OptionsFlags[LONG_FORMAT_OPTION_l] && S_ISLNK(buf->stx_mode)) 
     {
         char link_target[MAX_PATH_LENGTH];
 
@@ -456,7 +424,8 @@ void PrintEntry(const char *Entry, struct stat buf, char* path)
             link_target[len] = '\0';
 
             /** Print the symbolic link target */
-            printf(" -> %s", link_target);
+            OutputString(" -> ");
+            OutputBytes(link_target, (size_t)len);
         } 
         else 
         {
@@ -466,10 +435,7 @@ void PrintEntry(const char *Entry, struct stat buf, char* path)
     }
 
     /* Reset color to default after printing */
-    printf(RESET_COLOR);
-
-    /* Free duplicated file name from heap */
-    free(FileName);
+    OutputString(RESET_COLOR);
 }
 
 
@@ -502,14 +468,13 @@ void PrintEntry(const char *Entry, struct stat buf, char* path)
  *             with the formatted permissions. It will include the file type and
  *             permissions for the owner, group, and others, ending with a null
  *             terminator.
- * @param buf: A `stat` structure containing file status information, including
- *             the file mode.
+ * @param buf: The `statx` result of the file, including the file mode.
  *
  * @return: Void.
  */
-void GetFilePermessions(char* str, struct stat buf)
+void GetFilePermessions(char* str, const struct statx *buf)
 {
-    int mode = buf.st_mode;
+    int mode = buf->stx_mode;
 
     // Check if the file is executable
     if (S_ISDIR(mode)) str[0] = 'd'; // Directory
@@ -567,19 +532,19 @@ void GetFilePermessions(char* str, struct stat buf)
  * printed at the end. The function also considers options to show inode number
  * and access or change time based on the flags set in `OptionsFlags`.
  *
- * @param buf: A `stat` structure containing file status information, including
- *             permissions, number of links, owner, group, size, and time.
+ * @param buf: The `statx` result of the file (filled once when the directory was read),
+ *             including permissions, number of links, owner, group, size, and time.
  * @param file_name: The name of the file or directory to be printed.
  * @param path: The path to the file, used to determine the access or modification
  *              time and to read symbolic link targets if needed.
  *
  * @return: Void.
  */
-void PrintEntry_LongFormat(struct stat buf, const char *file_name, char* path)
+void PrintEntry_LongFormat(const struct statx *buf, const char *file_name, char* path)
 {
     if (OptionsFlags[SHOW_INODE_OPTION_i]) 
     {
-        printf("%ld  ", buf.st_ino);
+        OutputFormat("%llu  ", (unsigned long long)buf->stx_ino);
     }
 
     char str[11];
@@ -588,41 +553,33 @@ void PrintEntry_LongFormat(struct stat buf, const char *file_name, char* path)
     GetFilePermessions(str, buf);
 
     // Print file permissions
-    printf("%3s ", str);
+    OutputFormat("%3s ", str);
 
     // Number of hard links (right-aligned with a width of 3)
-    printf("%3ld ", buf.st_nlink);
+    OutputFormat("%3u ", buf->stx_nlink);
 
-    // Owner name (left-aligned with a width of 8)
-    struct passwd *pwd = getpwuid(buf.st_uid);
-    printf("%-8s ", pwd->pw_name);
+    // Owner name (left-aligned with a width of 8; cached, the number if the user is unknown)
+    OutputFormat("%-8s ", LookupUserName(buf->stx_uid));
 
     // Group name (left-aligned with a width of 8)
-    struct group *grp = getgrgid(buf.st_gid);
-    printf("%-2s ", grp->gr_name);
+    OutputFormat("%-2s ", LookupGroupName(buf->stx_gid));
 
     // File size (right-aligned with a width of 8)
-    printf("%8ld ", buf.st_size);
+    OutputFormat("%8llu ", (unsigned long long)buf->stx_size);
 
-    /* Time */
+    /* Time (formatted like ctime, cached across entries) */
     if (OptionsFlags[ACCESS_TIME_OPTION_u]) 
     {
-        char *time_str = ctime(&buf.st_atime);
-        time_str[strlen(time_str) - 1] = '\0'; // Remove the newline
-        printf(" %s ", time_str);            
+        OutputFormat(" %s ", FormatTime(buf->stx_atime.tv_sec));
     }
     else if (OptionsFlags[CHANGE_TIME_OPTION_c]) 
     {
-        char *time_str = ctime(&buf.st_ctime);
-        time_str[strlen(time_str) - 1] = '\0'; // Remove the newline
-        printf(" %s ", time_str);            
+        OutputFormat(" %s ", FormatTime(buf->stx_ctime.tv_sec));
     }
     else 
     {
         /* Default: Modification time */
-        char *time_str = ctime(&buf.st_mtime);
-        time_str[strlen(time_str) - 1] = '\0'; // Remove the newline
-        printf(" %s ", time_str);
+        OutputFormat(" %s ", FormatTime(buf->stx_mtime.tv_sec));
     }
     
     // File name (left-aligned)
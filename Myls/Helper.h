@@ -20,6 +20,7 @@
 #include <dirent.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <errno.h>
 
@@ -307,6 +308,52 @@
 
 
 
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/ 
+/**
+ * @brief Record of one directory entry.
+ *
+ * The metadata of an entry is fetched at most once, with one `statx` call relative to the
+ * listed directory, and then shared by the sort comparisons and the printers. When the
+ * options only need the file type or inode number, `status` is filled from the directory
+ * entry instead (see `FetchMetadata`).
+ *
+ * Fields:
+ *
+ * @param name: Name of the entry, relative to the listed directory (points into the name
+ *              arena of the listing, set once the whole directory has been read).
+ * @param name_offset: Offset of the name in the name arena.
+ * @param name_length: Length of the name in bytes.
+ * @param key: Sort key of the name (points into the name arena, see `BuildSortKeys`);
+ *             keys are compared with `memcmp`.
+ * @param key_offset: Offset of the sort key in the name arena.
+ * @param key_length: Length of the sort key in bytes.
+ * @param type: File type from the directory entry (`DT_*`, `DT_UNKNOWN` if not provided).
+ * @param inode: Inode number from the directory entry.
+ * @param status: Metadata of the entry (symbolic links are not followed); `stx_mask`
+ *                tells which fields are valid.
+ * @param has_status: 1 if `status` is valid, 0 if `statx` failed.
+ */
+typedef struct
+{
+    char *name;              /**< Entry name. */
+    size_t name_offset;      /**< Offset of the name in the arena. */
+    size_t name_length;      /**< Length of the name. */
+    const char *key;         /**< Sort key. */
+    size_t key_offset;       /**< Offset of the key in the arena. */
+    size_t key_length;       /**< Length of the key. */
+    unsigned char type;      /**< d_type of the entry. */
+    unsigned long long inode;/**< d_ino of the entry. */
+    struct statx status;     /**< Entry metadata. */
+    int has_status;          /**< 1 if `status` was filled. */
+} FileEntry;
+
+
+
+
+
+
 /*============================================================================
  ********************************  Macros  ***********************************
  ============================================================================*/ 
@@ -315,8 +362,8 @@ int CompareFileModificationTimes(const void *p1, const void *p2);
 int CompareFileAccessTimes(const void *p1, const void *p2);
 int CompareFileChangeTimes(const void *p1, const void *p2);
 int CheckSymbolicLinkTarget(const char *path);
-void GetFilePermessions( char* str , struct stat buf);
-void PrintEntry(const char *Entry, struct stat buf , char* path);
-void PrintEntry_LongFormat( struct stat buf , const char *file_name , char* path );
+void GetFilePermessions( char* str , const struct statx *buf);
+void PrintEntry(const char *Entry, const struct statx *buf , char* path);
+void PrintEntry_LongFormat( const struct statx *buf , const char *file_name , char* path );
 
 #endif
\ No newline at end of file
@@ -15,12 +15,15 @@
 /*============================================================================
  ******************************  Includes  ***********************************
  ============================================================================*/ 
+#define _GNU_SOURCE      // Exposes statx
 #include <unistd.h>
 #include <stdio.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <stdlib.h>
+#include <locale.h>
 #include "Option_Handler.h"
+#include "Renderer.h"
 
 
 
@@ -32,7 +35,7 @@ extern char *optarg;
 extern int optind, opterr, optopt;
 
 /* Array to carry the state of options */
-extern int OptionsFlags[9];
+extern int OptionsFlags[OPTIONS_COUNT];
 
 
 
@@ -74,6 +77,7 @@ static void set_option_flag(int opt)
         case 'f': OptionsFlags[DISABLE_EVERYTING_OPTION_f] = 1;         break;
         case 'd': OptionsFlags[SHOW_DIRECTORY_ITSELF_OPTION_d] = 1;     break;
         case '1': OptionsFlags[SHOW_1_FILE_IN_LINE_OPTION_1] = 1;       break;
+        case 'v': OptionsFlags[VERSION_SORT_OPTION_v] = 1;              break;
         default:  
             fprintf(stderr, "Unexpected option: -%c\n", opt);  // Handle unexpected option
             exit(EXIT_FAILURE);
@@ -95,7 +99,7 @@ static void parse_options(int argc, char *argv[])
     int opt;
 
     // Parse options using getopt()
-    while ((opt = getopt(argc, argv, ":latucifd1")) != -1) 
+    while ((opt = getopt(argc, argv, ":latucifd1v")) != -1) 
     {
         set_option_flag(opt);  // Set flag based on parsed option
     }
@@ -121,13 +125,13 @@ static void list_specified_directories(int argc, char *argv[])
             continue;
         }
 
-        printf("%s:\n", argv[i]);
+        OutputFormat("%s:\n", argv[i]);
         list_directory(argv[i]);  // List the specified directory
 
         // Print a newline between directories for formatting consistency
         if (i < argc - 1) 
         {
-            printf("\n");
+            OutputString("\n");
         }
     }
 }
@@ -148,8 +152,16 @@ static void list_specified_directories(int argc, char *argv[])
  */
 int main(int argc, char *argv[])
 {
+    setlocale(LC_COLLATE, "");  // Sort names with the collation of the user's locale
+
     parse_options(argc, argv);  // Parse command-line options
 
+    // Like ls, print one file per line when the output is not a terminal
+    if (!isatty(STDOUT_FILENO)) 
+    {
+        OptionsFlags[SHOW_1_FILE_IN_LINE_OPTION_1] = 1;
+    }
+
     // If no directory is passed, list the current working directory's entries
     if (optind == argc) 
     {
@@ -160,6 +172,7 @@ int main(int argc, char *argv[])
         list_specified_directories(argc, argv);  // List passed directories
     }
 
+    FlushOutput();  // Write the buffered output
     return 0;
 }
 
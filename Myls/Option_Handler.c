@@ -14,6 +14,7 @@
 /*============================================================================
  ******************************  Includes  ***********************************
  ============================================================================*/ 
+#define _GNU_SOURCE      // Exposes statx
 #include <unistd.h>
 #include <stdio.h>
 #include <dirent.h>
@@ -24,9 +25,14 @@
 #include <pwd.h>
 #include <grp.h>
 #include <time.h>
+#include <locale.h>
 
 #include "Helper.h"
 #include "Option_Handler.h"
+#include "Dir_Reader.h"
+#include "Stat_Planner.h"
+#include "Entry_Sorter.h"
+#include "Renderer.h"
 
 
 
@@ -36,7 +42,7 @@
  **********************  Global Variables Declerations  **********************
  ============================================================================*/ 
 extern int errno;
-int OptionsFlags[9] = {0};
+int OptionsFlags[OPTIONS_COUNT] = {0};
 
 
 
@@ -62,17 +68,19 @@ static void construct_file_path(char *path, size_t path_size, const char *dir, c
 
 
 /**
- * Retrieves the file status using lstat and handles error reporting.
+ * Retrieves the file status using statx (symbolic links are not followed) and handles
+ * error reporting.
  *
+ * @param dir_fd: Directory `path` is relative to, or AT_FDCWD.
  * @param path: Path to the file.
  * @param buf: Buffer to store file statistics.
- * @return: 1 if successful, 0 if lstat fails.
+ * @return: 1 if successful, 0 if statx fails.
  */
-static int get_file_status(const char *path, struct stat *buf)
+static int get_file_status(int dir_fd, const char *path, struct statx *buf)
 {
-    if (lstat(path, buf) < 0) 
+    if (statx(dir_fd, path, AT_SYMLINK_NOFOLLOW, STATX_BASIC_STATS, buf) < 0) 
     {
-        perror("Error in lstat");
+        perror("Error in statx");
         return 0;
     }
     return 1;
@@ -88,56 +96,187 @@ static int get_file_status(const char *path, struct stat *buf)
  * @param dir: Directory name.
  * @param buf: File statistics structure.
  */
-static void print_directory_entry(const char *dir, struct stat buf)
+static void print_directory_entry(const char *dir, const struct statx *buf)
 {
     if (OptionsFlags[DISABLE_EVERYTING_OPTION_f]) 
     {
-        printf("%s", dir);  // Print directory name without color
+        OutputString(dir);  // Print directory name without color
     } 
     else 
     {
         PrintEntry(dir, buf, NULL);  // Print directory name with formatting
     }
-    printf("\n");
+    OutputString("\n");
 }
 
 
 
 
 /**
- * Prints a file entry in basic format, handling options such as -i, -f, and -1.
+ * Prints a file entry in basic format, handling options such as -i and -f. The caller
+ * prints the separator (new line or column padding).
  *
  * @param file_name: Name of the file.
  * @param buf: File statistics structure.
- * @param path: Full path to the file.
+ * @param dir: Directory name, used to build the path of symbolic links to check.
  */
-static void print_basic_entry(const char *file_name, struct stat buf, char *path)
+static void print_basic_entry(const char *file_name, const struct statx *buf, const char *dir)
 {
     // If -i option is used, print the inode number
     if (OptionsFlags[SHOW_INODE_OPTION_i]) 
     {
-        printf("%ld  ", buf.st_ino);
+        OutputFormat("%llu  ", (unsigned long long)buf->stx_ino);
     }
 
     // If -f option is used, print without color
     if (OptionsFlags[DISABLE_EVERYTING_OPTION_f]) 
     {
-        printf("%s", file_name);
+        OutputString(file_name);
     } 
     else 
     {
+        char path[MAX_PATH_LENGTH];
+
+        construct_file_path(path, sizeof(path), dir, file_name);
         PrintEntry(file_name, buf, path);  // Print file name with formatting
     }
+}
+
+
+
+
+/**
+ * Returns the number of characters `print_basic_entry` displays for an entry (colour
+ * codes take no room).
+ *
+ * @param entry: The entry record.
+ *
+ * @return: The display width of the entry.
+ */
+static int basic_entry_width(const FileEntry *entry)
+{
+    int width = (int)entry->name_length;
 
-    // Handle new line or tab separation based on options
-    if (OptionsFlags[SHOW_1_FILE_IN_LINE_OPTION_1]) 
+    if (OptionsFlags[SHOW_INODE_OPTION_i]) 
     {
-        printf("\n");  // Print each file on a new line
-    } 
-    else 
+        unsigned long long inode = entry->status.stx_ino;
+        width += 3;  // First digit and the two spaces
+        while (inode >= 10)
+        {
+            inode /= 10;
+            width++;
+        }
+    }
+    return width;
+}
+
+
+
+
+/**
+ * Prints entries in columns filling the line width, sorted down the columns, like `ls -C`.
+ *
+ * The widths of every possible layout (1 to the maximum number of columns) are computed
+ * in one pass over the entries; the layout with the most columns whose lines fit is used.
+ *
+ * @param entries[]: Entry records of the directory.
+ * @param shown[]: Indexes of the records to print, in order.
+ * @param widths[]: Display width of every shown record.
+ * @param shown_count: Number of records to print.
+ * @param dir: Directory name to list.
+ *
+ * @return: 0 on success, -1 if memory allocation fails (nothing is printed).
+ */
+static int print_in_columns(FileEntry entries[], const int shown[], const int widths[], int shown_count, const char *dir)
+{
+    if (shown_count == 0)
+    {
+        return 0;
+    }
+
+    int line_width = GetLineWidth();
+
+    /* A column takes at least one character and a separator */
+    int max_columns = line_width / (1 + COLUMN_SEPARATOR_WIDTH);
+    if (max_columns < 1)
     {
-        printf("  ");  // Separate files with a tab
+        max_columns = 1;
     }
+    if (max_columns > shown_count)
+    {
+        max_columns = shown_count;
+    }
+
+    /* Layout with c columns: column widths at column_widths + c * (c - 1) / 2 */
+    int *column_widths = calloc((size_t)max_columns * (max_columns + 1) / 2, sizeof(int));
+    int *line_lengths = calloc((size_t)max_columns + 1, sizeof(int));
+    char *fits = malloc((size_t)max_columns + 1);
+    if (column_widths == NULL || line_lengths == NULL || fits == NULL)
+    {
+        free(column_widths);
+        free(line_lengths);
+        free(fits);
+        return -1;
+    }
+    memset(fits, 1, (size_t)max_columns + 1);
+
+    for (int k = 0; k < shown_count; k++)
+    {
+        for (int columns = 1; columns <= max_columns; columns++)
+        {
+            if (!fits[columns])
+            {
+                continue;
+            }
+
+            int rows = (shown_count + columns - 1) / columns;
+            int column = k / rows;
+            int width = widths[k] + ((column != columns - 1) ? COLUMN_SEPARATOR_WIDTH : 0);
+            int *column_width = &column_widths[columns * (columns - 1) / 2 + column];
+            if (*column_width < width)
+            {
+                line_lengths[columns] += width - *column_width;
+                *column_width = width;
+                fits[columns] = (line_lengths[columns] < line_width);
+            }
+        }
+    }
+
+    /* One column always fits */
+    int columns = max_columns;
+    while (columns > 1 && !fits[columns])
+    {
+        columns--;
+    }
+
+    int rows = (shown_count + columns - 1) / columns;
+    const int *layout = &column_widths[columns * (columns - 1) / 2];
+    for (int row = 0; row < rows; row++)
+    {
+        for (int column = 0; column < columns; column++)
+        {
+            int k = column * rows + row;
+            if (k >= shown_count)
+            {
+                break;
+            }
+
+            const FileEntry *entry = &entries[shown[k]];
+            print_basic_entry(entry->name, &entry->status, dir);
+
+            /* Pad to the next column, if there is one on this row */
+            if (k + rows < shown_count)
+            {
+                OutputPadding(layout[column] - widths[k]);
+            }
+        }
+        OutputString("\n");
+    }
+
+    free(column_widths);
+    free(line_lengths);
+    free(fits);
+    return 0;
 }
 
 
@@ -148,40 +287,64 @@ static void print_basic_entry(const char *file_name, struct stat buf, char *path
 /**
  * Handles printing files in basic format, including options such as -d, -f, -i, and -1.
  *
- * @param file_names[]: Array of file names in the directory.
+ * With `-1` (implied when the output is not a terminal) every file is printed on its own
+ * line; otherwise the files are laid out in columns (see `print_in_columns`).
+ *
+ * @param entries[]: Entry records of the directory, with their metadata already filled.
  * @param file_count: Number of files in the directory.
  * @param dir: Directory name to list.
  */
-void Print_ls_WithoutLongFormat(char *file_names[], int file_count, const char *dir)
+void Print_ls_WithoutLongFormat(FileEntry entries[], int file_count, const char *dir)
 {
-    struct stat buf;
+    struct statx buf;
 
     // Handle the case where the -d option is used (print directory name only)
     if (OptionsFlags[SHOW_DIRECTORY_ITSELF_OPTION_d]) 
     {
-        if (!get_file_status(dir, &buf)) 
+        if (!get_file_status(AT_FDCWD, dir, &buf)) 
         {
             return;
         }
 
-        print_directory_entry(dir, buf);
+        print_directory_entry(dir, &buf);
     } 
     else 
     {
-        // Loop over and print each file in the directory
-        for (int i = 0; i < file_count; i++) 
+        int *shown = malloc((size_t)file_count * sizeof(int) + 1);
+        int *widths = malloc((size_t)file_count * sizeof(int) + 1);
+        int shown_count = 0;
+
+        // Collect the files to print and their widths
+        for (int i = 0; i < file_count && shown != NULL && widths != NULL; i++) 
         {
-            char path[MAX_PATH_LENGTH];
+            if (!entries[i].has_status) 
+            {
+                continue;  // Skip files with statx errors
+            }
 
-            construct_file_path(path, sizeof(path), dir, file_names[i]);
+            shown[shown_count] = i;
+            widths[shown_count] = basic_entry_width(&entries[i]);
+            shown_count++;
+        }
 
-            if (!get_file_status(path, &buf)) 
+        // Columns unless -1 is set; one file per line if the columns cannot be laid out
+        if (OptionsFlags[SHOW_1_FILE_IN_LINE_OPTION_1] || shown == NULL || widths == NULL ||
+            print_in_columns(entries, shown, widths, shown_count, dir) != 0) 
+        {
+            for (int i = 0; i < file_count; i++) 
             {
-                continue;  // Skip files with lstat errors
-            }
+                if (!entries[i].has_status) 
+                {
+                    continue;  // Skip files with statx errors
+                }
 
-            print_basic_entry(file_names[i], buf, path);
+                print_basic_entry(entries[i].name, &entries[i].status, dir);
+                OutputString("\n");  // Print each file on a new line
+            }
         }
+
+        free(shown);
+        free(widths);
     }
 }
 
@@ -203,10 +366,10 @@ void Print_ls_WithoutLongFormat(char *file_names[], int file_count, const char *
  * @param file_name: Name of the file.
  * @param path: Full path to the file, can be NULL if -d option is used.
  */
-static void print_long_format_entry(struct stat buf, const char *file_name, char *path)
+static void print_long_format_entry(const struct statx *buf, const char *file_name, char *path)
 {
     PrintEntry_LongFormat(buf, file_name, path);
-    printf("\n");
+    OutputString("\n");
 }
 
 
@@ -216,23 +379,23 @@ static void print_long_format_entry(struct stat buf, const char *file_name, char
 /**
  * Handles the printing of directory entries in long format.
  *
- * @param file_names[]: Array of file names in the directory.
+ * @param entries[]: Entry records of the directory, with their metadata already filled.
  * @param file_count: Number of files in the directory.
  * @param dir: Directory name to list.
  */
-void Print_ls_LongFormat(char *file_names[], int file_count, const char *dir)
+void Print_ls_LongFormat(FileEntry entries[], int file_count, const char *dir)
 {
-    struct stat buf;
+    struct statx buf;
 
     // Handle the case where the -d option is used
     if (OptionsFlags[SHOW_DIRECTORY_ITSELF_OPTION_d]) 
     {
-        if (!get_file_status(dir, &buf)) 
+        if (!get_file_status(AT_FDCWD, dir, &buf)) 
         {
-            return;  // Exit if lstat fails
+            return;  // Exit if statx fails
         }
 
-        print_long_format_entry(buf, dir, NULL);
+        print_long_format_entry(&buf, dir, NULL);
         return;
     }
 
@@ -241,14 +404,14 @@ void Print_ls_LongFormat(char *file_names[], int file_count, const char *dir)
     {
         char path[MAX_PATH_LENGTH];
 
-        construct_file_path(path, sizeof(path), dir, file_names[i]);
-
-        if (!get_file_status(path, &buf)) 
+        if (!entries[i].has_status) 
         {
-            continue;  // Skip files with lstat errors
+            continue;  // Skip files with statx errors
         }
 
-        print_long_format_entry(buf, file_names[i], path);
+        construct_file_path(path, sizeof(path), dir, entries[i].name);
+
+        print_long_format_entry(&entries[i].status, entries[i].name, path);
     }
 }
 
@@ -291,79 +454,6 @@ static void handle_disable_option()
 
 
 
-/**
- * Determines whether to skip hidden files based on user-specified options.
- *
- * This function checks if a file is hidden (its name starts with a '.') and whether
- * the user has requested to show hidden files using the `-a` option. If the `-a`
- * option is not set, the function returns `1` (true) to indicate that hidden files 
- * should be skipped. Otherwise, it returns `0` (false) to include hidden files 
- * in the directory listing.
- *
- *
- * @param filename: A string representing the name of the file. The function checks 
- *                  whether this file is hidden by examining the first character of 
- *                  the file name.
- * 
- * @return: Returns `1` (true) if the file should be skipped (i.e., the file is hidden 
- *          and the `-a` option is not set). Returns `0` (false) if the file should 
- *          not be skipped (either because it is not hidden or the `-a` option is set).
- */
-static int should_skip_hidden(const char *filename) 
-{
-    /* If the -a option is not set and the file is hidden, return true (1) */
-    return (!OptionsFlags[SHOW_HIDDEN_OPTION_a] && filename[0] == '.');
-}
-
-
-
-
-/**
- * Stores a file name in the `file_names` array with proper memory allocation.
- *
- * This function dynamically allocates memory for a file name and stores it in the 
- * `file_names` array. It ensures that each file name is copied into the array 
- * safely, and handles memory allocation errors by printing an error message and 
- * exiting the program.
- *
- * If memory allocation fails, the function prints an error message using `perror`
- * and immediately terminates the program with an exit status of `EXIT_FAILURE`.
- *
- * @param file_names: An array of strings where each element represents a file name.
- *                    The function allocates memory for each file name and stores 
- *                    them in this array.
- * @param file_name:  A string representing the name of the file to be stored in 
- *                    the array. The function allocates enough memory to store 
- *                    this file name and copies it into the array.
- * @param file_count: A pointer to an integer that tracks the number of files in the 
- *                    `file_names` array. The function increments this count 
- *                    after adding a new file name.
- *
- * @return: Void
- */
-static void store_file_name(char *file_names[], const char *file_name, int *file_count) 
-{
-    /* Allocate memory for the new file name */
-    file_names[*file_count] = malloc(strlen(file_name) + 1);
-    
-    /* Check if memory allocation was successful */
-    if (file_names[*file_count] == NULL) 
-    {
-        perror("Memory allocation failed");  // Print error message
-        exit(EXIT_FAILURE);  // Exit on memory allocation failure
-    }
-
-    /* Copy the file name into the allocated memory */
-    strcpy(file_names[*file_count], file_name);
-
-    /* Increment the file count to reflect the added file */
-    (*file_count)++;  
-}
-
-
-
-
-
 /**
  * Sorts the files based on the selected command-line options.
  *
@@ -373,19 +463,20 @@ static void store_file_name(char *file_names[], const char *file_name, int *file
  * the files are sorted alphabetically by name. If the `-f` option is provided, sorting is 
  * disabled, and the file order remains unchanged.
  *
+ * `SortEntries` sorts very large directories with several threads, in the same order.
  *
- * @param file_names: An array of strings containing the names of the files to be sorted.
- *                    The array is passed by reference and will be modified in place based
- *                    on the sorting criteria.
- * @param file_count: The number of files in the `file_names` array. This value indicates
+ *
+ * @param entries:    An array of entry records to be sorted, with their metadata already
+ *                    filled. The array is modified in place based on the sorting criteria.
+ * @param file_count: The number of records in the `entries` array. This value indicates
  *                    how many entries will be considered for sorting.
  *
  * @return: Void. 
  */
-static void sort_files(char *file_names[], int file_count)
+static void sort_files(FileEntry entries[], int file_count)
 {
-    /* Default comparison function: Alphabetical sort */
-    int (*compare_func)(const void *, const void *) = CompareFileNamesAlphabetically;
+    /* Default order: Alphabetical sort */
+    SortOrder order = SORT_BY_NAME;
 
     /* Check if sorting is enabled (if the `-f` option is not set) */
     if (!OptionsFlags[DISABLE_EVERYTING_OPTION_f]) 
@@ -396,26 +487,54 @@ static void sort_files(char *file_names[], int file_count)
             /* Sort by access time if the `-u` option is also set */
             if (OptionsFlags[ACCESS_TIME_OPTION_u]) 
             {
-                compare_func = CompareFileAccessTimes;
+                order = SORT_BY_ACCESS_TIME;
             }
             /* Sort by change time if the `-c` option is also set */
             else if (OptionsFlags[CHANGE_TIME_OPTION_c]) 
             {
-                compare_func = CompareFileChangeTimes;
+                order = SORT_BY_CHANGE_TIME;
             }            
             /* Otherwise, sort by modification time (default with `-t`) */
             else 
             {
-                compare_func = CompareFileModificationTimes;
+                order = SORT_BY_MODIFICATION_TIME;
             }
         }
-        /* Perform the sort using the selected comparison function */
-        qsort(file_names, file_count, sizeof(char *), compare_func);
+        /* Perform the sort in the selected order */
+        SortEntries(entries, file_count, order);
+    }
+}
+
+
+
+/**
+ * Selects the kind of sort key matching the sorting options.
+ *
+ * `-v` sorts by natural version order. Otherwise names are ordered case-insensitively in
+ * the C/POSIX collation, and by the `strxfrm` key of the collation of the user's locale
+ * in any other one.
+ *
+ * @return: The kind of key to pass to `BuildSortKeys`.
+ */
+static SortKeyKind select_sort_key_kind(void)
+{
+    if (OptionsFlags[VERSION_SORT_OPTION_v])
+    {
+        return SORT_KEY_VERSION;
+    }
+
+    const char *collation = setlocale(LC_COLLATE, NULL);
+    if (collation == NULL || strcmp(collation, "C") == 0 || strcmp(collation, "POSIX") == 0 ||
+        strncmp(collation, "C.", 2) == 0)
+    {
+        return SORT_KEY_LOWERCASE;
     }
+    return SORT_KEY_LOCALE;
 }
 
 
 
+
 /**
  * Prints the files in the specified directory in either long format or basic format.
  *
@@ -427,30 +546,29 @@ static void sort_files(char *file_names[], int file_count)
  * After listing the files in basic format, it appends a newline character for proper output formatting.
  *
  *
- * @param file_names: An array of strings containing the names of the files to be printed.
- *                    The array should be dynamically allocated and passed to this function.
- * @param file_count: The number of files in the `file_names` array. This value determines how
+ * @param entries:    An array of entry records (names and metadata) to be printed.
+ * @param file_count: The number of records in the `entries` array. This value determines how
  *                    many entries will be processed and printed.
  * @param dir:        A string representing the directory path that contains the files to be listed.
- *                    This is used to generate the full paths to the files for metadata access.
+ *                    This is used to build the paths of symbolic links to resolve.
  *
  * @return: Void. This function does not return a value, but prints the file list to the output.
  */
-static void print_files(char *file_names[], int file_count, const char *dir) 
+static void print_files(FileEntry entries[], int file_count, const char *dir) 
 {
     /* Check if the long format option is enabled */
     if (OptionsFlags[LONG_FORMAT_OPTION_l]) 
     {
         /* Print the files in long format (detailed information) */
-        Print_ls_LongFormat(file_names, file_count, dir);
+        Print_ls_LongFormat(entries, file_count, dir);
     } 
     else 
     {
         /* Print the files in basic format (compact listing) */
-        Print_ls_WithoutLongFormat(file_names, file_count, dir);
+        Print_ls_WithoutLongFormat(entries, file_count, dir);
         
         /* Print a newline after the basic listing for proper formatting */
-        printf("\n");
+        OutputString("\n");
     }
 }
 
@@ -470,8 +588,14 @@ static void print_files(char *file_names[], int file_count, const char *dir)
  * - Sort file names based on various sorting options.
  * - Disable all options (-f flag).
  *
- * Memory is dynamically allocated for each file name, and the function ensures that
- * all allocated memory is freed at the end of the operation.
+ * The directory is read by `ReadDirectory` (`getdents64`, names stored in one arena, no
+ * limit on the number of entries). Every entry is a record holding its name and its
+ * metadata; `PlanMetadata` decides which metadata the options need and `FetchMetadata`
+ * retrieves it at most once per entry (often from the directory entry alone). Unless
+ * sorting is disabled, `BuildSortKeys` computes the sort key of every name once, so
+ * comparisons are plain byte comparisons. Sorting and printing only use the records, and
+ * the listing is formatted into the output buffer of Renderer.c. The arena and the records are freed at the end of
+ * the operation.
  *
  * @param dir: A string representing the path of the directory to list.
  *             If the directory cannot be opened, an error message is printed.
@@ -481,60 +605,39 @@ static void print_files(char *file_names[], int file_count, const char *dir)
  */
 void Execute_ls(char *dir) 
 {
-    struct dirent *entry;   // Pointer to hold directory entries
-    DIR *dp = opendir(dir); // Open the specified directory
-
-    // If the directory could not be opened, print an error message and return
-    if (dp == NULL) 
-    {
-        fprintf(stderr, "Cannot open directory '%s': %s\n", dir, strerror(errno));
-        return;
-    }
-
-    /* Array of pointers to hold file names dynamically allocated later */
-    char *file_names[MAX_FILES];
-    int file_count = 0;     // Count of valid file entries
+    DirListing listing;
+    StatPlan plan;
 
     /* Handle command-line option (-f) to disable certain options */
     handle_disable_option();
 
-    /* Read directory entries one by one and process valid file names */
-    while ((entry = readdir(dp)) != NULL) 
-    {
-        /* Skip hidden files unless the option to show them is enabled */
-        if (should_skip_hidden(entry->d_name)) 
-        {
-            continue; // Skip this entry if it's hidden and should not be displayed
-        }
-
-        /* Store the file name in the file_names array and increment the count */
-        store_file_name(file_names, entry->d_name, &file_count);
+    /* Write what was printed so far, so error messages of this directory come after it */
+    FlushOutput();
 
-        /* If the directory contains more files than allowed, issue a warning and stop processing */
-        if (file_count >= MAX_FILES) 
-        {
-            fprintf(stderr, "Warning: Too many files in directory, only processing the first %d files.\n", MAX_FILES);
-            break;
-        }
+    /* Read all the entries (hidden ones only with -a); on error a message is printed */
+    if (ReadDirectory(dir, OptionsFlags[SHOW_HIDDEN_OPTION_a], &listing) != 0) 
+    {
+        return;
     }
 
-    /* Close the directory as it's no longer needed */
-    closedir(dp);
-
-    /* Sort the files based on command-line options (e.g., alphabetical, based on access time..etc.) */
-    sort_files(file_names, file_count);
+    /* Retrieve only the metadata the options need, at most once per entry */
+    PlanMetadata(&plan);
+    FetchMetadata(listing.dir_fd, listing.entries, listing.count, &plan);
 
-    /* Print the directory listing based on the processed file names */
-    print_files(file_names, file_count, dir);
-
-    /* Free allocated memory for each stored file name */
-    for (int i = 0; i < file_count; i++) 
+    /* Compute the sort key of every name once (the order of -f needs none) */
+    if (!OptionsFlags[DISABLE_EVERYTING_OPTION_f] &&
+        BuildSortKeys(&listing, select_sort_key_kind()) != 0)
     {
-        free(file_names[i]);
+        FreeDirectory(&listing);
+        return;
     }
-}
-
-
 
+    /* Sort the files based on command-line options (e.g., alphabetical, based on access time..etc.) */
+    sort_files(listing.entries, listing.count);
 
+    /* Print the directory listing based on the processed entry records */
+    print_files(listing.entries, listing.count, dir);
 
+    /* Close the directory and free the names and the records */
+    FreeDirectory(&listing);
+}
@@ -83,6 +83,18 @@
  */
 #define SHOW_1_FILE_IN_LINE_OPTION_1        8
 
+/**
+ * @brief Option flag for natural version sort.
+ * 
+ * This flag indicates that the option to sort numbers inside names by value (`-v`) is enabled.
+ */
+#define VERSION_SORT_OPTION_v               9
+
+/**
+ * @brief Number of option flags in `OptionsFlags`.
+ */
+#define OPTIONS_COUNT                       10
+
 /* Constants */
 
 /**
@@ -92,13 +104,6 @@
  */
 #define MAX_PATH_LENGTH                     2048    
 
-/**
- * @brief Maximum number of files.
- * 
- * This constant defines the maximum number of files that can be handled, set to 1000.
- */
-#define MAX_FILES                           1000          
-
 /* File Mode Constants */
 
 /**
@@ -115,11 +120,20 @@
 
 
 
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/ 
+#include "Helper.h"
+
+
+
+
+
 /*============================================================================
  ********************************  Functions  ********************************
  ============================================================================*/ 
-void Print_ls_WithoutLongFormat( char *file_names[],int file_count, const char *dir );
-void Print_ls_LongFormat(char *file_names[], int file_count, const char *dir);
+void Print_ls_WithoutLongFormat( FileEntry entries[],int file_count, const char *dir );
+void Print_ls_LongFormat(FileEntry entries[], int file_count, const char *dir);
 void Execute_ls(char *dir);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,495 @@
+ /*===================================================================================
+ * @file           : Renderer.c
+ * @author         : Ali Mamdouh
+ * @brief          : Buffered output and cached formatting of the listings.
+ * @Reviewer       : Eng Reda
+ * @Version        : 1.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <pwd.h>
+#include <grp.h>
+#include <sys/ioctl.h>
+
+#include "Renderer.h"
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * @brief One formatted time of the time cache.
+ *
+ * Fields:
+ *
+ * @param seconds: The time formatted in `text`.
+ * @param valid: 1 once the slot has been filled.
+ * @param text: The formatted time.
+ */
+typedef struct
+{
+    long long seconds;               /**< Formatted time. */
+    int valid;                       /**< 1 if the slot is filled. */
+    char text[TIME_STRING_SIZE];     /**< Formatted text. */
+} time_slot;
+
+/**
+ * @brief Name of a user or group ID, one slot of an `id_name_cache`.
+ *
+ * Fields:
+ *
+ * @param id: The ID.
+ * @param name: Its name, or its number if it has none (NULL for a free slot).
+ */
+typedef struct
+{
+    unsigned int id;                 /**< User or group ID. */
+    char *name;                      /**< Name to display. */
+} id_name;
+
+/**
+ * @brief Hash table (open addressing, linear probing) from user or group IDs to names.
+ *
+ * A listing has few distinct owners, so every ID is looked up once per run, whatever
+ * the number of entries and directories.
+ *
+ * Fields:
+ *
+ * @param slots: The slots (the capacity is a power of two).
+ * @param capacity: Number of slots.
+ * @param count: Number of used slots.
+ */
+typedef struct
+{
+    id_name *slots;                  /**< Slots. */
+    size_t capacity;                 /**< Number of slots. */
+    size_t count;                    /**< Used slots. */
+} id_name_cache;
+
+
+
+
+
+
+/*============================================================================
+ *********************  Global Variables Declerations  ***********************
+ ============================================================================*/
+/* Output waiting to be written, and the number of bytes in it */
+static char output_buffer[OUTPUT_BUFFER_SIZE];
+static size_t output_used;
+
+/* Set when a write fails: the rest of the output is discarded */
+static int output_failed;
+
+static time_slot time_cache[TIME_CACHE_SLOTS];
+/* Names of the user and group IDs met so far, shared by all the listed directories */
+static id_name_cache user_names;
+static id_name_cache group_names;
+
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Writes a block of bytes to the standard output, retrying partial writes.
+ *
+ * @param data: The bytes.
+ * @param length: Number of bytes.
+ *
+ * @return: Void (a failure is reported once and the following output is discarded).
+ */
+static void write_all(const char *data, size_t length)
+{
+    while (length > 0 && !output_failed)
+    {
+        ssize_t written = write(STDOUT_FILENO, data, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("Error writing output");
+            output_failed = 1;
+            return;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+
+
+
+/**
+ * Writes the buffered output to the standard output.
+ *
+ * Call it before exiting, and before messages on the standard error that must appear
+ * after the output printed so far.
+ *
+ * @return: Void.
+ */
+void FlushOutput(void)
+{
+    write_all(output_buffer, output_used);
+    output_used = 0;
+}
+
+
+
+
+/**
+ * Appends bytes to the output buffer, writing the buffer when it is full.
+ *
+ * @param data: The bytes.
+ * @param length: Number of bytes.
+ *
+ * @return: Void.
+ */
+void OutputBytes(const char *data, size_t length)
+{
+    if (length > OUTPUT_BUFFER_SIZE - output_used)
+    {
+        FlushOutput();
+        if (length >= OUTPUT_BUFFER_SIZE)
+        {
+            write_all(data, length);
+            return;
+        }
+    }
+
+    memcpy(output_buffer + output_used, data, length);
+    output_used += length;
+}
+
+
+
+
+/**
+ * Appends a NUL-terminated string to the output buffer.
+ *
+ * @param text: The string.
+ *
+ * @return: Void.
+ */
+void OutputString(const char *text)
+{
+    OutputBytes(text, strlen(text));
+}
+
+
+
+
+/**
+ * Appends `count` spaces to the output buffer (column padding).
+ *
+ * @param count: Number of spaces (nothing if not positive).
+ *
+ * @return: Void.
+ */
+void OutputPadding(int count)
+{
+    static const char spaces[] = "                                ";
+
+    while (count > 0)
+    {
+        int chunk = (count < (int)sizeof(spaces) - 1) ? count : (int)sizeof(spaces) - 1;
+        OutputBytes(spaces, (size_t)chunk);
+        count -= chunk;
+    }
+}
+
+
+
+
+/**
+ * Formats text directly into the output buffer, like `printf`.
+ *
+ * @param format: The `printf` format.
+ *
+ * @return: Void.
+ */
+void OutputFormat(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    int length = vsnprintf(output_buffer + output_used, OUTPUT_BUFFER_SIZE - output_used, format, args);
+    va_end(args);
+    if (length < 0)
+    {
+        return;
+    }
+
+    /* Did not fit: make room and format again */
+    if ((size_t)length >= OUTPUT_BUFFER_SIZE - output_used)
+    {
+        FlushOutput();
+        va_start(args, format);
+        length = vsnprintf(output_buffer, OUTPUT_BUFFER_SIZE, format, args);
+        va_end(args);
+        if (length < 0)
+        {
+            return;
+        }
+        if ((size_t)length >= OUTPUT_BUFFER_SIZE)
+        {
+            length = OUTPUT_BUFFER_SIZE - 1;  // Truncated
+        }
+    }
+    output_used += (size_t)length;
+}
+
+
+
+
+/**
+ * Formats a time like `ctime` (local time, without the newline).
+ *
+ * Entries of a directory often share the same times, so every formatted time is kept in
+ * a direct-mapped cache and `localtime_r` only runs for new ones.
+ *
+ * @param seconds: Seconds since the Epoch.
+ *
+ * @return: The formatted time (valid until the next call with a time of the same slot).
+ */
+const char *FormatTime(long long seconds)
+{
+    static int timezone_loaded;
+    time_slot *slot = &time_cache[(unsigned long long)seconds % TIME_CACHE_SLOTS];
+
+    if (slot->valid && slot->seconds == seconds)
+    {
+        return slot->text;
+    }
+
+    if (!timezone_loaded)
+    {
+        tzset();
+        timezone_loaded = 1;
+    }
+
+    time_t time_value = (time_t)seconds;
+    struct tm broken_down;
+    if (localtime_r(&time_value, &broken_down) == NULL ||
+        strftime(slot->text, sizeof(slot->text), "%a %b %e %H:%M:%S %Y", &broken_down) == 0)
+    {
+        snprintf(slot->text, sizeof(slot->text), "%lld", seconds);
+    }
+    slot->seconds = seconds;
+    slot->valid = 1;
+    return slot->text;
+}
+
+
+
+
+/**
+ * Returns the slot of an ID in a cache: the slot holding it, or the free slot where it
+ * belongs.
+ *
+ * @param cache: The cache (with at least one free slot).
+ * @param id: The ID.
+ *
+ * @return: The slot.
+ */
+static id_name *find_id_slot(const id_name_cache *cache, unsigned int id)
+{
+    size_t mask = cache->capacity - 1;
+    size_t index = (size_t)(id * 2654435761u) & mask;  // Multiplicative hashing
+
+    while (cache->slots[index].name != NULL && cache->slots[index].id != id)
+    {
+        index = (index + 1) & mask;
+    }
+    return &cache->slots[index];
+}
+
+
+
+
+/**
+ * Doubles the number of slots of a cache, moving the names to their new slots.
+ *
+ * @param cache: The cache.
+ *
+ * @return: 0 on success, -1 if memory allocation fails (the cache is unchanged).
+ */
+static int grow_id_cache(id_name_cache *cache)
+{
+    size_t capacity = cache->capacity ? cache->capacity * 2 : ID_CACHE_INITIAL_SLOTS;
+    id_name *slots = calloc(capacity, sizeof(id_name));
+    if (slots == NULL)
+    {
+        return -1;
+    }
+
+    id_name_cache grown = { slots, capacity, cache->count };
+    for (size_t i = 0; i < cache->capacity; i++)
+    {
+        if (cache->slots[i].name != NULL)
+        {
+            *find_id_slot(&grown, cache->slots[i].id) = cache->slots[i];
+        }
+    }
+    free(cache->slots);
+    *cache = grown;
+    return 0;
+}
+
+
+
+
+/**
+ * Looks up the name of a user or group ID in the user and group databases.
+ *
+ * IDs without a name (deleted users, files from another system) are shown as their
+ * number, like `ls` does.
+ *
+ * @param id: The ID.
+ * @param is_group: 1 for a group ID (`getgrgid`), 0 for a user ID (`getpwuid`).
+ * @param number: Receives the number of the ID if it has no name.
+ * @param number_size: Size of `number`.
+ *
+ * @return: The name (valid until the next lookup), or `number`.
+ */
+static const char *query_id_name(unsigned int id, int is_group, char *number, size_t number_size)
+{
+    if (is_group)
+    {
+        struct group *grp = getgrgid((gid_t)id);
+        if (grp != NULL)
+        {
+            return grp->gr_name;
+        }
+    }
+    else
+    {
+        struct passwd *pwd = getpwuid((uid_t)id);
+        if (pwd != NULL)
+        {
+            return pwd->pw_name;
+        }
+    }
+
+    snprintf(number, number_size, "%u", id);
+    return number;
+}
+
+
+
+
+/**
+ * Returns the name of a user or group ID, from the cache or looked up once and cached.
+ *
+ * @param cache: The cache of the kind of ID.
+ * @param id: The ID.
+ * @param is_group: 1 for a group ID, 0 for a user ID.
+ *
+ * @return: The name to display, or the number of the ID if it has no name.
+ */
+static const char *lookup_id_name(id_name_cache *cache, unsigned int id, int is_group)
+{
+    static char number[16];
+
+    if (cache->capacity > 0)
+    {
+        id_name *slot = find_id_slot(cache, id);
+        if (slot->name != NULL)
+        {
+            return slot->name;
+        }
+    }
+
+    const char *name = query_id_name(id, is_group, number, sizeof(number));
+
+    /* Keep the table at most 3/4 full; without memory the name is not cached */
+    if ((cache->count + 1) * 4 > cache->capacity * 3 && grow_id_cache(cache) != 0)
+    {
+        return name;
+    }
+
+    id_name *slot = find_id_slot(cache, id);
+    slot->name = strdup(name);
+    if (slot->name == NULL)
+    {
+        return name;
+    }
+    slot->id = id;
+    cache->count++;
+    return slot->name;
+}
+
+
+
+
+/**
+ * Returns the name of a user ID (see `lookup_id_name`).
+ *
+ * @param uid: The user ID.
+ *
+ * @return: The user name, or the ID number if it has no name.
+ */
+const char *LookupUserName(uid_t uid)
+{
+    return lookup_id_name(&user_names, (unsigned int)uid, 0);
+}
+
+
+
+
+/**
+ * Returns the name of a group ID (see `lookup_id_name`).
+ *
+ * @param gid: The group ID.
+ *
+ * @return: The group name, or the ID number if it has no name.
+ */
+const char *LookupGroupName(gid_t gid)
+{
+    return lookup_id_name(&group_names, (unsigned int)gid, 1);
+}
+
+
+
+
+/**
+ * Returns the width of the output lines for the multi-column format: the terminal width
+ * (`TIOCGWINSZ`), else the `COLUMNS` environment variable, else `DEFAULT_LINE_WIDTH`.
+ *
+ * @return: The line width in characters.
+ */
+int GetLineWidth(void)
+{
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0)
+    {
+        return size.ws_col;
+    }
+
+    const char *columns = getenv("COLUMNS");
+    int width = (columns != NULL) ? atoi(columns) : 0;
+    return (width > 0) ? width : DEFAULT_LINE_WIDTH;
+}
@@ -0,0 +1,78 @@
+ /*===================================================================================
+ * @file           : Renderer.h
+ * @author         : Ali Mamdouh
+ * @brief          : Header of Renderer (buffered output and cached formatting).
+ * @Reviewer       : Eng Reda
+ * @Version        : 1.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _RENDERER_H_
+#define _RENDERER_H_
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include <stddef.h>
+#include <sys/types.h>
+
+
+
+
+
+/*============================================================================
+ **********************************  Macros  *********************************
+ ============================================================================*/
+/**
+ * @brief Size of the output buffer, written with one `write` call when full.
+ */
+#define OUTPUT_BUFFER_SIZE                  (256 * 1024)
+
+/**
+ * @brief Number of formatted times kept (direct-mapped on the seconds).
+ */
+#define TIME_CACHE_SLOTS                    1024
+
+/**
+ * @brief Size of a formatted time ("Wed Jun 30 21:49:08 1993", as `ctime` without newline).
+ */
+#define TIME_STRING_SIZE                    32
+
+/**
+ * @brief Initial number of slots of the user and group name caches (doubled when 3/4 full).
+ */
+#define ID_CACHE_INITIAL_SLOTS              64
+
+/**
+ * @brief Line width used when the terminal width is unknown.
+ */
+#define DEFAULT_LINE_WIDTH                  80
+
+/**
+ * @brief Number of spaces between two columns of the multi-column format.
+ */
+#define COLUMN_SEPARATOR_WIDTH              2
+
+
+
+
+
+
+/*============================================================================
+ ********************************  Functions  ********************************
+ ============================================================================*/
+void OutputBytes(const char *data, size_t length);
+void OutputString(const char *text);
+void OutputFormat(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void OutputPadding(int count);
+void FlushOutput(void);
+const char *FormatTime(long long seconds);
+const char *LookupUserName(uid_t uid);
+const char *LookupGroupName(gid_t gid);
+int GetLineWidth(void);
+
+#endif
@@ -0,0 +1,491 @@
+ /*===================================================================================
+ * @file           : Stat_Planner.c
+ * @author         : Ali Mamdouh
+ * @brief          : Decides and retrieves the minimal metadata a listing needs.
+ * @Reviewer       : Eng Reda
+ * @Version        : 1.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#define _GNU_SOURCE      // Exposes statx and DTTOIF
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "Stat_Planner.h"
+#include "Option_Handler.h"
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * @brief The entries of one directory that need `statx`, shared by the fetch strategies.
+ *
+ * Fields:
+ *
+ * @param dir_fd: File descriptor of the listed directory.
+ * @param mask: `STATX_*` fields requested.
+ * @param entries: The entry records of the directory.
+ * @param pending: Indexes in `entries` of the entries to stat.
+ * @param errors: Per pending entry: 0 on success, an errno value on failure.
+ * @param count: Number of pending entries.
+ * @param next: Next pending entry to take (thread pool).
+ */
+typedef struct
+{
+    int dir_fd;              /**< Directory descriptor. */
+    unsigned int mask;       /**< statx mask. */
+    FileEntry *entries;      /**< Entry records. */
+    int *pending;            /**< Entries to stat. */
+    int *errors;             /**< Result of every pending entry. */
+    int count;               /**< Number of pending entries. */
+    int next;                /**< Work index of the thread pool. */
+} stat_batch;
+
+
+
+
+
+
+/*============================================================================
+ *********************  Global Variables Declerations  ***********************
+ ============================================================================*/
+
+extern int OptionsFlags[OPTIONS_COUNT];
+
+
+
+
+
+
+/*============================================================================
+ ******************************  Functions  **********************************
+ ============================================================================*/
+/**
+ * Decides which metadata the listing needs, from the options in `OptionsFlags`.
+ *
+ * - `-d`: the entries are not printed, nothing is needed.
+ * - `-l`: type, permissions, link count, owner, group, size and the displayed time
+ *   (`-u` access, `-c` change, modification by default), plus the inode with `-i`, for
+ *   every entry.
+ * - `-t` (unless `-f`): the sort time, for every entry.
+ * - Colour output (unless `-f`): the permission bits, which tell executables and
+ *   SetUID/SetGID entries apart, for regular files and directories only. Other entries
+ *   are coloured from the type of the directory entry.
+ * - `-f`, `-1`, `-i`: the name, type and inode number of the directory entry are enough.
+ *
+ * Call it after the `-f` option has been applied to the other options.
+ *
+ * @param plan: Receives the plan.
+ *
+ * @return: Void.
+ */
+void PlanMetadata(StatPlan *plan)
+{
+    unsigned int time_field = OptionsFlags[ACCESS_TIME_OPTION_u] ? STATX_ATIME :
+                              OptionsFlags[CHANGE_TIME_OPTION_c] ? STATX_CTIME : STATX_MTIME;
+
+    plan->mask = 0;
+    plan->all_entries = 0;
+
+    /* With -d only the directory itself is printed */
+    if (OptionsFlags[SHOW_DIRECTORY_ITSELF_OPTION_d])
+    {
+        return;
+    }
+
+    /* Long format: every column of every entry */
+    if (OptionsFlags[LONG_FORMAT_OPTION_l])
+    {
+        plan->mask |= STATX_TYPE | STATX_MODE | STATX_NLINK | STATX_UID | STATX_GID | STATX_SIZE | time_field;
+        if (OptionsFlags[SHOW_INODE_OPTION_i])
+        {
+            plan->mask |= STATX_INO;
+        }
+        plan->all_entries = 1;
+    }
+
+    /* Time sort: the sort key of every entry */
+    if (OptionsFlags[SORT_BY_TIME_OPTION_t] && !OptionsFlags[DISABLE_EVERYTING_OPTION_f])
+    {
+        plan->mask |= time_field;
+        plan->all_entries = 1;
+    }
+
+    /* Colours: the permission bits of the entries whose colour depends on them */
+    if (!OptionsFlags[DISABLE_EVERYTING_OPTION_f])
+    {
+        plan->mask |= STATX_TYPE | STATX_MODE;
+    }
+}
+
+
+
+
+/**
+ * Fills the metadata of an entry from its directory entry, without a system call.
+ *
+ * The file type (`stx_mode` without permission bits) and the inode number are known;
+ * `stx_mask` says so.
+ *
+ * @param entry: The entry record.
+ *
+ * @return: Void.
+ */
+static void fill_from_directory_entry(FileEntry *entry)
+{
+    memset(&entry->status, 0, sizeof(entry->status));
+    entry->status.stx_mask = STATX_INO;
+    entry->status.stx_ino = entry->inode;
+    if (entry->type != DT_UNKNOWN)
+    {
+        entry->status.stx_mask |= STATX_TYPE;
+        entry->status.stx_mode = DTTOIF(entry->type);
+    }
+    entry->has_status = 1;
+}
+
+
+
+
+/**
+ * Retrieves the metadata of the batch entries one after the other (small batches).
+ *
+ * @param batch: The batch.
+ *
+ * @return: Void.
+ */
+static void stat_serially(stat_batch *batch)
+{
+    for (int k = 0; k < batch->count; k++)
+    {
+        FileEntry *entry = &batch->entries[batch->pending[k]];
+        int failed = statx(batch->dir_fd, entry->name, AT_SYMLINK_NOFOLLOW, batch->mask, &entry->status) < 0;
+        batch->errors[k] = failed ? errno : 0;
+    }
+}
+
+
+
+
+/**
+ * Worker of `stat_with_threads`: takes the next entry of the batch until none is left.
+ *
+ * @param arg: The batch.
+ *
+ * @return: NULL.
+ */
+static void *stat_worker(void *arg)
+{
+    stat_batch *batch = arg;
+
+    for (;;)
+    {
+        int k = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED);
+        if (k >= batch->count)
+        {
+            break;
+        }
+
+        FileEntry *entry = &batch->entries[batch->pending[k]];
+        int failed = statx(batch->dir_fd, entry->name, AT_SYMLINK_NOFOLLOW, batch->mask, &entry->status) < 0;
+        batch->errors[k] = failed ? errno : 0;
+    }
+    return NULL;
+}
+
+
+
+
+/**
+ * Retrieves the metadata of the batch entries with a pool of threads, each one keeping a
+ * `statx` in flight (the fallback when io_uring is not available).
+ *
+ * The calling thread works as well, so the batch completes even if no thread can be created.
+ *
+ * @param batch: The batch.
+ *
+ * @return: Void.
+ */
+static void stat_with_threads(stat_batch *batch)
+{
+    pthread_t threads[STAT_THREAD_COUNT];
+    int thread_count = 0;
+
+    batch->next = 0;
+    for (int t = 0; t < STAT_THREAD_COUNT - 1 && t < batch->count; t++)
+    {
+        if (pthread_create(&threads[thread_count], NULL, stat_worker, batch) == 0)
+        {
+            thread_count++;
+        }
+    }
+
+    stat_worker(batch);
+
+    for (int t = 0; t < thread_count; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+
+
+
+/**
+ * Retrieves the metadata of the batch entries with batched `IORING_OP_STATX` requests.
+ *
+ * Up to `STAT_QUEUE_DEPTH` requests are kept in flight; every `io_uring_enter` call
+ * submits the free slots and reaps the completions, so a whole directory costs a few
+ * system calls and the storage round-trips overlap. The rings are set up with the raw
+ * system calls (no liburing dependency).
+ *
+ * @param batch: The batch.
+ *
+ * @return: 0 if every entry completed, -1 if io_uring or its statx operation is not
+ *          available (entries that did not complete keep an error of -1).
+ */
+static int stat_with_io_uring(stat_batch *batch)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    unsigned int depth = (batch->count < STAT_QUEUE_DEPTH) ? (unsigned int)batch->count : STAT_QUEUE_DEPTH;
+    int ring_fd = (int)syscall(__NR_io_uring_setup, depth, &params);
+    if (ring_fd < 0)
+    {
+        return -1;  // Not supported or disabled (e.g., kernel.io_uring_disabled)
+    }
+
+    /* Check that the kernel supports IORING_OP_STATX (Linux 5.6) */
+    size_t probe_size = sizeof(struct io_uring_probe) + STAT_PROBE_OPS * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, probe_size);
+    int supported = probe != NULL &&
+                    syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, STAT_PROBE_OPS) >= 0 &&
+                    probe->last_op >= IORING_OP_STATX &&
+                    (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    if (!supported)
+    {
+        close(ring_fd);
+        return -1;
+    }
+
+    /* Map the submission queue, the completion queue and the submission entries */
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+    {
+        sq_size = cq_size = (sq_size > cq_size) ? sq_size : cq_size;
+    }
+    size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    char *sq_ring = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    char *cq_ring = single_mmap ? sq_ring :
+                    mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    struct io_uring_sqe *sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+        if (!single_mmap && cq_ring != MAP_FAILED) munmap(cq_ring, cq_size);
+        if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_size);
+        close(ring_fd);
+        return -1;
+    }
+
+    unsigned int *sq_head = (unsigned int *)(sq_ring + params.sq_off.head);
+    unsigned int *sq_tail = (unsigned int *)(sq_ring + params.sq_off.tail);
+    unsigned int sq_mask = *(unsigned int *)(sq_ring + params.sq_off.ring_mask);
+    unsigned int *sq_array = (unsigned int *)(sq_ring + params.sq_off.array);
+    unsigned int *cq_head = (unsigned int *)(cq_ring + params.cq_off.head);
+    unsigned int *cq_tail = (unsigned int *)(cq_ring + params.cq_off.tail);
+    unsigned int cq_mask = *(unsigned int *)(cq_ring + params.cq_off.ring_mask);
+    struct io_uring_cqe *cqes = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+
+    for (int k = 0; k < batch->count; k++)
+    {
+        batch->errors[k] = -1;  // Not completed yet
+    }
+
+    int submitted = 0;
+    int completed = 0;
+    unsigned int in_flight = 0;
+    int result = 0;
+    while (completed < batch->count)
+    {
+        /* Fill the free submission slots */
+        unsigned int tail = *sq_tail;
+        while (submitted < batch->count && in_flight < params.sq_entries)
+        {
+            FileEntry *entry = &batch->entries[batch->pending[submitted]];
+            unsigned int index = tail & sq_mask;
+            struct io_uring_sqe *sqe = &sqes[index];
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = batch->dir_fd;
+            sqe->addr = (unsigned long)entry->name;
+            sqe->len = batch->mask;
+            sqe->off = (unsigned long)&entry->status;
+            sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+            sqe->user_data = (unsigned long)submitted;
+            sq_array[index] = index;
+
+            tail++;
+            submitted++;
+            in_flight++;
+        }
+        __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+        /* Submit what the kernel has not consumed yet and wait for a completion */
+        unsigned int to_submit = tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        if (syscall(__NR_io_uring_enter, ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+            {
+                continue;
+            }
+            result = -1;
+            break;
+        }
+
+        /* Reap the completions */
+        unsigned int head = *cq_head;
+        unsigned int ready = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != ready; head++)
+        {
+            const struct io_uring_cqe *cqe = &cqes[head & cq_mask];
+            batch->errors[cqe->user_data] = (cqe->res < 0) ? -cqe->res : 0;
+            completed++;
+            in_flight--;
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    munmap(sqes, sqes_size);
+    if (!single_mmap)
+    {
+        munmap(cq_ring, cq_size);
+    }
+    munmap(sq_ring, sq_size);
+    close(ring_fd);
+    return result;
+}
+
+
+
+
+/**
+ * Retrieves the metadata of every entry record according to a plan.
+ *
+ * Entries that need `statx` get exactly one call, relative to the open directory and
+ * with the minimal mask of the plan (so network and FUSE file systems can skip fields
+ * that are not needed). The others are filled from their directory entry.
+ *
+ * Above `STAT_PARALLEL_THRESHOLD` entries the calls are issued concurrently, so the
+ * round-trips of high-latency storage (NFS, FUSE) overlap: as batched io_uring
+ * `IORING_OP_STATX` requests, or with a pool of threads if io_uring is not available.
+ * All the results are collected before the entries are sorted. Entries whose metadata
+ * cannot be retrieved (e.g., removed while listing) are reported once, in directory
+ * order, and skipped by the printers.
+ *
+ * @param dir_fd: File descriptor of the listed directory.
+ * @param entries: The entry records to fill.
+ * @param file_count: Number of records.
+ * @param plan: The plan decided by `PlanMetadata`.
+ *
+ * @return: Void.
+ */
+void FetchMetadata(int dir_fd, FileEntry entries[], int file_count, const StatPlan *plan)
+{
+    stat_batch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.dir_fd = dir_fd;
+    batch.mask = plan->mask;
+    batch.entries = entries;
+    batch.pending = malloc((size_t)file_count * sizeof(int) + 1);
+    batch.errors = malloc((size_t)file_count * sizeof(int) + 1);
+    if (batch.pending == NULL || batch.errors == NULL)
+    {
+        perror("Memory allocation failed");
+        free(batch.pending);
+        free(batch.errors);
+        for (int i = 0; i < file_count; i++)
+        {
+            entries[i].has_status = 0;
+        }
+        return;
+    }
+
+    /* Fill what the directory entries answer, collect the entries that need statx */
+    for (int i = 0; i < file_count; i++)
+    {
+        FileEntry *entry = &entries[i];
+        int needs_mode = (entry->type == DT_REG || entry->type == DT_DIR || entry->type == DT_UNKNOWN);
+
+        if (plan->mask == 0 || (!plan->all_entries && !needs_mode))
+        {
+            fill_from_directory_entry(entry);
+        }
+        else
+        {
+            batch.pending[batch.count++] = i;
+        }
+    }
+
+    /* Issue the statx calls, concurrently for large directories */
+    if (batch.count < STAT_PARALLEL_THRESHOLD)
+    {
+        stat_serially(&batch);
+    }
+    else if (stat_with_io_uring(&batch) != 0)
+    {
+        stat_with_threads(&batch);
+    }
+
+    /* Collect the results in directory order */
+    for (int k = 0; k < batch.count; k++)
+    {
+        FileEntry *entry = &entries[batch.pending[k]];
+
+        if (batch.errors[k] != 0)
+        {
+            errno = batch.errors[k];
+            perror("Error in statx");
+            entry->has_status = 0;
+            continue;
+        }
+
+        /* The inode number is known even if it was not requested */
+        if (!(entry->status.stx_mask & STATX_INO))
+        {
+            entry->status.stx_ino = entry->inode;
+        }
+        entry->has_status = 1;
+    }
+
+    free(batch.pending);
+    free(batch.errors);
+}
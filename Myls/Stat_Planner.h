@@ -0,0 +1,87 @@
+ /*===================================================================================
+ * @file           : Stat_Planner.h
+ * @author         : Ali Mamdouh
+ * @brief          : Header of Stat_Planner (minimal metadata retrieval per listing).
+ * @Reviewer       : Eng Reda
+ * @Version        : 1.0.0
+ *===================================================================================
+ *
+ *===================================================================================
+ */
+
+
+#ifndef _STAT_PLANNER_H_
+#define _STAT_PLANNER_H_
+
+
+/*============================================================================
+ ******************************  Includes  ***********************************
+ ============================================================================*/
+#include "Helper.h"
+
+
+
+
+
+/*============================================================================
+ **********************************  Macros  *********************************
+ ============================================================================*/
+/**
+ * @brief Number of entries from which the `statx` calls of a directory are issued
+ * concurrently (below it, one call after the other costs less than the setup).
+ */
+#define STAT_PARALLEL_THRESHOLD             64
+
+/**
+ * @brief Number of `IORING_OP_STATX` requests kept in flight.
+ */
+#define STAT_QUEUE_DEPTH                    256
+
+/**
+ * @brief Number of threads of the fallback pool (including the calling thread).
+ *
+ * The threads mostly wait for the storage, so there are more than CPUs.
+ */
+#define STAT_THREAD_COUNT                   32
+
+/**
+ * @brief Number of operations queried from the kernel to check for `IORING_OP_STATX`.
+ */
+#define STAT_PROBE_OPS                      256
+
+
+
+
+
+
+/*============================================================================
+ *************************  Data types Declerations  *************************
+ ============================================================================*/
+/**
+ * @brief Metadata a listing needs, decided once from the options.
+ *
+ * Fields:
+ *
+ * @param mask: `STATX_*` fields requested from `statx` (0 if no entry is stat'ed).
+ * @param all_entries: 1 if every entry needs `statx` (long format, time sort), 0 if only
+ *                     the entries whose colour depends on their permission bits do
+ *                     (regular files, directories and entries of unknown type).
+ */
+typedef struct
+{
+    unsigned int mask;       /**< statx mask. */
+    int all_entries;         /**< 1 to stat every entry. */
+} StatPlan;
+
+
+
+
+
+
+/*============================================================================
+ ********************************  Functions  ********************************
+ ============================================================================*/
+void PlanMetadata(StatPlan *plan);
+void FetchMetadata(int dir_fd, FileEntry entries[], int file_count, const StatPlan *plan);
+
+#endif